@@ -37,6 +37,7 @@
 #include "guilib/TextureManager.h"
 #include "cores/IPlayer.h"
 #include "cores/VideoPlayer/DVDFileInfo.h"
+#include "cores/VideoPlayer/DVDCodecs/DVDSliceWorkers.h"
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSP.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
@@ -45,6 +46,7 @@
 #include "Autorun.h"
 #include "video/Bookmark.h"
 #include "video/VideoLibraryQueue.h"
+#include "video/VideoProbeQueue.h"
 #include "guilib/GUIControlProfiler.h"
 #include "utils/LangCodeExpander.h"
 #include "GUIInfoManager.h"
@@ -73,6 +75,7 @@
 #include "filesystem/DirectoryCache.h"
 #include "filesystem/StackDirectory.h"
 #include "filesystem/SpecialProtocol.h"
+#include "filesystem/CurlTransfer.h"
 #include "filesystem/DllLibCurl.h"
 #include "filesystem/PluginDirectory.h"
 #include "utils/SystemInfo.h"
@@ -261,6 +264,7 @@ using namespace XbmcThreads;
 using KODI::MESSAGING::HELPERS::DialogResponse;
 
 #define MAX_FFWD_SPEED 5
+#define PREOPEN_NEXT_ITEM_TIME 30 // seconds before the end of a video the next one is opened
 
 //extern IDirectSoundRenderer* m_pAudioDecoder;
 CApplication::CApplication(void)
@@ -2846,6 +2850,16 @@ bool CApplication::Cleanup()
 {
   try
   {
+    // probe workers ask the player whether video is playing and use the settings
+    CVideoProbeQueue::GetInstance().Stop();
+
+    // the player is closed, nothing splits picture copies anymore
+    CDVDSliceWorkers::GetInstance().Stop();
+
+    // jobs still waiting for a download are woken, and freed if they were cancelled, while the
+    // job manager and curl are still around
+    XFILE::CCurlEventLoop::GetInstance().Stop();
+
     CLog::Log(LOGNOTICE, "unload skin");
     UnloadSkin();
 
@@ -3799,6 +3813,30 @@ void CApplication::SaveFileState(bool bForeground /* = false */)
     CJobManager::GetInstance().AddJob(job, NULL, CJob::PRIORITY_NORMAL);
 }
 
+void CApplication::PreOpenNextItem()
+{
+  if (!m_pPlayer->IsPlayingVideo() || m_itemCurrentFile->IsStack() || CurrentFile() == m_preOpenedAfter)
+    return;
+
+  double total = GetTotalTime();
+  if (total <= 0.0 || total - GetTime() > PREOPEN_NEXT_ITEM_TIME)
+    return;
+  m_preOpenedAfter = CurrentFile();
+
+  int iNext = g_playlistPlayer.GetNextSong();
+  CPlayList& playlist = g_playlistPlayer.GetPlaylist(g_playlistPlayer.GetCurrentPlaylist());
+  if (iNext < 0 || iNext >= playlist.size())
+    return;
+
+  // plugin and upnp items are resolved when they start playing
+  const CFileItem &file = *playlist[iNext];
+  if (!file.IsVideo() || file.IsStack() ||
+      URIUtils::IsProtocol(file.GetPath(), "plugin") || URIUtils::IsUPnP(file.GetPath()))
+    return;
+
+  m_pPlayer->PreOpenFile(file);
+}
+
 void CApplication::UpdateFileState()
 {
   // Did the file change?
@@ -4640,6 +4678,9 @@ void CApplication::ProcessSlow()
   // Store our file state for use on close()
   UpdateFileState();
 
+  // get the next video of the playlist going before the current one ends
+  PreOpenNextItem();
+
   // Check if we need to activate the screensaver / DPMS.
   CheckScreenSaverAndDPMS();
 
@@ -190,6 +190,7 @@ public:
   PlayBackRet PlayFile(CFileItem item, const std::string& player, bool bRestart = false);
   void SaveFileState(bool bForeground = false);
   void UpdateFileState();
+  void PreOpenNextItem();
   void LoadVideoSettings(const CFileItem& item);
   void StopPlaying();
   void Restart(bool bSamePosition = true);
@@ -484,6 +485,7 @@ protected:
 
   int m_currentStackPosition;
   int m_nextPlaylistItem;
+  std::string m_preOpenedAfter; ///< file that had the playlist item following it opened ahead
 
   unsigned int m_lastRenderTime;
   bool m_skipGuiRender;
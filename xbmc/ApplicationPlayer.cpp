@@ -485,6 +485,12 @@ bool CApplicationPlayer::QueueNextFile(const CFileItem &file)
   return (player && player->QueueNextFile(file));
 }
 
+bool CApplicationPlayer::PreOpenFile(const CFileItem &file)
+{
+  std::shared_ptr<IPlayer> player = GetInternal();
+  return (player && player->PreOpenFile(file));
+}
+
 bool CApplicationPlayer::GetStreamDetails(CStreamDetails &details)
 {
   std::shared_ptr<IPlayer> player = GetInternal();
@@ -511,6 +517,14 @@ void CApplicationPlayer::GetVideoStreamInfo(int streamId, SPlayerVideoStreamInfo
     player->GetVideoStreamInfo(streamId, info);
 }
 
+bool CApplicationPlayer::GetPlaybackStats(CVariant &stats)
+{
+  std::shared_ptr<IPlayer> player = GetInternal();
+  if (player)
+    return player->GetPlaybackStats(stats);
+  return false;
+}
+
 void CApplicationPlayer::GetAudioStreamInfo(int index, SPlayerAudioStreamInfo &info)
 {
   std::shared_ptr<IPlayer> player = GetInternal();
@@ -134,6 +134,7 @@ public:
   int   GetVideoStream();
   int   GetVideoStreamCount();
   void  GetVideoStreamInfo(int streamId, SPlayerVideoStreamInfo &info);
+  bool  GetPlaybackStats(CVariant &stats);
   bool  HasAudio() const;
   bool  HasMenu() const;
   bool  HasVideo() const;
@@ -153,6 +154,7 @@ public:
   void  OnNothingToQueueNotify();
   void  Pause();
   bool  QueueNextFile(const CFileItem &file);
+  bool  PreOpenFile(const CFileItem &file);
   bool  Record(bool bOnOff);
   void  Seek(bool bPlus = true, bool bLargeStep = false, bool bChapterOverride = false);
   int   SeekChapter(int iChapter);
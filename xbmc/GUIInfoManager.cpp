@@ -458,6 +458,12 @@ const infomap integer_bools[] =  {{ "isequal",          INTEGER_IS_EQUAL },
 ///     Returns true if pvr channel preview is active (used channel tag different
 ///     from played tag)
 ///   }
+///   \table_row3{   <b>`Player.SeekPreview`</b>,
+///                  \anchor Player_SeekPreview
+///                  _string_,
+///     Image of the video at the position the user is seeking to, empty until a
+///     thumbnail of that part of the file has been extracted
+///   }
 /// \table_end
 /// @}
 const infomap player_labels[] =  {{ "hasmedia",         PLAYER_HAS_MEDIA },           // bools from here
@@ -508,7 +514,8 @@ const infomap player_labels[] =  {{ "hasmedia",         PLAYER_HAS_MEDIA },
                                   { "channelpreviewactive", PLAYER_IS_CHANNEL_PREVIEW_ACTIVE},
                                   { "tempoenabled", PLAYER_SUPPORTS_TEMPO},
                                   { "istempo", PLAYER_IS_TEMPO},
-                                  { "playspeed", PLAYER_PLAYSPEED}};
+                                  { "playspeed", PLAYER_PLAYSPEED},
+                                  { "seekpreview",      PLAYER_SEEKPREVIEW }};
 
 /// \page modules__General__List_of_gui_access
 /// @{
@@ -8223,6 +8230,12 @@ std::string CGUIInfoManager::GetImage(int info, int contextWindow, std::string *
       *fallback = "DefaultAlbumCover.png";
     return m_currentFile->HasArt("thumb") ? m_currentFile->GetArt("thumb") : "DefaultAlbumCover.png";
   }
+  else if (info == PLAYER_SEEKPREVIEW)
+  {
+    if (!g_application.m_pPlayer->IsPlayingVideo()) return "";
+    double time = g_application.GetTime() + CSeekHandler::GetInstance().GetSeekSize();
+    return m_seekPreview.GetThumb(MathUtils::round_int(time * 1000));
+  }
   else if (info == VIDEOPLAYER_COVER)
   {
     if (!g_application.m_pPlayer->IsPlayingVideo()) return "";
@@ -9233,6 +9246,7 @@ std::string CGUIInfoManager::GetCurrentPlayTimeRemaining(TIME_FORMAT format) con
 
 void CGUIInfoManager::ResetCurrentItem()
 {
+  m_seekPreview.Stop();
   m_currentFile->Reset();
   m_currentMovieThumb = "";
   m_currentMovieDuration = "";
@@ -9367,6 +9381,8 @@ void CGUIInfoManager::SetCurrentMovie(CFileItem &item)
 
   item.FillInDefaultIcon();
   m_currentMovieThumb = item.GetArt("thumb");
+
+  m_seekPreview.Start(*m_currentFile);
 }
 
 std::string CGUIInfoManager::GetSystemHeatInfo(int info)
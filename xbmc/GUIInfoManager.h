@@ -37,6 +37,7 @@
 #include "interfaces/info/SkinVariable.h"
 #include "cores/IPlayer.h"
 #include "FileItem.h"
+#include "video/VideoSeekPreview.h"
 
 #include <memory>
 #include <list>
@@ -313,6 +314,7 @@ protected:
   // Current playing stuff
   CFileItem* m_currentFile;
   std::string m_currentMovieThumb;
+  CVideoSeekPreview m_seekPreview;
   CFileItem* m_currentSlide;
 
   // fan stuff
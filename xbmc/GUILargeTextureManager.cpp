@@ -31,11 +31,16 @@
 
 #include <cassert>
 
-CImageLoader::CImageLoader(const std::string &path, const bool useCache):
+CImageLoader::CImageLoader(const std::string &path, const bool useCache, const bool fromSource /* = false */):
   m_path(path)
 {
   m_texture = NULL;
   m_use_cache = useCache;
+  m_from_source = fromSource;
+  m_needs_source = false;
+  // loading the cached copy doesn't touch the source, so don't hold up the jobs reading from it
+  if (!m_use_cache || m_from_source)
+    SetResource(CJobManager::GetResource(m_path));
 }
 
 CImageLoader::~CImageLoader()
@@ -52,8 +57,15 @@ bool CImageLoader::DoWork()
   if (texturePath.empty())
     return false;
 
+  if (m_from_source)
+  {
+    // load directly and then cache the result
+    CTextureCache::GetInstance().CacheImage(texturePath, &m_texture);
+    return (m_texture != NULL);
+  }
+
   if (m_use_cache)
-    loadPath = CTextureCache::GetInstance().CheckCachedImage(texturePath, needsChecking);
+    loadPath = CTextureCache::GetInstance().CheckCachedImage(texturePath, needsChecking, true);
   else
     loadPath = texturePath;
 
@@ -81,9 +93,9 @@ bool CImageLoader::DoWork()
   if (!m_use_cache)
     return false; // We're done
 
-  // not in our texture cache or it failed to load from it, so try and load directly and then cache the result
-  CTextureCache::GetInstance().CacheImage(texturePath, &m_texture);
-  return (m_texture != NULL);
+  // not in our texture cache or it failed to load from it, so it has to be loaded from its source
+  m_needs_source = true;
+  return false;
 }
 
 CGUILargeTextureManager::CLargeTexture::CLargeTexture(const std::string &path):
@@ -241,6 +253,12 @@ void CGUILargeTextureManager::OnJobComplete(unsigned int jobID, bool success, CJ
     if (it->first == jobID)
     { // found our job
       CImageLoader *loader = (CImageLoader *)job;
+      if (loader->m_needs_source)
+      {
+        // hand it to a job that counts towards the limit of the image's source
+        it->first = CJobManager::GetInstance().AddJob(new CImageLoader(loader->m_path, true, true), this, CJob::PRIORITY_NORMAL);
+        return;
+      }
       CLargeTexture *image = it->second;
       image->SetTexture(loader->m_texture);
       loader->m_texture = NULL; // we want to keep the texture, and jobs are auto-deleted.
@@ -38,7 +38,7 @@
 class CImageLoader : public CJob
 {
 public:
-  CImageLoader(const std::string &path, const bool useCache);
+  CImageLoader(const std::string &path, const bool useCache, const bool fromSource = false);
   virtual ~CImageLoader();
 
   /*!
@@ -47,6 +47,8 @@ public:
   virtual bool DoWork();
 
   bool          m_use_cache; ///< Whether or not to use any caching with this image
+  bool          m_from_source; ///< Whether to skip the texture cache lookup and read the image itself
+  bool          m_needs_source; ///< Set if the image isn't cached and has to be read by a job with m_from_source set
   std::string    m_path; ///< path of image to load
   CBaseTexture *m_texture; ///< Texture object to load the image into \sa CBaseTexture.
 };
@@ -29,9 +29,15 @@
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
 #include "URL.h"
+#include "windowing/WindowingFactory.h"
 
 using namespace XFILE;
 
+static bool UseDDS()
+{
+  return g_advancedSettings.m_useDDSArtwork && g_Windowing.SupportsDXT();
+}
+
 CTextureCache &CTextureCache::GetInstance()
 {
   static CTextureCache s_cache;
@@ -102,13 +108,21 @@ bool CTextureCache::CanCacheImageURL(const CURL &url)
   return (url.GetUserName().empty() || url.GetUserName() == "music");
 }
 
-std::string CTextureCache::CheckCachedImage(const std::string &url, bool &needsRecaching)
+std::string CTextureCache::CheckCachedImage(const std::string &url, bool &needsRecaching, bool returnDDS)
 {
   CTextureDetails details;
   std::string path(GetCachedImage(url, details, true));
   needsRecaching = !details.hash.empty();
   if (!path.empty())
+  {
+    if (returnDDS && !details.file.empty() && UseDDS())
+    {
+      std::string ddsPath = URIUtils::ReplaceExtension(path, ".dds");
+      if (CFile::Exists(ddsPath))
+        return ddsPath;
+    }
     return path;
+  }
   return "";
 }
 
@@ -269,7 +283,16 @@ void CTextureCache::OnCachingComplete(bool success, CTextureCacheJob *job)
     if (job->m_oldHash == job->m_details.hash)
       SetCachedTextureValid(job->m_url, job->m_details.updateable);
     else
+    {
       AddCachedTexture(job->m_url, job->m_details);
+
+      // a .dds of the previous image is out of date
+      std::string ddsPath = URIUtils::ReplaceExtension(GetCachedPath(job->m_details.file), ".dds");
+      if (!job->m_oldHash.empty() && CFile::Exists(ddsPath))
+        CFile::Delete(ddsPath);
+      if (UseDDS())
+        AddJob(new CTextureDDSJob(GetCachedPath(job->m_details.file)));
+    }
   }
 
   { // remove from our processing list
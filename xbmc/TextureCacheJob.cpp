@@ -20,27 +20,34 @@
 
 #include "TextureCacheJob.h"
 #include "TextureCache.h"
+#include "guilib/DDSImage.h"
 #include "guilib/Texture.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "utils/log.h"
+#include "utils/Mime.h"
+#include "filesystem/CurlTransfer.h"
 #include "filesystem/File.h"
 #include "pictures/Picture.h"
 #include "utils/URIUtils.h"
 #include "utils/StringUtils.h"
 #include "URL.h"
 #include "FileItem.h"
+#include "XBDateTime.h"
 #include "music/MusicThumbLoader.h"
 #include "music/tags/MusicInfoTag.h"
 #if defined(HAS_OMXPLAYER)
 #include "cores/omxplayer/OMXImage.h"
 #endif
 
+#include <algorithm>
+
 CTextureCacheJob::CTextureCacheJob(const std::string &url, const std::string &oldHash):
   m_url(url),
   m_oldHash(oldHash),
   m_cachePath(CTextureCache::GetCacheFile(m_url))
 {
+  SetResource(CJobManager::GetResource(m_url));
 }
 
 CTextureCacheJob::~CTextureCacheJob()
@@ -58,19 +65,55 @@ bool CTextureCacheJob::operator==(const CJob* job) const
   return false;
 }
 
-bool CTextureCacheJob::DoWork()
+CAsyncJob::STATUS CTextureCacheJob::Resume()
 {
+  if (m_transfer)
+  {
+    // woken once the download is done
+    if (!m_transfer->Succeeded())
+    {
+      CLog::Log(LOGDEBUG, "%s - unable to download %s (%ld)", __FUNCTION__, CURL::GetRedacted(m_url).c_str(), m_transfer->GetResponseCode());
+      return FAILED;
+    }
+    return CacheTexture() ? SUCCEEDED : FAILED;
+  }
+
   if (ShouldCancel(0, 0))
-    return false;
+    return FAILED;
   if (ShouldCancel(1, 0)) // HACK: second check is because we cancel the job in the first callback, but we don't detect it
-    return false;         //       until the second
+    return FAILED;        //       until the second
 
   // check whether we need cache the job anyway
   bool needsRecaching = false;
   std::string path(CTextureCache::GetInstance().CheckCachedImage(m_url, needsRecaching));
   if (!path.empty() && !needsRecaching)
-    return false;
-  return CacheTexture();
+    return FAILED;
+
+  // let the worker go on with other jobs while an online image is downloaded
+  std::string additional_info;
+  unsigned int width, height;
+  CPictureScalingAlgorithm::Algorithm scalingAlgorithm;
+  std::string image = DecodeImageURL(m_url, width, height, scalingAlgorithm, additional_info);
+  bool download = additional_info != "music" && URIUtils::IsHTTP(image);
+#if defined(HAS_OMXPLAYER)
+  // the hardware jpeg decoder reads the image itself
+  if (CSettings::GetInstance().GetBool(CSettings::SETTING_VIDEOPLAYER_ACCELERATEDJPEGS))
+    download = false;
+#endif
+  if (download)
+  {
+    m_transfer.reset(new XFILE::CCurlTransfer());
+    if (m_transfer->Start(image, [this]{ Wake(); }))
+      return SUSPENDED;
+    m_transfer.reset();
+  }
+  return CacheTexture() ? SUCCEEDED : FAILED;
+}
+
+void CTextureCacheJob::Abort()
+{
+  if (m_transfer)
+    m_transfer->Abort();
 }
 
 bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
@@ -83,15 +126,18 @@ bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
 
   m_details.updateable = additional_info != "music" && UpdateableURL(image);
 
+  // the download of the image, if the job did it
+  const XFILE::CCurlTransfer *transfer = m_transfer.get();
+
   // generate the hash
-  m_details.hash = GetImageHash(image);
+  m_details.hash = transfer ? GetImageHash(*transfer) : GetImageHash(image);
   if (m_details.hash.empty())
     return false;
   else if (m_details.hash == m_oldHash)
     return true;
 
 #if defined(HAS_OMXPLAYER)
-  if (CSettings::GetInstance().GetBool(CSettings::SETTING_VIDEOPLAYER_ACCELERATEDJPEGS) && COMXImage::CreateThumb(image, width, height, additional_info, CTextureCache::GetCachedPath(m_cachePath + ".jpg")))
+  if (!transfer && CSettings::GetInstance().GetBool(CSettings::SETTING_VIDEOPLAYER_ACCELERATEDJPEGS) && COMXImage::CreateThumb(image, width, height, additional_info, CTextureCache::GetCachedPath(m_cachePath + ".jpg")))
   {
     m_details.width = width;
     m_details.height = height;
@@ -102,7 +148,12 @@ bool CTextureCacheJob::CacheTexture(CBaseTexture **out_texture)
     return true;
   }
 #endif
-  CBaseTexture *texture = LoadImage(image, width, height, additional_info, true);
+  // no need to decode more than CPicture::CacheTexture() keeps
+  unsigned int maxHeight = std::max(g_advancedSettings.m_imageRes, g_advancedSettings.m_fanartRes);
+  unsigned int maxWidth = maxHeight * 16 / 9;
+  unsigned int loadWidth = width ? std::min(width, maxWidth) : maxWidth;
+  unsigned int loadHeight = height ? std::min(height, maxHeight) : maxHeight;
+  CBaseTexture *texture = LoadImage(image, loadWidth, loadHeight, additional_info, true, transfer);
   if (texture)
   {
     if (texture->HasAlpha())
@@ -191,7 +242,8 @@ std::string CTextureCacheJob::DecodeImageURL(const std::string &url, unsigned in
   return image;
 }
 
-CBaseTexture *CTextureCacheJob::LoadImage(const std::string &image, unsigned int width, unsigned int height, const std::string &additional_info, bool requirePixels)
+CBaseTexture *CTextureCacheJob::LoadImage(const std::string &image, unsigned int width, unsigned int height, const std::string &additional_info, bool requirePixels,
+                                         const XFILE::CCurlTransfer *transfer)
 {
   if (additional_info == "music")
   { // special case for embedded music images
@@ -202,12 +254,26 @@ CBaseTexture *CTextureCacheJob::LoadImage(const std::string &image, unsigned int
 
   // Validate file URL to see if it is an image
   CFileItem file(image, false);
-  file.FillInMimeType();
+  if (transfer)
+    file.SetMimeType(transfer->GetHttpHeader().GetMimeType());
+  else
+    file.FillInMimeType();
   if (!(file.IsPicture() && !(file.IsZIP() || file.IsRAR() || file.IsCBR() || file.IsCBZ() ))
       && !StringUtils::StartsWithNoCase(file.GetMimeType(), "image/") && !StringUtils::EqualsNoCase(file.GetMimeType(), "application/octet-stream")) // ignore non-pictures
     return NULL;
 
-  CBaseTexture *texture = CBaseTexture::LoadFromFile(image, width, height, requirePixels, file.GetMimeType());
+  CBaseTexture *texture;
+  if (transfer)
+  {
+    // the server may not have said what it is, go by the extension then
+    std::string mimeType = file.GetMimeType();
+    if (mimeType.empty() || StringUtils::EqualsNoCase(mimeType, "application/octet-stream"))
+      mimeType = CMime::GetMimeType(URIUtils::GetExtension(image));
+    const std::string &data = transfer->GetData();
+    texture = CBaseTexture::LoadFromFileInMemory((unsigned char *)data.data(), data.size(), mimeType, width, height);
+  }
+  else
+    texture = CBaseTexture::LoadFromFile(image, width, height, requirePixels, file.GetMimeType());
   if (!texture)
     return NULL;
 
@@ -248,6 +314,64 @@ std::string CTextureCacheJob::GetImageHash(const std::string &url)
   return "";
 }
 
+std::string CTextureCacheJob::GetImageHash(const XFILE::CCurlTransfer &transfer)
+{
+  int64_t time = 0;
+  CDateTime lastModified;
+  if (lastModified.SetFromRFC1123DateTime(transfer.GetHttpHeader().GetValue("last-modified")))
+  {
+    time_t modified;
+    lastModified.GetAsTime(modified);
+    time = modified;
+  }
+  if (transfer.GetData().empty())
+    return "";
+  return StringUtils::Format("d%" PRId64"s%" PRId64, time, (int64_t)transfer.GetData().size());
+}
+
+CTextureDDSJob::CTextureDDSJob(const std::string &original):
+  m_original(original)
+{
+}
+
+bool CTextureDDSJob::operator==(const CJob* job) const
+{
+  if (strcmp(job->GetType(),GetType()) == 0)
+  {
+    const CTextureDDSJob* ddsJob = dynamic_cast<const CTextureDDSJob*>(job);
+    if (ddsJob && ddsJob->m_original == m_original)
+      return true;
+  }
+  return false;
+}
+
+bool CTextureDDSJob::DoWork()
+{
+  if (URIUtils::HasExtension(m_original, ".dds"))
+    return false;
+
+  // the cached image is already scaled down, so load it at full size
+  CBaseTexture *texture = CBaseTexture::LoadFromFile(m_original, 0, 0, true);
+  if (!texture)
+    return false;
+
+  bool success = false;
+  if (texture->GetPixels())
+  {
+    // write to a temporary name first, so a reader never sees a partly written .dds
+    std::string ddsPath = URIUtils::ReplaceExtension(m_original, ".dds");
+    std::string tempPath = ddsPath + ".tmp";
+    CDDSImage dds;
+    success = dds.Create(texture->GetWidth(), texture->GetHeight(), texture->GetPitch(), texture->GetPixels(), texture->HasAlpha()) &&
+              dds.WriteFile(tempPath) &&
+              XFILE::CFile::Rename(tempPath, ddsPath);
+    if (!success && XFILE::CFile::Exists(tempPath))
+      XFILE::CFile::Delete(tempPath);
+  }
+  delete texture;
+  return success;
+}
+
 CTextureUseCountJob::CTextureUseCountJob(const std::vector<CTextureDetails> &textures) : m_textures(textures)
 {
 }
@@ -20,15 +20,21 @@
 
 #pragma once
 
+#include <memory>
 #include <stdint.h>
 #include <string>
 #include <vector>
 
 #include "pictures/PictureScalingAlgorithm.h"
-#include "utils/Job.h"
+#include "utils/AsyncJob.h"
 
 class CBaseTexture;
 
+namespace XFILE
+{
+  class CCurlTransfer;
+}
+
 /*!
  \ingroup textures
  \brief Simple class for passing texture detail around
@@ -60,9 +66,11 @@ public:
  \ingroup textures
  \brief Job class for caching textures
  
- Handles loading and caching of textures.
+ Handles loading and caching of textures. Images on http(s) servers are downloaded
+ without holding up a worker while the download is running, unless they are given to
+ the hardware jpeg decoder, which reads them itself.
  */
-class CTextureCacheJob : public CJob
+class CTextureCacheJob : public CAsyncJob
 {
 public:
   CTextureCacheJob(const std::string &url, const std::string &oldHash = "");
@@ -70,7 +78,8 @@ public:
 
   virtual const char* GetType() const { return kJobTypeCacheImage; };
   virtual bool operator==(const CJob *job) const;
-  virtual bool DoWork();
+  virtual STATUS Resume();
+  virtual void Abort();
 
   /*! \brief retrieve a hash for the given image
    Combines the size, ctime and mtime of the image file into a "unique" hash
@@ -92,6 +101,14 @@ private:
    */
   static std::string GetImageHash(const std::string &url);
 
+  /*! \brief retrieve a hash for a downloaded image
+   Combines the last modification time sent by the server and the size of the image, as a stat of
+   the url would
+   \param transfer the finished download of the image
+   \return a hash string for this image
+   */
+  static std::string GetImageHash(const XFILE::CCurlTransfer &transfer);
+
   /*! \brief Check whether a given URL represents an image that can be updated
    We currently don't check http:// and https:// URLs for updates, under the assumption that
    a image URL is much more likely to be static and the actual image at the URL is unlikely
@@ -120,11 +137,33 @@ private:
    \param width the desired maximum width.
    \param height the desired maximum height.
    \param additional_info extra info for loading, such as whether to flip horizontally.
+   \param transfer the finished download of the image to load it from, NULL to read the image file.
    \return a pointer to a CBaseTexture object, NULL if failed.
    */
-  static CBaseTexture *LoadImage(const std::string &image, unsigned int width, unsigned int height, const std::string &additional_info, bool requirePixels = false);
+  static CBaseTexture *LoadImage(const std::string &image, unsigned int width, unsigned int height, const std::string &additional_info, bool requirePixels = false,
+                                 const XFILE::CCurlTransfer *transfer = NULL);
 
   std::string    m_cachePath;
+  std::unique_ptr<XFILE::CCurlTransfer> m_transfer; ///< download of an image on a http(s) server, set once it was started
+};
+
+/*!
+ \ingroup textures
+ \brief Job class for compressing a cached image to DXT
+
+ Stores the .dds next to the cached image, so it can be uploaded to the GPU as is.
+ \sa CTextureCache::CheckCachedImage
+ */
+class CTextureDDSJob : public CJob
+{
+public:
+  CTextureDDSJob(const std::string &original);
+
+  virtual const char* GetType() const { return kJobTypeDDSCompress; };
+  virtual bool operator==(const CJob *job) const;
+  virtual bool DoWork();
+
+  std::string m_original;
 };
 
 /* \brief Job class for storing the use count of textures
@@ -46,6 +46,7 @@
   #pragma message("NOTICE: No audio sink for target platform.  Audio output will not be available.")
 #endif
 #include "Sinks/AESinkNULL.h"
+#include "Sinks/AESinkFILE.h"
 
 #include "utils/log.h"
 
@@ -85,6 +86,7 @@ void CAESinkFactory::ParseDevice(std::string &device, std::string &driver)
   #endif
 #endif
         driver == "PROFILER"    ||
+        driver == "FILE"        ||
         driver == "NULL")
       device = device.substr(pos + 1, device.length() - pos - 1);
     else
@@ -100,6 +102,8 @@ IAESink *CAESinkFactory::TrySink(std::string &driver, std::string &device, AEAud
 
   if (driver == "NULL")
     sink = new CAESinkNULL();
+  else if (driver == "FILE")
+    sink = new CAESinkFILE();
   else
   {
 #if defined(TARGET_WINDOWS)
@@ -25,6 +25,7 @@ using namespace ActiveAE;
 #include "ActiveAEStream.h"
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSP.h"
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSPProcess.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "cores/AudioEngine/Utils/AEStreamInfo.h"
 #include "cores/AudioEngine/AEResampleFactory.h"
@@ -38,6 +39,11 @@ using namespace ActiveAE;
 #define MAX_WATER_LEVEL 0.2   // buffered time after stream stages in seconds
 #define MAX_BUFFER_TIME 0.1   // max time of a buffer in seconds
 
+// low latency mode, the sink is asked for periods of LOW_LATENCY_BUFFER_TIME
+#define LOW_LATENCY_CACHE_LEVEL 0.08
+#define LOW_LATENCY_WATER_LEVEL 0.04
+#define LOW_LATENCY_BUFFER_TIME 0.01
+
 void CEngineStats::Reset(unsigned int sampleRate, bool pcm)
 {
   CSingleLock lock(m_lock);
@@ -90,6 +96,7 @@ void CEngineStats::AddStream(unsigned int streamid)
   stream.m_resampleRatio = 1.0;
   stream.m_syncError = 0;
   stream.m_syncState = CAESyncInfo::AESyncState::SYNC_OFF;
+  stream.m_latency = 0;
   m_streamStats.push_back(stream);
 }
 
@@ -99,6 +106,7 @@ void CEngineStats::RemoveStream(unsigned int streamid)
   {
     if (it->m_streamId == streamid)
     {
+      CLog::Log(LOGDEBUG, "CEngineStats::%s - stream %u had a latency of %d ms", __FUNCTION__, streamid, (int)(it->m_latency * 1000));
       m_streamStats.erase(it);
       return;
     }
@@ -136,6 +144,17 @@ void CEngineStats::UpdateStream(CActiveAEStream *stream)
       }
       str.m_bufferedTime = delay;
       stream->m_bufferedTime = 0;
+
+      // what data added now has ahead of it, smoothed over roughly the last second of updates
+      float latency = m_sinkDelay.delay + m_sinkLatency + delay / str.m_resampleRatio;
+      if (m_pcmOutput)
+        latency += (float)m_bufferedSamples / m_sinkSampleRate;
+      else
+        latency += (float)m_bufferedSamples * m_sinkFormat.m_streamInfo.GetDuration() / 1000;
+      if (str.m_latency == 0)
+        str.m_latency = latency;
+      else
+        str.m_latency += (latency - str.m_latency) * 0.05f;
       break;
     }
   }
@@ -214,7 +233,18 @@ float CEngineStats::GetCacheTime(CActiveAEStream *stream)
 
 float CEngineStats::GetCacheTotal(CActiveAEStream *stream)
 {
-  return MAX_CACHE_LEVEL + m_sinkCacheTotal;
+  return m_cacheLevel + m_sinkCacheTotal;
+}
+
+float CEngineStats::GetLatency(CActiveAEStream *stream)
+{
+  CSingleLock lock(m_lock);
+  for (auto &str : m_streamStats)
+  {
+    if (str.m_streamId == stream->m_id)
+      return str.m_latency;
+  }
+  return 0;
 }
 
 float CEngineStats::GetWaterLevel()
@@ -284,6 +314,10 @@ CActiveAE::CActiveAE() :
   m_sinkHasVolume = false;
   m_aeGUISoundForce = false;
   m_stats.Reset(44100, true);
+  m_stats.SetCacheLevel(MAX_CACHE_LEVEL);
+  m_cacheLevel = MAX_CACHE_LEVEL;
+  m_waterLevel = MAX_WATER_LEVEL;
+  m_bufferTime = MAX_BUFFER_TIME;
   m_streamIdGen = 0;
 }
 
@@ -1089,6 +1123,21 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
   AEAudioFormat oldInternalFormat = m_internalFormat;
   AEAudioFormat oldSinkRequestFormat = m_sinkRequestFormat;
 
+  if (m_settings.lowlatency)
+  {
+    m_cacheLevel = LOW_LATENCY_CACHE_LEVEL;
+    m_waterLevel = LOW_LATENCY_WATER_LEVEL;
+    m_bufferTime = LOW_LATENCY_BUFFER_TIME;
+  }
+  else
+  {
+    m_cacheLevel = MAX_CACHE_LEVEL;
+    m_waterLevel = MAX_WATER_LEVEL;
+    m_bufferTime = MAX_BUFFER_TIME;
+  }
+  m_stats.SetCacheLevel(m_cacheLevel);
+  SetPriority(m_settings.lowlatency ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_NORMAL);
+
   inputFormat = GetInputFormat(desiredFmt);
 
   m_sinkRequestFormat = inputFormat;
@@ -1099,6 +1148,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
   std::string driver;
   CAESinkFactory::ParseDevice(device, driver);
   if ((!CompareFormat(m_sinkRequestFormat, m_sinkFormat) && !CompareFormat(m_sinkRequestFormat, oldSinkRequestFormat)) ||
+      m_sinkRequestFormat.m_frames != oldSinkRequestFormat.m_frames ||
       m_currDevice.compare(device) != 0 ||
       m_settings.driver.compare(driver) != 0)
   {
@@ -1115,10 +1165,10 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
     {
       // limit buffer size in case of sink returns large buffer
       double buffertime = (double)m_sinkFormat.m_frames / m_sinkFormat.m_sampleRate;
-      if (buffertime > MAX_BUFFER_TIME)
+      if (buffertime > m_bufferTime)
       {
-        CLog::Log(LOGWARNING, "ActiveAE::%s - sink returned large buffer of %d ms, reducing to %d ms", __FUNCTION__, (int)(buffertime * 1000), (int)(MAX_BUFFER_TIME*1000));
-        m_sinkFormat.m_frames = MAX_BUFFER_TIME * m_sinkFormat.m_sampleRate;
+        CLog::Log(LOGWARNING, "ActiveAE::%s - sink returned large buffer of %d ms, reducing to %d ms", __FUNCTION__, (int)(buffertime * 1000), (int)(m_bufferTime*1000));
+        m_sinkFormat.m_frames = m_bufferTime * m_sinkFormat.m_sampleRate;
       }
     }
   }
@@ -1142,7 +1192,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
     inputFormat.m_frameSize = inputFormat.m_channelLayout.Count() *
                               (CAEUtil::DataFormatToBits(inputFormat.m_dataFormat) >> 3);
     m_silenceBuffers = new CActiveAEBufferPool(inputFormat);
-    m_silenceBuffers->Create(MAX_WATER_LEVEL*1000);
+    m_silenceBuffers->Create(m_waterLevel*1000);
     sinkInputFormat = inputFormat;
     m_internalFormat = inputFormat;
 
@@ -1222,7 +1272,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
         if (!m_encoderBuffers)
         {
           m_encoderBuffers = new CActiveAEBufferPool(format);
-          m_encoderBuffers->Create(MAX_WATER_LEVEL*1000);
+          m_encoderBuffers->Create(m_waterLevel*1000);
         }
       }
 
@@ -1267,7 +1317,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
 
         // create buffer pool
         (*it)->m_inputBuffers = new CActiveAEBufferPool((*it)->m_format);
-        (*it)->m_inputBuffers->Create(MAX_CACHE_LEVEL*1000);
+        (*it)->m_inputBuffers->Create(m_cacheLevel*1000);
         (*it)->m_streamSpace = (*it)->m_format.m_frameSize * (*it)->m_format.m_frames;
 
         // if input format does not follow ffmpeg channel mask, we may need to remap channels
@@ -1291,7 +1341,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
 
         if (useDSP && !(*it)->m_bypassDSP)
           (*it)->m_processingBuffers->SetExtraData((*it)->m_profile, (*it)->m_matrixEncoding, (*it)->m_audioServiceType);
-        (*it)->m_processingBuffers->Create(MAX_CACHE_LEVEL*1000, false, m_settings.stereoupmix, m_settings.normalizelevels, useDSP);
+        (*it)->m_processingBuffers->Create(m_cacheLevel*1000, false, m_settings.stereoupmix, m_settings.normalizelevels, useDSP);
 
         m_stats.SetDSP(useDSP);
       }
@@ -1351,22 +1401,12 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
   if (!m_sinkBuffers)
   {
     m_sinkBuffers = new CActiveAEBufferPoolResample(sinkInputFormat, m_sinkFormat, m_settings.resampleQuality);
-    m_sinkBuffers->Create(MAX_WATER_LEVEL*1000, true, false);
+    m_sinkBuffers->Create(m_waterLevel*1000, true, false);
   }
 
-  // reset gui sounds
+  // reset gui sounds, they keep converted versions of recent formats
   if (!CompareFormat(oldInternalFormat, m_internalFormat))
   {
-    if (m_settings.guisoundmode == AE_SOUND_ALWAYS ||
-       (m_settings.guisoundmode == AE_SOUND_IDLE && m_streams.empty()) ||
-       m_aeGUISoundForce)
-    {
-      std::vector<CActiveAESound*>::iterator it;
-      for (it = m_sounds.begin(); it != m_sounds.end(); ++it)
-      {
-        (*it)->SetConverted(false);
-      }
-    }
     m_sounds_playing.clear();
   }
 
@@ -1686,6 +1726,12 @@ void CActiveAE::ApplySettingsToFormat(AEAudioFormat &format, AudioSettings &sett
       format.m_channelLayout = AE_CH_LAYOUT_2_0;
     }
   }
+
+  // ask the sink for short periods in low latency mode, otherwise leave the period to the sink
+  if (format.m_dataFormat != AE_FMT_RAW && settings.lowlatency)
+    format.m_frames = format.m_sampleRate * LOW_LATENCY_BUFFER_TIME;
+  else
+    format.m_frames = 0;
 }
 
 bool CActiveAE::NeedReconfigureBuffers()
@@ -1711,6 +1757,7 @@ bool CActiveAE::NeedReconfigureSink()
   CAESinkFactory::ParseDevice(device, driver);
 
   if (!CompareFormat(newFormat, m_sinkFormat) ||
+      newFormat.m_frames != m_sinkRequestFormat.m_frames ||
       m_currDevice.compare(device) != 0 ||
       m_settings.driver.compare(driver) != 0)
     return true;
@@ -1854,7 +1901,7 @@ bool CActiveAE::RunStages()
       float buftime = (float)(*it)->m_inputBuffers->m_format.m_frames / (*it)->m_inputBuffers->m_format.m_sampleRate;
       if ((*it)->m_inputBuffers->m_format.m_dataFormat == AE_FMT_RAW)
         buftime = (*it)->m_inputBuffers->m_format.m_streamInfo.GetDuration() / 1000;
-      while ((time < MAX_CACHE_LEVEL || (*it)->m_streamIsBuffering) && !(*it)->m_inputBuffers->m_freeSamples.empty())
+      while ((time < m_cacheLevel || (*it)->m_streamIsBuffering) && !(*it)->m_inputBuffers->m_freeSamples.empty())
       {
         buffer = (*it)->m_inputBuffers->GetFreeBuffer();
         (*it)->m_processingSamples.push_back(buffer);
@@ -1893,7 +1940,7 @@ bool CActiveAE::RunStages()
     }
   }
 
-  if (m_stats.GetWaterLevel() < MAX_WATER_LEVEL &&
+  if (m_stats.GetWaterLevel() < m_waterLevel &&
      (m_mode != MODE_TRANSCODE || (m_encoderBuffers && !m_encoderBuffers->m_freeSamples.empty())))
   {
     // calculate sync error
@@ -1950,6 +1997,7 @@ bool CActiveAE::RunStages()
           allStreamsReady = false;
       }
 
+      const AEKernels &kernels = CAEKernels::Get();
       bool needClamp = false;
       for (it = m_streams.begin(); it != m_streams.end() && allStreamsReady; ++it)
       {
@@ -2032,15 +2080,7 @@ bool CActiveAE::RunStages()
 
               for(int j=0; j<out->pkt->planes; j++)
               {
-#if defined(HAVE_SSE) && defined(__SSE__)
-                CAEUtil::SSEMulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
-#else
-                float* fbuffer = (float*) out->pkt->data[j]+i*nb_floats;
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  fbuffer[k] *= volume;
-                }
-#endif
+                kernels.MulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
               }
             }
           }
@@ -2101,24 +2141,8 @@ bool CActiveAE::RunStages()
               {
                 float *dst = (float*)out->pkt->data[j]+i*nb_floats;
                 float *src = (float*)mix->pkt->data[j]+i*nb_floats;
-#if defined(HAVE_SSE) && defined(__SSE__)
-                CAEUtil::SSEMulAddArray(dst, src, volume, nb_floats);
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  if (fabs(dst[k]) > 1.0f)
-                  {
-                    needClamp = true;
-                    break;
-                  }
-                }
-#else
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  dst[k] += src[k] * volume;
-                  if (fabs(dst[k]) > 1.0f)
-                    needClamp = true;
-                }
-#endif
+                if (kernels.MulAddArray(dst, src, volume, nb_floats))
+                  needClamp = true;
               }
             }
             mix->Return();
@@ -2133,7 +2157,7 @@ bool CActiveAE::RunStages()
         int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
         for(int i=0; i<out->pkt->planes; i++)
         {
-          CAEUtil::ClampArray((float*)out->pkt->data[i], nb_floats);
+          kernels.ClampArray((float*)out->pkt->data[i], nb_floats);
         }
       }
 
@@ -2469,36 +2493,67 @@ void CActiveAE::MixSounds(CSoundPacket &dstSample)
   float *sample_buffer;
   int max_samples = dstSample.nb_samples;
 
+  const AEKernels &kernels = CAEKernels::Get();
   std::list<SoundState>::iterator it;
+  int channelMap[AE_CH_MAX];
   for (it = m_sounds_playing.begin(); it != m_sounds_playing.end(); )
   {
-    if (!it->sound->IsConverted())
-      ResampleSound(it->sound);
-    int available_samples = it->sound->GetSound(false)->nb_samples - it->samples_played;
-    int mix_samples = std::min(max_samples, available_samples);
-    int start = it->samples_played *
-                av_get_bytes_per_sample(it->sound->GetSound(false)->config.fmt) *
-                it->sound->GetSound(false)->config.channels /
-                it->sound->GetSound(false)->planes;
-
-    for(int j=0; j<dstSample.planes; j++)
+    volume = it->sound->GetVolume();
+    CSoundPacket *sound = it->sound->GetConvertedSound(m_internalFormat);
+    if (!sound && GetSoundChannelMap(it->sound, channelMap))
     {
-      volume = it->sound->GetVolume();
-      out = (float*)dstSample.data[j];
-      sample_buffer = (float*)(it->sound->GetSound(false)->data[j]+start);
-      int nb_floats = mix_samples * dstSample.config.channels / dstSample.planes;
-#if defined(HAVE_SSE) && defined(__SSE__)
-      CAEUtil::SSEMulAddArray(out, sample_buffer, volume, nb_floats);
-#else
-      for (int k = 0; k < nb_floats; ++k)
-        *out++ += *sample_buffer++ * volume;
-#endif
+      // mix the decoded float samples straight into the engine's channels
+      sound = it->sound->GetSound();
+      int channels = sound->config.channels;
+      int mix_samples = std::min(max_samples, sound->nb_samples - it->samples_played);
+      sample_buffer = (float*)sound->data[0] + it->samples_played * channels;
+
+      for (int c = 0; c < channels; c++)
+      {
+        int step = 1;
+        if (dstSample.planes > 1)
+          out = (float*)dstSample.data[channelMap[c]];
+        else
+        {
+          out = (float*)dstSample.data[0] + channelMap[c];
+          step = dstSample.config.channels;
+        }
+        for (int i = 0; i < mix_samples; i++)
+          out[i * step] += sample_buffer[i * channels + c] * volume;
+      }
+
+      it->samples_played += mix_samples;
     }
+    else
+    {
+      if (!sound && ResampleSound(it->sound))
+        sound = it->sound->GetConvertedSound(m_internalFormat);
+      if (!sound)
+      {
+        it = m_sounds_playing.erase(it);
+        continue;
+      }
 
-    it->samples_played += mix_samples;
+      int available_samples = sound->nb_samples - it->samples_played;
+      int mix_samples = std::min(max_samples, available_samples);
+      int start = it->samples_played *
+                  av_get_bytes_per_sample(sound->config.fmt) *
+                  sound->config.channels /
+                  sound->planes;
+
+      for(int j=0; j<dstSample.planes; j++)
+      {
+        out = (float*)dstSample.data[j];
+        sample_buffer = (float*)(sound->data[j]+start);
+        int nb_floats = mix_samples * dstSample.config.channels / dstSample.planes;
+        kernels.MulAddArray(out, sample_buffer, volume, nb_floats);
+      }
+
+      it->samples_played += mix_samples;
+    }
 
     // no more frames, so remove it from the list
-    if (it->samples_played >= it->sound->GetSound(false)->nb_samples)
+    if (it->samples_played >= sound->nb_samples)
     {
       it = m_sounds_playing.erase(it);
       continue;
@@ -2518,13 +2573,7 @@ void CActiveAE::Deamplify(CSoundPacket &dstSample)
     for(int j=0; j<dstSample.planes; j++)
     {
       buffer = (float*)dstSample.data[j];
-#if defined(HAVE_SSE) && defined(__SSE__)
-      CAEUtil::SSEMulArray(buffer, volume, nb_floats);
-#else
-      float *fbuffer = buffer;
-      for (int i = 0; i < nb_floats; i++)
-        *fbuffer++ *= volume;
-#endif
+      CAEKernels::Get().MulArray(buffer, volume, nb_floats);
     }
   }
 }
@@ -2562,6 +2611,7 @@ void CActiveAE::LoadSettings()
   m_settings.atempoThreshold = CSettings::GetInstance().GetInt(CSettings::SETTING_AUDIOOUTPUT_ATEMPOTHRESHOLD) / 100.0;
   m_settings.streamNoise = CSettings::GetInstance().GetBool(CSettings::SETTING_AUDIOOUTPUT_STREAMNOISE);
   m_settings.silenceTimeout = CSettings::GetInstance().GetInt(CSettings::SETTING_AUDIOOUTPUT_STREAMSILENCE) * 60000;
+  m_settings.lowlatency = CSettings::GetInstance().GetBool(CSettings::SETTING_AUDIOOUTPUT_LOWLATENCY);
 }
 
 bool CActiveAE::Initialize()
@@ -2625,7 +2675,8 @@ void CActiveAE::OnSettingsChange(const std::string& setting)
       setting == CSettings::SETTING_AUDIOOUTPUT_SAMPLERATE             ||
       setting == CSettings::SETTING_AUDIOOUTPUT_MAINTAINORIGINALVOLUME ||
       setting == CSettings::SETTING_AUDIOOUTPUT_GUISOUNDMODE           ||
-      setting == CSettings::SETTING_AUDIOOUTPUT_STREAMNOISE)
+      setting == CSettings::SETTING_AUDIOOUTPUT_STREAMNOISE            ||
+      setting == CSettings::SETTING_AUDIOOUTPUT_LOWLATENCY)
   {
     m_controlPort.SendOutMessage(CActiveAEControlProtocol::RECONFIGURE);
   }
@@ -3040,10 +3091,10 @@ IAESound *CActiveAE::MakeSound(const std::string& file)
           int samples = fileSize / av_get_bytes_per_sample(dec_ctx->sample_fmt) / config.channels;
           config.fmt = dec_ctx->sample_fmt;
           config.bits_per_sample = dec_ctx->bits_per_coded_sample;
-          sound->InitSound(true, config, samples);
+          sound->InitSound(config, samples);
           init = true;
         }
-        sound->StoreSound(true, decoded_frame->extended_data,
+        sound->StoreSound(decoded_frame->extended_data,
                           decoded_frame->nb_samples, decoded_frame->linesize[0]);
       }
       av_packet_unref(&avpkt);
@@ -3061,6 +3112,10 @@ IAESound *CActiveAE::MakeSound(const std::string& file)
 
   sound->Finish();
 
+  // keep the decoded samples as float, converting them for a new engine format is then
+  // at most a resample and often they can be mixed right in
+  ConvertSoundToFloat(sound);
+
   // register sound
   m_dataPort.SendOutMessage(CActiveAEDataProtocol::NEWSOUND, &sound, sizeof(CActiveAESound*));
 
@@ -3094,10 +3149,14 @@ void CActiveAE::ResampleSounds()
       !m_aeGUISoundForce)
     return;
 
+  if (m_mode == MODE_RAW || m_internalFormat.m_dataFormat == AE_FMT_INVALID)
+    return;
+
+  int channelMap[AE_CH_MAX];
   std::vector<CActiveAESound*>::iterator it;
   for (it = m_sounds.begin(); it != m_sounds.end(); ++it)
   {
-    if (!(*it)->IsConverted())
+    if (!(*it)->GetConvertedSound(m_internalFormat) && !GetSoundChannelMap(*it, channelMap))
     {
       ResampleSound(*it);
       // only do one sound, then yield to main loop
@@ -3106,6 +3165,88 @@ void CActiveAE::ResampleSounds()
   }
 }
 
+bool CActiveAE::GetSoundChannelMap(CActiveAESound *sound, int *channelMap)
+{
+  CSoundPacket *orig = sound->GetSound();
+  if (!orig || orig->config.fmt != AV_SAMPLE_FMT_FLT ||
+      orig->config.sample_rate != (int)m_internalFormat.m_sampleRate)
+    return false;
+
+  if (m_internalFormat.m_dataFormat != AE_FMT_FLOAT && m_internalFormat.m_dataFormat != AE_FMT_FLOATP)
+    return false;
+
+  // a mono sound placed on a single channel goes through the resampler's remapping
+  if (orig->config.channels == 1 && sound->GetChannel() != AE_CH_NULL)
+    return false;
+
+  // every channel of the sound needs its own channel in the engine format
+  CAEChannelInfo layout = CAEUtil::GetAEChannelLayout(orig->config.channel_layout);
+  if ((int)layout.Count() != orig->config.channels)
+    return false;
+
+  for (unsigned int c = 0; c < layout.Count(); c++)
+  {
+    channelMap[c] = -1;
+    for (unsigned int out = 0; out < m_internalFormat.m_channelLayout.Count(); out++)
+    {
+      if (m_internalFormat.m_channelLayout[out] == layout[c])
+      {
+        channelMap[c] = out;
+        break;
+      }
+    }
+    if (channelMap[c] < 0)
+      return false;
+  }
+  return true;
+}
+
+bool CActiveAE::ConvertSoundToFloat(CActiveAESound *sound)
+{
+  CSoundPacket *orig = sound->GetSound();
+  if (!orig || orig->config.fmt == AV_SAMPLE_FMT_FLT)
+    return false;
+
+  SampleConfig config = orig->config;
+  config.fmt = AV_SAMPLE_FMT_FLT;
+  config.bits_per_sample = CAEUtil::DataFormatToUsedBits(AE_FMT_FLOAT);
+  config.dither_bits = CAEUtil::DataFormatToDitherBits(AE_FMT_FLOAT);
+
+  IAEResample *resampler = CAEResampleFactory::Create(AERESAMPLEFACTORY_QUICK_RESAMPLE);
+  resampler->Init(config.channel_layout,
+                  config.channels,
+                  config.sample_rate,
+                  config.fmt,
+                  config.bits_per_sample,
+                  config.dither_bits,
+                  orig->config.channel_layout,
+                  orig->config.channels,
+                  orig->config.sample_rate,
+                  orig->config.fmt,
+                  orig->config.bits_per_sample,
+                  orig->config.dither_bits,
+                  false,
+                  false,
+                  NULL,
+                  AE_QUALITY_MID,
+                  false);
+
+  CSoundPacket *converted = new CSoundPacket(config, orig->nb_samples);
+  converted->nb_samples = resampler->Resample(converted->data, orig->nb_samples,
+                                              orig->data, orig->nb_samples, 1.0);
+  delete resampler;
+
+  if (converted->nb_samples != orig->nb_samples)
+  {
+    CLog::Log(LOGERROR, "CActiveAE::%s - failed to convert sound", __FUNCTION__);
+    delete converted;
+    return false;
+  }
+
+  sound->SetSound(converted);
+  return true;
+}
+
 bool CActiveAE::ResampleSound(CActiveAESound *sound)
 {
   SampleConfig orig_config, dst_config;
@@ -3115,10 +3256,11 @@ bool CActiveAE::ResampleSound(CActiveAESound *sound)
   if (m_mode == MODE_RAW || m_internalFormat.m_dataFormat == AE_FMT_INVALID)
     return false;
 
-  if (!sound->GetSound(true))
+  CSoundPacket *orig = sound->GetSound();
+  if (!orig)
     return false;
 
-  orig_config = sound->GetSound(true)->config;
+  orig_config = orig->config;
 
   dst_config.channel_layout = CAEUtil::GetAVChannelLayout(m_internalFormat.m_channelLayout);
   dst_config.channels = m_internalFormat.m_channelLayout.Count();
@@ -3129,7 +3271,7 @@ bool CActiveAE::ResampleSound(CActiveAESound *sound)
 
   AEChannel testChannel = sound->GetChannel();
   CAEChannelInfo outChannels;
-  if (sound->GetSound(true)->config.channels == 1 && testChannel != AE_CH_NULL)
+  if (orig->config.channels == 1 && testChannel != AE_CH_NULL)
   {
     for (unsigned int out=0; out < m_internalFormat.m_channelLayout.Count(); out++)
     {
@@ -3161,25 +3303,24 @@ bool CActiveAE::ResampleSound(CActiveAESound *sound)
                   m_settings.resampleQuality,
                   false);
 
-  dst_samples = resampler->CalcDstSampleCount(sound->GetSound(true)->nb_samples,
+  dst_samples = resampler->CalcDstSampleCount(orig->nb_samples,
                                               m_internalFormat.m_sampleRate,
                                               orig_config.sample_rate);
 
-  dst_buffer = sound->InitSound(false, dst_config, dst_samples);
+  dst_buffer = sound->InitConvertedSound(m_internalFormat, dst_config, dst_samples);
   if (!dst_buffer)
   {
     delete resampler;
     return false;
   }
   int samples = resampler->Resample(dst_buffer, dst_samples,
-                                    sound->GetSound(true)->data,
-                                    sound->GetSound(true)->nb_samples,
+                                    orig->data,
+                                    orig->nb_samples,
                                     1.0);
 
-  sound->GetSound(false)->nb_samples = samples;
+  sound->GetConvertedSound(m_internalFormat)->nb_samples = samples;
 
   delete resampler;
-  sound->SetConverted(true);
   return true;
 }
 
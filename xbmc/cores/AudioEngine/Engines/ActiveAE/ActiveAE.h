@@ -74,6 +74,7 @@ struct AudioSettings
   double atempoThreshold;
   bool streamNoise;
   int silenceTimeout;
+  bool lowlatency;
 };
 
 class CActiveAEControlProtocol : public Protocol
@@ -191,18 +192,21 @@ public:
   void GetSyncInfo(CAESyncInfo& info, CActiveAEStream *stream);
   float GetCacheTime(CActiveAEStream *stream);
   float GetCacheTotal(CActiveAEStream *stream);
+  float GetLatency(CActiveAEStream *stream);
   float GetWaterLevel();
   void SetSuspended(bool state);
   void SetDSP(bool state);
   void SetCurrentSinkFormat(AEAudioFormat SinkFormat);
   void SetSinkCacheTotal(float time) { m_sinkCacheTotal = time; }
   void SetSinkLatency(float time) { m_sinkLatency = time; }
+  void SetCacheLevel(float time) { m_cacheLevel = time; }
   bool IsSuspended();
   bool HasDSP();
   AEAudioFormat GetCurrentSinkFormat();
 protected:
   float m_sinkCacheTotal;
   float m_sinkLatency;
+  float m_cacheLevel;
   int m_bufferedSamples;
   unsigned int m_sinkSampleRate;
   AEDelayStatus m_sinkDelay;
@@ -219,6 +223,7 @@ protected:
     double m_syncError;
     unsigned int m_errorTime;
     CAESyncInfo::AESyncState m_syncState;
+    float m_latency;
   };
   std::vector<StreamStats> m_streamStats;
 };
@@ -286,6 +291,7 @@ protected:
   void GetSyncInfo(CAESyncInfo& info, CActiveAEStream *stream) { m_stats.GetSyncInfo(info, stream); }
   float GetCacheTime(CActiveAEStream *stream) { return m_stats.GetCacheTime(stream); }
   float GetCacheTotal(CActiveAEStream *stream) { return m_stats.GetCacheTotal(stream); }
+  float GetLatency(CActiveAEStream *stream) { return m_stats.GetLatency(stream); }
   void FlushStream(CActiveAEStream *stream);
   void PauseStream(CActiveAEStream *stream, bool pause);
   void StopSound(CActiveAESound *sound);
@@ -326,6 +332,8 @@ protected:
 
   void ResampleSounds();
   bool ResampleSound(CActiveAESound *sound);
+  bool GetSoundChannelMap(CActiveAESound *sound, int *channelMap);
+  bool ConvertSoundToFloat(CActiveAESound *sound);
   void MixSounds(CSoundPacket &dstSample);
   void Deamplify(CSoundPacket &dstSample);
 
@@ -363,6 +371,11 @@ protected:
   IAEEncoder *m_encoder;
   std::string m_currDevice;
 
+  // buffering in seconds, depends on low latency mode
+  float m_cacheLevel;
+  float m_waterLevel;
+  float m_bufferTime;
+
   // buffers
   CActiveAEBufferPoolResample *m_sinkBuffers;
   CActiveAEBufferPoolResample *m_vizBuffers;
@@ -18,6 +18,7 @@
  *
  */
 
+#include "cores/AudioEngine/Utils/AEKernels.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #include "ActiveAEResampleFFMPEG.h"
 #include "utils/log.h"
@@ -34,6 +35,8 @@ CActiveAEResampleFFMPEG::CActiveAEResampleFFMPEG()
 {
   m_pContext = NULL;
   m_doesResample = false;
+  m_convertOnly = false;
+  m_convertIdentity = false;
 }
 
 CActiveAEResampleFFMPEG::~CActiveAEResampleFFMPEG()
@@ -175,9 +178,117 @@ bool CActiveAEResampleFFMPEG::Init(uint64_t dst_chan_layout, int dst_channels, i
     CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Init - init resampler failed");
     return false;
   }
+
+  InitConvert(upmix, remapLayout);
   return true;
 }
 
+void CActiveAEResampleFFMPEG::InitConvert(bool upmix, CAEChannelInfo *remapLayout)
+{
+  m_convertOnly = false;
+  m_convertIdentity = true;
+
+  AVSampleFormat dst_fmt = av_get_packed_sample_fmt(m_dst_fmt);
+  if (m_doesResample || av_get_packed_sample_fmt(m_src_fmt) != AV_SAMPLE_FMT_FLT ||
+      (dst_fmt != AV_SAMPLE_FMT_S16 && dst_fmt != AV_SAMPLE_FMT_S32) ||
+      m_dst_channels > AE_CH_MAX || (upmix && m_src_channels == 2 && m_dst_channels > 2))
+    return;
+
+  if (remapLayout)
+  {
+    // the sink remap only picks channels, find the one of every output
+    for (int out = 0; out < m_dst_channels; out++)
+    {
+      m_convertMap[out] = -1;
+      for (int in = 0; in < AE_CH_MAX; in++)
+      {
+        if (m_rematrix[out][in] != 0.0)
+          m_convertMap[out] = in;
+      }
+      if (m_convertMap[out] >= m_src_channels)
+        return;
+      m_convertIdentity &= m_convertMap[out] == out;
+    }
+    m_convertIdentity &= m_src_channels == m_dst_channels;
+  }
+  else if (m_src_chan_layout == m_dst_chan_layout && m_src_channels == m_dst_channels)
+  {
+    for (int out = 0; out < m_dst_channels; out++)
+      m_convertMap[out] = out;
+  }
+  else
+    return;
+
+  // picking channels out of packed input isn't worth it
+  if (!av_sample_fmt_is_planar(m_src_fmt) && (!m_convertIdentity || av_sample_fmt_is_planar(m_dst_fmt)))
+    return;
+
+  m_convertOnly = true;
+}
+
+namespace
+{
+template<typename T>
+void Interleave(T *dst, const T *src, int channel, int channels, int samples)
+{
+  dst += channel;
+  for (int i = 0; i < samples; i++, dst += channels)
+    *dst = src[i];
+}
+}
+
+void CActiveAEResampleFFMPEG::Convert(uint8_t **dst_buffer, uint8_t **src_buffer, int samples)
+{
+  const AEKernels &kernels = CAEKernels::Get();
+  bool s16 = av_get_packed_sample_fmt(m_dst_fmt) == AV_SAMPLE_FMT_S16;
+  bool dstPlanar = av_sample_fmt_is_planar(m_dst_fmt);
+
+  // same layout in and out converts in one go
+  if (!av_sample_fmt_is_planar(m_src_fmt))
+  {
+    if (s16)
+      kernels.FloatToS16((int16_t*)dst_buffer[0], (const float*)src_buffer[0], samples * m_dst_channels);
+    else
+      kernels.FloatToS32((int32_t*)dst_buffer[0], (const float*)src_buffer[0], samples * m_dst_channels);
+    return;
+  }
+
+  if (!dstPlanar)
+    m_convertBuffer.resize(samples);
+
+  for (int ch = 0; ch < m_dst_channels; ch++)
+  {
+    int in = m_convertMap[ch];
+    if (dstPlanar)
+    {
+      if (in < 0)
+        memset(dst_buffer[ch], 0, samples * (s16 ? sizeof(int16_t) : sizeof(int32_t)));
+      else if (s16)
+        kernels.FloatToS16((int16_t*)dst_buffer[ch], (const float*)src_buffer[in], samples);
+      else
+        kernels.FloatToS32((int32_t*)dst_buffer[ch], (const float*)src_buffer[in], samples);
+    }
+    else if (s16)
+    {
+      int16_t *tmp = (int16_t*)m_convertBuffer.data();
+      if (in < 0)
+        memset(tmp, 0, samples * sizeof(int16_t));
+      else
+        kernels.FloatToS16(tmp, (const float*)src_buffer[in], samples);
+      Interleave((int16_t*)dst_buffer[0], tmp, ch, m_dst_channels, samples);
+    }
+    else
+    {
+      int32_t *tmp = (int32_t*)m_convertBuffer.data();
+      if (in < 0)
+        memset(tmp, 0, samples * sizeof(int32_t));
+      else
+        kernels.FloatToS32(tmp, (const float*)src_buffer[in], samples);
+      Interleave((int32_t*)dst_buffer[0], tmp, ch, m_dst_channels, samples);
+    }
+  }
+}
+
 int CActiveAEResampleFFMPEG::Resample(uint8_t **dst_buffer, int dst_samples, uint8_t **src_buffer, int src_samples, double ratio)
 {
   int delta = 0;
@@ -198,11 +309,22 @@ int CActiveAEResampleFFMPEG::Resample(uint8_t **dst_buffer, int dst_samples, uin
     }
   }
 
-  int ret = swr_convert(m_pContext, dst_buffer, dst_samples, (const uint8_t**)src_buffer, src_samples);
-  if (ret < 0)
+  int ret;
+  // nothing to resample and swresample holds no samples back
+  if (m_convertOnly && !m_doesResample && src_buffer && src_samples <= dst_samples &&
+      swr_get_delay(m_pContext, m_src_rate) == 0)
   {
-    CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Resample - resample failed");
-    return -1;
+    Convert(dst_buffer, src_buffer, src_samples);
+    ret = src_samples;
+  }
+  else
+  {
+    ret = swr_convert(m_pContext, dst_buffer, dst_samples, (const uint8_t**)src_buffer, src_samples);
+    if (ret < 0)
+    {
+      CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Resample - resample failed");
+      return -1;
+    }
   }
 
   // special handling for S24 formats which are carried in S32
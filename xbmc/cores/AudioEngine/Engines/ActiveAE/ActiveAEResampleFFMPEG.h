@@ -24,6 +24,8 @@
 #include "cores/AudioEngine/Interfaces/AE.h"
 #include "cores/AudioEngine/Interfaces/AEResample.h"
 
+#include <vector>
+
 extern "C" {
 #include "libavutil/samplefmt.h"
 }
@@ -49,6 +51,9 @@ public:
   int GetDstBufferSize(int samples);
 
 protected:
+  void InitConvert(bool upmix, CAEChannelInfo *remapLayout);
+  void Convert(uint8_t **dst_buffer, uint8_t **src_buffer, int samples);
+
   bool m_loaded;
   bool m_doesResample;
   uint64_t m_src_chan_layout, m_dst_chan_layout;
@@ -59,6 +64,12 @@ protected:
   int m_src_dither_bits, m_dst_dither_bits;
   SwrContext *m_pContext;
   double m_rematrix[AE_CH_MAX][AE_CH_MAX];
+
+  // float to integer conversion without resampling bypasses swresample
+  bool m_convertOnly;
+  bool m_convertIdentity;
+  int m_convertMap[AE_CH_MAX];
+  std::vector<float> m_convertBuffer;
 };
 
 }
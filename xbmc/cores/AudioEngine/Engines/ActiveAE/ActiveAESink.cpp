@@ -268,6 +268,9 @@ void CActiveAESink::StateMachine(int signal, Protocol *port, Message *msg)
 
           if (!m_extError)
           {
+            // the engine requests a period size only in low latency mode
+            SetPriority(m_requestedFormat.m_frames ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_ABOVE_NORMAL);
+
             SinkReply reply;
             reply.format = m_sinkFormat;
             //! @todo
@@ -42,17 +42,16 @@ CActiveAESound::CActiveAESound(const std::string &filename) :
   m_channel        (AE_CH_NULL)
 {
   m_orig_sound = NULL;
-  m_dst_sound = NULL;
   m_pFile = NULL;
   m_isSeekPossible = false;
   m_fileSize = 0;
-  m_isConverted = false;
 }
 
 CActiveAESound::~CActiveAESound()
 {
   delete m_orig_sound;
-  delete m_dst_sound;
+  for (auto &converted : m_converted)
+    delete converted.sound;
   Finish();
 }
 
@@ -72,56 +71,82 @@ bool CActiveAESound::IsPlaying()
   return false;
 }
 
-uint8_t** CActiveAESound::InitSound(bool orig, SampleConfig config, int nb_samples)
+uint8_t** CActiveAESound::InitSound(SampleConfig config, int nb_samples)
 {
-  CSoundPacket **info;
-  if (orig)
-    info = &m_orig_sound;
-  else
-    info = &m_dst_sound;
+  delete m_orig_sound;
+  m_orig_sound = new CSoundPacket(config, nb_samples);
+  m_orig_sound->nb_samples = 0;
 
-  delete *info;
-  *info = new CSoundPacket(config, nb_samples);
+  for (auto &converted : m_converted)
+    delete converted.sound;
+  m_converted.clear();
 
-  (*info)->nb_samples = 0;
-  m_isConverted = false;
-  return (*info)->data;
+  return m_orig_sound->data;
 }
 
-bool CActiveAESound::StoreSound(bool orig, uint8_t **buffer, int samples, int linesize)
+bool CActiveAESound::StoreSound(uint8_t **buffer, int samples, int linesize)
 {
-  CSoundPacket **info;
-  if (orig)
-    info = &m_orig_sound;
-  else
-    info = &m_dst_sound;
+  CSoundPacket *info = m_orig_sound;
 
-  if ((*info)->nb_samples + samples > (*info)->max_nb_samples)
+  if (info->nb_samples + samples > info->max_nb_samples)
   {
     CLog::Log(LOGERROR, "CActiveAESound::StoreSound - exceeded max samples");
     return false;
   }
 
-  int bytes_to_copy = samples * (*info)->bytes_per_sample * (*info)->config.channels;
-  bytes_to_copy /= (*info)->planes;
-  int start = (*info)->nb_samples * (*info)->bytes_per_sample * (*info)->config.channels;
-  start /= (*info)->planes;
+  int bytes_to_copy = samples * info->bytes_per_sample * info->config.channels;
+  bytes_to_copy /= info->planes;
+  int start = info->nb_samples * info->bytes_per_sample * info->config.channels;
+  start /= info->planes;
 
-  for (int i=0; i<(*info)->planes; i++)
+  for (int i=0; i<info->planes; i++)
   {
-    memcpy((*info)->data[i]+start, buffer[i], bytes_to_copy);
+    memcpy(info->data[i]+start, buffer[i], bytes_to_copy);
   }
-  (*info)->nb_samples += samples;
+  info->nb_samples += samples;
 
   return true;
 }
 
-CSoundPacket *CActiveAESound::GetSound(bool orig)
+void CActiveAESound::SetSound(CSoundPacket *sound)
 {
-  if (orig)
-    return m_orig_sound;
-  else
-    return m_dst_sound;
+  delete m_orig_sound;
+  m_orig_sound = sound;
+}
+
+CSoundPacket *CActiveAESound::GetConvertedSound(const AEAudioFormat &format)
+{
+  for (auto it = m_converted.begin(); it != m_converted.end(); ++it)
+  {
+    if (it->channel == m_channel &&
+        it->format.m_dataFormat == format.m_dataFormat &&
+        it->format.m_sampleRate == format.m_sampleRate &&
+        it->format.m_channelLayout == format.m_channelLayout)
+    {
+      if (it != m_converted.begin())
+        m_converted.splice(m_converted.begin(), m_converted, it);
+      return m_converted.front().sound;
+    }
+  }
+  return NULL;
+}
+
+uint8_t** CActiveAESound::InitConvertedSound(const AEAudioFormat &format, SampleConfig config, int nb_samples)
+{
+  if (m_converted.size() >= SOUND_CACHE_SIZE)
+  {
+    delete m_converted.back().sound;
+    m_converted.pop_back();
+  }
+
+  ConvertedSound converted;
+  converted.format = format;
+  converted.channel = m_channel;
+  converted.sound = new CSoundPacket(config, nb_samples);
+  converted.sound->nb_samples = 0;
+  m_converted.push_front(converted);
+
+  return converted.sound->data;
 }
 
 bool CActiveAESound::Prepare()
@@ -20,8 +20,14 @@
  */
 
 #include "cores/AudioEngine/Interfaces/AESound.h"
+#include "cores/AudioEngine/Utils/AEAudioFormat.h"
 #include "filesystem/File.h"
 
+#include <list>
+
+// number of formats a sound keeps converted versions for
+#define SOUND_CACHE_SIZE 3
+
 class DllAvUtil;
 
 namespace ActiveAE
@@ -42,12 +48,20 @@ public:
   virtual void SetVolume(float volume) { m_volume = std::max(0.0f, std::min(1.0f, volume)); }
   virtual float GetVolume() { return m_volume; }
 
-  uint8_t** InitSound(bool orig, SampleConfig config, int nb_samples);
-  bool StoreSound(bool orig, uint8_t **buffer, int samples, int linesize);
-  CSoundPacket *GetSound(bool orig);
+  uint8_t** InitSound(SampleConfig config, int nb_samples);
+  bool StoreSound(uint8_t **buffer, int samples, int linesize);
+  void SetSound(CSoundPacket *sound);
+  CSoundPacket *GetSound() { return m_orig_sound; }
+
+  /*!
+   \brief The sound converted to format for the current channel, NULL if it isn't cached
+   */
+  CSoundPacket *GetConvertedSound(const AEAudioFormat &format);
 
-  bool IsConverted() { return m_isConverted; }
-  void SetConverted(bool state) { m_isConverted = state; }
+  /*!
+   \brief Add a converted version for format, drops the least recently used one
+   */
+  uint8_t** InitConvertedSound(const AEAudioFormat &format, SampleConfig config, int nb_samples);
 
   bool Prepare();
   void Finish();
@@ -67,8 +81,13 @@ protected:
   AEChannel m_channel;
 
   CSoundPacket *m_orig_sound;
-  CSoundPacket *m_dst_sound;
 
-  bool m_isConverted;
+  struct ConvertedSound
+  {
+    AEAudioFormat format;
+    AEChannel channel;
+    CSoundPacket *sound;
+  };
+  std::list<ConvertedSound> m_converted; // most recently used first
 };
 }
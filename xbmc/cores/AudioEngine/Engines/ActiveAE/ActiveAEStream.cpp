@@ -376,6 +376,11 @@ double CActiveAEStream::GetCacheTotal()
   return AE.GetCacheTotal(this);
 }
 
+double CActiveAEStream::GetLatency()
+{
+  return AE.GetLatency(this);
+}
+
 void CActiveAEStream::Pause()
 {
   AE.PauseStream(this, true);
@@ -0,0 +1,448 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ActiveAEOfflineHarness.h"
+#include "cores/AudioEngine/Engines/ActiveAE/ActiveAEBuffer.h"
+#include "cores/AudioEngine/Sinks/AESinkFILE.h"
+#include "cores/AudioEngine/Utils/AEKernels.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/log.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <inttypes.h>
+#include <time.h>
+
+using namespace ActiveAE;
+
+// like the engine's cache level
+#define OFFLINE_BUFFER_TIME 400
+
+namespace
+{
+int64_t GetThreadCpuTime()
+{
+#if defined(TARGET_POSIX) && defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+  return -1;
+}
+
+int64_t ElapsedUsec(int64_t start)
+{
+  return (CurrentHostCounter() - start) * 1000000 / CurrentHostFrequency();
+}
+
+class CStageTimer
+{
+public:
+  CStageTimer(int64_t &time, int64_t &cpu)
+    : m_time(time)
+    , m_cpu(cpu)
+    , m_start(CurrentHostCounter())
+    , m_cpuStart(cpu < 0 ? -1 : GetThreadCpuTime())
+  {
+  }
+
+  ~CStageTimer()
+  {
+    m_time += ElapsedUsec(m_start);
+    if (m_cpuStart >= 0)
+      m_cpu += GetThreadCpuTime() - m_cpuStart;
+  }
+
+private:
+  int64_t &m_time;
+  int64_t &m_cpu;
+  int64_t m_start;
+  int64_t m_cpuStart;
+};
+}
+
+CActiveAEOfflineHarness::CActiveAEOfflineHarness()
+  : m_quality(AE_QUALITY_MID)
+  , m_dsp(false)
+{
+  memset(&m_result, 0, sizeof(m_result));
+}
+
+CActiveAEOfflineHarness::~CActiveAEOfflineHarness()
+{
+  Release();
+}
+
+const char* CActiveAEOfflineHarness::StageToStr(Stage stage)
+{
+  switch (stage)
+  {
+    case STAGE_RESAMPLE: return "resample";
+    case STAGE_ATEMPO:   return "atempo";
+    case STAGE_MIX:      return "mix";
+    case STAGE_OUTPUT:   return "output";
+    case STAGE_SINK:     return "sink";
+    default:             return "unknown";
+  }
+}
+
+bool CActiveAEOfflineHarness::Run(unsigned int duration)
+{
+  Release();
+
+  memset(&m_result, 0, sizeof(m_result));
+  int64_t cpu = GetThreadCpuTime() < 0 ? -1 : 0;
+  for (int i = 0; i < STAGE_MAX; i++)
+    m_result.stageCpu[i] = cpu;
+
+  if (m_streams.empty())
+  {
+    CLog::Log(LOGERROR, "CActiveAEOfflineHarness::%s - no streams", __FUNCTION__);
+    return false;
+  }
+
+  // the sink has the last word on the format, like when the engine opens it
+  m_outputFormat = m_sinkFormat;
+  std::string device = m_outputFile;
+  m_sink.reset(new CAESinkFILE(false));
+  if (!m_sink->Initialize(m_outputFormat, device))
+  {
+    m_sink.reset();
+    return false;
+  }
+
+  // the engine mixes float in the layout and rate of the sink
+  m_internalFormat = m_outputFormat;
+  m_internalFormat.m_dataFormat = AE_IS_PLANAR(m_outputFormat.m_dataFormat) ? AE_FMT_FLOATP : AE_FMT_FLOAT;
+  m_internalFormat.m_channelLayout = CAEUtil::GetAEChannelLayout(CAEUtil::GetAVChannelLayout(m_outputFormat.m_channelLayout));
+  m_internalFormat.m_frameSize = m_internalFormat.m_channelLayout.Count() * sizeof(float);
+
+  m_mixBuffers.reset(new CActiveAEBufferPool(m_internalFormat));
+  m_mixBuffers->Create(OFFLINE_BUFFER_TIME);
+  m_outputBuffers.reset(new CActiveAEBufferPoolResample(m_internalFormat, m_outputFormat, m_quality));
+  m_outputBuffers->Create(OFFLINE_BUFFER_TIME, true, false);
+
+  for (auto &config : m_streams)
+  {
+    std::unique_ptr<StreamState> stream(new StreamState());
+    stream->config = config;
+    stream->position = 0;
+    stream->length = (uint64_t)config.format.m_sampleRate * duration / 1000;
+    stream->draining = false;
+    stream->finished = false;
+    if (!CreateStream(*stream))
+    {
+      Release();
+      return false;
+    }
+    m_states.push_back(std::move(stream));
+  }
+
+  int64_t start = CurrentHostCounter();
+  while (Mix())
+    Output(false);
+  Output(true);
+  m_result.elapsed = ElapsedUsec(start);
+
+  for (auto &stream : m_states)
+    m_result.inputFrames += stream->position;
+  m_result.outputFrames = m_sink->GetFramesWritten();
+  m_result.checksum = m_sink->GetChecksum();
+  if (m_result.elapsed > 0)
+    m_result.realtimeFactor = (double)m_result.outputFrames / m_outputFormat.m_sampleRate * 1000000 / m_result.elapsed;
+
+  Release();
+
+  CLog::Log(LOGNOTICE, "CActiveAEOfflineHarness::%s - %s", __FUNCTION__, GetReport().c_str());
+  return true;
+}
+
+bool CActiveAEOfflineHarness::CreateStream(StreamState &stream)
+{
+  AEAudioFormat &format = stream.config.format;
+  switch (format.m_dataFormat)
+  {
+    case AE_FMT_S16NE:
+    case AE_FMT_S16NEP:
+    case AE_FMT_S32NE:
+    case AE_FMT_S32NEP:
+    case AE_FMT_FLOAT:
+    case AE_FMT_FLOATP:
+      break;
+    default:
+      CLog::Log(LOGERROR, "CActiveAEOfflineHarness::%s - unsupported stream format %s", __FUNCTION__,
+                CAEUtil::DataFormatToStr(format.m_dataFormat));
+      return false;
+  }
+  if (!format.m_sampleRate || !format.m_channelLayout.Count())
+  {
+    CLog::Log(LOGERROR, "CActiveAEOfflineHarness::%s - invalid stream format", __FUNCTION__);
+    return false;
+  }
+
+  // align input buffers with the period of the sink, as the engine does
+  format.m_frames = m_internalFormat.m_frames * ((float)format.m_sampleRate / m_internalFormat.m_sampleRate);
+  format.m_frameSize = format.m_channelLayout.Count() * (CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3);
+
+  stream.inputBuffers.reset(new CActiveAEBufferPool(format));
+  stream.inputBuffers->Create(OFFLINE_BUFFER_TIME);
+
+  stream.resampleBuffers.reset(new CActiveAEBufferPoolResample(format, m_internalFormat, m_quality));
+  // streams synced by resampling keep the resampler even if the formats match
+  stream.resampleBuffers->ForceResampler(stream.config.resampleRatio != 1.0);
+  stream.resampleBuffers->SetDSPConfig(m_dsp, false);
+  if (!stream.resampleBuffers->Create(OFFLINE_BUFFER_TIME, false, false, true, m_dsp))
+    return false;
+
+  stream.atempoBuffers.reset(new CActiveAEBufferPoolAtempo(m_internalFormat));
+  if (!stream.atempoBuffers->Create(OFFLINE_BUFFER_TIME))
+    return false;
+
+  // full periods from every stream, like the engine when it mixes
+  stream.resampleBuffers->FillBuffer();
+  stream.atempoBuffers->FillBuffer();
+  stream.resampleBuffers->SetRR(stream.config.resampleRatio);
+  stream.atempoBuffers->SetTempo(stream.config.tempo);
+  return true;
+}
+
+void CActiveAEOfflineHarness::FillInput(StreamState &stream, CSampleBuffer *buffer)
+{
+  CSoundPacket *pkt = buffer->pkt;
+  int channels = pkt->config.channels;
+  int frames = (int)std::min<uint64_t>(pkt->max_nb_samples, stream.length - stream.position);
+  bool planar = pkt->planes > 1;
+
+  for (int c = 0; c < channels; c++)
+  {
+    double step = 2.0 * M_PI * stream.config.frequency * (1.0 + c / 8.0) / pkt->config.sample_rate;
+    uint8_t *plane = pkt->data[planar ? c : 0];
+    for (int i = 0; i < frames; i++)
+    {
+      double value = 0.5 * sin(step * (stream.position + i));
+      int index = planar ? i : i * channels + c;
+      switch (pkt->config.fmt)
+      {
+        case AV_SAMPLE_FMT_S16:
+        case AV_SAMPLE_FMT_S16P:
+          ((int16_t*)plane)[index] = (int16_t)lrint(value * INT16_MAX);
+          break;
+        case AV_SAMPLE_FMT_S32:
+        case AV_SAMPLE_FMT_S32P:
+          ((int32_t*)plane)[index] = (int32_t)lrint(value * INT32_MAX);
+          break;
+        default:
+          ((float*)plane)[index] = (float)value;
+          break;
+      }
+    }
+  }
+
+  pkt->nb_samples = frames;
+  buffer->timestamp = 0;
+  buffer->pkt_start_offset = 0;
+  stream.position += frames;
+}
+
+bool CActiveAEOfflineHarness::ProcessStream(StreamState &stream)
+{
+  bool busy = false;
+  CSampleBuffer *buffer;
+
+  if (!stream.draining && stream.resampleBuffers->m_inputSamples.empty())
+  {
+    buffer = stream.inputBuffers->GetFreeBuffer();
+    if (buffer)
+    {
+      FillInput(stream, buffer);
+      stream.resampleBuffers->m_inputSamples.push_back(buffer);
+      busy = true;
+
+      if (stream.position >= stream.length)
+      {
+        stream.resampleBuffers->SetDrain(true);
+        stream.atempoBuffers->SetDrain(true);
+        stream.draining = true;
+      }
+    }
+  }
+
+  {
+    CStageTimer timer(m_result.stageTime[STAGE_RESAMPLE], m_result.stageCpu[STAGE_RESAMPLE]);
+    busy |= stream.resampleBuffers->ResampleBuffers();
+  }
+
+  while (!stream.resampleBuffers->m_outputSamples.empty())
+  {
+    buffer = stream.resampleBuffers->m_outputSamples.front();
+    stream.resampleBuffers->m_outputSamples.pop_front();
+    stream.atempoBuffers->m_inputSamples.push_back(buffer);
+    busy = true;
+  }
+
+  {
+    CStageTimer timer(m_result.stageTime[STAGE_ATEMPO], m_result.stageCpu[STAGE_ATEMPO]);
+    busy |= stream.atempoBuffers->ProcessBuffers();
+  }
+
+  while (!stream.atempoBuffers->m_outputSamples.empty())
+  {
+    buffer = stream.atempoBuffers->m_outputSamples.front();
+    stream.atempoBuffers->m_outputSamples.pop_front();
+    stream.outputSamples.push_back(buffer);
+    busy = true;
+  }
+
+  return busy;
+}
+
+bool CActiveAEOfflineHarness::Mix()
+{
+  for (auto &stream : m_states)
+  {
+    while (stream->outputSamples.empty() && !stream->finished)
+    {
+      if (ProcessStream(*stream))
+        continue;
+
+      if (!stream->draining)
+        CLog::Log(LOGERROR, "CActiveAEOfflineHarness::%s - stream stalled", __FUNCTION__);
+      stream->finished = true;
+    }
+  }
+
+  const AEKernels &kernels = CAEKernels::Get();
+  CSampleBuffer *out = nullptr;
+  bool clip = false;
+
+  CStageTimer timer(m_result.stageTime[STAGE_MIX], m_result.stageCpu[STAGE_MIX]);
+  for (auto &stream : m_states)
+  {
+    if (stream->outputSamples.empty())
+      continue;
+
+    CSampleBuffer *buffer = stream->outputSamples.front();
+    stream->outputSamples.pop_front();
+
+    if (!out)
+    {
+      out = m_mixBuffers->GetFreeBuffer();
+      if (!out)
+      {
+        CLog::Log(LOGERROR, "CActiveAEOfflineHarness::%s - out of mix buffers", __FUNCTION__);
+        buffer->Return();
+        return false;
+      }
+      int bytes = out->pkt->max_nb_samples * out->pkt->bytes_per_sample * out->pkt->config.channels / out->pkt->planes;
+      for (int i = 0; i < out->pkt->planes; i++)
+        memset(out->pkt->data[i], 0, bytes);
+    }
+
+    int nb_floats = buffer->pkt->nb_samples * buffer->pkt->config.channels / buffer->pkt->planes;
+    for (int i = 0; i < buffer->pkt->planes; i++)
+    {
+      if (kernels.MulAddArray((float*)out->pkt->data[i], (float*)buffer->pkt->data[i], stream->config.volume, nb_floats))
+        clip = true;
+    }
+    out->pkt->nb_samples = std::max(out->pkt->nb_samples, buffer->pkt->nb_samples);
+    buffer->Return();
+  }
+
+  if (!out)
+    return false;
+
+  if (clip)
+  {
+    int nb_floats = out->pkt->nb_samples * out->pkt->config.channels / out->pkt->planes;
+    for (int i = 0; i < out->pkt->planes; i++)
+      kernels.ClampArray((float*)out->pkt->data[i], nb_floats);
+  }
+
+  m_outputBuffers->m_inputSamples.push_back(out);
+  return true;
+}
+
+void CActiveAEOfflineHarness::Output(bool drain)
+{
+  if (drain)
+    m_outputBuffers->SetDrain(true);
+
+  bool busy = true;
+  while (busy)
+  {
+    {
+      CStageTimer timer(m_result.stageTime[STAGE_OUTPUT], m_result.stageCpu[STAGE_OUTPUT]);
+      busy = m_outputBuffers->ResampleBuffers();
+    }
+
+    while (!m_outputBuffers->m_outputSamples.empty())
+    {
+      CSampleBuffer *buffer = m_outputBuffers->m_outputSamples.front();
+      m_outputBuffers->m_outputSamples.pop_front();
+
+      CStageTimer timer(m_result.stageTime[STAGE_SINK], m_result.stageCpu[STAGE_SINK]);
+      m_sink->AddPackets(buffer->pkt->data, buffer->pkt->nb_samples, 0);
+      buffer->Return();
+    }
+  }
+}
+
+void CActiveAEOfflineHarness::Release()
+{
+  // buffers go back to the pools they came from before those are freed
+  for (auto &stream : m_states)
+  {
+    while (!stream->outputSamples.empty())
+    {
+      stream->outputSamples.front()->Return();
+      stream->outputSamples.pop_front();
+    }
+    stream->atempoBuffers.reset();
+    stream->resampleBuffers.reset();
+    stream->inputBuffers.reset();
+  }
+  m_states.clear();
+
+  m_outputBuffers.reset();
+  m_mixBuffers.reset();
+
+  if (m_sink)
+  {
+    m_sink->Deinitialize();
+    m_sink.reset();
+  }
+}
+
+std::string CActiveAEOfflineHarness::GetReport() const
+{
+  std::string report = StringUtils::Format("%" PRIu64 " frames in, %" PRIu64 " frames out in %.1f ms (%.1fx realtime), checksum %016" PRIx64,
+                                           m_result.inputFrames, m_result.outputFrames, m_result.elapsed / 1000.0,
+                                           m_result.realtimeFactor, m_result.checksum);
+  for (int i = 0; i < STAGE_MAX; i++)
+  {
+    report += StringUtils::Format(", %s %.1f ms", StageToStr((Stage)i), m_result.stageTime[i] / 1000.0);
+    if (m_result.stageCpu[i] >= 0)
+      report += StringUtils::Format(" (cpu %.1f ms)", m_result.stageCpu[i] / 1000.0);
+  }
+  return report;
+}
@@ -0,0 +1,157 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEAudioFormat.h"
+#include "cores/AudioEngine/Interfaces/AE.h"
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CAESinkFILE;
+
+namespace ActiveAE
+{
+
+class CActiveAEBufferPool;
+class CActiveAEBufferPoolResample;
+class CActiveAEBufferPoolAtempo;
+class CSampleBuffer;
+
+/*!
+ \brief A stream fed through the harness, a sine per channel in the given format
+ */
+struct OfflineStream
+{
+  AEAudioFormat format;           //!< S16, S32 or float, interleaved or planar
+  double resampleRatio = 1.0;     //!< like the engine's resample sync
+  float tempo = 1.0f;             //!< played through the atempo filter if not 1.0
+  float volume = 1.0f;
+  double frequency = 440.0;       //!< of the first channel, each further one is 1/8 higher
+};
+
+/*!
+ \brief Processes audio offline through the stages ActiveAE runs a stream through
+
+ Streams go through the resample buffers (format conversion, remap, resample
+ and audio dsp), the atempo buffers, get mixed into the engine's float format
+ and converted for the sink, which writes to a file. There is no engine thread
+ and no clock, every period is processed as soon as the previous one is done,
+ so the output of a given configuration is the same on every run.
+
+ It times the buffer stages one by one, the order they run in and the mixing
+ are its own. TestActiveAE plays through the engine itself to cover those.
+ */
+class CActiveAEOfflineHarness
+{
+public:
+  enum Stage
+  {
+    STAGE_RESAMPLE = 0,           //!< conversion, remap, resample and dsp of the streams
+    STAGE_ATEMPO,
+    STAGE_MIX,
+    STAGE_OUTPUT,                 //!< conversion to the sink format
+    STAGE_SINK,
+    STAGE_MAX
+  };
+
+  struct Result
+  {
+    uint64_t inputFrames;         //!< of all streams
+    uint64_t outputFrames;
+    uint64_t checksum;            //!< of the sample data given to the sink
+    int64_t elapsed;              //!< us
+    double realtimeFactor;        //!< seconds of output processed per second
+    int64_t stageTime[STAGE_MAX]; //!< us
+    int64_t stageCpu[STAGE_MAX];  //!< us of thread cpu time, -1 if unavailable
+  };
+
+  CActiveAEOfflineHarness();
+  ~CActiveAEOfflineHarness();
+
+  /*!
+   \brief Format requested from the sink, m_frames is the period
+   */
+  void SetSinkFormat(const AEAudioFormat &format) { m_sinkFormat = format; }
+  void SetQuality(AEQuality quality) { m_quality = quality; }
+  void SetDSP(bool dsp) { m_dsp = dsp; }
+
+  /*!
+   \brief WAV file the output goes to, none if empty
+   */
+  void SetOutputFile(const std::string &path) { m_outputFile = path; }
+
+  void AddStream(const OfflineStream &stream) { m_streams.push_back(stream); }
+
+  /*!
+   \brief Process duration ms of every stream and drain the pipeline
+   */
+  bool Run(unsigned int duration);
+
+  const Result& GetResult() const { return m_result; }
+  const AEAudioFormat& GetInternalFormat() const { return m_internalFormat; }
+  const AEAudioFormat& GetOutputFormat() const { return m_outputFormat; }
+
+  /*!
+   \brief One line summary of the last run
+   */
+  std::string GetReport() const;
+
+  static const char* StageToStr(Stage stage);
+
+private:
+  struct StreamState
+  {
+    OfflineStream config;
+    std::unique_ptr<CActiveAEBufferPool> inputBuffers;
+    std::unique_ptr<CActiveAEBufferPoolResample> resampleBuffers;
+    std::unique_ptr<CActiveAEBufferPoolAtempo> atempoBuffers;
+    std::deque<CSampleBuffer*> outputSamples;
+    uint64_t position;
+    uint64_t length;
+    bool draining;
+    bool finished;
+  };
+
+  bool CreateStream(StreamState &stream);
+  bool ProcessStream(StreamState &stream);
+  void FillInput(StreamState &stream, CSampleBuffer *buffer);
+  bool Mix();
+  void Output(bool drain);
+  void Release();
+
+  AEAudioFormat m_sinkFormat;
+  AEAudioFormat m_internalFormat;
+  AEAudioFormat m_outputFormat;
+  AEQuality m_quality;
+  bool m_dsp;
+  std::string m_outputFile;
+  std::vector<OfflineStream> m_streams;
+
+  std::vector<std::unique_ptr<StreamState>> m_states;
+  std::unique_ptr<CActiveAEBufferPool> m_mixBuffers;
+  std::unique_ptr<CActiveAEBufferPoolResample> m_outputBuffers;
+  std::unique_ptr<CAESinkFILE> m_sink;
+  Result m_result;
+};
+
+}
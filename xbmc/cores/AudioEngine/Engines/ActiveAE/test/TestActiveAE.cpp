@@ -0,0 +1,232 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/AEFactory.h"
+#include "cores/AudioEngine/Interfaces/AE.h"
+#include "cores/AudioEngine/Interfaces/AEStream.h"
+#include "filesystem/File.h"
+#include "settings/Settings.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+#ifdef TARGET_POSIX
+#include "linux/XTimeUtils.h"
+#endif
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const unsigned int wavHeaderSize = 68;
+
+// the format the engine idles in, so the sink is not reopened for the stream
+const unsigned int sampleRate = 44100;
+
+// starts at full level, the first frame of the stream is easy to spot in the output
+float Signal(unsigned int channel, unsigned int frame)
+{
+  return (float)(0.5 * cos(2.0 * M_PI * (440.0 + channel * 110.0) * frame / sampleRate));
+}
+}
+
+/*!
+ \brief Plays streams through a running engine into the FILE sink
+
+ Unlike the offline harness, this goes through CActiveAE and IAEStream, so
+ the order of the stages and the mixing are the engine's own.
+ */
+class TestActiveAE : public testing::Test
+{
+protected:
+  TestActiveAE()
+  {
+    CSettings &settings = CSettings::GetInstance();
+    m_device = settings.GetString(CSettings::SETTING_AUDIOOUTPUT_AUDIODEVICE);
+    m_config = settings.GetInt(CSettings::SETTING_AUDIOOUTPUT_CONFIG);
+    m_streamNoise = settings.GetBool(CSettings::SETTING_AUDIOOUTPUT_STREAMNOISE);
+    m_passthrough = settings.GetBool(CSettings::SETTING_AUDIOOUTPUT_PASSTHROUGH);
+
+    m_file = XBMC_CREATETEMPFILE(".wav");
+    m_path = XBMC_TEMPFILEPATH(m_file);
+    m_file->Close();
+
+    settings.SetString(CSettings::SETTING_AUDIOOUTPUT_AUDIODEVICE, "FILE:" + m_path);
+    settings.SetInt(CSettings::SETTING_AUDIOOUTPUT_CONFIG, AE_CONFIG_AUTO);
+    // the sink gets exact silence while no stream plays
+    settings.SetBool(CSettings::SETTING_AUDIOOUTPUT_STREAMNOISE, false);
+    settings.SetBool(CSettings::SETTING_AUDIOOUTPUT_PASSTHROUGH, false);
+
+    m_started = CAEFactory::LoadEngine() && CAEFactory::StartEngine();
+  }
+
+  ~TestActiveAE()
+  {
+    CAEFactory::UnLoadEngine();
+
+    CSettings &settings = CSettings::GetInstance();
+    settings.SetString(CSettings::SETTING_AUDIOOUTPUT_AUDIODEVICE, m_device);
+    settings.SetInt(CSettings::SETTING_AUDIOOUTPUT_CONFIG, m_config);
+    settings.SetBool(CSettings::SETTING_AUDIOOUTPUT_STREAMNOISE, m_streamNoise);
+    settings.SetBool(CSettings::SETTING_AUDIOOUTPUT_PASSTHROUGH, m_passthrough);
+
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  /*!
+   \brief Play frames of the signal in format and wait until the stream drained
+   */
+  bool Play(AEDataFormat dataFormat, unsigned int frames, float volume = 1.0f)
+  {
+    AEAudioFormat format;
+    format.m_dataFormat = dataFormat;
+    format.m_sampleRate = sampleRate;
+    format.m_channelLayout = CAEChannelInfo(AE_CH_LAYOUT_2_0);
+    IAEStream *stream = CAEFactory::MakeStream(format);
+    if (!stream)
+      return false;
+    stream->SetVolume(volume);
+
+    bool planar = dataFormat == AE_FMT_FLOATP;
+    bool s16 = dataFormat == AE_FMT_S16NE;
+    unsigned int sampleSize = s16 ? sizeof(int16_t) : sizeof(float);
+    std::vector<uint8_t> channelData[2];
+    for (unsigned int channel = 0; channel < 2; channel++)
+      channelData[channel].resize(frames * sampleSize * (planar ? 1 : 2));
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+      for (unsigned int channel = 0; channel < 2; channel++)
+      {
+        float sample = Signal(channel, frame);
+        uint8_t *dst = planar ? &channelData[channel][frame * sampleSize] : &channelData[0][(frame * 2 + channel) * sampleSize];
+        if (s16)
+        {
+          int16_t value = (int16_t)lrint(sample * 32768.0f);
+          memcpy(dst, &value, sizeof(value));
+        }
+        else
+          memcpy(dst, &sample, sizeof(sample));
+      }
+    }
+
+    const uint8_t *data[2] = { channelData[0].data(), channelData[1].data() };
+    unsigned int added = 0;
+    XbmcThreads::EndTime timeout(10000);
+    while (added < frames && !timeout.IsTimePast())
+    {
+      unsigned int copied = stream->AddData(data, added, frames - added);
+      if (!copied)
+        Sleep(10);
+      added += copied;
+    }
+
+    stream->Drain(true);
+    while (!stream->IsDrained() && !timeout.IsTimePast())
+      Sleep(10);
+    bool drained = stream->IsDrained();
+
+    CAEFactory::FreeStream(stream);
+    return added == frames && drained;
+  }
+
+  /*!
+   \brief Interleaved float output from the first frame that is not silent
+   */
+  std::vector<float> ReadOutput()
+  {
+    // closing the sink completes the file
+    CAEFactory::UnLoadEngine();
+
+    XFILE::CFile file;
+    XFILE::auto_buffer buffer;
+    std::vector<float> samples;
+    if (file.LoadFile(m_path, buffer) <= (ssize_t)wavHeaderSize)
+      return samples;
+
+    // the engine writes float, see CActiveAE::ApplySettingsToFormat. the
+    // first sample of the signal is the first one that is not zero
+    const float *begin = (const float*)(buffer.get() + wavHeaderSize);
+    const float *end = begin + (buffer.size() - wavHeaderSize) / sizeof(float);
+    while (begin < end && *begin == 0.0f)
+      begin++;
+    samples.assign(begin, end);
+    return samples;
+  }
+
+  void ExpectSignal(const std::vector<float> &output, unsigned int frames, float volume)
+  {
+    ASSERT_GE(output.size(), frames * 2);
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+      for (unsigned int channel = 0; channel < 2; channel++)
+        ASSERT_FLOAT_EQ(Signal(channel, frame) * volume, output[frame * 2 + channel])
+          << "frame " << frame << " channel " << channel;
+    }
+    // silence follows the stream
+    for (size_t i = frames * 2; i < output.size(); i++)
+      ASSERT_EQ(0.0f, output[i]) << "sample " << i;
+  }
+
+  XFILE::CFile *m_file;
+  std::string m_path;
+  bool m_started;
+
+private:
+  std::string m_device;
+  int m_config;
+  bool m_streamNoise;
+  bool m_passthrough;
+};
+
+TEST_F(TestActiveAE, Float)
+{
+  ASSERT_TRUE(m_started);
+  ASSERT_TRUE(Play(AE_FMT_FLOAT, sampleRate / 2));
+  ExpectSignal(ReadOutput(), sampleRate / 2, 1.0f);
+}
+
+TEST_F(TestActiveAE, Planar)
+{
+  ASSERT_TRUE(m_started);
+  ASSERT_TRUE(Play(AE_FMT_FLOATP, sampleRate / 2));
+  ExpectSignal(ReadOutput(), sampleRate / 2, 1.0f);
+}
+
+TEST_F(TestActiveAE, S16)
+{
+  // 16 bit samples convert to float without loss, the signal is rounded to them
+  ASSERT_TRUE(m_started);
+  ASSERT_TRUE(Play(AE_FMT_S16NE, sampleRate / 2));
+  std::vector<float> output = ReadOutput();
+  ASSERT_GE(output.size(), sampleRate);
+  for (unsigned int i = 0; i < sampleRate; i++)
+    ASSERT_NEAR(Signal(i % 2, i / 2), output[i], 1.0 / 32768) << "sample " << i;
+}
+
+TEST_F(TestActiveAE, Volume)
+{
+  // the stream volume is applied when the engine mixes the stream
+  ASSERT_TRUE(m_started);
+  ASSERT_TRUE(Play(AE_FMT_FLOAT, sampleRate / 2, 0.5f));
+  ExpectSignal(ReadOutput(), sampleRate / 2, 0.5f);
+}
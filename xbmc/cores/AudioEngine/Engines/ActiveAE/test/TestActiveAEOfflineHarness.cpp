@@ -0,0 +1,366 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ActiveAEOfflineHarness.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace ActiveAE;
+
+namespace
+{
+const unsigned int period = 1024;
+const unsigned int wavHeaderSize = 68;
+
+AEAudioFormat MakeFormat(AEDataFormat dataFormat, unsigned int sampleRate, AEStdChLayout layout)
+{
+  AEAudioFormat format;
+  format.m_dataFormat = dataFormat;
+  format.m_sampleRate = sampleRate;
+  format.m_channelLayout = CAEChannelInfo(layout);
+  return format;
+}
+
+OfflineStream MakeStream(AEDataFormat dataFormat, unsigned int sampleRate, AEStdChLayout layout)
+{
+  OfflineStream stream;
+  stream.format = MakeFormat(dataFormat, sampleRate, layout);
+  return stream;
+}
+
+void SetupHarness(CActiveAEOfflineHarness &harness, AEDataFormat sinkFormat, AEStdChLayout layout = AE_CH_LAYOUT_2_0)
+{
+  AEAudioFormat format = MakeFormat(sinkFormat, 48000, layout);
+  format.m_frames = period;
+  harness.SetSinkFormat(format);
+}
+
+// the signal the harness feeds a stream with
+double Sine(const OfflineStream &stream, unsigned int channel, uint64_t frame)
+{
+  double step = 2.0 * M_PI * stream.frequency * (1.0 + channel / 8.0) / stream.format.m_sampleRate;
+  return 0.5 * sin(step * frame);
+}
+
+std::vector<uint8_t> ReadSamples(const std::string &path)
+{
+  XFILE::CFile file;
+  XFILE::auto_buffer buffer;
+  std::vector<uint8_t> samples;
+  if (file.LoadFile(path, buffer) > wavHeaderSize)
+    samples.assign(buffer.get() + wavHeaderSize, buffer.get() + buffer.size());
+  XFILE::CFile::Delete(path);
+  return samples;
+}
+
+// FNV-1a, as computed by CAESinkFILE
+uint64_t Checksum(const std::vector<uint8_t> &data)
+{
+  uint64_t checksum = 14695981039346656037ULL;
+  for (uint8_t byte : data)
+  {
+    checksum ^= byte;
+    checksum *= 1099511628211ULL;
+  }
+  return checksum;
+}
+}
+
+TEST(TestActiveAEOfflineHarness, Deterministic)
+{
+  uint64_t checksum = 0;
+  for (int run = 0; run < 2; run++)
+  {
+    CActiveAEOfflineHarness harness;
+    SetupHarness(harness, AE_FMT_S16NE);
+    harness.AddStream(MakeStream(AE_FMT_S16NE, 44100, AE_CH_LAYOUT_2_0));
+    ASSERT_TRUE(harness.Run(1000));
+
+    const CActiveAEOfflineHarness::Result &result = harness.GetResult();
+    EXPECT_EQ(44100U, result.inputFrames);
+    // resampler delay and the padding of the last period
+    EXPECT_GE(result.outputFrames, 48000U - period);
+    EXPECT_LE(result.outputFrames, 48000U + 2 * period);
+    if (run == 0)
+      checksum = result.checksum;
+    else
+      EXPECT_EQ(checksum, result.checksum);
+  }
+}
+
+TEST(TestActiveAEOfflineHarness, GoldenIdentity)
+{
+  // s16 in the format of the sink goes through float and back unchanged
+  std::string path = "special://temp/offlineharness-identity.wav";
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_S16NE);
+  harness.SetOutputFile(path);
+  OfflineStream stream = MakeStream(AE_FMT_S16NE, 48000, AE_CH_LAYOUT_2_0);
+  harness.AddStream(stream);
+  ASSERT_TRUE(harness.Run(500));
+  std::vector<uint8_t> data = ReadSamples(path);
+
+  const CActiveAEOfflineHarness::Result &result = harness.GetResult();
+  ASSERT_EQ(24000U, result.inputFrames);
+  ASSERT_GE(result.outputFrames, result.inputFrames);
+  ASSERT_EQ(result.outputFrames * 2 * sizeof(int16_t), data.size());
+
+  // the input samples, then silence up to the end of the last period
+  std::vector<uint8_t> expected(data.size(), 0);
+  int16_t *samples = (int16_t*)expected.data();
+  for (uint64_t i = 0; i < result.inputFrames; i++)
+  {
+    for (unsigned int c = 0; c < 2; c++)
+      samples[i * 2 + c] = (int16_t)lrint(Sine(stream, c, i) * INT16_MAX);
+  }
+  EXPECT_TRUE(expected == data);
+  EXPECT_EQ(Checksum(expected), result.checksum);
+}
+
+TEST(TestActiveAEOfflineHarness, GoldenRemap)
+{
+  // stereo into a 5.1 sink keeps front left and right as they are and leaves the rest silent
+  std::string path = "special://temp/offlineharness-remap.wav";
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_FLOAT, AE_CH_LAYOUT_5_1);
+  harness.SetOutputFile(path);
+  OfflineStream stream = MakeStream(AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_2_0);
+  harness.AddStream(stream);
+  ASSERT_TRUE(harness.Run(500));
+  std::vector<uint8_t> data = ReadSamples(path);
+
+  const CActiveAEOfflineHarness::Result &result = harness.GetResult();
+  ASSERT_EQ(6U, harness.GetOutputFormat().m_channelLayout.Count());
+  ASSERT_EQ(24000U, result.inputFrames);
+  ASSERT_GE(result.outputFrames, result.inputFrames);
+  ASSERT_EQ(result.outputFrames * 6 * sizeof(float), data.size());
+
+  std::vector<uint8_t> expected(data.size(), 0);
+  float *samples = (float*)expected.data();
+  for (uint64_t i = 0; i < result.inputFrames; i++)
+  {
+    for (unsigned int c = 0; c < 2; c++)
+      samples[i * 6 + c] = (float)Sine(stream, c, i);
+  }
+  EXPECT_TRUE(expected == data);
+  EXPECT_EQ(Checksum(expected), result.checksum);
+}
+
+TEST(TestActiveAEOfflineHarness, GoldenResample)
+{
+  // the bits of resampled output depend on the cpu features swresample uses, so check
+  // the signal itself: level and frequency of every channel have to survive 44.1k to 48k
+  std::string path = "special://temp/offlineharness-resample.wav";
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_FLOAT);
+  harness.SetOutputFile(path);
+  OfflineStream stream = MakeStream(AE_FMT_FLOAT, 44100, AE_CH_LAYOUT_2_0);
+  harness.AddStream(stream);
+  ASSERT_TRUE(harness.Run(1000));
+  std::vector<uint8_t> data = ReadSamples(path);
+
+  const CActiveAEOfflineHarness::Result &result = harness.GetResult();
+  ASSERT_EQ(44100U, result.inputFrames);
+  ASSERT_EQ(result.outputFrames * 2 * sizeof(float), data.size());
+  ASSERT_GE(result.outputFrames, 48000U - period);
+
+  // leave out the filter's run in and out at both ends
+  const float *samples = (const float*)data.data();
+  uint64_t first = 2 * period;
+  uint64_t last = 48000 - 2 * period;
+  for (unsigned int c = 0; c < 2; c++)
+  {
+    double power = 0;
+    unsigned int crossings = 0;
+    for (uint64_t i = first; i < last; i++)
+    {
+      power += samples[i * 2 + c] * samples[i * 2 + c];
+      if (samples[(i - 1) * 2 + c] < 0 && samples[i * 2 + c] >= 0)
+        crossings++;
+    }
+    double rms = sqrt(power / (last - first));
+    double cycles = stream.frequency * (1.0 + c / 8.0) * (last - first) / 48000;
+    EXPECT_NEAR(0.5 / M_SQRT2, rms, 0.005) << "channel " << c;
+    EXPECT_NEAR(cycles, crossings, 1.0) << "channel " << c;
+  }
+}
+
+TEST(TestActiveAEOfflineHarness, PlanarInput)
+{
+  // the same samples, interleaved or not, have to end up the same
+  uint64_t checksums[2];
+  AEDataFormat formats[] = { AE_FMT_FLOAT, AE_FMT_FLOATP };
+  for (int i = 0; i < 2; i++)
+  {
+    CActiveAEOfflineHarness harness;
+    SetupHarness(harness, AE_FMT_FLOAT);
+    harness.AddStream(MakeStream(formats[i], 48000, AE_CH_LAYOUT_5_1));
+    ASSERT_TRUE(harness.Run(500));
+    checksums[i] = harness.GetResult().checksum;
+  }
+  EXPECT_EQ(checksums[0], checksums[1]);
+}
+
+TEST(TestActiveAEOfflineHarness, Formats)
+{
+  AEDataFormat inputs[] = { AE_FMT_S16NE, AE_FMT_S16NEP, AE_FMT_S32NE, AE_FMT_S32NEP, AE_FMT_FLOAT, AE_FMT_FLOATP };
+  AEDataFormat outputs[] = { AE_FMT_S16NE, AE_FMT_S32NE, AE_FMT_FLOAT };
+  for (AEDataFormat input : inputs)
+  {
+    for (AEDataFormat output : outputs)
+    {
+      CActiveAEOfflineHarness harness;
+      SetupHarness(harness, output);
+      harness.AddStream(MakeStream(input, 48000, AE_CH_LAYOUT_2_0));
+      ASSERT_TRUE(harness.Run(200)) << input << " " << output;
+      EXPECT_EQ(output, harness.GetOutputFormat().m_dataFormat);
+      EXPECT_GE(harness.GetResult().outputFrames, 9600U);
+      EXPECT_LE(harness.GetResult().outputFrames, 9600U + period);
+    }
+  }
+
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_FLOAT);
+  harness.AddStream(MakeStream(AE_FMT_S24NE3, 48000, AE_CH_LAYOUT_2_0));
+  EXPECT_FALSE(harness.Run(200));
+}
+
+TEST(TestActiveAEOfflineHarness, Remap)
+{
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_FLOAT);
+  harness.AddStream(MakeStream(AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_7_1));
+  ASSERT_TRUE(harness.Run(200));
+  EXPECT_EQ(2U, harness.GetInternalFormat().m_channelLayout.Count());
+  EXPECT_GE(harness.GetResult().outputFrames, 9600U);
+}
+
+TEST(TestActiveAEOfflineHarness, Atempo)
+{
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_FLOAT);
+  OfflineStream stream = MakeStream(AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_2_0);
+  stream.tempo = 1.25f;
+  harness.AddStream(stream);
+  ASSERT_TRUE(harness.Run(2000));
+  EXPECT_EQ(96000U, harness.GetResult().inputFrames);
+  EXPECT_NEAR(96000 / 1.25, (double)harness.GetResult().outputFrames, 4 * period);
+}
+
+TEST(TestActiveAEOfflineHarness, ResampleRatio)
+{
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_FLOAT);
+  OfflineStream stream = MakeStream(AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_2_0);
+  stream.resampleRatio = 1.01;
+  harness.AddStream(stream);
+  ASSERT_TRUE(harness.Run(2000));
+  EXPECT_GT(harness.GetResult().outputFrames, 96000U + 480U);
+  EXPECT_LT(harness.GetResult().outputFrames, 96960U + 2 * period);
+}
+
+TEST(TestActiveAEOfflineHarness, Mix)
+{
+  CActiveAEOfflineHarness single;
+  SetupHarness(single, AE_FMT_FLOAT);
+  single.AddStream(MakeStream(AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_2_0));
+  ASSERT_TRUE(single.Run(500));
+
+  CActiveAEOfflineHarness mixed;
+  SetupHarness(mixed, AE_FMT_FLOAT);
+  mixed.AddStream(MakeStream(AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_2_0));
+  OfflineStream second = MakeStream(AE_FMT_S16NE, 44100, AE_CH_LAYOUT_1_0);
+  second.frequency = 1000.0;
+  second.volume = 0.5f;
+  mixed.AddStream(second);
+  ASSERT_TRUE(mixed.Run(500));
+
+  EXPECT_EQ(24000U + 22050U, mixed.GetResult().inputFrames);
+  EXPECT_NE(single.GetResult().checksum, mixed.GetResult().checksum);
+  EXPECT_GE(mixed.GetResult().outputFrames, single.GetResult().outputFrames);
+}
+
+TEST(TestActiveAEOfflineHarness, OutputFile)
+{
+  std::string path = "special://temp/offlineharness.wav";
+  CActiveAEOfflineHarness harness;
+  SetupHarness(harness, AE_FMT_S16NE);
+  harness.SetOutputFile(path);
+  harness.AddStream(MakeStream(AE_FMT_S16NE, 48000, AE_CH_LAYOUT_2_0));
+  ASSERT_TRUE(harness.Run(300));
+
+  XFILE::CFile file;
+  ASSERT_TRUE(file.Open(path));
+  EXPECT_EQ(68 + (int64_t)harness.GetResult().outputFrames * 4, file.GetLength());
+  char header[12];
+  ASSERT_EQ(12, file.Read(header, sizeof(header)));
+  EXPECT_EQ(0, memcmp(header, "RIFF", 4));
+  EXPECT_EQ(0, memcmp(header + 8, "WAVE", 4));
+  file.Close();
+  XFILE::CFile::Delete(path);
+}
+
+/*
+ * Runs a set of typical configurations and prints what each stage took.
+ * KODI_BENCHMARK_ACTIVEAE sets the seconds of audio to process, 10 by default.
+ */
+TEST(TestActiveAEOfflineHarness, DISABLED_Benchmark)
+{
+  int seconds = atoi(XBMC_BENCHMARK_OPTION("KODI_BENCHMARK_ACTIVEAE", "10").c_str());
+  ASSERT_GT(seconds, 0);
+  unsigned int duration = seconds * 1000;
+
+  struct
+  {
+    const char *name;
+    AEDataFormat input;
+    unsigned int rate;
+    AEStdChLayout layout;
+    AEDataFormat sink;
+    float tempo;
+    bool dsp;
+  } configs[] = {
+    { "stereo s16 passthrough rate", AE_FMT_S16NE, 48000, AE_CH_LAYOUT_2_0, AE_FMT_S16NE, 1.0f, false },
+    { "stereo s16 44.1k to 48k", AE_FMT_S16NE, 44100, AE_CH_LAYOUT_2_0, AE_FMT_S16NE, 1.0f, false },
+    { "7.1 float downmix", AE_FMT_FLOATP, 48000, AE_CH_LAYOUT_7_1, AE_FMT_S32NE, 1.0f, false },
+    { "stereo atempo 1.1", AE_FMT_FLOAT, 48000, AE_CH_LAYOUT_2_0, AE_FMT_FLOAT, 1.1f, false },
+    { "stereo s16 44.1k dsp", AE_FMT_S16NE, 44100, AE_CH_LAYOUT_2_0, AE_FMT_S16NE, 1.0f, true },
+  };
+
+  for (auto &config : configs)
+  {
+    CActiveAEOfflineHarness harness;
+    SetupHarness(harness, config.sink);
+    harness.SetDSP(config.dsp);
+    OfflineStream stream = MakeStream(config.input, config.rate, config.layout);
+    stream.tempo = config.tempo;
+    harness.AddStream(stream);
+    ASSERT_TRUE(harness.Run(duration)) << config.name;
+    std::cout << config.name << ": " << harness.GetReport() << std::endl;
+  }
+}
@@ -115,6 +115,13 @@ public:
    */
   virtual double GetCacheTotal() = 0;
 
+  /**
+   * Returns the measured latency of the stream, the time data added now spends in the
+   * engine and the sink until it is heard, smoothed over the recent updates
+   * @return seconds
+   */
+  virtual double GetLatency() { return GetDelay(); }
+
   /**
    * Pauses the stream playback
    */
@@ -515,6 +515,7 @@ bool CAESinkALSA::Initialize(AEAudioFormat &format, std::string &device)
   ALSAConfig inconfig, outconfig;
   inconfig.format = format.m_dataFormat;
   inconfig.sampleRate = format.m_sampleRate;
+  inconfig.periodSize = format.m_frames; // requested by the engine in low latency mode
 
   /*
    * We can't use the better GetChannelLayout() at this point as the device
@@ -756,6 +757,13 @@ bool CAESinkALSA::InitializeHW(const ALSAConfig &inconfig, ALSAConfig &outconfig
   */
   periodSize  = std::min(periodSize, (snd_pcm_uframes_t) sampleRate / 20);
   bufferSize  = std::min(bufferSize, (snd_pcm_uframes_t) sampleRate / 5);
+
+  /* low latency: the requested period and just enough periods to not underrun */
+  if (inconfig.periodSize)
+  {
+    periodSize = std::min(periodSize, (snd_pcm_uframes_t) inconfig.periodSize);
+    bufferSize = std::min(bufferSize, (snd_pcm_uframes_t) inconfig.periodSize * 4);
+  }
   
   /* 
    According to upstream we should set buffer size first - so make sure it is always at least
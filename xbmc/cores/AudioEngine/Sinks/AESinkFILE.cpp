@@ -0,0 +1,251 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+#include "AESinkFILE.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "URL.h"
+#include "utils/log.h"
+#include "utils/TimeUtils.h"
+
+#define WAVE_FORMAT_PCM        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+#define WAVE_HEADER_SIZE       68
+
+#define FNV_OFFSET_BASIS       14695981039346656037ULL
+#define FNV_PRIME              1099511628211ULL
+
+namespace
+{
+void PutLE(std::vector<uint8_t> &header, uint32_t value, int bytes)
+{
+  for (int i = 0; i < bytes; i++)
+    header.push_back((value >> (8 * i)) & 0xFF);
+}
+
+void PutTag(std::vector<uint8_t> &header, const char *tag)
+{
+  header.insert(header.end(), tag, tag + 4);
+}
+}
+
+CAESinkFILE::CAESinkFILE(bool realtime)
+  : m_fileOpen(false),
+    m_realtime(realtime),
+    m_checksum(FNV_OFFSET_BASIS),
+    m_framesWritten(0),
+    m_playStart(0),
+    m_bufferTime(0)
+{
+}
+
+CAESinkFILE::~CAESinkFILE()
+{
+  Deinitialize();
+}
+
+bool CAESinkFILE::Initialize(AEAudioFormat &format, std::string &device)
+{
+  if (format.m_dataFormat == AE_FMT_RAW)
+  {
+    CLog::Log(LOGERROR, "CAESinkFILE::%s - passthrough can't be written", __FUNCTION__);
+    return false;
+  }
+
+  switch (format.m_dataFormat)
+  {
+    case AE_FMT_U8:
+    case AE_FMT_U8P:
+    case AE_FMT_S16BE:
+    case AE_FMT_S16LE:
+    case AE_FMT_S16NE:
+    case AE_FMT_S16NEP:
+      format.m_dataFormat = AE_FMT_S16NE;
+      break;
+    case AE_FMT_DOUBLE:
+    case AE_FMT_DOUBLEP:
+    case AE_FMT_FLOAT:
+    case AE_FMT_FLOATP:
+      format.m_dataFormat = AE_FMT_FLOAT;
+      break;
+    default:
+      format.m_dataFormat = AE_FMT_S32NE;
+      break;
+  }
+
+  // take the period the engine asks for, a 50ms one otherwise
+  if (format.m_frames < 256)
+    format.m_frames = std::max(256U, format.m_sampleRate / 20);
+  format.m_frameSize = format.m_channelLayout.Count() * (CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3);
+  m_format = format;
+
+  // a device buffers a few periods
+  m_bufferTime = 4.0 * format.m_frames / format.m_sampleRate;
+  m_checksum = FNV_OFFSET_BASIS;
+  m_framesWritten = 0;
+  m_playStart = 0;
+
+  if (!device.empty())
+  {
+    if (!m_file.OpenForWrite(device, true))
+    {
+      CLog::Log(LOGERROR, "CAESinkFILE::%s - unable to open %s", __FUNCTION__, CURL::GetRedacted(device).c_str());
+      return false;
+    }
+    m_fileOpen = true;
+    if (!WriteHeader())
+    {
+      Deinitialize();
+      return false;
+    }
+  }
+
+  CLog::Log(LOGDEBUG, "CAESinkFILE::%s - writing %s, %u Hz, %u channels to %s", __FUNCTION__,
+            CAEUtil::DataFormatToStr(format.m_dataFormat), format.m_sampleRate, format.m_channelLayout.Count(),
+            device.empty() ? "nowhere" : CURL::GetRedacted(device).c_str());
+  return true;
+}
+
+void CAESinkFILE::Deinitialize()
+{
+  if (!m_fileOpen)
+    return;
+
+  // now that the size of the data is known
+  if (m_file.Seek(0, SEEK_SET) == 0)
+    WriteHeader();
+  m_file.Close();
+  m_fileOpen = false;
+}
+
+bool CAESinkFILE::WriteHeader()
+{
+  unsigned int channels = m_format.m_channelLayout.Count();
+  unsigned int bits = CAEUtil::DataFormatToBits(m_format.m_dataFormat);
+  uint32_t formatTag = m_format.m_dataFormat == AE_FMT_FLOAT ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+  uint32_t dataSize = (uint32_t)std::min<uint64_t>(m_framesWritten * m_format.m_frameSize, UINT32_MAX - WAVE_HEADER_SIZE);
+
+  // ffmpeg channel masks use the same bits as the wave ones for the speakers they have in common
+  uint32_t channelMask = (uint32_t)(CAEUtil::GetAVChannelLayout(m_format.m_channelLayout) & 0x3FFFF);
+
+  std::vector<uint8_t> header;
+  PutTag(header, "RIFF");
+  PutLE(header, WAVE_HEADER_SIZE - 8 + dataSize, 4);
+  PutTag(header, "WAVE");
+  PutTag(header, "fmt ");
+  PutLE(header, 40, 4);
+  PutLE(header, WAVE_FORMAT_EXTENSIBLE, 2);
+  PutLE(header, channels, 2);
+  PutLE(header, m_format.m_sampleRate, 4);
+  PutLE(header, m_format.m_sampleRate * m_format.m_frameSize, 4);
+  PutLE(header, m_format.m_frameSize, 2);
+  PutLE(header, bits, 2);
+  PutLE(header, 22, 2);
+  PutLE(header, bits, 2);
+  PutLE(header, channelMask, 4);
+  // KSDATAFORMAT_SUBTYPE_PCM or _IEEE_FLOAT
+  PutLE(header, formatTag, 4);
+  PutLE(header, 0x0000, 2);
+  PutLE(header, 0x0010, 2);
+  PutLE(header, 0xAA000080, 4);
+  PutLE(header, 0x719B3800, 4);
+  PutTag(header, "data");
+  PutLE(header, dataSize, 4);
+
+  if (m_file.Write(header.data(), header.size()) != (ssize_t)header.size())
+  {
+    CLog::Log(LOGERROR, "CAESinkFILE::%s - error writing header", __FUNCTION__);
+    return false;
+  }
+  return true;
+}
+
+double CAESinkFILE::GetBufferedTime()
+{
+  if (!m_realtime || !m_playStart)
+    return 0.0;
+
+  int64_t frequency = CurrentHostFrequency();
+  double played = (double)(CurrentHostCounter() - m_playStart) / frequency;
+  double written = (double)m_framesWritten / m_format.m_sampleRate;
+  if (played > written)
+  {
+    // ran dry, play out from now on
+    m_playStart = CurrentHostCounter() - (int64_t)(written * frequency);
+    return 0.0;
+  }
+  return written - played;
+}
+
+void CAESinkFILE::GetDelay(AEDelayStatus& status)
+{
+  status.SetDelay(GetBufferedTime());
+}
+
+double CAESinkFILE::GetCacheTotal()
+{
+  return m_bufferTime;
+}
+
+unsigned int CAESinkFILE::AddPackets(uint8_t **data, unsigned int frames, unsigned int offset)
+{
+  if (m_realtime)
+  {
+    // block until the frames fit into the buffer, the way a device does
+    double duration = (double)frames / m_format.m_sampleRate;
+    double buffered = GetBufferedTime();
+    if (buffered + duration > m_bufferTime)
+      Sleep((unsigned int)((buffered + duration - m_bufferTime) * 1000));
+    if (!m_playStart)
+      m_playStart = CurrentHostCounter();
+  }
+
+  uint8_t *buffer = data[0] + offset * m_format.m_frameSize;
+  unsigned int size = frames * m_format.m_frameSize;
+
+  for (unsigned int i = 0; i < size; i++)
+  {
+    m_checksum ^= buffer[i];
+    m_checksum *= FNV_PRIME;
+  }
+
+  if (m_fileOpen && m_file.Write(buffer, size) != (ssize_t)size)
+  {
+    CLog::Log(LOGERROR, "CAESinkFILE::%s - error writing, output is dropped from now on", __FUNCTION__);
+    m_file.Close();
+    m_fileOpen = false;
+  }
+
+  m_framesWritten += frames;
+  return frames;
+}
+
+void CAESinkFILE::Drain()
+{
+  double buffered = GetBufferedTime();
+  if (buffered > 0)
+    Sleep((unsigned int)(buffered * 1000));
+}
@@ -0,0 +1,67 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Interfaces/AESink.h"
+#include "filesystem/File.h"
+
+/*!
+ \brief Sink writing the engine output into a WAV file
+
+ Selected with the audio device FILE:<path>, it is never enumerated. Output
+ is S16, S32 or float, always interleaved. The sink plays out in real time
+ like a device would, unless it was created for offline processing where
+ it takes everything right away. An empty path only checksums the output.
+ */
+class CAESinkFILE : public IAESink
+{
+public:
+  virtual const char *GetName() { return "FILE"; }
+
+  explicit CAESinkFILE(bool realtime = true);
+  virtual ~CAESinkFILE();
+
+  virtual bool Initialize(AEAudioFormat &format, std::string &device);
+  virtual void Deinitialize();
+
+  virtual void         GetDelay        (AEDelayStatus& status);
+  virtual double       GetCacheTotal   ();
+  virtual unsigned int AddPackets      (uint8_t **data, unsigned int frames, unsigned int offset);
+  virtual void         Drain           ();
+
+  /*!
+   \brief FNV-1a hash over all sample data written since Initialize
+   */
+  uint64_t GetChecksum() const { return m_checksum; }
+  uint64_t GetFramesWritten() const { return m_framesWritten; }
+
+private:
+  bool WriteHeader();
+  double GetBufferedTime();
+
+  XFILE::CFile         m_file;
+  bool                 m_fileOpen;
+  bool                 m_realtime;
+  AEAudioFormat        m_format;
+  uint64_t             m_checksum;
+  uint64_t             m_framesWritten;
+  int64_t              m_playStart;
+  double               m_bufferTime;
+};
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <limits.h>
+#include <algorithm>
 
 #include "AESinkNULL.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
@@ -43,15 +44,20 @@ CAESinkNULL::~CAESinkNULL()
 
 bool CAESinkNULL::Initialize(AEAudioFormat &format, std::string &device)
 {
-  // setup for a 250ms sink feed from SoftAE 
+  // setup for a 250ms sink feed from SoftAE, or the period the engine asks for in low latency mode
+  bool lowLatency = format.m_frames != 0 && format.m_dataFormat != AE_FMT_RAW;
   format.m_dataFormat    = (format.m_dataFormat == AE_FMT_RAW) ? AE_FMT_S16NE : AE_FMT_FLOAT;
-  format.m_frames        = format.m_sampleRate / 1000 * 250;
+  if (!lowLatency)
+    format.m_frames      = format.m_sampleRate / 1000 * 250;
   format.m_frameSize     = format.m_channelLayout.Count() * (CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3);
   m_format = format;
 
-  // setup a pretend 500ms internal buffer
+  // setup a pretend 500ms internal buffer, four periods in low latency mode
   m_sink_frameSize = format.m_channelLayout.Count() * CAEUtil::DataFormatToBits(format.m_dataFormat) >> 3;
-  m_sinkbuffer_size = m_sink_frameSize * format.m_sampleRate / 2;
+  if (lowLatency)
+    m_sinkbuffer_size = m_sink_frameSize * format.m_frames * 4;
+  else
+    m_sinkbuffer_size = m_sink_frameSize * format.m_sampleRate / 2;
   m_sinkbuffer_sec_per_byte = 1.0 / (double)(m_sink_frameSize * format.m_sampleRate);
 
   m_draining = false;
@@ -130,8 +136,8 @@ void CAESinkNULL::Process()
       m_draining = false;
     }
 
-    // pretend we have a 64k audio buffer
-    unsigned int min_buffer_size = 64 * 1024;
+    // pretend we have a 64k audio buffer, never more than a quarter of the sink buffer
+    unsigned int min_buffer_size = std::min(64U * 1024, m_sinkbuffer_size / 4);
     unsigned int read_bytes = m_sinkbuffer_level;
     if (read_bytes > min_buffer_size)
       read_bytes = min_buffer_size;
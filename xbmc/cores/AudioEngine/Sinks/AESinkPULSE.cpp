@@ -687,6 +687,13 @@ bool CAESinkPULSE::Initialize(AEAudioFormat &format, std::string &device)
     process_time = latency / 4;
   }
 
+  // low latency: the engine requests the period, keep four of them queued
+  if (format.m_frames && !m_passthrough)
+  {
+    process_time = std::min(process_time, format.m_frames * frameSize);
+    latency = std::min(latency, process_time * 4);
+  }
+
   pa_buffer_attr buffer_attr;
   buffer_attr.fragsize = latency;
   buffer_attr.maxlength = (uint32_t) -1;
@@ -0,0 +1,472 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEKernels.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+
+#include <math.h>
+
+#if defined(TARGET_WINDOWS) && _M_IX86_FP>1 && !defined(HAVE_SSE2)
+#define HAVE_SSE2
+#endif
+
+#if defined(HAVE_SSE2) && defined(__SSE2__)
+#define AE_KERNELS_HAVE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AE_KERNELS_HAVE_AVX2
+#include <immintrin.h>
+#define AVX2_FUNC __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define AE_KERNELS_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+/*
+ * Plain C, the reference for all others
+ */
+
+namespace
+{
+/*
+   This is a rational function to approximate a tanh-like soft clipper.
+   It is based on the pade-approximation of the tanh function with tweaked coefficients.
+   See: http://www.musicdsp.org/showone.php?id=238
+*/
+inline float SoftClamp(float x)
+{
+  if (x < -3.0f)
+    return -1.0f;
+  else if (x > 3.0f)
+    return 1.0f;
+  float y = x * x;
+  return x * (27.0f + y) / (27.0f + 9.0f * y);
+}
+
+inline int16_t FloatToS16(float x)
+{
+  float v = x * 32768.0f;
+  if (v >= 32767.0f)
+    return INT16_MAX;
+  if (v <= -32768.0f)
+    return INT16_MIN;
+  return (int16_t)lrintf(v);
+}
+
+inline int32_t FloatToS32(float x)
+{
+  float v = x * 2147483648.0f;
+  if (v >= 2147483648.0f)
+    return INT32_MAX;
+  if (v <= -2147483648.0f)
+    return INT32_MIN;
+  return (int32_t)lrintf(v);
+}
+
+void MulArrayC(float *data, float mul, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    data[i] *= mul;
+}
+
+bool MulAddArrayC(float *dst, const float *src, float mul, uint32_t count)
+{
+  bool clip = false;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    float add = src[i] * mul;
+    dst[i] += add;
+    if (fabsf(dst[i]) > 1.0f)
+      clip = true;
+  }
+  return clip;
+}
+
+void ClampArrayC(float *data, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    data[i] = SoftClamp(data[i]);
+}
+
+void FloatToS16C(int16_t *dst, const float *src, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    dst[i] = FloatToS16(src[i]);
+}
+
+void FloatToS32C(int32_t *dst, const float *src, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+    dst[i] = FloatToS32(src[i]);
+}
+
+const AEKernels kernelsC =
+{
+  "C",
+  MulArrayC,
+  MulAddArrayC,
+  ClampArrayC,
+  FloatToS16C,
+  FloatToS32C
+};
+
+/*
+ * SSE2, tails are left to the C routines
+ */
+
+#if defined(AE_KERNELS_HAVE_SSE2)
+void MulArraySSE2(float *data, float mul, uint32_t count)
+{
+  const __m128 m = _mm_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), m));
+  MulArrayC(data + i, mul, count - i);
+}
+
+bool MulAddArraySSE2(float *dst, const float *src, float mul, uint32_t count)
+{
+  const __m128 m = _mm_set1_ps(mul);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 clip = _mm_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 out = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), m));
+    _mm_storeu_ps(dst + i, out);
+    clip = _mm_or_ps(clip, _mm_cmpgt_ps(_mm_andnot_ps(sign, out), one));
+  }
+  bool tail = MulAddArrayC(dst + i, src + i, mul, count - i);
+  return _mm_movemask_ps(clip) != 0 || tail;
+}
+
+void ClampArraySSE2(float *data, uint32_t count)
+{
+  const __m128 c27 = _mm_set1_ps(27.0f);
+  const __m128 c9 = _mm_set1_ps(9.0f);
+  const __m128 c3 = _mm_set1_ps(3.0f);
+  const __m128 cm3 = _mm_set1_ps(-3.0f);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 mone = _mm_set1_ps(-1.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 x = _mm_loadu_ps(data + i);
+    __m128 y = _mm_mul_ps(x, x);
+    __m128 r = _mm_div_ps(_mm_mul_ps(x, _mm_add_ps(c27, y)), _mm_add_ps(c27, _mm_mul_ps(c9, y)));
+    __m128 hi = _mm_cmpgt_ps(x, c3);
+    __m128 lo = _mm_cmplt_ps(x, cm3);
+    r = _mm_or_ps(_mm_andnot_ps(hi, r), _mm_and_ps(hi, one));
+    r = _mm_or_ps(_mm_andnot_ps(lo, r), _mm_and_ps(lo, mone));
+    _mm_storeu_ps(data + i, r);
+  }
+  ClampArrayC(data + i, count - i);
+}
+
+void FloatToS16SSE2(int16_t *dst, const float *src, uint32_t count)
+{
+  const __m128 scale = _mm_set1_ps(32768.0f);
+  const __m128 max = _mm_set1_ps(32767.0f);
+  const __m128 min = _mm_set1_ps(-32768.0f);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), min), max);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), min), max);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+  }
+  FloatToS16C(dst + i, src + i, count - i);
+}
+
+void FloatToS32SSE2(int32_t *dst, const float *src, uint32_t count)
+{
+  const __m128 scale = _mm_set1_ps(2147483648.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+    // the conversion yields INT32_MIN for anything too large, flip that to INT32_MAX
+    __m128i over = _mm_castps_si128(_mm_cmpge_ps(v, scale));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(_mm_cvtps_epi32(v), over));
+  }
+  FloatToS32C(dst + i, src + i, count - i);
+}
+
+const AEKernels kernelsSSE2 =
+{
+  "SSE2",
+  MulArraySSE2,
+  MulAddArraySSE2,
+  ClampArraySSE2,
+  FloatToS16SSE2,
+  FloatToS32SSE2
+};
+#endif
+
+/*
+ * AVX2, built with a target attribute and only used if the cpu has it
+ */
+
+#if defined(AE_KERNELS_HAVE_AVX2)
+AVX2_FUNC void MulArrayAVX2(float *data, float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), m));
+  MulArrayC(data + i, mul, count - i);
+}
+
+AVX2_FUNC bool MulAddArrayAVX2(float *dst, const float *src, float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 clip = _mm256_setzero_ps();
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 out = _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), m));
+    _mm256_storeu_ps(dst + i, out);
+    clip = _mm256_or_ps(clip, _mm256_cmp_ps(_mm256_andnot_ps(sign, out), one, _CMP_GT_OQ));
+  }
+  bool tail = MulAddArrayC(dst + i, src + i, mul, count - i);
+  return _mm256_movemask_ps(clip) != 0 || tail;
+}
+
+AVX2_FUNC void ClampArrayAVX2(float *data, uint32_t count)
+{
+  const __m256 c27 = _mm256_set1_ps(27.0f);
+  const __m256 c9 = _mm256_set1_ps(9.0f);
+  const __m256 c3 = _mm256_set1_ps(3.0f);
+  const __m256 cm3 = _mm256_set1_ps(-3.0f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 mone = _mm256_set1_ps(-1.0f);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 x = _mm256_loadu_ps(data + i);
+    __m256 y = _mm256_mul_ps(x, x);
+    __m256 r = _mm256_div_ps(_mm256_mul_ps(x, _mm256_add_ps(c27, y)), _mm256_add_ps(c27, _mm256_mul_ps(c9, y)));
+    r = _mm256_blendv_ps(r, one, _mm256_cmp_ps(x, c3, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, mone, _mm256_cmp_ps(x, cm3, _CMP_LT_OQ));
+    _mm256_storeu_ps(data + i, r);
+  }
+  ClampArrayC(data + i, count - i);
+}
+
+AVX2_FUNC void FloatToS16AVX2(int16_t *dst, const float *src, uint32_t count)
+{
+  const __m256 scale = _mm256_set1_ps(32768.0f);
+  const __m256 max = _mm256_set1_ps(32767.0f);
+  const __m256 min = _mm256_set1_ps(-32768.0f);
+  uint32_t i = 0;
+  for (; i + 16 <= count; i += 16)
+  {
+    __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), min), max);
+    __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale), min), max);
+    // packing works per 128 bit lane, put the quarters back in order
+    __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+  FloatToS16C(dst + i, src + i, count - i);
+}
+
+AVX2_FUNC void FloatToS32AVX2(int32_t *dst, const float *src, uint32_t count)
+{
+  const __m256 scale = _mm256_set1_ps(2147483648.0f);
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+    __m256i over = _mm256_castps_si256(_mm256_cmp_ps(v, scale, _CMP_GE_OQ));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(_mm256_cvtps_epi32(v), over));
+  }
+  FloatToS32C(dst + i, src + i, count - i);
+}
+
+const AEKernels kernelsAVX2 =
+{
+  "AVX2",
+  MulArrayAVX2,
+  MulAddArrayAVX2,
+  ClampArrayAVX2,
+  FloatToS16AVX2,
+  FloatToS32AVX2
+};
+#endif
+
+/*
+ * NEON
+ */
+
+#if defined(AE_KERNELS_HAVE_NEON)
+void MulArrayNEON(float *data, float mul, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), mul));
+  MulArrayC(data + i, mul, count - i);
+}
+
+bool MulAddArrayNEON(float *dst, const float *src, float mul, uint32_t count)
+{
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  uint32x4_t clip = vdupq_n_u32(0);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t out = vaddq_f32(vld1q_f32(dst + i), vmulq_n_f32(vld1q_f32(src + i), mul));
+    vst1q_f32(dst + i, out);
+    clip = vorrq_u32(clip, vcgtq_f32(vabsq_f32(out), one));
+  }
+  uint32x2_t any = vorr_u32(vget_low_u32(clip), vget_high_u32(clip));
+  bool tail = MulAddArrayC(dst + i, src + i, mul, count - i);
+  return (vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) != 0 || tail;
+}
+
+#if defined(__aarch64__)
+void ClampArrayNEON(float *data, uint32_t count)
+{
+  const float32x4_t c27 = vdupq_n_f32(27.0f);
+  const float32x4_t c9 = vdupq_n_f32(9.0f);
+  const float32x4_t c3 = vdupq_n_f32(3.0f);
+  const float32x4_t cm3 = vdupq_n_f32(-3.0f);
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t mone = vdupq_n_f32(-1.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t x = vld1q_f32(data + i);
+    float32x4_t y = vmulq_f32(x, x);
+    float32x4_t r = vdivq_f32(vmulq_f32(x, vaddq_f32(c27, y)), vaddq_f32(c27, vmulq_f32(c9, y)));
+    r = vbslq_f32(vcgtq_f32(x, c3), one, r);
+    r = vbslq_f32(vcltq_f32(x, cm3), mone, r);
+    vst1q_f32(data + i, r);
+  }
+  ClampArrayC(data + i, count - i);
+}
+
+inline int32x4_t RoundNEON(float32x4_t v)
+{
+  return vcvtnq_s32_f32(v);
+}
+#else
+// ARMv7 NEON has no division, an estimate would not match the C output
+#define ClampArrayNEON ClampArrayC
+
+// round to nearest even like lrintf: adding and removing 2^23 with the sign of
+// v drops the fraction, values beyond that have none
+inline int32x4_t RoundNEON(float32x4_t v)
+{
+  const uint32x4_t sign = vdupq_n_u32(0x80000000);
+  const float32x4_t limit = vdupq_n_f32(8388608.0f);
+  float32x4_t magic = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(v), sign),
+                                                      vreinterpretq_u32_f32(limit)));
+  float32x4_t rounded = vsubq_f32(vaddq_f32(v, magic), magic);
+  return vcvtq_s32_f32(vbslq_f32(vcltq_f32(vabsq_f32(v), limit), rounded, v));
+}
+#endif
+
+void FloatToS16NEON(int16_t *dst, const float *src, uint32_t count)
+{
+  const float32x4_t max = vdupq_n_f32(32767.0f);
+  const float32x4_t min = vdupq_n_f32(-32768.0f);
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    float32x4_t v = vminq_f32(vmaxq_f32(vmulq_n_f32(vld1q_f32(src + i), 32768.0f), min), max);
+    vst1_s16(dst + i, vqmovn_s32(RoundNEON(v)));
+  }
+  FloatToS16C(dst + i, src + i, count - i);
+}
+
+void FloatToS32NEON(int32_t *dst, const float *src, uint32_t count)
+{
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    // the conversion saturates
+    vst1q_s32(dst + i, RoundNEON(vmulq_n_f32(vld1q_f32(src + i), 2147483648.0f)));
+  }
+  FloatToS32C(dst + i, src + i, count - i);
+}
+
+const AEKernels kernelsNEON =
+{
+  "NEON",
+  MulArrayNEON,
+  MulAddArrayNEON,
+  ClampArrayNEON,
+  FloatToS16NEON,
+  FloatToS32NEON
+};
+#endif
+
+const AEKernels* Select()
+{
+  const AEKernels *kernels = NULL;
+  for (int set = AE_KERNELS_MAX - 1; set >= 0 && !kernels; set--)
+    kernels = CAEKernels::Get((AEKernelSet)set);
+
+  CLog::Log(LOGNOTICE, "CAEKernels - using %s sample processing", kernels->name);
+  return kernels;
+}
+}
+
+const AEKernels& CAEKernels::Get()
+{
+  static const AEKernels *kernels = Select();
+  return *kernels;
+}
+
+const AEKernels* CAEKernels::Get(AEKernelSet set)
+{
+  unsigned int features = g_cpuInfo.GetCPUFeatures();
+
+  switch (set)
+  {
+  case AE_KERNELS_C:
+    return &kernelsC;
+#if defined(AE_KERNELS_HAVE_SSE2)
+  case AE_KERNELS_SSE2:
+    return (features & CPU_FEATURE_SSE2) ? &kernelsSSE2 : NULL;
+#endif
+#if defined(AE_KERNELS_HAVE_AVX2)
+  case AE_KERNELS_AVX2:
+    return (features & CPU_FEATURE_AVX2) ? &kernelsAVX2 : NULL;
+#endif
+#if defined(AE_KERNELS_HAVE_NEON)
+  case AE_KERNELS_NEON:
+#if defined(__aarch64__)
+    return &kernelsNEON;
+#else
+    return (features & CPU_FEATURE_NEON) ? &kernelsNEON : NULL;
+#endif
+#endif
+  default:
+    return NULL;
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+enum AEKernelSet
+{
+  AE_KERNELS_C = 0,
+  AE_KERNELS_SSE2,
+  AE_KERNELS_AVX2,
+  AE_KERNELS_NEON,
+  AE_KERNELS_MAX
+};
+
+/*!
+ \brief Sample processing routines of the audio engine
+
+ All implementations produce the same output bit for bit as the plain C
+ ones, buffers need no particular alignment.
+ */
+struct AEKernels
+{
+  const char *name;
+
+  /*! \brief data *= mul */
+  void (*MulArray)(float *data, float mul, uint32_t count);
+
+  /*! \brief dst += src * mul
+   \return true if a sample of dst left the range -1..1
+   */
+  bool (*MulAddArray)(float *dst, const float *src, float mul, uint32_t count);
+
+  /*! \brief soft clamp data into -1..1 */
+  void (*ClampArray)(float *data, uint32_t count);
+
+  /*! \brief convert float samples to S16 and S32, rounding to nearest and saturating like swresample */
+  void (*FloatToS16)(int16_t *dst, const float *src, uint32_t count);
+  void (*FloatToS32)(int32_t *dst, const float *src, uint32_t count);
+};
+
+class CAEKernels
+{
+public:
+  /*! \brief fastest kernels the cpu supports, picked on first use */
+  static const AEKernels& Get();
+
+  /*! \brief a specific implementation, NULL if it isn't built in or the cpu lacks it */
+  static const AEKernels* Get(AEKernelSet set);
+};
@@ -0,0 +1,305 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEKernels.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+// odd sizes and offsets so every implementation runs its vector loop and its tail unaligned
+const uint32_t sizes[] = { 0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 1001 };
+const uint32_t offsets[] = { 0, 1, 2, 3 };
+
+std::vector<float> RandomSamples(size_t count, float range, unsigned int seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> distribution(-range, range);
+  std::vector<float> samples(count);
+  for (auto& sample : samples)
+    sample = distribution(generator);
+  return samples;
+}
+
+std::vector<const AEKernels*> Kernels()
+{
+  std::vector<const AEKernels*> kernels;
+  for (int set = AE_KERNELS_C + 1; set < AE_KERNELS_MAX; set++)
+  {
+    const AEKernels *k = CAEKernels::Get((AEKernelSet)set);
+    if (k)
+      kernels.push_back(k);
+  }
+  return kernels;
+}
+}
+
+TEST(TestAEKernels, Available)
+{
+  ASSERT_NE(nullptr, CAEKernels::Get(AE_KERNELS_C));
+  EXPECT_NE(nullptr, CAEKernels::Get().name);
+}
+
+TEST(TestAEKernels, MulArray)
+{
+  const AEKernels &c = *CAEKernels::Get(AE_KERNELS_C);
+  for (const AEKernels *k : Kernels())
+  {
+    for (uint32_t size : sizes)
+    {
+      for (uint32_t offset : offsets)
+      {
+        std::vector<float> expected = RandomSamples(size + offset, 2.0f, size);
+        std::vector<float> result(expected);
+        c.MulArray(expected.data() + offset, 0.37f, size);
+        k->MulArray(result.data() + offset, 0.37f, size);
+        EXPECT_EQ(0, memcmp(expected.data(), result.data(), expected.size() * sizeof(float)))
+          << k->name << " size " << size << " offset " << offset;
+      }
+    }
+  }
+}
+
+TEST(TestAEKernels, MulAddArray)
+{
+  const AEKernels &c = *CAEKernels::Get(AE_KERNELS_C);
+  for (const AEKernels *k : Kernels())
+  {
+    for (uint32_t size : sizes)
+    {
+      for (uint32_t offset : offsets)
+      {
+        std::vector<float> src = RandomSamples(size + offset, 1.0f, size + 1);
+        std::vector<float> expected = RandomSamples(size + offset, 0.5f, size);
+        std::vector<float> result(expected);
+        bool expectedClip = c.MulAddArray(expected.data() + offset, src.data() + offset, 0.8f, size);
+        bool clip = k->MulAddArray(result.data() + offset, src.data() + offset, 0.8f, size);
+        EXPECT_EQ(expectedClip, clip) << k->name << " size " << size;
+        EXPECT_EQ(0, memcmp(expected.data(), result.data(), expected.size() * sizeof(float)))
+          << k->name << " size " << size << " offset " << offset;
+      }
+    }
+  }
+}
+
+TEST(TestAEKernels, MulAddArrayClip)
+{
+  for (int set = AE_KERNELS_C; set < AE_KERNELS_MAX; set++)
+  {
+    const AEKernels *k = CAEKernels::Get((AEKernelSet)set);
+    if (!k)
+      continue;
+
+    // a single sample out of range, wherever it is, has to be reported
+    for (uint32_t pos = 0; pos < 33; pos++)
+    {
+      std::vector<float> dst(33, 0.5f);
+      std::vector<float> src(33, 0.0f);
+      src[pos] = -2.0f;
+      EXPECT_TRUE(k->MulAddArray(dst.data(), src.data(), 1.0f, 33)) << k->name << " pos " << pos;
+    }
+
+    std::vector<float> dst(33, 0.5f);
+    std::vector<float> src(33, 0.5f);
+    EXPECT_FALSE(k->MulAddArray(dst.data(), src.data(), 1.0f, 33)) << k->name;
+  }
+}
+
+TEST(TestAEKernels, ClampArray)
+{
+  const AEKernels &c = *CAEKernels::Get(AE_KERNELS_C);
+  for (const AEKernels *k : Kernels())
+  {
+    for (uint32_t size : sizes)
+    {
+      for (uint32_t offset : offsets)
+      {
+        std::vector<float> expected = RandomSamples(size + offset, 4.0f, size);
+        std::vector<float> result(expected);
+        c.ClampArray(expected.data() + offset, size);
+        k->ClampArray(result.data() + offset, size);
+        EXPECT_EQ(0, memcmp(expected.data(), result.data(), expected.size() * sizeof(float)))
+          << k->name << " size " << size << " offset " << offset;
+      }
+    }
+  }
+}
+
+TEST(TestAEKernels, ClampRange)
+{
+  const AEKernels &c = *CAEKernels::Get(AE_KERNELS_C);
+  float samples[] = { -10.0f, -3.0f, -1.0f, 0.0f, 0.5f, 1.0f, 3.0f, 10.0f };
+  c.ClampArray(samples, sizeof(samples) / sizeof(float));
+  for (float sample : samples)
+  {
+    EXPECT_LE(sample, 1.0f);
+    EXPECT_GE(sample, -1.0f);
+  }
+  EXPECT_EQ(-1.0f, samples[0]);
+  EXPECT_EQ(0.0f, samples[3]);
+  EXPECT_EQ(1.0f, samples[7]);
+}
+
+TEST(TestAEKernels, FloatToS16)
+{
+  const AEKernels &c = *CAEKernels::Get(AE_KERNELS_C);
+
+  float edges[] = { -2.0f, -1.0f, -0.5f, 0.0f, 0.5f, 32766.5f / 32768, 32767.5f / 32768, 1.0f, 2.0f };
+  int16_t converted[sizeof(edges) / sizeof(float)];
+  c.FloatToS16(converted, edges, sizeof(edges) / sizeof(float));
+  EXPECT_EQ(INT16_MIN, converted[0]);
+  EXPECT_EQ(INT16_MIN, converted[1]);
+  EXPECT_EQ(-16384, converted[2]);
+  EXPECT_EQ(0, converted[3]);
+  EXPECT_EQ(16384, converted[4]);
+  EXPECT_EQ(32766, converted[5]);
+  EXPECT_EQ(INT16_MAX, converted[6]);
+  EXPECT_EQ(INT16_MAX, converted[7]);
+  EXPECT_EQ(INT16_MAX, converted[8]);
+
+  // every value halfway between two steps, rounding has to go to even everywhere
+  std::vector<float> ties;
+  for (int i = -33000; i < 33000; i++)
+    ties.push_back((i + 0.5f) / 32768);
+
+  for (const AEKernels *k : Kernels())
+  {
+    for (uint32_t size : sizes)
+    {
+      for (uint32_t offset : offsets)
+      {
+        std::vector<float> src = RandomSamples(size + offset, 1.5f, size);
+        std::vector<int16_t> expected(size), result(size);
+        c.FloatToS16(expected.data(), src.data() + offset, size);
+        k->FloatToS16(result.data(), src.data() + offset, size);
+        EXPECT_EQ(expected, result) << k->name << " size " << size << " offset " << offset;
+      }
+    }
+
+    std::vector<int16_t> expected(ties.size()), result(ties.size());
+    c.FloatToS16(expected.data(), ties.data(), ties.size());
+    k->FloatToS16(result.data(), ties.data(), ties.size());
+    EXPECT_EQ(expected, result) << k->name;
+  }
+}
+
+TEST(TestAEKernels, FloatToS32)
+{
+  const AEKernels &c = *CAEKernels::Get(AE_KERNELS_C);
+
+  float edges[] = { -2.0f, -1.0f, -0.5f, 0.0f, 0.5f, 1.0f, 2.0f };
+  int32_t converted[sizeof(edges) / sizeof(float)];
+  c.FloatToS32(converted, edges, sizeof(edges) / sizeof(float));
+  EXPECT_EQ(INT32_MIN, converted[0]);
+  EXPECT_EQ(INT32_MIN, converted[1]);
+  EXPECT_EQ(-1073741824, converted[2]);
+  EXPECT_EQ(0, converted[3]);
+  EXPECT_EQ(1073741824, converted[4]);
+  EXPECT_EQ(INT32_MAX, converted[5]);
+  EXPECT_EQ(INT32_MAX, converted[6]);
+
+  std::vector<float> ties;
+  for (int i = -33000; i < 33000; i++)
+    ties.push_back((i + 0.5f) / 2147483648.0f);
+
+  for (const AEKernels *k : Kernels())
+  {
+    for (uint32_t size : sizes)
+    {
+      for (uint32_t offset : offsets)
+      {
+        std::vector<float> src = RandomSamples(size + offset, 1.5f, size);
+        std::vector<int32_t> expected(size), result(size);
+        c.FloatToS32(expected.data(), src.data() + offset, size);
+        k->FloatToS32(result.data(), src.data() + offset, size);
+        EXPECT_EQ(expected, result) << k->name << " size " << size << " offset " << offset;
+      }
+    }
+
+    std::vector<int32_t> expected(ties.size()), result(ties.size());
+    c.FloatToS32(expected.data(), ties.data(), ties.size());
+    k->FloatToS32(result.data(), ties.data(), ties.size());
+    EXPECT_EQ(expected, result) << k->name;
+
+    int32_t edge[sizeof(edges) / sizeof(float)];
+    k->FloatToS32(edge, edges, sizeof(edges) / sizeof(float));
+    EXPECT_EQ(0, memcmp(converted, edge, sizeof(edge))) << k->name;
+  }
+}
+
+/*
+ * Times the mix path of one second of 7.1 float at 192 kHz for every implementation.
+ * KODI_BENCHMARK_AEKERNELS sets the number of rounds, 10 by default.
+ */
+TEST(TestAEKernels, DISABLED_Benchmark)
+{
+  int rounds = atoi(XBMC_BENCHMARK_OPTION("KODI_BENCHMARK_AEKERNELS", "10").c_str());
+  ASSERT_GT(rounds, 0);
+
+  const uint32_t count = 192000 * 8;
+  std::vector<float> src = RandomSamples(count, 0.5f, 1);
+  std::vector<float> dst(count);
+  std::vector<int16_t> s16(count);
+  std::vector<int32_t> s32(count);
+
+  for (int set = AE_KERNELS_C; set < AE_KERNELS_MAX; set++)
+  {
+    const AEKernels *k = CAEKernels::Get((AEKernelSet)set);
+    if (!k)
+      continue;
+
+    unsigned int times[5] = {};
+    for (int round = 0; round < rounds; round++)
+    {
+      std::fill(dst.begin(), dst.end(), 0.5f);
+
+      unsigned int start = XbmcThreads::SystemClockMillis();
+      k->MulArray(dst.data(), 0.9f, count);
+      times[0] += XbmcThreads::SystemClockMillis() - start;
+
+      start = XbmcThreads::SystemClockMillis();
+      k->MulAddArray(dst.data(), src.data(), 1.5f, count);
+      times[1] += XbmcThreads::SystemClockMillis() - start;
+
+      start = XbmcThreads::SystemClockMillis();
+      k->ClampArray(dst.data(), count);
+      times[2] += XbmcThreads::SystemClockMillis() - start;
+
+      start = XbmcThreads::SystemClockMillis();
+      k->FloatToS16(s16.data(), dst.data(), count);
+      times[3] += XbmcThreads::SystemClockMillis() - start;
+
+      start = XbmcThreads::SystemClockMillis();
+      k->FloatToS32(s32.data(), dst.data(), count);
+      times[4] += XbmcThreads::SystemClockMillis() - start;
+    }
+
+    std::cout << k->name << ": mul " << times[0] << " ms, mix " << times[1] << " ms, clamp " << times[2]
+              << " ms, s16 " << times[3] << " ms, s32 " << times[4] << " ms" << std::endl;
+  }
+}
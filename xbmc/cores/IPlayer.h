@@ -37,6 +37,7 @@ struct TextCacheStruct_t;
 class TiXmlElement;
 class CStreamDetails;
 class CAction;
+class CVariant;
 
 namespace PVR
 {
@@ -238,6 +239,8 @@ public:
   virtual bool Initialize(TiXmlElement* pConfig) { return true; };
   virtual bool OpenFile(const CFileItem& file, const CPlayerOptions& options){ return false;}
   virtual bool QueueNextFile(const CFileItem &file) { return false; }
+  /*! \brief Open the input of the item likely played next ahead, so a following OpenFile of it starts sooner */
+  virtual bool PreOpenFile(const CFileItem &file) { return false; }
   virtual void OnNothingToQueueNotify() {}
   virtual bool CloseFile(bool reopen = false) = 0;
   virtual bool IsPlaying() const { return false;}
@@ -288,6 +291,12 @@ public:
   virtual void GetVideoStreamInfo(int streamId, SPlayerVideoStreamInfo &info) {}
   virtual void SetVideoStream(int iStream) {}
 
+  /*!
+   \brief Get timing, drop, buffer level and sync statistics of the current playback
+   \return false if the player doesn't collect statistics
+   */
+  virtual bool GetPlaybackStats(CVariant &stats) { return false; }
+
   virtual TextCacheStruct_t* GetTeletextCache() { return NULL; };
   virtual void LoadPage(int p, int sp, unsigned char* buffer) {};
 
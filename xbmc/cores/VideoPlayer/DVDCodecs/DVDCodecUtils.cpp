@@ -20,6 +20,7 @@
 
 #include "DVDCodecUtils.h"
 #include "DVDClock.h"
+#include "DVDSliceWorkers.h"
 #include "cores/VideoPlayer/VideoRenderers/RenderManager.h"
 #include "utils/log.h"
 #include "cores/FFmpeg.h"
@@ -39,6 +40,34 @@ extern "C" {
 #include "libswscale/swscale.h"
 }
 
+namespace
+{
+// copy the rows of a plane belonging to the given slice, contiguous planes in one go
+void CopyPlaneSlice(uint8_t *dst, int dstStride, const uint8_t *src, int srcStride,
+                    int width, int rows, int slice, int slices)
+{
+  int first = rows * slice / slices;
+  int last = rows * (slice + 1) / slices;
+  if (first >= last)
+    return;
+
+  dst += first * dstStride;
+  src += first * srcStride;
+  if (width == srcStride && srcStride == dstStride)
+  {
+    memcpy(dst, src, width * (last - first));
+    return;
+  }
+
+  for (int y = first; y < last; y++)
+  {
+    memcpy(dst, src, width);
+    src += srcStride;
+    dst += dstStride;
+  }
+}
+}
+
 // allocate a new picture (AV_PIX_FMT_YUV420P)
 DVDVideoPicture* CDVDCodecUtils::AllocatePicture(int iWidth, int iHeight)
 {
@@ -82,94 +111,33 @@ void CDVDCodecUtils::FreePicture(DVDVideoPicture* pPicture)
 
 bool CDVDCodecUtils::CopyPicture(DVDVideoPicture* pDst, DVDVideoPicture* pSrc)
 {
-  uint8_t *s, *d;
   int w = pSrc->iWidth;
   int h = pSrc->iHeight;
 
-  s = pSrc->data[0];
-  d = pDst->data[0];
-
-  for (int y = 0; y < h; y++)
-  {
-    memcpy(d, s, w);
-    s += pSrc->iLineSize[0];
-    d += pDst->iLineSize[0];
-  }
-
-  w >>= 1;
-  h >>= 1;
-
-  s = pSrc->data[1];
-  d = pDst->data[1];
-  for (int y = 0; y < h; y++)
+  CDVDSliceWorkers& workers = CDVDSliceWorkers::GetInstance();
+  workers.Run(workers.GetSliceCount(w * h * 3 / 2), [&](int slice, int slices)
   {
-    memcpy(d, s, w);
-    s += pSrc->iLineSize[1];
-    d += pDst->iLineSize[1];
-  }
-
-  s = pSrc->data[2];
-  d = pDst->data[2];
-  for (int y = 0; y < h; y++)
-  {
-    memcpy(d, s, w);
-    s += pSrc->iLineSize[2];
-    d += pDst->iLineSize[2];
-  }
+    CopyPlaneSlice(pDst->data[0], pDst->iLineSize[0], pSrc->data[0], pSrc->iLineSize[0], w, h, slice, slices);
+    CopyPlaneSlice(pDst->data[1], pDst->iLineSize[1], pSrc->data[1], pSrc->iLineSize[1], w >> 1, h >> 1, slice, slices);
+    CopyPlaneSlice(pDst->data[2], pDst->iLineSize[2], pSrc->data[2], pSrc->iLineSize[2], w >> 1, h >> 1, slice, slices);
+  });
   return true;
 }
 
 bool CDVDCodecUtils::CopyPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  uint8_t *s = pSrc->data[0];
-  uint8_t *d = pImage->plane[0];
   int w = pImage->width * pImage->bpp;
   int h = pImage->height;
-  if ((w == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      memcpy(d, s, w);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  s = pSrc->data[1];
-  d = pImage->plane[1];
-  w =(pImage->width  >> pImage->cshift_x) * pImage->bpp;
-  h =(pImage->height >> pImage->cshift_y);
-  if ((w==pSrc->iLineSize[1]) && ((unsigned int) pSrc->iLineSize[1]==pImage->stride[1]))
-  {
-    memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      memcpy(d, s, w);
-      s += pSrc->iLineSize[1];
-      d += pImage->stride[1];
-    }
-  }
-  s = pSrc->data[2];
-  d = pImage->plane[2];
-  if ((w==pSrc->iLineSize[2]) && ((unsigned int) pSrc->iLineSize[2]==pImage->stride[2]))
-  {
-    memcpy(d, s, w*h);
-  }
-  else
+  int cw = (pImage->width  >> pImage->cshift_x) * pImage->bpp;
+  int ch = (pImage->height >> pImage->cshift_y);
+
+  CDVDSliceWorkers& workers = CDVDSliceWorkers::GetInstance();
+  workers.Run(workers.GetSliceCount(w * h + cw * ch * 2), [&](int slice, int slices)
   {
-    for (int y = 0; y < h; y++)
-    {
-      memcpy(d, s, w);
-      s += pSrc->iLineSize[2];
-      d += pImage->stride[2];
-    }
-  }
+    CopyPlaneSlice(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], w, h, slice, slices);
+    CopyPlaneSlice(pImage->plane[1], pImage->stride[1], pSrc->data[1], pSrc->iLineSize[1], cw, ch, slice, slices);
+    CopyPlaneSlice(pImage->plane[2], pImage->stride[2], pSrc->data[2], pSrc->iLineSize[2], cw, ch, slice, slices);
+  });
   return true;
 }
 
@@ -198,27 +166,25 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToNV12Picture(DVDVideoPicture *pSrc)
       pPicture->iLineSize[3] = 0;
       pPicture->format = RENDER_FMT_NV12;
       
-      // copy luma
-      uint8_t *s = pSrc->data[0];
-      uint8_t *d = pPicture->data[0];
-      for (int y = 0; y < (int)pSrc->iHeight; y++)
+      CDVDSliceWorkers& workers = CDVDSliceWorkers::GetInstance();
+      workers.Run(workers.GetSliceCount(totalsize), [&](int slice, int slices)
       {
-        memcpy(d, s, pSrc->iWidth);
-        s += pSrc->iLineSize[0];
-        d += pPicture->iLineSize[0];
-      }
-
-      //copy chroma
-      for (int y = 0; y < (int)pSrc->iHeight/2; y++) {
-        uint8_t *s_u = pSrc->data[1] + (y * pSrc->iLineSize[1]);
-        uint8_t *s_v = pSrc->data[2] + (y * pSrc->iLineSize[2]);
-        uint8_t *d_uv = pPicture->data[1] + (y * pPicture->iLineSize[1]);
-        for (int x = 0; x < (int)pSrc->iWidth/2; x++) {
-          *d_uv++ = *s_u++;
-          *d_uv++ = *s_v++;
+        // copy luma
+        CopyPlaneSlice(pPicture->data[0], pPicture->iLineSize[0], pSrc->data[0], pSrc->iLineSize[0],
+                       pSrc->iWidth, pSrc->iHeight, slice, slices);
+
+        //copy chroma
+        int rows = pSrc->iHeight / 2;
+        for (int y = rows * slice / slices; y < rows * (slice + 1) / slices; y++) {
+          uint8_t *s_u = pSrc->data[1] + (y * pSrc->iLineSize[1]);
+          uint8_t *s_v = pSrc->data[2] + (y * pSrc->iLineSize[2]);
+          uint8_t *d_uv = pPicture->data[1] + (y * pPicture->iLineSize[1]);
+          for (int x = 0; x < (int)pSrc->iWidth/2; x++) {
+            *d_uv++ = *s_u++;
+            *d_uv++ = *s_v++;
+          }
         }
-      }
-      
+      });
     }
     else
     {
@@ -287,69 +253,31 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToYUV422PackedPicture(DVDVideoPicture *p
 
 bool CDVDCodecUtils::CopyNV12Picture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  uint8_t *s = pSrc->data[0];
-  uint8_t *d = pImage->plane[0];
   int w = pSrc->iWidth;
   int h = pSrc->iHeight;
-  // Copy Y
-  if ((w == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      memcpy(d, s, w);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  
-  s = pSrc->data[1];
-  d = pImage->plane[1];
-  w = pSrc->iWidth;
-  h = pSrc->iHeight >> 1;
-  // Copy packed UV (width is same as for Y as it's both U and V components)
-  if ((w==pSrc->iLineSize[1]) && ((unsigned int) pSrc->iLineSize[1]==pImage->stride[1]))
-  {
-    memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      memcpy(d, s, w);
-      s += pSrc->iLineSize[1];
-      d += pImage->stride[1];
-    }
-  }
 
+  CDVDSliceWorkers& workers = CDVDSliceWorkers::GetInstance();
+  workers.Run(workers.GetSliceCount(w * h * 3 / 2), [&](int slice, int slices)
+  {
+    // Copy Y
+    CopyPlaneSlice(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], w, h, slice, slices);
+    // Copy packed UV (width is same as for Y as it's both U and V components)
+    CopyPlaneSlice(pImage->plane[1], pImage->stride[1], pSrc->data[1], pSrc->iLineSize[1], w, h >> 1, slice, slices);
+  });
   return true;
 }
 
 bool CDVDCodecUtils::CopyYUV422PackedPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  uint8_t *s = pSrc->data[0];
-  uint8_t *d = pImage->plane[0];
   int w = pSrc->iWidth;
   int h = pSrc->iHeight;
 
   // Copy YUYV
-  if ((w * 2 == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    memcpy(d, s, w*h*2);
-  }
-  else
+  CDVDSliceWorkers& workers = CDVDSliceWorkers::GetInstance();
+  workers.Run(workers.GetSliceCount(w * h * 2), [&](int slice, int slices)
   {
-    for (int y = 0; y < h; y++)
-    {
-      memcpy(d, s, w*2);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  
+    CopyPlaneSlice(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], w * 2, h, slice, slices);
+  });
   return true;
 }
 
@@ -0,0 +1,137 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDSliceWorkers.h"
+#include "threads/SingleLock.h"
+#include "utils/CPUInfo.h"
+#include "utils/log.h"
+
+#include <algorithm>
+
+#define MAX_SLICE_WORKERS 3
+#define MIN_SLICE_BYTES (1024 * 1024) // below this a memcpy is faster than waking a thread
+
+CDVDSliceWorkers& CDVDSliceWorkers::GetInstance()
+{
+  static CDVDSliceWorkers workers;
+  return workers;
+}
+
+CDVDSliceWorkers::CDVDSliceWorkers()
+  : m_func(NULL)
+  , m_pending(0)
+  , m_stopped(false)
+{
+}
+
+CDVDSliceWorkers::~CDVDSliceWorkers()
+{
+  Stop();
+}
+
+void CDVDSliceWorkers::Stop()
+{
+  CSingleLock lock(m_section);
+  m_stopped = true;
+  for (auto& worker : m_workers)
+    worker->StopThread();
+  m_workers.clear();
+}
+
+int CDVDSliceWorkers::GetSliceCount(unsigned int bytes) const
+{
+  int cpus = g_cpuInfo.getCPUCount();
+  if (cpus < 2 || bytes < MIN_SLICE_BYTES)
+    return 1;
+
+  int slices = std::min(cpus, MAX_SLICE_WORKERS + 1);
+  return std::max(1, std::min<int>(slices, bytes / MIN_SLICE_BYTES));
+}
+
+void CDVDSliceWorkers::Run(int slices, const SliceFunc &func)
+{
+  CSingleTryLock lock(m_section);
+  if (slices <= 1 || !lock.IsOwner() || m_stopped)
+  {
+    for (int i = 0; i < slices; i++)
+      func(i, slices);
+    return;
+  }
+
+  slices = std::min(slices, MAX_SLICE_WORKERS + 1);
+  while ((int)m_workers.size() < slices - 1)
+  {
+    m_workers.push_back(std::unique_ptr<CWorker>(new CWorker(*this)));
+    m_workers.back()->Create();
+    CLog::Log(LOGDEBUG, "CDVDSliceWorkers::%s - started slice worker %d", __FUNCTION__, (int)m_workers.size());
+  }
+
+  m_func = &func;
+  m_pending = slices - 1;
+  m_done.Reset();
+  for (int i = 1; i < slices; i++)
+    m_workers[i - 1]->Start(i, slices);
+
+  func(0, slices);
+
+  m_done.Wait();
+  m_func = NULL;
+}
+
+void CDVDSliceWorkers::SliceDone()
+{
+  if (--m_pending == 0)
+    m_done.Set();
+}
+
+CDVDSliceWorkers::CWorker::CWorker(CDVDSliceWorkers &owner)
+  : CThread("SliceWorker")
+  , m_owner(owner)
+  , m_slice(0)
+  , m_slices(0)
+{
+}
+
+void CDVDSliceWorkers::CWorker::Start(int slice, int slices)
+{
+  m_slice = slice;
+  m_slices = slices;
+  m_start.Set();
+}
+
+void CDVDSliceWorkers::CWorker::StopThread(bool bWait /*= true*/)
+{
+  m_bStop = true;
+  m_start.Set();
+  CThread::StopThread(bWait);
+}
+
+void CDVDSliceWorkers::CWorker::Process()
+{
+  while (!m_bStop)
+  {
+    m_start.Wait();
+    if (m_bStop)
+      break;
+
+    (*m_owner.m_func)(m_slice, m_slices);
+    m_owner.SliceDone();
+  }
+}
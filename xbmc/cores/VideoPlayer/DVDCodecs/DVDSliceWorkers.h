@@ -0,0 +1,93 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
+
+/*!
+ \brief Small pool of threads splitting picture copies and conversions into slices of rows.
+
+ The calling thread works on the first slice itself and waits for the workers
+ to finish the others, so a call behaves like a plain function call. Only one
+ job runs at a time, a second caller runs all its slices inline rather than
+ waiting for the pool.
+ */
+class CDVDSliceWorkers
+{
+public:
+  typedef std::function<void(int slice, int slices)> SliceFunc;
+
+  static CDVDSliceWorkers& GetInstance();
+
+  /*!
+   \brief Number of slices worth using for a job touching the given amount of memory
+   \return 1 if the job is too small to be split
+   */
+  int GetSliceCount(unsigned int bytes) const;
+
+  /*! \brief Run func for every slice in [0, slices) and return when all are done */
+  void Run(int slices, const SliceFunc &func);
+
+  /*!
+   \brief Stop the worker threads, waits for a job in progress
+   Called on shutdown rather than leaving the threads to the static destructor.
+   Jobs run afterwards are done inline by the caller.
+   */
+  void Stop();
+
+  ~CDVDSliceWorkers();
+
+private:
+  CDVDSliceWorkers();
+  CDVDSliceWorkers(const CDVDSliceWorkers&) = delete;
+  CDVDSliceWorkers& operator=(const CDVDSliceWorkers&) = delete;
+
+  class CWorker : public CThread
+  {
+  public:
+    explicit CWorker(CDVDSliceWorkers &owner);
+    void Start(int slice, int slices);
+    void StopThread(bool bWait = true) override;
+  protected:
+    void Process() override;
+  private:
+    CDVDSliceWorkers &m_owner;
+    CEvent m_start;
+    int m_slice;
+    int m_slices;
+  };
+
+  void SliceDone();
+
+  std::vector<std::unique_ptr<CWorker>> m_workers;
+  CCriticalSection m_section;
+  const SliceFunc *m_func;
+  std::atomic<int> m_pending;
+  CEvent m_done;
+  bool m_stopped;
+};
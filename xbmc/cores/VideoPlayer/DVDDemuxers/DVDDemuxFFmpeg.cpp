@@ -171,6 +171,9 @@ CDVDDemuxFFmpeg::CDVDDemuxFFmpeg() : CDVDDemux()
   memset(&m_pkt.pkt, 0, sizeof(AVPacket));
   m_streaminfo = true; /* set to true if we want to look for streams before playback */
   m_checkvideo = false;
+  m_keyframeStream = -1;
+  m_keyframeContinuous = false;
+  m_keyframeFromStart = false;
 }
 
 CDVDDemuxFFmpeg::~CDVDDemuxFFmpeg()
@@ -191,7 +194,7 @@ bool CDVDDemuxFFmpeg::Aborted()
   return false;
 }
 
-bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool fileinfo)
+bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool fileinfo, bool quickProbe)
 {
   AVInputFormat* iformat = NULL;
   std::string strFile;
@@ -413,6 +416,18 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
   // Avoid detecting framerate if advancedsettings.xml says so
   if (g_advancedSettings.m_videoFpsDetect == 0) 
       m_pFormatContext->fps_probe_size = 0;
+
+  // stream details and thumbs don't need the frame rate
+  if (fileinfo)
+    m_pFormatContext->fps_probe_size = 0;
+
+  // containers with a complete header only need a few packets to fill in what it leaves open
+  if (quickProbe)
+  {
+    const char *name = m_pFormatContext->iformat->name;
+    if (strncmp(name, "matroska", 8) == 0 || strcmp(name, "mov,mp4,m4a,3gp,3g2,mj2") == 0)
+      av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
+  }
   
   // analyse very short to speed up mjpeg playback start
   if (iformat && (strcmp(iformat->name, "mjpeg") == 0) && m_ioContext->seekable == 0)
@@ -543,7 +558,21 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
   {
     SeekTime(0);
   }
-  
+
+  // mpeg ts/ps carry no index of their own, keep one so seeks can go straight to a keyframe
+  if (m_pInput->IsStreamType(DVDSTREAM_TYPE_FILE) && !m_pInput->IsRealtime() && m_pFormatContext->iformat &&
+      (m_pFormatContext->iformat->flags & AVFMT_TS_DISCONT) && !(m_pFormatContext->iformat->flags & AVFMT_NO_BYTE_SEEK))
+  {
+    int64_t length = m_pInput->GetLength();
+    if (length > 0)
+    {
+      m_keyframeIndex = CDVDKeyframeIndex::Get(m_pInput->GetFileName(), length);
+      m_keyframeStream = av_find_best_stream(m_pFormatContext, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+      m_keyframeContinuous = false;
+      m_keyframeFromStart = true;
+    }
+  }
+
   return true;
 }
 
@@ -577,6 +606,9 @@ void CDVDDemuxFFmpeg::Dispose()
   m_pFormatContext = NULL;
   m_speed = DVD_PLAYSPEED_NORMAL;
 
+  m_keyframeIndex.reset();
+  m_keyframeStream = -1;
+
   DisposeStreams();
 
   m_pInput = NULL;
@@ -605,6 +637,7 @@ void CDVDDemuxFFmpeg::Flush()
 
   m_displayTime = 0;
   m_dtsAtDisplayTime = DVD_NOPTS_VALUE;
+  m_keyframeContinuous = false;
 }
 
 void CDVDDemuxFFmpeg::Abort()
@@ -875,6 +908,9 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
     }
     else if (m_pkt.result < 0)
     {
+      // every keyframe went through the index if we got here without seeking
+      if (m_pkt.result == AVERROR_EOF && m_keyframeIndex && m_keyframeFromStart)
+        m_keyframeIndex->SetComplete();
       Flush();
     }
     else if (IsProgramChange())
@@ -921,7 +957,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           {
             if(m_pkt.pkt.stream_index == (int)m_pFormatContext->programs[m_program]->stream_index[i])
             {
-              pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt.size);
+              pPacket = CDVDDemuxUtils::AllocateDemuxPacketFromAVPacket(&m_pkt.pkt);
               break;
             }
           }
@@ -930,7 +966,7 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
             bReturnEmpty = true;
         }
         else
-          pPacket = CDVDDemuxUtils::AllocateDemuxPacket(m_pkt.pkt.size);
+          pPacket = CDVDDemuxUtils::AllocateDemuxPacketFromAVPacket(&m_pkt.pkt);
       }
       else
         bReturnEmpty = true;
@@ -957,17 +993,22 @@ DemuxPacket* CDVDDemuxFFmpeg::Read()
           m_pkt.pkt.pts = AV_NOPTS_VALUE;
         }
 
-        // copy contents into our own packet
-        pPacket->iSize = m_pkt.pkt.size;
-
-        // maybe we can avoid a memcpy here by detecting where pkt.destruct is pointing too?
-        if (m_pkt.pkt.data)
-          memcpy(pPacket->pData, m_pkt.pkt.data, pPacket->iSize);
-
         pPacket->pts = ConvertTimestamp(m_pkt.pkt.pts, stream->time_base.den, stream->time_base.num);
         pPacket->dts = ConvertTimestamp(m_pkt.pkt.dts, stream->time_base.den, stream->time_base.num);
         pPacket->duration =  DVD_SEC_TO_TIME((double)m_pkt.pkt.duration * stream->time_base.num / stream->time_base.den);
 
+        if (m_keyframeIndex && m_pkt.pkt.stream_index == m_keyframeStream)
+        {
+          double keyTime = pPacket->dts != DVD_NOPTS_VALUE ? pPacket->dts : pPacket->pts;
+          if (keyTime == DVD_NOPTS_VALUE)
+            m_keyframeContinuous = false;
+          else if ((m_pkt.pkt.flags & AV_PKT_FLAG_KEY) && m_pkt.pkt.pos >= 0)
+          {
+            m_keyframeIndex->Add(DVD_TIME_TO_MSEC(keyTime), m_pkt.pkt.pos, m_keyframeContinuous);
+            m_keyframeContinuous = true;
+          }
+        }
+
         CDVDInputStream::IDisplayTime *inputStream = m_pInput->GetIDisplayTime();
         if (inputStream)
         {
@@ -1111,7 +1152,23 @@ bool CDVDDemuxFFmpeg::SeekTime(double time, bool backwards, double *startpts)
   if (m_pFormatContext->start_time != (int64_t)AV_NOPTS_VALUE && !ismp3)
     seek_pts += m_pFormatContext->start_time;
 
-  int ret;
+  m_keyframeContinuous = false;
+  m_keyframeFromStart = false;
+
+  int ret = -1;
+  CDVDKeyframeIndex::Entry keyframe;
+  if (m_keyframeIndex && m_keyframeIndex->Lookup((int)time, backwards, keyframe))
+  {
+    CSingleLock lock(m_critSection);
+    ret = av_seek_frame(m_pFormatContext, -1, keyframe.pos, AVSEEK_FLAG_BYTE);
+    if (ret >= 0)
+    {
+      CLog::Log(LOGDEBUG, "%s - seek to %d ms through keyframe at %d ms", __FUNCTION__, (int)time, keyframe.time);
+      UpdateCurrentPTS();
+    }
+  }
+
+  if (ret < 0)
   {
     CSingleLock lock(m_critSection);
     ret = av_seek_frame(m_pFormatContext, -1, seek_pts, backwards ? AVSEEK_FLAG_BACKWARD : 0);
@@ -1158,6 +1215,8 @@ bool CDVDDemuxFFmpeg::SeekByte(int64_t pos)
 {
   CSingleLock lock(m_critSection);
   int ret = av_seek_frame(m_pFormatContext, -1, pos, AVSEEK_FLAG_BYTE);
+  m_keyframeContinuous = false;
+  m_keyframeFromStart = false;
 
   if(ret >= 0)
     UpdateCurrentPTS();
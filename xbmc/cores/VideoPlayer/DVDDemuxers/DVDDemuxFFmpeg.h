@@ -21,9 +21,11 @@
  */
 
 #include "DVDDemux.h"
+#include "DVDKeyframeIndex.h"
 #include "threads/CriticalSection.h"
 #include "threads/SystemClock.h"
 #include <map>
+#include <memory>
 #include <vector>
 
 extern "C" {
@@ -90,7 +92,7 @@ public:
   CDVDDemuxFFmpeg();
   virtual ~CDVDDemuxFFmpeg();
 
-  bool Open(CDVDInputStream* pInput, bool streaminfo = true, bool fileinfo = false);
+  bool Open(CDVDInputStream* pInput, bool streaminfo = true, bool fileinfo = false, bool quickProbe = false);
   void Dispose();
   void Reset() override ;
   void Flush() override;
@@ -169,5 +171,10 @@ protected:
   bool m_checkvideo;
   int m_displayTime;
   double m_dtsAtDisplayTime;
+
+  std::shared_ptr<CDVDKeyframeIndex> m_keyframeIndex;
+  int m_keyframeStream;
+  bool m_keyframeContinuous; // no seek since the last keyframe added to the index
+  bool m_keyframeFromStart;  // no seek since the file was opened
 };
 
@@ -38,4 +38,6 @@ typedef struct DemuxPacket
   double duration; // duration in DVD_TIME_BASE if available
 
   int dispTime;
+
+  void* pBufferRef; // reference counted buffer pData points into (AVBufferRef), NULL if pData is owned by the packet
 } DemuxPacket;
@@ -23,6 +23,8 @@
 #endif
 #include "DVDDemuxUtils.h"
 #include "DVDClock.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "system.h"
 
@@ -30,17 +32,79 @@
 #include "linux/XMemUtils.h"
 #endif
 
+#include <vector>
+
 extern "C" {
 #include "libavcodec/avcodec.h"
 }
 
+// packets are allocated and freed for every demuxed frame, so keep the headers of
+// freed packets around instead of going through the heap each time
+#define PACKET_POOL_SIZE 256
+
+namespace
+{
+class CDemuxPacketPool
+{
+public:
+  ~CDemuxPacketPool()
+  {
+    for (auto packet : m_packets)
+      delete packet;
+  }
+
+  DemuxPacket* Get()
+  {
+    {
+      CSingleLock lock(m_critSection);
+      if (!m_packets.empty())
+      {
+        DemuxPacket* packet = m_packets.back();
+        m_packets.pop_back();
+        return packet;
+      }
+    }
+    return new DemuxPacket;
+  }
+
+  void Put(DemuxPacket* packet)
+  {
+    {
+      CSingleLock lock(m_critSection);
+      if (m_packets.size() < PACKET_POOL_SIZE)
+      {
+        m_packets.push_back(packet);
+        return;
+      }
+    }
+    delete packet;
+  }
+
+private:
+  CCriticalSection m_critSection;
+  std::vector<DemuxPacket*> m_packets;
+};
+
+CDemuxPacketPool& GetPacketPool()
+{
+  static CDemuxPacketPool pool;
+  return pool;
+}
+}
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);
-      delete pPacket;
+      if (pPacket->pBufferRef)
+      {
+        AVBufferRef* buffer = static_cast<AVBufferRef*>(pPacket->pBufferRef);
+        av_buffer_unref(&buffer);
+      }
+      else if (pPacket->pData)
+        _aligned_free(pPacket->pData);
+      GetPacketPool().Put(pPacket);
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -50,7 +114,7 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
+  DemuxPacket* pPacket = GetPacketPool().Get();
   if (!pPacket) return NULL;
 
   try
@@ -93,3 +157,38 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
   }
   return pPacket;
 }
+
+DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacketFromAVPacket(AVPacket* avpkt)
+{
+  // the decoders rely on zeroed padding behind the data, which buffers allocated by
+  // av_new_packet/av_grow_packet have. Anything else is copied into a buffer of our own.
+  if (!avpkt->buf || !avpkt->data ||
+      avpkt->data < avpkt->buf->data ||
+      avpkt->data + avpkt->size + FF_INPUT_BUFFER_PADDING_SIZE > avpkt->buf->data + avpkt->buf->size)
+  {
+    DemuxPacket* pPacket = AllocateDemuxPacket(avpkt->size);
+    if (pPacket)
+    {
+      if (avpkt->data && avpkt->size > 0)
+        memcpy(pPacket->pData, avpkt->data, avpkt->size);
+      pPacket->iSize = avpkt->size;
+    }
+    return pPacket;
+  }
+
+  AVBufferRef* buffer = av_buffer_ref(avpkt->buf);
+  if (!buffer)
+    return NULL;
+
+  DemuxPacket* pPacket = AllocateDemuxPacket(0);
+  if (!pPacket)
+  {
+    av_buffer_unref(&buffer);
+    return NULL;
+  }
+
+  pPacket->pBufferRef = buffer;
+  pPacket->pData = avpkt->data;
+  pPacket->iSize = avpkt->size;
+  return pPacket;
+}
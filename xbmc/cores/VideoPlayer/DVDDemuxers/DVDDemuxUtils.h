@@ -22,10 +22,20 @@
 
 #include "DVDDemuxPacket.h"
 
+struct AVPacket;
+
 class CDVDDemuxUtils
 {
 public:
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
+
+  /*!
+   \brief Allocate a packet holding the data of an ffmpeg packet.
+   The packet takes a reference on the buffer of avpkt instead of copying it, if the buffer
+   is reference counted and padded. Otherwise the data is copied.
+   \return the packet, or NULL on failure
+   */
+  static DemuxPacket* AllocateDemuxPacketFromAVPacket(AVPacket* avpkt);
 };
 
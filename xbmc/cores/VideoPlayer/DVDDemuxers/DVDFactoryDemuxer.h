@@ -26,5 +26,9 @@ class CDVDInputStream;
 class CDVDFactoryDemuxer
 {
 public:
-  static CDVDDemux* CreateDemuxer(CDVDInputStream* pInputStream, bool fileinfo = false);
+  /*!
+   \param fileinfo open for thumbs and stream details rather than playback
+   \param quickProbe analyse as little of containers with a complete header as possible, for bulk probing
+   */
+  static CDVDDemux* CreateDemuxer(CDVDInputStream* pInputStream, bool fileinfo = false, bool quickProbe = false);
 };
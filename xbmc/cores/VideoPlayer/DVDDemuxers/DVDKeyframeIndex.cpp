@@ -0,0 +1,362 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDKeyframeIndex.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "XBDateTime.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/Crc32.h"
+#include "utils/StringUtils.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+#define INDEX_FOLDER "special://profile/keyframes/"
+#define INDEX_MAGIC "KFIX"
+#define INDEX_VERSION 2
+#define INDEX_FLAG_COMPLETE      0x01
+#define INDEX_FLAG_DISCONTINUOUS 0x02
+#define INDEX_MAX_AGE_DAYS 90                  // indexes not updated for this long are dropped
+#define INDEX_FOLDER_MAX_SIZE (16 * 1024 * 1024) // oldest indexes are dropped beyond this, a single one takes up to 2.6MB
+
+namespace
+{
+bool CompareTime(const CDVDKeyframeIndex::Entry &entry, int time)
+{
+  return entry.time < time;
+}
+
+bool CompareTimeUpper(int time, const CDVDKeyframeIndex::Entry &entry)
+{
+  return time < entry.time;
+}
+
+// the stored index is little endian whatever the platform
+void PutLE(std::string &data, uint64_t value, int bytes)
+{
+  for (int i = 0; i < bytes; i++)
+    data.push_back((char)((value >> (8 * i)) & 0xFF));
+}
+
+uint64_t GetLE(const char *data, int bytes)
+{
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++)
+    value |= (uint64_t)(uint8_t)data[i] << (8 * i);
+  return value;
+}
+}
+
+std::shared_ptr<CDVDKeyframeIndex> CDVDKeyframeIndex::Get(const std::string &path, int64_t size)
+{
+  static CCriticalSection section;
+  static std::map<std::string, std::weak_ptr<CDVDKeyframeIndex> > indexes;
+
+  CSingleLock lock(section);
+
+  for (auto it = indexes.begin(); it != indexes.end(); )
+  {
+    if (it->second.expired())
+      it = indexes.erase(it);
+    else
+      ++it;
+  }
+
+  auto it = indexes.find(path);
+  if (it != indexes.end())
+  {
+    std::shared_ptr<CDVDKeyframeIndex> index = it->second.lock();
+    if (index && index->m_size == size)
+      return index;
+  }
+
+  std::shared_ptr<CDVDKeyframeIndex> index(new CDVDKeyframeIndex(path, size));
+  index->Load();
+  indexes[path] = index;
+  return index;
+}
+
+CDVDKeyframeIndex::CDVDKeyframeIndex(const std::string &path, int64_t size)
+  : m_path(path)
+  , m_size(size)
+  , m_complete(false)
+  , m_discontinuous(false)
+  , m_changed(false)
+{
+}
+
+CDVDKeyframeIndex::~CDVDKeyframeIndex()
+{
+  if (m_changed)
+    Save();
+}
+
+void CDVDKeyframeIndex::Add(int time, int64_t pos, bool follows)
+{
+  CSingleLock lock(m_section);
+
+  if (m_discontinuous)
+    return;
+
+  auto it = std::lower_bound(m_entries.begin(), m_entries.end(), time, CompareTime);
+  if (it != m_entries.end() && it->time == time)
+  {
+    if (it->pos != pos)
+      SetDiscontinuous();
+    else if (follows && !it->follows)
+    {
+      it->follows = true;
+      m_changed = true;
+    }
+    return;
+  }
+
+  // a timestamp wrap or discontinuity, time no longer grows with the position
+  if ((it != m_entries.begin() && (it - 1)->pos >= pos) ||
+      (it != m_entries.end() && it->pos <= pos))
+  {
+    SetDiscontinuous();
+    return;
+  }
+
+  if (m_entries.size() >= MAX_ENTRIES)
+    return;
+
+  // whatever came after it before can't have followed the entry in front of it
+  if (it != m_entries.end())
+    it->follows = false;
+
+  Entry entry;
+  entry.time = time;
+  entry.pos = pos;
+  entry.follows = follows;
+  m_entries.insert(it, entry);
+  m_changed = true;
+}
+
+void CDVDKeyframeIndex::SetDiscontinuous()
+{
+  CLog::Log(LOGDEBUG, "CDVDKeyframeIndex::%s - timestamps of %s are not continuous, not indexing it", __FUNCTION__,
+            CURL::GetRedacted(m_path).c_str());
+
+  // remembered, so the file is not indexed again every time it is played
+  m_entries.clear();
+  m_complete = false;
+  m_discontinuous = true;
+  m_changed = true;
+}
+
+bool CDVDKeyframeIndex::Lookup(int time, bool backwards, Entry &entry) const
+{
+  CSingleLock lock(m_section);
+
+  if (backwards)
+  {
+    // last keyframe at or before time, the next one has to prove nothing is in between
+    auto next = std::upper_bound(m_entries.begin(), m_entries.end(), time, CompareTimeUpper);
+    if (next == m_entries.begin())
+      return false;
+    if (next == m_entries.end() ? !m_complete : !next->follows)
+      return false;
+
+    entry = *(next - 1);
+    return true;
+  }
+
+  // first keyframe at or after time
+  auto it = std::lower_bound(m_entries.begin(), m_entries.end(), time, CompareTime);
+  if (it == m_entries.end())
+    return false;
+  if (it->time != time && !(it == m_entries.begin() ? m_complete : it->follows))
+    return false;
+
+  entry = *it;
+  return true;
+}
+
+void CDVDKeyframeIndex::SetComplete()
+{
+  CSingleLock lock(m_section);
+
+  // entries beyond MAX_ENTRIES were dropped, so some keyframes are missing
+  if (m_complete || m_discontinuous || m_entries.size() >= MAX_ENTRIES)
+    return;
+
+  // one reader went through the whole file
+  for (auto& entry : m_entries)
+    entry.follows = true;
+  m_complete = true;
+  m_changed = true;
+}
+
+bool CDVDKeyframeIndex::IsComplete() const
+{
+  CSingleLock lock(m_section);
+  return m_complete;
+}
+
+size_t CDVDKeyframeIndex::GetSize() const
+{
+  CSingleLock lock(m_section);
+  return m_entries.size();
+}
+
+std::string CDVDKeyframeIndex::GetCacheFile() const
+{
+  return StringUtils::Format(INDEX_FOLDER "%08x.kfi", Crc32::ComputeFromLowerCase(m_path));
+}
+
+bool CDVDKeyframeIndex::Load()
+{
+  std::string cacheFile = GetCacheFile();
+  if (!XFILE::CFile::Exists(cacheFile))
+    return false;
+
+  XFILE::CFile file;
+  XFILE::auto_buffer buffer;
+  if (file.LoadFile(cacheFile, buffer) <= 0)
+    return false;
+
+  const char *data = buffer.get();
+  size_t size = buffer.size();
+  size_t offset = 0;
+  auto read = [&](uint64_t &value, int bytes)
+  {
+    if (offset + bytes > size)
+      return false;
+    value = GetLE(data + offset, bytes);
+    offset += bytes;
+    return true;
+  };
+
+  // an index of another version is rebuilt
+  uint64_t version, fileSize, flags, pathLength;
+  if (size < 4 || memcmp(data, INDEX_MAGIC, 4) != 0)
+    return false;
+  offset = 4;
+  if (!read(version, 4) || version != INDEX_VERSION ||
+      !read(fileSize, 8) || !read(flags, 1) ||
+      !read(pathLength, 4) || offset + pathLength > size)
+    return false;
+
+  // different file with the same hash, or the file changed
+  if (std::string(data + offset, pathLength) != m_path || (int64_t)fileSize != m_size)
+    return false;
+  offset += pathLength;
+
+  uint64_t count;
+  if (!read(count, 4) || count > MAX_ENTRIES)
+    return false;
+
+  std::vector<Entry> entries;
+  entries.reserve(count);
+  for (uint64_t i = 0; i < count; i++)
+  {
+    uint64_t time, pos, follows;
+    if (!read(time, 4) || !read(pos, 8) || !read(follows, 1))
+      return false;
+
+    Entry entry;
+    entry.time = (int32_t)(uint32_t)time;
+    entry.pos = (int64_t)pos;
+    entry.follows = follows != 0;
+    entries.push_back(entry);
+  }
+
+  CSingleLock lock(m_section);
+  m_entries.swap(entries);
+  m_complete = (flags & INDEX_FLAG_COMPLETE) != 0;
+  m_discontinuous = (flags & INDEX_FLAG_DISCONTINUOUS) != 0;
+  m_changed = false;
+  CLog::Log(LOGDEBUG, "CDVDKeyframeIndex::%s - loaded %u keyframes for %s", __FUNCTION__, (unsigned int)count, CURL::GetRedacted(m_path).c_str());
+  return true;
+}
+
+bool CDVDKeyframeIndex::Save()
+{
+  std::string data;
+  {
+    CSingleLock lock(m_section);
+
+    uint8_t flags = (m_complete ? INDEX_FLAG_COMPLETE : 0) | (m_discontinuous ? INDEX_FLAG_DISCONTINUOUS : 0);
+    data.append(INDEX_MAGIC, 4);
+    PutLE(data, INDEX_VERSION, 4);
+    PutLE(data, m_size, 8);
+    PutLE(data, flags, 1);
+    PutLE(data, m_path.size(), 4);
+    data.append(m_path);
+    PutLE(data, m_entries.size(), 4);
+    for (const auto& entry : m_entries)
+    {
+      PutLE(data, (uint32_t)entry.time, 4);
+      PutLE(data, entry.pos, 8);
+      PutLE(data, entry.follows ? 1 : 0, 1);
+    }
+    m_changed = false;
+  }
+
+  if (!XFILE::CDirectory::Exists(INDEX_FOLDER))
+    XFILE::CDirectory::Create(INDEX_FOLDER);
+
+  std::string cacheFile = GetCacheFile();
+  bool created = !XFILE::CFile::Exists(cacheFile);
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(cacheFile, true) ||
+      file.Write(data.c_str(), data.size()) != (ssize_t)data.size())
+  {
+    CLog::Log(LOGERROR, "CDVDKeyframeIndex::%s - unable to store keyframes of %s", __FUNCTION__, CURL::GetRedacted(m_path).c_str());
+    return false;
+  }
+  file.Close();
+
+  // the folder only grows when a new index is added
+  if (created)
+    PruneCache();
+  return true;
+}
+
+void CDVDKeyframeIndex::PruneCache()
+{
+  CFileItemList items;
+  if (!XFILE::CDirectory::GetDirectory(INDEX_FOLDER, items, ".kfi", XFILE::DIR_FLAG_NO_FILE_DIRS | XFILE::DIR_FLAG_BYPASS_CACHE))
+    return;
+
+  // newest first, so whatever is past the size limit is the least recently updated
+  items.Sort(SortByDate, SortOrderDescending);
+
+  CDateTime expiry = CDateTime::GetCurrentDateTime() - CDateTimeSpan(INDEX_MAX_AGE_DAYS, 0, 0, 0);
+  int64_t total = 0;
+  for (int i = 0; i < items.Size(); i++)
+  {
+    const CFileItemPtr item = items[i];
+    total += item->m_dwSize;
+    if (total > INDEX_FOLDER_MAX_SIZE || (item->m_dateTime.IsValid() && item->m_dateTime < expiry))
+    {
+      CLog::Log(LOGDEBUG, "CDVDKeyframeIndex::%s - removing %s", __FUNCTION__, item->GetPath().c_str());
+      XFILE::CFile::Delete(item->GetPath());
+    }
+  }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+
+/*!
+ \brief Keyframe time to byte offset table of a file.
+
+ Filled from the packets every CDVDDemuxFFmpeg reading the file comes across,
+ so it grows with what has been played, and kept on disk below
+ special://profile/keyframes. Entries remember whether they were read right
+ after the previous keyframe, so a lookup only succeeds where no keyframe can
+ be missing between the target time and the returned entry.
+
+ Lookups rely on the time growing with the byte offset. A keyframe that breaks
+ the order, after a timestamp wrap or discontinuity, drops the index and the
+ file is not indexed anymore.
+
+ Instances are shared by everyone working on the same file, see Get().
+ */
+class CDVDKeyframeIndex
+{
+public:
+  struct Entry
+  {
+    int time;      ///< ms, relative to the start of the file like CDVDDemux::SeekTime()
+    int64_t pos;   ///< byte offset of the packet
+    bool follows;  ///< no keyframe between the previous entry and this one
+  };
+
+  /*!
+   \brief Index for the given file, shared with other users of the same file.
+   Loads a previously stored index on first use.
+   \param size the file size, a stored index of a different size is discarded
+   */
+  static std::shared_ptr<CDVDKeyframeIndex> Get(const std::string &path, int64_t size);
+
+  ~CDVDKeyframeIndex();
+
+  /*!
+   \brief Record a keyframe
+   \param follows true if the previous keyframe of the stream was recorded
+   by the same reader without a seek in between
+   */
+  void Add(int time, int64_t pos, bool follows);
+
+  /*!
+   \brief Find the keyframe closest to time, before it if backwards is set and after it otherwise
+   \return false if the index can't tell
+   */
+  bool Lookup(int time, bool backwards, Entry &entry) const;
+
+  /*! \brief Mark the index as holding every keyframe, once a reader went through the whole file without seeking */
+  void SetComplete();
+  bool IsComplete() const;
+
+  const std::string& GetPath() const { return m_path; }
+  size_t GetSize() const;
+
+  static const size_t MAX_ENTRIES = 200000;
+
+private:
+  CDVDKeyframeIndex(const std::string &path, int64_t size);
+  CDVDKeyframeIndex(const CDVDKeyframeIndex&) = delete;
+  CDVDKeyframeIndex& operator=(const CDVDKeyframeIndex&) = delete;
+
+  void SetDiscontinuous();
+  std::string GetCacheFile() const;
+  bool Load();
+  bool Save();
+  static void PruneCache();
+
+  std::string m_path;
+  int64_t m_size;
+  std::vector<Entry> m_entries;
+  bool m_complete;
+  bool m_discontinuous;
+  bool m_changed;
+  mutable CCriticalSection m_section;
+};
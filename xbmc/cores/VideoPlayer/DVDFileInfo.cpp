@@ -56,6 +56,40 @@
 #include <cstdlib>
 #include <memory>
 
+CDVDThumbCodecCache::CDVDThumbCodecCache()
+{
+}
+
+CDVDThumbCodecCache::~CDVDThumbCodecCache()
+{
+  Clear();
+}
+
+CDVDVideoCodec* CDVDThumbCodecCache::Get(const CDVDStreamInfo &hint)
+{
+  if (m_codec && m_hint->Equal(hint, true))
+  {
+    m_codec->Reset();
+    return m_codec.get();
+  }
+
+  Clear();
+
+  // the decoder may keep a reference to the process info, it has to outlive it
+  m_processInfo.reset(CProcessInfo::CreateInstance());
+  m_codec.reset(CDVDFactoryCodec::CreateVideoCodec(hint, *m_processInfo));
+  if (m_codec)
+    m_hint.reset(new CDVDStreamInfo(hint));
+  return m_codec.get();
+}
+
+void CDVDThumbCodecCache::Clear()
+{
+  m_codec.reset();
+  m_processInfo.reset();
+  m_hint.reset();
+}
+
 bool CDVDFileInfo::GetFileDuration(const std::string &path, int& duration)
 {
   std::unique_ptr<CDVDInputStream> input;
@@ -95,9 +129,77 @@ int DegreeToOrientation(int degrees)
   }
 }
 
+// scale a decoded picture to the given width and store it in the texture cache
+static bool CacheThumb(const DVDVideoPicture &picture, const CDVDStreamInfo &hint, unsigned int nWidth, CTextureDetails &details)
+{
+  double aspect = (double)picture.iDisplayWidth / (double)picture.iDisplayHeight;
+  if(hint.forced_aspect && hint.aspect != 0)
+    aspect = hint.aspect;
+  unsigned int nHeight = (unsigned int)((double)nWidth / aspect);
+
+  bool bOk = false;
+  uint8_t *pOutBuf = (uint8_t*)av_malloc(nWidth * nHeight * 4);
+  struct SwsContext *context = sws_getContext(picture.iWidth, picture.iHeight,
+        AV_PIX_FMT_YUV420P, nWidth, nHeight, AV_PIX_FMT_BGRA, SWS_FAST_BILINEAR, NULL, NULL, NULL);
+
+  if (context)
+  {
+    uint8_t *src[] = { picture.data[0], picture.data[1], picture.data[2], 0 };
+    int     srcStride[] = { picture.iLineSize[0], picture.iLineSize[1], picture.iLineSize[2], 0 };
+    uint8_t *dst[] = { pOutBuf, 0, 0, 0 };
+    int     dstStride[] = { (int)nWidth*4, 0, 0, 0 };
+    int orientation = DegreeToOrientation(hint.orientation);
+    sws_scale(context, src, srcStride, 0, picture.iHeight, dst, dstStride);
+    sws_freeContext(context);
+
+    details.width = nWidth;
+    details.height = nHeight;
+    CPicture::CacheTexture(pOutBuf, nWidth, nHeight, nWidth * 4, orientation, nWidth, nHeight, CTextureCache::GetCachedPath(details.file));
+    bOk = true;
+  }
+  av_free(pOutBuf);
+  return bOk;
+}
+
+// decode the first video packet after a seek on its own, the decoder is
+// drained instead of being fed the frames referencing it
+static bool DecodeKeyframe(CDVDDemux *pDemuxer, CDVDVideoCodec *pVideoCodec, int nVideoStream, DVDVideoPicture &picture)
+{
+  DemuxPacket* pPacket = NULL;
+  int abort_index = pDemuxer->GetNrOfStreams() * 160;
+  while (abort_index--)
+  {
+    pPacket = pDemuxer->Read();
+    if (!pPacket || pPacket->iStreamId == nVideoStream)
+      break;
+    CDVDDemuxUtils::FreeDemuxPacket(pPacket);
+    pPacket = NULL;
+  }
+
+  if (!pPacket)
+    return false;
+
+  int iDecoderState = pVideoCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
+  CDVDDemuxUtils::FreeDemuxPacket(pPacket);
+
+  if (!(iDecoderState & (VC_PICTURE | VC_ERROR)))
+  {
+    pVideoCodec->SetCodecControl(DVD_CODEC_CTRL_DRAIN);
+    iDecoderState = pVideoCodec->Decode(NULL, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+    pVideoCodec->SetCodecControl(0);
+  }
+
+  if ((iDecoderState & VC_ERROR) || !(iDecoderState & VC_PICTURE))
+    return false;
+
+  memset(&picture, 0, sizeof(DVDVideoPicture));
+  return pVideoCodec->GetPicture(&picture) && !(picture.iFlags & DVP_FLAG_DROPPED);
+}
+
 bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
                                 CTextureDetails &details,
-                                CStreamDetails *pStreamDetails, int pos)
+                                CStreamDetails *pStreamDetails, int pos,
+                                CDVDThumbCodecCache *codecCache)
 {
   std::string redactPath = CURL::GetRedacted(strPath);
   unsigned int nTime = XbmcThreads::SystemClockMillis();
@@ -123,7 +225,8 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
 
   try
   {
-    pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(pInputStream, true);
+    // only the probe queue hands in a codec cache
+    pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(pInputStream, true, codecCache != NULL);
     if(!pDemuxer)
     {
       delete pInputStream;
@@ -201,7 +304,10 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
     CDVDStreamInfo hint(*pDemuxer->GetStream(demuxerId, nVideoStream), true);
     hint.software = true;
 
-    pVideoCodec = CDVDFactoryCodec::CreateVideoCodec(hint, *pProcessInfo);
+    if (codecCache)
+      pVideoCodec = codecCache->Get(hint);
+    else
+      pVideoCodec = CDVDFactoryCodec::CreateVideoCodec(hint, *pProcessInfo);
 
     if (pVideoCodec)
     {
@@ -252,41 +358,15 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
 
         if (iDecoderState & VC_PICTURE && !(picture.iFlags & DVP_FLAG_DROPPED))
         {
-          {
-            unsigned int nWidth = g_advancedSettings.m_imageRes;
-            double aspect = (double)picture.iDisplayWidth / (double)picture.iDisplayHeight;
-            if(hint.forced_aspect && hint.aspect != 0)
-              aspect = hint.aspect;
-            unsigned int nHeight = (unsigned int)((double)g_advancedSettings.m_imageRes / aspect);
-
-            uint8_t *pOutBuf = (uint8_t*)av_malloc(nWidth * nHeight * 4);
-            struct SwsContext *context = sws_getContext(picture.iWidth, picture.iHeight,
-                  AV_PIX_FMT_YUV420P, nWidth, nHeight, AV_PIX_FMT_BGRA, SWS_FAST_BILINEAR, NULL, NULL, NULL);
-
-            if (context)
-            {
-              uint8_t *src[] = { picture.data[0], picture.data[1], picture.data[2], 0 };
-              int     srcStride[] = { picture.iLineSize[0], picture.iLineSize[1], picture.iLineSize[2], 0 };
-              uint8_t *dst[] = { pOutBuf, 0, 0, 0 };
-              int     dstStride[] = { (int)nWidth*4, 0, 0, 0 };
-              int orientation = DegreeToOrientation(hint.orientation);
-              sws_scale(context, src, srcStride, 0, picture.iHeight, dst, dstStride);
-              sws_freeContext(context);
-
-              details.width = nWidth;
-              details.height = nHeight;
-              CPicture::CacheTexture(pOutBuf, nWidth, nHeight, nWidth * 4, orientation, nWidth, nHeight, CTextureCache::GetCachedPath(details.file));
-              bOk = true;
-            }
-            av_free(pOutBuf);
-          }
+          bOk = CacheThumb(picture, hint, g_advancedSettings.m_imageRes, details);
         }
         else
         {
           CLog::Log(LOGDEBUG,"%s - decode failed in %s after %d packets.", __FUNCTION__, redactPath.c_str(), packetsTried);
         }
       }
-      delete pVideoCodec;
+      if (!codecCache)
+        delete pVideoCodec;
     }
   }
 
@@ -307,6 +387,89 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
   return bOk;
 }
 
+bool CDVDFileInfo::ExtractThumbs(const std::string &strPath, const std::vector<int> &times, unsigned int width,
+                                 std::vector<CTextureDetails> &details, const std::function<bool(size_t, bool)> &progress)
+{
+  std::string redactPath = CURL::GetRedacted(strPath);
+  unsigned int nTime = XbmcThreads::SystemClockMillis();
+  CFileItem item(strPath, false);
+
+  item.SetMimeTypeForInternetFile();
+  std::unique_ptr<CDVDInputStream> pInputStream(CDVDFactoryInputStream::CreateInputStream(NULL, item));
+  if (!pInputStream || !pInputStream->Open())
+  {
+    CLog::Log(LOGERROR, "InputStream: Error opening, %s", redactPath.c_str());
+    return false;
+  }
+
+  std::unique_ptr<CDVDDemux> pDemuxer;
+  try
+  {
+    pDemuxer.reset(CDVDFactoryDemuxer::CreateDemuxer(pInputStream.get(), true));
+  }
+  catch(...)
+  {
+    CLog::Log(LOGERROR, "%s - Exception thrown when opening demuxer", __FUNCTION__);
+    return false;
+  }
+
+  if (!pDemuxer)
+  {
+    CLog::Log(LOGERROR, "%s - Error creating demuxer", __FUNCTION__);
+    return false;
+  }
+
+  int nVideoStream = -1;
+  int64_t demuxerId = -1;
+  for (CDemuxStream* pStream : pDemuxer->GetStreams())
+  {
+    if (pStream)
+    {
+      if (pStream->type == STREAM_VIDEO && !(pStream->flags & AV_DISPOSITION_ATTACHED_PIC))
+      {
+        nVideoStream = pStream->uniqueId;
+        demuxerId = pStream->demuxerId;
+      }
+      else
+        pDemuxer->EnableStream(pStream->demuxerId, pStream->uniqueId, false);
+    }
+  }
+
+  if (nVideoStream == -1)
+    return false;
+
+  std::unique_ptr<CProcessInfo> pProcessInfo(CProcessInfo::CreateInstance());
+  CDVDStreamInfo hint(*pDemuxer->GetStream(demuxerId, nVideoStream), true);
+  hint.software = true;
+
+  std::unique_ptr<CDVDVideoCodec> pVideoCodec(CDVDFactoryCodec::CreateVideoCodec(hint, *pProcessInfo));
+  if (!pVideoCodec)
+    return false;
+
+  int extracted = 0;
+  for (size_t i = 0; i < times.size() && i < details.size(); i++)
+  {
+    bool bOk = false;
+    if (pDemuxer->SeekTime(times[i], true))
+    {
+      pVideoCodec->Reset();
+
+      DVDVideoPicture picture;
+      if (DecodeKeyframe(pDemuxer.get(), pVideoCodec.get(), nVideoStream, picture))
+        bOk = CacheThumb(picture, hint, width, details[i]);
+    }
+    if (bOk)
+      extracted++;
+
+    if (!progress(i, bOk))
+      break;
+  }
+
+  unsigned int nTotalTime = XbmcThreads::SystemClockMillis() - nTime;
+  CLog::Log(LOGDEBUG, "%s - extracted %d of %d thumbs from file <%s> in %u ms", __FUNCTION__, extracted, (int)times.size(), redactPath.c_str(), nTotalTime);
+  return extracted > 0;
+}
+
 /**
  * \brief Open the item pointed to by pItem and extact streamdetails
  * \return true if the stream details have changed
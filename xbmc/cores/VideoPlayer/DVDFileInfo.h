@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,15 +30,52 @@ class CDVDDemux;
 class CStreamDetails;
 class CStreamDetailSubtitle;
 class CDVDInputStream;
+class CDVDStreamInfo;
+class CDVDVideoCodec;
+class CProcessInfo;
 class CTextureDetails;
 
+/*!
+ \brief Keeps the video decoder of a thumbnail extraction open for the next file with identical stream parameters,
+ as found among the episodes of a show. Not thread safe, every thread extracting thumbs needs its own.
+ */
+class CDVDThumbCodecCache
+{
+public:
+  CDVDThumbCodecCache();
+  ~CDVDThumbCodecCache();
+
+  /*! \brief Decoder for hint, flushed if it is reused. Owned by the cache. */
+  CDVDVideoCodec* Get(const CDVDStreamInfo &hint);
+  void Clear();
+
+private:
+  std::unique_ptr<CDVDStreamInfo> m_hint;
+  std::unique_ptr<CProcessInfo> m_processInfo;
+  std::unique_ptr<CDVDVideoCodec> m_codec;
+};
+
 class CDVDFileInfo
 {
 public:
   // Extract a thumbnail immage from the media at strPath, optionally populating a streamdetails class with the data
+  // the decoder is taken from codecCache if one is given, and the container is then only analysed briefly
   static bool ExtractThumb(const std::string &strPath,
                            CTextureDetails &details,
-                           CStreamDetails *pStreamDetails, int pos=-1);
+                           CStreamDetails *pStreamDetails, int pos=-1,
+                           CDVDThumbCodecCache *codecCache = NULL);
+
+  /*!
+   \brief Extract small thumbnails of the keyframes at or before the given times, opening the media only once.
+   Only the keyframe itself is decoded for each thumbnail, the decoder is drained instead of fed the frames following it.
+   \param times positions in ms
+   \param width width of the thumbnails
+   \param details one per time, file has to be set to the texture cache file to write, width and height are filled in
+   \param progress called with the index of each time done, returns false to stop
+   \return true if at least one thumbnail was extracted
+   */
+  static bool ExtractThumbs(const std::string &strPath, const std::vector<int> &times, unsigned int width,
+                            std::vector<CTextureDetails> &details, const std::function<bool(size_t, bool)> &progress);
 
   // Probe the files streams and store the info in the VideoInfoTag
   static bool GetFileStreamDetails(CFileItem *pItem);
@@ -25,6 +25,7 @@
 #include "threads/CriticalSection.h"
 #include "threads/Condition.h"
 #include "utils/MathUtils.h"
+#include "utils/TimeUtils.h"
 #include "utils/log.h"
 
 class CDVDMsgGeneralSynchronizePriv
@@ -110,6 +111,7 @@ CDVDMsgDemuxerPacket::CDVDMsgDemuxerPacket(DemuxPacket* packet, bool drop) : CDV
 {
   m_packet = packet;
   m_drop   = drop;
+  m_time   = CurrentHostCounter();
 }
 
 CDVDMsgDemuxerPacket::~CDVDMsgDemuxerPacket()
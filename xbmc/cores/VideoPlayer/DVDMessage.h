@@ -267,8 +267,10 @@ public:
   DemuxPacket* GetPacket()      { return m_packet; }
   unsigned int GetPacketSize();
   bool         GetPacketDrop()  { return m_drop; }
+  int64_t      GetPacketTime()  { return m_time; } // host counter when the packet was queued
   DemuxPacket* m_packet;
   bool         m_drop;
+  int64_t      m_time;
 };
 
 class CDVDMsgDemuxerReset : public CDVDMsg
@@ -25,22 +25,33 @@
 #include "DVDClock.h"
 #include "math.h"
 
+#define PACKET_RING_SIZE 4096
+
 CDVDMessageQueue::CDVDMessageQueue(const std::string &owner) : m_hEvent(true), m_owner(owner)
 {
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   m_bInitialized = false;
+  m_drain = false;
 
   m_TimeBack = DVD_NOPTS_VALUE;
   m_TimeFront = DVD_NOPTS_VALUE;
   m_TimeSize = 1.0 / 4.0; /* 4 seconds */
   m_iMaxDataSize = 0;
+
+  m_sequence = 0;
+  m_jumpSequence = 0;
+  m_packetWrite = 0;
+  m_packetRead = 0;
+  m_producer = std::thread::id();
+  m_waiting = false;
 }
 
 CDVDMessageQueue::~CDVDMessageQueue()
 {
   // remove all remaining messages
   Flush(CDVDMsg::NONE);
+  ClearPackets();
 }
 
 void CDVDMessageQueue::Init()
@@ -57,8 +68,13 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
   CSingleLock lock(m_section);
 
-  m_messages.remove_if([type](const DVDMessageListItem &item){
-    return type == CDVDMsg::NONE || item.message->IsType(type);
+  // the producer may put packets meanwhile, so only the sizes of the
+  // packets removed here are taken off m_iDataSize instead of zeroing it
+  m_messages.remove_if([this, type](const DVDMessageListItem &item){
+    if (type != CDVDMsg::NONE && !item.message->IsType(type))
+      return false;
+    DropPacketSize(item.message);
+    return true;
   });
 
   m_prioMessages.remove_if([type](const DVDMessageListItem &item){
@@ -67,7 +83,21 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
-    m_iDataSize = 0;
+    // m_section keeps the consumer out of the ring, packets put from here on are kept
+    if (m_packets)
+    {
+      uint64_t read = m_packetRead.load(std::memory_order_relaxed);
+      uint64_t write = m_packetWrite.load();
+      for (; read != write; read++)
+      {
+        PacketSlot& slot = m_packets[read % PACKET_RING_SIZE];
+        DropPacketSize(slot.message);
+        slot.message->Release();
+        slot.message = NULL;
+      }
+      m_packetRead.store(read, std::memory_order_release);
+    }
+
     m_TimeBack = DVD_NOPTS_VALUE;
     m_TimeFront = DVD_NOPTS_VALUE;
   }
@@ -89,6 +119,9 @@ void CDVDMessageQueue::End()
 
   Flush(CDVDMsg::NONE);
 
+  // the consumer has stopped, so the ring can be released and handed to a new producer
+  ClearPackets();
+
   m_bInitialized = false;
   m_iDataSize = 0;
   m_bAbortRequest = false;
@@ -96,6 +129,21 @@ void CDVDMessageQueue::End()
 
 MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front)
 {
+  if (!pMsg)
+  {
+    CLog::Log(LOGFATAL, "CDVDMessageQueue(%s)::Put MSGQ_INVALID_MSG", m_owner.c_str());
+    return MSGQ_INVALID_MSG;
+  }
+
+  // fast path for the demux thread, without taking m_section
+  if (priority == 0 && front && m_bInitialized &&
+      pMsg->IsType(CDVDMsg::DEMUXER_PACKET) &&
+      m_producer.load() == std::this_thread::get_id() &&
+      PutPacket(pMsg))
+  {
+    return MSGQ_OK;
+  }
+
   CSingleLock lock(m_section);
 
   if (!m_bInitialized)
@@ -104,10 +152,16 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
     pMsg->Release();
     return MSGQ_NOT_INITIALIZED;
   }
-  if (!pMsg)
+
+  if (priority == 0 && front && pMsg->IsType(CDVDMsg::DEMUXER_PACKET) &&
+      m_producer.load() == std::thread::id())
   {
-    CLog::Log(LOGFATAL, "CDVDMessageQueue(%s)::Put MSGQ_INVALID_MSG", m_owner.c_str());
-    return MSGQ_INVALID_MSG;
+    // first packet, the putting thread becomes the producer of the ring
+    if (!m_packets)
+      m_packets.reset(new PacketSlot[PACKET_RING_SIZE]);
+    m_producer = std::this_thread::get_id();
+    if (PutPacket(pMsg))
+      return MSGQ_OK;
   }
 
   if (priority > 0)
@@ -125,26 +179,13 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
   else
   {
     if (front)
-      m_messages.emplace_front(pMsg, priority);
+      m_messages.emplace_front(pMsg, priority, m_sequence++);
     else
-      m_messages.emplace_back(pMsg, priority);
+      m_messages.emplace_back(pMsg, priority, -(++m_jumpSequence)); // ahead of everything queued
   }
 
-  if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
-  {
-    DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
-    if (packet)
-    {
-      m_iDataSize += packet->iSize;
-      if (packet->dts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->dts;
-      else if (packet->pts != DVD_NOPTS_VALUE)
-        m_TimeFront = packet->pts;
-
-      if (m_TimeBack == DVD_NOPTS_VALUE)
-        m_TimeBack = m_TimeFront;
-    }
-  }
+  if (priority == 0)
+    AddPacketSize(pMsg);
 
   pMsg->Release();
 
@@ -154,6 +195,101 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority, bool front
   return MSGQ_OK;
 }
 
+bool CDVDMessageQueue::PutPacket(CDVDMsg* pMsg)
+{
+  uint64_t write = m_packetWrite.load(std::memory_order_relaxed);
+  if (write - m_packetRead.load(std::memory_order_acquire) >= PACKET_RING_SIZE)
+    return false;
+
+  PacketSlot& slot = m_packets[write % PACKET_RING_SIZE];
+  slot.message = pMsg; // takes over the reference of the caller
+  slot.sequence = m_sequence++;
+
+  AddPacketSize(pMsg);
+  m_packetWrite.store(write + 1);
+
+  // only wake the consumer if it is (about to start) waiting
+  if (m_waiting.load())
+    m_hEvent.Set();
+
+  return true;
+}
+
+CDVDMessageQueue::PacketSlot* CDVDMessageQueue::PeekPacket()
+{
+  if (!m_packets)
+    return NULL;
+
+  uint64_t read = m_packetRead.load(std::memory_order_relaxed);
+  if (read == m_packetWrite.load())
+    return NULL;
+
+  return &m_packets[read % PACKET_RING_SIZE];
+}
+
+void CDVDMessageQueue::PopPacket()
+{
+  uint64_t read = m_packetRead.load(std::memory_order_relaxed);
+  m_packets[read % PACKET_RING_SIZE].message = NULL;
+  m_packetRead.store(read + 1, std::memory_order_release);
+}
+
+void CDVDMessageQueue::ClearPackets()
+{
+  if (m_packets)
+  {
+    for (uint64_t pos = m_packetRead; pos != m_packetWrite; pos++)
+      m_packets[pos % PACKET_RING_SIZE].message->Release();
+  }
+  m_packetRead = m_packetWrite.load();
+  m_producer = std::thread::id();
+}
+
+void CDVDMessageQueue::AddPacketSize(CDVDMsg* pMsg)
+{
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+    return;
+
+  DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+  if (packet)
+  {
+    m_iDataSize += packet->iSize;
+    if (packet->dts != DVD_NOPTS_VALUE)
+      m_TimeFront = packet->dts;
+    else if (packet->pts != DVD_NOPTS_VALUE)
+      m_TimeFront = packet->pts;
+
+    double none = DVD_NOPTS_VALUE;
+    m_TimeBack.compare_exchange_strong(none, m_TimeFront.load());
+  }
+}
+
+void CDVDMessageQueue::DropPacketSize(CDVDMsg* pMsg)
+{
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+    return;
+
+  DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+  if (packet)
+    m_iDataSize -= packet->iSize;
+}
+
+void CDVDMessageQueue::RemovePacketSize(CDVDMsg* pMsg)
+{
+  if (!pMsg->IsType(CDVDMsg::DEMUXER_PACKET))
+    return;
+
+  DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
+  if (packet)
+  {
+    m_iDataSize -= packet->iSize;
+    if (packet->dts != DVD_NOPTS_VALUE)
+      m_TimeBack = packet->dts;
+    else if (packet->pts != DVD_NOPTS_VALUE)
+      m_TimeBack = packet->pts;
+  }
+}
+
 MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutInMilliSeconds, int &priority)
 {
   CSingleLock lock(m_section);
@@ -170,48 +306,71 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
 
   while (!m_bAbortRequest)
   {
-    std::list<DVDMessageListItem> &msgs = (priority > 0 || !m_prioMessages.empty()) ? m_prioMessages : m_messages;
+    if (priority > 0 || !m_prioMessages.empty())
+    {
+      if (!m_prioMessages.empty() && (m_prioMessages.back().priority >= priority || m_drain))
+      {
+        DVDMessageListItem& item(m_prioMessages.back());
+        priority = item.priority;
+        *pMsg = item.message->Acquire();
+        m_prioMessages.pop_back();
 
-    if (!msgs.empty() && (msgs.back().priority >= priority || m_drain))
+        ret = MSGQ_OK;
+        break;
+      }
+    }
+    else
     {
-      DVDMessageListItem& item(msgs.back());
-      priority = item.priority;
+      // take whichever of the ring and the list holds the older message
+      PacketSlot* slot = PeekPacket();
+      if (slot && (m_messages.empty() || slot->sequence < m_messages.back().sequence))
+      {
+        priority = 0;
+        RemovePacketSize(slot->message);
+        *pMsg = slot->message;
+        PopPacket();
 
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
+        ret = MSGQ_OK;
+        break;
+      }
+      else if (!m_messages.empty())
       {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
-        if (packet)
-        {
-          m_iDataSize -= packet->iSize;
-          if (packet->dts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->dts;
-          else if (packet->pts != DVD_NOPTS_VALUE)
-            m_TimeBack = packet->pts;
-        }
+        DVDMessageListItem& item(m_messages.back());
+        priority = item.priority;
+        RemovePacketSize(item.message);
+        *pMsg = item.message->Acquire();
+        m_messages.pop_back();
+
+        ret = MSGQ_OK;
+        break;
       }
-
-      *pMsg = item.message->Acquire();
-      msgs.pop_back();
-
-      ret = MSGQ_OK;
-      break;
     }
-    else if (!iTimeoutInMilliSeconds)
+
+    if (!iTimeoutInMilliSeconds)
     {
       ret = MSGQ_TIMEOUT;
       break;
     }
-    else
-    {
-      m_hEvent.Reset();
-      lock.Leave();
 
-      // wait for a new message
-      if (!m_hEvent.WaitMSec(iTimeoutInMilliSeconds))
-        return MSGQ_TIMEOUT;
+    m_waiting = true;
+    m_hEvent.Reset();
 
-      lock.Enter();
+    // a packet may have arrived before the producer could see we are waiting
+    if (priority == 0 && PeekPacket())
+    {
+      m_waiting = false;
+      continue;
     }
+
+    lock.Leave();
+
+    // wait for a new message
+    bool signaled = m_hEvent.WaitMSec(iTimeoutInMilliSeconds);
+    m_waiting = false;
+    if (!signaled)
+      return MSGQ_TIMEOUT;
+
+    lock.Enter();
   }
 
   if (m_bAbortRequest)
@@ -239,6 +398,11 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
       count++;
   }
 
+  if (type == CDVDMsg::DEMUXER_PACKET)
+  {
+    count += m_packetWrite - m_packetRead;
+  }
+
   return count;
 }
 
@@ -263,20 +427,23 @@ void CDVDMessageQueue::WaitUntilEmpty()
 
 int CDVDMessageQueue::GetLevel() const
 {
-  CSingleLock lock(m_section);
+  // the producer updates these without m_section, work on one snapshot of them
+  int dataSize = m_iDataSize;
+  double timeFront = m_TimeFront;
+  double timeBack = m_TimeBack;
 
-  if (m_iDataSize > m_iMaxDataSize)
+  if (dataSize > m_iMaxDataSize)
     return 100;
-  if (m_iDataSize == 0)
+  if (dataSize <= 0)
     return 0;
 
-  if (IsDataBased())
-    return std::min(100, 100 * m_iDataSize / m_iMaxDataSize);
+  if (IsDataBased(timeFront, timeBack))
+    return std::min(100, 100 * dataSize / m_iMaxDataSize);
 
-  int level = std::min(100.0, ceil(100.0 * m_TimeSize * (m_TimeFront - m_TimeBack) / DVD_TIME_BASE ));
+  int level = std::min(100.0, ceil(100.0 * m_TimeSize * (timeFront - timeBack) / DVD_TIME_BASE ));
 
   // if we added lots of packets with NOPTS, make sure that the queue is not signalled empty
-  if (level == 0 && m_iDataSize != 0)
+  if (level == 0)
   {
     CLog::Log(LOGDEBUG, "CDVDMessageQueue::GetLevel() - can't determine level");
     return 1;
@@ -287,17 +454,23 @@ int CDVDMessageQueue::GetLevel() const
 
 int CDVDMessageQueue::GetTimeSize() const
 {
-  CSingleLock lock(m_section);
+  double timeFront = m_TimeFront;
+  double timeBack = m_TimeBack;
 
-  if (IsDataBased())
+  if (IsDataBased(timeFront, timeBack))
     return 0;
   else
-    return (int)((m_TimeFront - m_TimeBack) / DVD_TIME_BASE);
+    return (int)((timeFront - timeBack) / DVD_TIME_BASE);
 }
 
 bool CDVDMessageQueue::IsDataBased() const
 {
-  return (m_TimeBack == DVD_NOPTS_VALUE  ||
-          m_TimeFront == DVD_NOPTS_VALUE ||
-          m_TimeFront <= m_TimeBack);
+  return IsDataBased(m_TimeFront, m_TimeBack);
+}
+
+bool CDVDMessageQueue::IsDataBased(double timeFront, double timeBack)
+{
+  return (timeBack == DVD_NOPTS_VALUE  ||
+          timeFront == DVD_NOPTS_VALUE ||
+          timeFront <= timeBack);
 }
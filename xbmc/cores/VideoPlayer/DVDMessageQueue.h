@@ -22,23 +22,28 @@
 
 #include "DVDMessage.h"
 #include <atomic>
+#include <memory>
 #include <string>
 #include <list>
 #include <algorithm>
+#include <stdint.h>
+#include <thread>
 #include "threads/CriticalSection.h"
 #include "threads/Event.h"
 
 struct DVDMessageListItem
 {
-  DVDMessageListItem(CDVDMsg* msg, int prio)
+  DVDMessageListItem(CDVDMsg* msg, int prio, int64_t seq = 0)
   {
     message = msg->Acquire();
     priority = prio;
+    sequence = seq;
   }
   DVDMessageListItem()
   {
     message = NULL;
     priority = 0;
+    sequence = 0;
   }
   DVDMessageListItem(const DVDMessageListItem&) = delete;
  ~DVDMessageListItem()
@@ -51,6 +56,7 @@ struct DVDMessageListItem
 
   CDVDMsg* message;
   int priority;
+  int64_t sequence; // order of priority 0 messages, shared with the packet ring
 };
 
 enum MsgQueueReturnCode
@@ -65,6 +71,18 @@ enum MsgQueueReturnCode
 
 #define MSGQ_IS_ERROR(c)    (c < 0)
 
+/*!
+ Threading contract: a queue has one consumer, the thread calling Get(), and
+ any number of threads calling Put(). The first thread to put a demuxer packet
+ becomes the producer of the packet ring and puts its packets without taking
+ m_section. Everything that reads or pops the ring (Get, Flush, End) holds
+ m_section, so Flush may be called from any thread, including the consumer.
+
+ The producer updates the data size and the front time while the other
+ threads do, so GetDataSize, GetLevel and GetTimeSize are snapshots. Flush
+ only takes the sizes of the packets it drops off the data size, packets put
+ meanwhile keep theirs. The times it resets are set again by the next packet.
+ */
 class CDVDMessageQueue
 {
 public:
@@ -109,18 +127,49 @@ public:
 
 private:
 
+  /*!
+   Demuxer packets are by far the most frequent messages. Those put by the
+   thread feeding the queue (the first one to put a packet) go through a
+   bounded single producer/single consumer ring, so the producer neither
+   allocates nor takes m_section. Everything else, and packets that don't
+   fit into the ring, go through the locked lists. Priority 0 messages carry
+   a sequence number so Get() can return them in the order they were put.
+   */
+  struct PacketSlot
+  {
+    CDVDMsg* message;
+    int64_t sequence;
+  };
+
+  bool PutPacket(CDVDMsg* pMsg);
+  PacketSlot* PeekPacket();
+  void PopPacket();
+  void ClearPackets();
+  void AddPacketSize(CDVDMsg* pMsg);
+  void RemovePacketSize(CDVDMsg* pMsg);
+  void DropPacketSize(CDVDMsg* pMsg);
+  static bool IsDataBased(double timeFront, double timeBack);
+
   CEvent m_hEvent;
   mutable CCriticalSection m_section;
 
   std::atomic<bool> m_bAbortRequest;
-  bool m_bInitialized;
+  std::atomic<bool> m_bInitialized;
   bool m_drain;
 
-  int m_iDataSize;
-  double m_TimeFront;
-  double m_TimeBack;
+  std::atomic<int> m_iDataSize;
+  std::atomic<double> m_TimeFront;
+  std::atomic<double> m_TimeBack;
   double m_TimeSize;
 
+  std::atomic<int64_t> m_sequence;
+  std::atomic<int64_t> m_jumpSequence;
+  std::unique_ptr<PacketSlot[]> m_packets;
+  std::atomic<uint64_t> m_packetWrite;
+  std::atomic<uint64_t> m_packetRead;
+  std::atomic<std::thread::id> m_producer;
+  std::atomic<bool> m_waiting;
+
   int m_iMaxDataSize;
   std::string m_owner;
 
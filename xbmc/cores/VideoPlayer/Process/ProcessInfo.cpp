@@ -21,7 +21,16 @@
 #include "ProcessInfo.h"
 #include "ServiceBroker.h"
 #include "cores/DataCacheCore.h"
+#include "cores/VideoPlayer/DVDClock.h"
+#include "filesystem/File.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 // Override for platform ports
 #if !defined(PLATFORM_OVERRIDE_VP_PROCESSINFO)
@@ -38,6 +47,7 @@ CProcessInfo* CProcessInfo::CreateInstance()
 CProcessInfo::CProcessInfo()
 {
   ResetVideoCodecInfo();
+  ResetPlaybackStats();
 }
 
 CProcessInfo::~CProcessInfo()
@@ -381,3 +391,175 @@ bool CProcessInfo::IsSeeking()
 
   return m_stateSeeking;
 }
+
+// playback statistics
+namespace
+{
+// upper bounds of the histogram buckets, the last bucket takes everything above
+const int64_t stageBounds[] = { 500, 1000, 2000, 4000, 8000, 16000, 33000, 66000 }; // usec
+const int syncBounds[] = { -100, -40, -20, -10, -5, 5, 10, 20, 40, 100 }; // msec
+
+const char* stageNames[] = { "demux", "queue", "decode", "upload", "present" };
+
+CVariant LevelStats(uint64_t count, int64_t total, int min, unsigned int empty)
+{
+  CVariant level(CVariant::VariantTypeObject);
+  level["average"] = count ? (int)(total / count) : 0;
+  level["min"] = count ? min : 0;
+  level["empty"] = empty;
+  return level;
+}
+}
+
+void CProcessInfo::ResetPlaybackStats()
+{
+  CSingleLock lock(m_statsSection);
+
+  memset(m_stageStats, 0, sizeof(m_stageStats));
+  memset(&m_videoLevelStats, 0, sizeof(m_videoLevelStats));
+  memset(&m_audioLevelStats, 0, sizeof(m_audioLevelStats));
+  memset(m_syncBuckets, 0, sizeof(m_syncBuckets));
+  m_videoLevelStats.min = 100;
+  m_audioLevelStats.min = 100;
+  m_syncErrorMax = 0.0;
+  m_renderQueueSkipped = 0;
+  m_renderLateFrames = 0;
+  m_renderLateFramesMax = 0;
+  m_decoderDropped = 0;
+  m_playbackStart = XbmcThreads::SystemClockMillis();
+}
+
+void CProcessInfo::AddStageTime(PlaybackStage stage, int64_t usec)
+{
+  if (stage < 0 || stage >= STAGE_MAX || usec < 0)
+    return;
+
+  int bucket = std::upper_bound(stageBounds, stageBounds + STAGE_BUCKETS - 1, usec) - stageBounds;
+
+  CSingleLock lock(m_statsSection);
+
+  SStageStats &stats = m_stageStats[stage];
+  stats.count++;
+  stats.total += usec;
+  stats.max = std::max(stats.max, usec);
+  stats.buckets[bucket]++;
+}
+
+void CProcessInfo::UpdateRenderDrops(int queueSkipped, int lateFrames)
+{
+  CSingleLock lock(m_statsSection);
+
+  m_renderQueueSkipped = queueSkipped;
+  m_renderLateFrames = lateFrames;
+  m_renderLateFramesMax = std::max(m_renderLateFramesMax, lateFrames);
+}
+
+void CProcessInfo::UpdateDecoderDrops(int dropped)
+{
+  CSingleLock lock(m_statsSection);
+
+  m_decoderDropped = dropped;
+}
+
+void CProcessInfo::AddBufferLevels(int video, int audio)
+{
+  CSingleLock lock(m_statsSection);
+
+  if (video >= 0)
+  {
+    m_videoLevelStats.count++;
+    m_videoLevelStats.total += video;
+    m_videoLevelStats.min = std::min(m_videoLevelStats.min, video);
+    if (video == 0)
+      m_videoLevelStats.empty++;
+  }
+  if (audio >= 0)
+  {
+    m_audioLevelStats.count++;
+    m_audioLevelStats.total += audio;
+    m_audioLevelStats.min = std::min(m_audioLevelStats.min, audio);
+    if (audio == 0)
+      m_audioLevelStats.empty++;
+  }
+}
+
+void CProcessInfo::AddSyncError(double error)
+{
+  double msec = DVD_TIME_TO_MSEC(error);
+  int bucket = std::upper_bound(syncBounds, syncBounds + SYNC_BUCKETS - 1, msec) - syncBounds;
+
+  CSingleLock lock(m_statsSection);
+
+  m_syncBuckets[bucket]++;
+  if (fabs(msec) > fabs(m_syncErrorMax))
+    m_syncErrorMax = msec;
+}
+
+void CProcessInfo::GetPlaybackStats(CVariant &stats)
+{
+  stats = CVariant(CVariant::VariantTypeObject);
+
+  {
+    CSingleLock lock(m_videoCodecSection);
+    CVariant &video = stats["video"];
+    video["decoder"] = m_videoDecoderName;
+    video["hwdecoder"] = m_videoIsHWDecoder;
+    video["width"] = m_videoWidth;
+    video["height"] = m_videoHeight;
+    video["fps"] = m_videoFPS;
+  }
+
+  CSingleLock lock(m_statsSection);
+
+  stats["duration"] = (int)((XbmcThreads::SystemClockMillis() - m_playbackStart) / 1000);
+
+  CVariant &bounds = stats["histogrambounds"];
+  bounds["stage"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = 0; i < STAGE_BUCKETS - 1; i++)
+    bounds["stage"].push_back((int)stageBounds[i]);
+  bounds["syncerror"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = 0; i < SYNC_BUCKETS - 1; i++)
+    bounds["syncerror"].push_back(syncBounds[i]);
+
+  for (int i = 0; i < STAGE_MAX; i++)
+  {
+    const SStageStats &stage = m_stageStats[i];
+    CVariant &value = stats["stages"][stageNames[i]];
+    value["count"] = stage.count;
+    value["average"] = stage.count ? stage.total / (int64_t)stage.count : 0;
+    value["max"] = stage.max;
+    value["histogram"] = CVariant(CVariant::VariantTypeArray);
+    for (int j = 0; j < STAGE_BUCKETS; j++)
+      value["histogram"].push_back(stage.buckets[j]);
+  }
+
+  CVariant &drops = stats["drops"];
+  drops["decoder"] = m_decoderDropped;
+  drops["renderskipped"] = m_renderQueueSkipped;
+  drops["renderlate"] = m_renderLateFrames;
+  drops["renderlatemax"] = m_renderLateFramesMax;
+
+  CVariant &levels = stats["bufferlevels"];
+  levels["video"] = LevelStats(m_videoLevelStats.count, m_videoLevelStats.total, m_videoLevelStats.min, m_videoLevelStats.empty);
+  levels["audio"] = LevelStats(m_audioLevelStats.count, m_audioLevelStats.total, m_audioLevelStats.min, m_audioLevelStats.empty);
+
+  CVariant &sync = stats["syncerror"];
+  sync["max"] = m_syncErrorMax;
+  sync["histogram"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = 0; i < SYNC_BUCKETS; i++)
+    sync["histogram"].push_back(m_syncBuckets[i]);
+}
+
+bool CProcessInfo::DumpPlaybackStats(const std::string &path)
+{
+  CVariant stats;
+  GetPlaybackStats(stats);
+
+  std::string json = CJSONVariantWriter::Write(stats, false);
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(path, true))
+    return false;
+
+  return file.Write(json.c_str(), json.size()) == (ssize_t)json.size();
+}
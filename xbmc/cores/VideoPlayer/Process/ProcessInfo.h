@@ -23,8 +23,11 @@
 #include "cores/VideoPlayer/VideoRenderers/RenderFormats.h"
 #include "threads/CriticalSection.h"
 #include <list>
+#include <stdint.h>
 #include <string>
 
+class CVariant;
+
 class CProcessInfo
 {
 public:
@@ -76,6 +79,25 @@ public:
   void SetStateSeeking(bool active);
   bool IsSeeking();
 
+  // playback statistics
+  enum PlaybackStage
+  {
+    STAGE_DEMUX = 0,   // reading a packet from the demuxer
+    STAGE_QUEUE,       // packet waiting in the queue of a stream player
+    STAGE_DECODE,      // decoding a video packet
+    STAGE_UPLOAD,      // handing a decoded picture to the renderer
+    STAGE_PRESENT,     // picture waiting in the render queue until it gets presented
+    STAGE_MAX
+  };
+  void ResetPlaybackStats();
+  void AddStageTime(PlaybackStage stage, int64_t usec);
+  void UpdateRenderDrops(int queueSkipped, int lateFrames);
+  void UpdateDecoderDrops(int dropped);
+  void AddBufferLevels(int video, int audio);
+  void AddSyncError(double error);
+  void GetPlaybackStats(CVariant &stats);
+  bool DumpPlaybackStats(const std::string &path);
+
 protected:
   CProcessInfo();
 
@@ -110,4 +132,33 @@ protected:
   // player states
   CCriticalSection m_stateSection;
   bool m_stateSeeking;
+
+  // playback statistics
+  static const int STAGE_BUCKETS = 9;
+  static const int SYNC_BUCKETS = 11;
+  struct SStageStats
+  {
+    uint64_t count;
+    int64_t total;
+    int64_t max;
+    unsigned int buckets[STAGE_BUCKETS];
+  };
+  struct SLevelStats
+  {
+    uint64_t count;
+    int64_t total;
+    int min;
+    unsigned int empty;
+  };
+  CCriticalSection m_statsSection;
+  SStageStats m_stageStats[STAGE_MAX];
+  SLevelStats m_videoLevelStats;
+  SLevelStats m_audioLevelStats;
+  unsigned int m_syncBuckets[SYNC_BUCKETS];
+  double m_syncErrorMax;
+  int m_renderQueueSkipped;
+  int m_renderLateFrames;
+  int m_renderLateFramesMax;
+  int m_decoderDropped;
+  unsigned int m_playbackStart;
 };
@@ -72,7 +72,9 @@
 #include "dialogs/GUIDialogBusy.h"
 #include "dialogs/GUIDialogKaiToast.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 #include "Util.h"
+#include "XBDateTime.h"
 #include "LangInfo.h"
 #include "URL.h"
 
@@ -623,7 +625,8 @@ CVideoPlayer::CVideoPlayer(IPlayerCallback& callback)
       m_CurrentRadioRDS(STREAM_RADIO_RDS, VideoPlayer_RDS),
       m_messenger("player"),
       m_renderManager(m_clock, this),
-      m_ready(true)
+      m_ready(true),
+      m_preOpen(this)
 {
   m_players_created = false;
   m_pDemuxer = NULL;
@@ -686,7 +689,7 @@ bool CVideoPlayer::OpenFile(const CFileItem& file, const CPlayerOptions &options
   // if playing a file close it first
   // this has to be changed so we won't have to close it.
   if(IsRunning())
-    CloseFile();
+    CloseCurrentFile();
 
   m_bAbortRequest = false;
   SetPlaySpeed(DVD_PLAYSPEED_NORMAL);
@@ -719,7 +722,25 @@ bool CVideoPlayer::OpenFile(const CFileItem& file, const CPlayerOptions &options
   return true;
 }
 
+bool CVideoPlayer::PreOpenFile(const CFileItem &file)
+{
+  if (!IsPlaying() || m_PlayerOptions.identify)
+    return false;
+
+  m_preOpen.Open(file);
+  return true;
+}
+
 bool CVideoPlayer::CloseFile(bool reopen)
+{
+  // when closing for the next playlist item, its OpenFile takes over what was
+  // opened ahead. only a stop leaves nobody to take it
+  if (!reopen)
+    m_preOpen.Close();
+  return CloseCurrentFile();
+}
+
+bool CVideoPlayer::CloseCurrentFile()
 {
   CLog::Log(LOGNOTICE, "CVideoPlayer::CloseFile()");
 
@@ -787,17 +808,22 @@ bool CVideoPlayer::OpenInputStream()
     m_item.SetPath(g_mediaManager.TranslateDevicePath(""));
   }
 
-  m_pInputStream = CDVDFactoryInputStream::CreateInputStream(this, m_item, true);
-  if(m_pInputStream == NULL)
+  // the input might have been opened ahead while the previous item was playing
+  m_pInputStream = m_preOpen.TakeInputStream(m_item.GetPath(), m_bAbortRequest);
+  if (!m_pInputStream)
   {
-    CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - unable to create input stream for [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
-    return false;
-  }
+    m_pInputStream = CDVDFactoryInputStream::CreateInputStream(this, m_item, true);
+    if(m_pInputStream == NULL)
+    {
+      CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - unable to create input stream for [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
+      return false;
+    }
 
-  if (!m_pInputStream->Open())
-  {
-    CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - error opening [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
-    return false;
+    if (!m_pInputStream->Open())
+    {
+      CLog::Log(LOGERROR, "CVideoPlayer::OpenInputStream - error opening [%s]", CURL::GetRedacted(m_item.GetPath()).c_str());
+      return false;
+    }
   }
 
   // find any available external subtitles for non dvd files
@@ -861,8 +887,10 @@ bool CVideoPlayer::OpenDemuxStream()
 
   CLog::Log(LOGNOTICE, "Creating Demuxer");
 
+  m_pDemuxer = m_preOpen.TakeDemuxer(m_pInputStream);
+
   int attempts = 10;
-  while(!m_bStop && attempts-- > 0)
+  while(!m_pDemuxer && !m_bStop && attempts-- > 0)
   {
     m_pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(m_pInputStream);
     if(!m_pDemuxer && m_pInputStream->IsStreamType(DVDSTREAM_TYPE_PVRMANAGER))
@@ -1066,7 +1094,11 @@ bool CVideoPlayer::ReadPacket(DemuxPacket*& packet, CDemuxStream*& stream)
   }
   // read a data frame from stream.
   if(m_pDemuxer)
+  {
+    int64_t start = CurrentHostCounter();
     packet = m_pDemuxer->Read();
+    m_processInfo->AddStageTime(CProcessInfo::STAGE_DEMUX, (CurrentHostCounter() - start) * 1000000 / CurrentHostFrequency());
+  }
 
   if(packet)
   {
@@ -1223,6 +1255,8 @@ void CVideoPlayer::Process()
 {
   CFFmpegLog::SetLogLevel(1);
 
+  m_processInfo->ResetPlaybackStats();
+
   if (!OpenInputStream())
   {
     m_bAbortRequest = true;
@@ -2467,6 +2501,15 @@ void CVideoPlayer::OnExit()
       m_OmxPlayerState.av_clock.OMXDeinitialize();
     }
 
+  if (g_advancedSettings.m_videoDumpPlaybackStats && m_PlayerOptions.identify == false)
+  {
+    std::string path = "special://temp/playbackstats-" + CDateTime::GetCurrentDateTime().GetAsSaveString() + ".json";
+    if (m_processInfo->DumpPlaybackStats(path))
+      CLog::Log(LOGNOTICE, "VideoPlayer: playback statistics written to %s", path.c_str());
+    else
+      CLog::Log(LOGERROR, "VideoPlayer: failed to write playback statistics to %s", path.c_str());
+  }
+
   m_bStop = true;
   // if we didn't stop playing, advance to the next item in xbmc's playlist
   if(m_PlayerOptions.identify == false)
@@ -4709,6 +4752,12 @@ double CVideoPlayer::GetQueueTime()
   return std::max(a, v) * 8000.0 / 100;
 }
 
+bool CVideoPlayer::GetPlaybackStats(CVariant &stats)
+{
+  m_processInfo->GetPlaybackStats(stats);
+  return true;
+}
+
 void CVideoPlayer::GetVideoStreamInfo(int streamId, SPlayerVideoStreamInfo &info)
 {
   CSingleLock lock(m_SelectionStreams.m_section);
@@ -4978,6 +5027,10 @@ void CVideoPlayer::UpdatePlayState(double timeout)
   else
     state.cache_bytes = 0;
 
+  if (!state.caching)
+    m_processInfo->AddBufferLevels(m_CurrentVideo.id >= 0 ? m_VideoPlayerVideo->GetLevel() : -1,
+                                   m_CurrentAudio.id >= 0 ? m_VideoPlayerAudio->GetLevel() : -1);
+
   state.timestamp = m_clock.GetAbsoluteClock();
 
   CSingleLock lock(m_StateSection);
@@ -5228,6 +5281,12 @@ void CVideoPlayer::UpdateRenderBuffers(int queued, int discard, int free)
   m_processInfo->UpdateRenderBuffers(queued, discard, free);
 }
 
+void CVideoPlayer::UpdateRenderStats(int queueSkipped, int lateFrames, int64_t presentDelay)
+{
+  m_processInfo->UpdateRenderDrops(queueSkipped, lateFrames);
+  m_processInfo->AddStageTime(CProcessInfo::STAGE_PRESENT, presentDelay);
+}
+
 // IDispResource interface
 void CVideoPlayer::OnLostDisplay()
 {
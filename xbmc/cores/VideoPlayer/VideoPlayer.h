@@ -34,6 +34,7 @@
 #include "VideoPlayerSubtitle.h"
 #include "VideoPlayerTeletext.h"
 #include "VideoPlayerRadioRDS.h"
+#include "VideoPlayerPreOpen.h"
 #include "Edl.h"
 #include "FileItem.h"
 #include "system.h"
@@ -294,6 +295,7 @@ public:
   CVideoPlayer(IPlayerCallback& callback);
   virtual ~CVideoPlayer();
   virtual bool OpenFile(const CFileItem& file, const CPlayerOptions &options);
+  virtual bool PreOpenFile(const CFileItem &file) override;
   virtual bool CloseFile(bool reopen = false);
   virtual bool IsPlaying() const;
   virtual void Pause() override;
@@ -338,6 +340,7 @@ public:
   virtual int GetVideoStreamCount() const override;
   virtual void GetVideoStreamInfo(int streamId, SPlayerVideoStreamInfo &info) override;
   virtual void SetVideoStream(int iStream);
+  virtual bool GetPlaybackStats(CVariant &stats) override;
 
   virtual TextCacheStruct_t* GetTeletextCache();
   virtual void LoadPage(int p, int sp, unsigned char* buffer);
@@ -410,6 +413,7 @@ protected:
   virtual void UpdateClockSync(bool enabled) override;
   virtual void UpdateRenderInfo(CRenderInfo &info) override;
   virtual void UpdateRenderBuffers(int queued, int discard, int free) override;
+  virtual void UpdateRenderStats(int queueSkipped, int lateFrames, int64_t presentDelay) override;
 
   void CreatePlayers();
   void DestroyPlayers();
@@ -485,6 +489,7 @@ protected:
   bool CheckDelayedChannelEntry(void);
 
   bool OpenInputStream();
+  bool CloseCurrentFile(); ///< stop playback but keep the item opened ahead, for OpenFile of the next item
   bool OpenDemuxStream();
   void CloseDemuxer();
   void OpenDefaultStreams(bool reset = true);
@@ -580,6 +585,7 @@ protected:
   XbmcThreads::EndTime m_syncTimer;
 
   CEvent m_ready;
+  CVideoPlayerPreOpen m_preOpen;
 
   CEdl m_Edl;
   bool m_SkipCommercials;
@@ -26,6 +26,7 @@
 #include "settings/Settings.h"
 #include "utils/log.h"
 #include "utils/MathUtils.h"
+#include "utils/TimeUtils.h"
 #include "cores/AudioEngine/AEFactory.h"
 #include "cores/AudioEngine/Utils/AEUtil.h"
 #ifdef TARGET_RASPBERRY_PI
@@ -363,6 +364,9 @@ void CVideoPlayerAudio::Process()
       DemuxPacket* pPacket = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
       bool bPacketDrop  = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacketDrop();
 
+      m_processInfo.AddStageTime(CProcessInfo::STAGE_QUEUE,
+                                 (CurrentHostCounter() - ((CDVDMsgDemuxerPacket*)pMsg)->GetPacketTime()) * 1000000 / CurrentHostFrequency());
+
       int consumed = m_pAudioCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
       if (consumed < 0)
       {
@@ -535,6 +539,7 @@ void CVideoPlayerAudio::SetSyncType(bool passthrough)
 bool CVideoPlayerAudio::OutputPacket(DVDAudioFrame &audioframe)
 {
   double syncerror = m_dvdAudio.GetSyncError();
+  m_processInfo.AddSyncError(syncerror);
 
   if (m_synctype == SYNC_DISCON && fabs(syncerror) > DVD_MSEC_TO_TIME(10))
   {
@@ -0,0 +1,185 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VideoPlayerPreOpen.h"
+#include "DVDDemuxers/DVDDemux.h"
+#include "DVDDemuxers/DVDFactoryDemuxer.h"
+#include "DVDInputStreams/DVDFactoryInputStream.h"
+#include "DVDInputStreams/DVDInputStream.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+
+CVideoPlayerPreOpen::CVideoPlayerPreOpen(IVideoPlayer *player)
+  : CThread("VideoPlayerPreOpen")
+  , m_player(player)
+  , m_input(NULL)
+  , m_demuxer(NULL)
+  , m_inputTaken(false)
+  , m_opened(false)
+{
+}
+
+CVideoPlayerPreOpen::~CVideoPlayerPreOpen()
+{
+  Close();
+}
+
+void CVideoPlayerPreOpen::Open(const CFileItem &item)
+{
+  Close();
+
+  CLog::Log(LOGDEBUG, "CVideoPlayerPreOpen::%s - opening %s ahead", __FUNCTION__, CURL::GetRedacted(item.GetPath()).c_str());
+
+  CSingleLock lock(m_section);
+  m_item = item;
+  Create();
+}
+
+void CVideoPlayerPreOpen::Close()
+{
+  {
+    CSingleLock lock(m_section);
+    m_bStop = true;
+    if (m_demuxer)
+      m_demuxer->Abort();
+    if (m_input && !m_inputTaken)
+      m_input->Abort();
+  }
+
+  StopThread();
+
+  CSingleLock lock(m_section);
+  delete m_demuxer;
+  if (!m_inputTaken)
+    delete m_input;
+  m_demuxer = NULL;
+  m_input = NULL;
+  m_inputTaken = false;
+  m_opened = false;
+  m_item.Reset();
+}
+
+CDVDInputStream* CVideoPlayerPreOpen::TakeInputStream(const std::string &path, const bool &abort)
+{
+  bool other;
+  {
+    CSingleLock lock(m_section);
+    if (m_item.GetPath().empty())
+      return NULL;
+    other = m_item.GetPath() != path;
+  }
+
+  // don't wait for an open of another item, abort it
+  if (other)
+  {
+    Close();
+    return NULL;
+  }
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  while (!WaitForThreadExit(100))
+  {
+    if (abort)
+    {
+      Close();
+      return NULL;
+    }
+  }
+
+  CSingleLock lock(m_section);
+  if (!m_opened || m_inputTaken)
+  {
+    lock.Leave();
+    Close();
+    return NULL;
+  }
+
+  CLog::Log(LOGNOTICE, "CVideoPlayerPreOpen::%s - using input opened ahead for %s, waited %u ms", __FUNCTION__,
+            CURL::GetRedacted(path).c_str(), XbmcThreads::SystemClockMillis() - start);
+  m_inputTaken = true;
+  return m_input;
+}
+
+CDVDDemux* CVideoPlayerPreOpen::TakeDemuxer(CDVDInputStream *input)
+{
+  CDVDDemux *demuxer;
+  {
+    CSingleLock lock(m_section);
+    if (!m_inputTaken || m_input != input)
+      return NULL;
+
+    demuxer = m_demuxer;
+    m_demuxer = NULL;
+  }
+
+  // nothing is left to hand over
+  Close();
+  return demuxer;
+}
+
+void CVideoPlayerPreOpen::Process()
+{
+  CFileItem item;
+  {
+    CSingleLock lock(m_section);
+    item = m_item;
+  }
+  item.SetMimeTypeForInternetFile();
+
+  std::string redactPath = CURL::GetRedacted(item.GetPath());
+
+  CDVDInputStream *input = CDVDFactoryInputStream::CreateInputStream(m_player, item, true);
+  if (!input)
+    return;
+
+  if (!input->IsStreamType(DVDSTREAM_TYPE_FILE))
+  {
+    CLog::Log(LOGDEBUG, "CVideoPlayerPreOpen::%s - not opening %s ahead", __FUNCTION__, redactPath.c_str());
+    delete input;
+    return;
+  }
+
+  {
+    CSingleLock lock(m_section);
+    if (m_bStop)
+    {
+      delete input;
+      return;
+    }
+    m_input = input;
+  }
+
+  // the file cache starts filling as soon as the file is open
+  if (!input->Open())
+  {
+    CLog::Log(LOGERROR, "CVideoPlayerPreOpen::%s - error opening %s", __FUNCTION__, redactPath.c_str());
+    return;
+  }
+
+  CDVDDemux *demuxer = NULL;
+  if (!m_bStop)
+    demuxer = CDVDFactoryDemuxer::CreateDemuxer(input);
+
+  CSingleLock lock(m_section);
+  m_demuxer = demuxer;
+  m_opened = !m_bStop;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+#include "FileItem.h"
+#include "threads/CriticalSection.h"
+#include "threads/Thread.h"
+
+class CDVDDemux;
+class CDVDInputStream;
+class IVideoPlayer;
+
+/*!
+ \brief Opens the input stream and demuxer of the next playlist item ahead
+
+ Started by the player shortly before the current item ends. The input stream
+ is opened, which gets its file cache filling, and the demuxer probes the
+ streams in the background, so the next OpenFile of the same item can take
+ both over instead of opening the file from scratch.
+
+ Only plain files are opened ahead, discs, live tv and addon streams are left
+ to the regular open.
+ */
+class CVideoPlayerPreOpen : private CThread
+{
+public:
+  explicit CVideoPlayerPreOpen(IVideoPlayer *player);
+  ~CVideoPlayerPreOpen() override;
+
+  /*!
+   \brief Start opening item, drops whatever was opened before
+   */
+  void Open(const CFileItem &item);
+
+  /*!
+   \brief Drop the opened item, aborts an open in progress
+   */
+  void Close();
+
+  /*!
+   \brief Take over the input stream if it was opened for path
+   Waits for an open in progress unless abort gets set.
+   \return the opened input stream, NULL if there is none for path
+   */
+  CDVDInputStream* TakeInputStream(const std::string &path, const bool &abort);
+
+  /*!
+   \brief Take over the demuxer opened on input, NULL if there is none
+   */
+  CDVDDemux* TakeDemuxer(CDVDInputStream *input);
+
+protected:
+  void Process() override;
+
+private:
+  IVideoPlayer *m_player;
+  CCriticalSection m_section;
+  CFileItem m_item;
+  CDVDInputStream *m_input;
+  CDVDDemux *m_demuxer;
+  bool m_inputTaken;
+  bool m_opened;
+};
@@ -25,6 +25,7 @@
 #include "settings/MediaSettings.h"
 #include "settings/Settings.h"
 #include "utils/MathUtils.h"
+#include "utils/TimeUtils.h"
 #include "VideoPlayerVideo.h"
 #include "DVDCodecs/DVDFactoryCodec.h"
 #include "DVDCodecs/DVDCodecUtils.h"
@@ -420,6 +421,10 @@ void CVideoPlayerVideo::Process()
       DemuxPacket* pPacket = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
       bool bPacketDrop     = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacketDrop();
 
+      int64_t decodeStart = CurrentHostCounter();
+      m_processInfo.AddStageTime(CProcessInfo::STAGE_QUEUE,
+                                 (decodeStart - ((CDVDMsgDemuxerPacket*)pMsg)->GetPacketTime()) * 1000000 / CurrentHostFrequency());
+
       if (m_stalled)
       {
         CLog::Log(LOGINFO, "CVideoPlayerVideo - Stillframe left, switching to normal playback");
@@ -471,6 +476,7 @@ void CVideoPlayerVideo::Process()
       m_pVideoCodec->SetDropState(bRequestDrop);
 
       int iDecoderState = m_pVideoCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
+      m_processInfo.AddStageTime(CProcessInfo::STAGE_DECODE, (CurrentHostCounter() - decodeStart) * 1000000 / CurrentHostFrequency());
 
       // buffer packets so we can recover should decoder flush for some reason
       if(m_pVideoCodec->GetConvergeCount() > 0)
@@ -503,6 +509,7 @@ void CVideoPlayerVideo::Process()
         // the decoder didn't need more data, flush the remaning buffer
         iDecoderState = m_pVideoCodec->Decode(NULL, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
       }
+      m_processInfo.UpdateDecoderDrops(m_iDroppedFrames);
     }
 
     // all data is used by the decoder, we can safely free it now
@@ -876,7 +883,9 @@ int CVideoPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
 
   ProcessOverlays(pPicture, pts);
 
+  int64_t uploadStart = CurrentHostCounter();
   int index = m_renderManager.AddVideoPicture(*pPicture);
+  m_processInfo.AddStageTime(CProcessInfo::STAGE_UPLOAD, (CurrentHostCounter() - uploadStart) * 1000000 / CurrentHostFrequency());
 
   // video device might not be done yet
   while (index < 0 && !m_bAbortOutput &&
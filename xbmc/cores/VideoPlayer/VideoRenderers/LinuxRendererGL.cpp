@@ -110,6 +110,11 @@ CLinuxRendererGL::YUVBUFFER::YUVBUFFER()
   memset(&fields, 0, sizeof(fields));
   memset(&image , 0, sizeof(image));
   memset(&pbo   , 0, sizeof(pbo));
+  memset(&pboMap, 0, sizeof(pboMap));
+#ifdef HAS_GL_PERSISTENT_PBO
+  fence = 0;
+#endif
+  pboPersistent = false;
   flipindex = 0;
   hwDec = NULL;
 }
@@ -154,6 +159,7 @@ CLinuxRendererGL::CLinuxRendererGL()
   m_clearColour = 0.0f;
   m_pboSupported = false;
   m_pboUsed = false;
+  m_pboPersistentSupported = false;
   m_nonLinStretch = false;
   m_nonLinStretchGui = false;
   m_pixelRatio = 0.0f;
@@ -1027,6 +1033,17 @@ void CLinuxRendererGL::LoadShaders(int field)
   }
   else
     m_pboUsed = false;
+
+  m_pboPersistentSupported = false;
+#ifdef HAS_GL_PERSISTENT_PBO
+  if (m_pboUsed &&
+      g_Windowing.IsExtSupported("GL_ARB_buffer_storage") &&
+      g_Windowing.IsExtSupported("GL_ARB_sync"))
+  {
+    CLog::Log(LOGNOTICE, "GL: Using persistently mapped pixel buffer objects");
+    m_pboPersistentSupported = true;
+  }
+#endif
 }
 
 void CLinuxRendererGL::UnInit()
@@ -1650,15 +1667,19 @@ void CLinuxRendererGL::DeleteTexture(int index)
 
 bool CLinuxRendererGL::UploadTexture(int index)
 {
+  bool ret;
   if (m_format == RENDER_FMT_NV12)
-    return UploadNV12Texture(index);
+    ret = UploadNV12Texture(index);
   else if (m_format == RENDER_FMT_YUYV422 ||
            m_format == RENDER_FMT_UYVY422)
-    return UploadYUV422PackedTexture(index);
+    ret = UploadYUV422PackedTexture(index);
   else
-    return UploadYV12Texture(index);
+    ret = UploadYV12Texture(index);
 
-  return false;
+  if (ret)
+    FencePbo(m_buffers[index]);
+
+  return ret;
 }
 
 //********************************************************************************************************
@@ -1705,8 +1726,7 @@ bool CLinuxRendererGL::CreateYV12Texture(int index)
     for (int i = 0; i < 3; i++)
     {
       glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, pbo[i]);
-      glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, im.planesize[i] + PBO_OFFSET, 0, GL_STREAM_DRAW_ARB);
-      void* pboPtr = glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+      void* pboPtr = AllocatePbo(m_buffers[index], im.planesize[i] + PBO_OFFSET);
       if (pboPtr)
       {
         im.plane[i] = (BYTE*) pboPtr + PBO_OFFSET;
@@ -1729,6 +1749,7 @@ bool CLinuxRendererGL::CreateYV12Texture(int index)
       }
       glDeleteBuffersARB(3, pbo);
       memset(m_buffers[index].pbo, 0, sizeof(m_buffers[index].pbo));
+      m_buffers[index].pboPersistent = false;
     }
 
     glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
@@ -1891,6 +1912,8 @@ void CLinuxRendererGL::DeleteYV12Texture(int index)
   YUVFIELDS &fields = m_buffers[index].fields;
   GLuint    *pbo    = m_buffers[index].pbo;
 
+  DeletePboFence(m_buffers[index]);
+
   if( fields[FIELD_FULL][0].id == 0 ) return;
 
   /* finish up all textures, and delete them */
@@ -1920,6 +1943,7 @@ void CLinuxRendererGL::DeleteYV12Texture(int index)
       }
       glDeleteBuffersARB(1, pbo + p);
       pbo[p] = 0;
+      m_buffers[index].pboPersistent = false;
     }
     else
     {
@@ -2038,8 +2062,7 @@ bool CLinuxRendererGL::CreateNV12Texture(int index)
     for (int i = 0; i < 2; i++)
     {
       glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, pbo[i]);
-      glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, im.planesize[i] + PBO_OFFSET, 0, GL_STREAM_DRAW_ARB);
-      void* pboPtr = glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+      void* pboPtr = AllocatePbo(m_buffers[index], im.planesize[i] + PBO_OFFSET);
       if (pboPtr)
       {
         im.plane[i] = (BYTE*)pboPtr + PBO_OFFSET;
@@ -2062,6 +2085,7 @@ bool CLinuxRendererGL::CreateNV12Texture(int index)
       }
       glDeleteBuffersARB(2, pbo);
       memset(m_buffers[index].pbo, 0, sizeof(m_buffers[index].pbo));
+      m_buffers[index].pboPersistent = false;
     }
 
     glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
@@ -2146,6 +2170,8 @@ void CLinuxRendererGL::DeleteNV12Texture(int index)
   YUVFIELDS &fields = m_buffers[index].fields;
   GLuint    *pbo    = m_buffers[index].pbo;
 
+  DeletePboFence(m_buffers[index]);
+
   if( fields[FIELD_FULL][0].id == 0 ) return;
 
   // finish up all textures, and delete them
@@ -2178,6 +2204,7 @@ void CLinuxRendererGL::DeleteNV12Texture(int index)
       }
       glDeleteBuffersARB(1, pbo + p);
       pbo[p] = 0;
+      m_buffers[index].pboPersistent = false;
     }
     else
     {
@@ -2243,6 +2270,8 @@ void CLinuxRendererGL::DeleteYUV422PackedTexture(int index)
   YUVFIELDS &fields = m_buffers[index].fields;
   GLuint    *pbo    = m_buffers[index].pbo;
 
+  DeletePboFence(m_buffers[index]);
+
   if( fields[FIELD_FULL][0].id == 0 ) return;
 
   // finish up all textures, and delete them
@@ -2271,6 +2300,7 @@ void CLinuxRendererGL::DeleteYUV422PackedTexture(int index)
     }
     glDeleteBuffersARB(1, pbo);
     pbo[0] = 0;
+    m_buffers[index].pboPersistent = false;
   }
   else
   {
@@ -2320,8 +2350,7 @@ bool CLinuxRendererGL::CreateYUV422PackedTexture(int index)
     glGenBuffersARB(1, pbo);
 
     glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, pbo[0]);
-    glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, im.planesize[0] + PBO_OFFSET, 0, GL_STREAM_DRAW_ARB);
-    void* pboPtr = glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+    void* pboPtr = AllocatePbo(m_buffers[index], im.planesize[0] + PBO_OFFSET);
     if (pboPtr)
     {
       im.plane[0] = (BYTE*)pboPtr + PBO_OFFSET;
@@ -2339,6 +2368,7 @@ bool CLinuxRendererGL::CreateYUV422PackedTexture(int index)
       glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
       glDeleteBuffersARB(1, pbo);
       memset(m_buffers[index].pbo, 0, sizeof(m_buffers[index].pbo));
+      m_buffers[index].pboPersistent = false;
     }
 
     glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
@@ -2518,6 +2548,25 @@ bool CLinuxRendererGL::Supports(ESCALINGMETHOD method)
   return false;
 }
 
+void* CLinuxRendererGL::AllocatePbo(YUVBUFFER& buff, unsigned int size)
+{
+#ifdef HAS_GL_PERSISTENT_PBO
+  // immutable storage mapped once, the decoder writes straight into it and no
+  // reallocation or remapping is needed on every flip. the buffer keeps the
+  // mode it was created with until its pbos are deleted
+  buff.pboPersistent = m_pboPersistentSupported;
+  if (buff.pboPersistent)
+  {
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER_ARB, size, NULL, flags);
+    return glMapBufferRange(GL_PIXEL_UNPACK_BUFFER_ARB, 0, size, flags);
+  }
+#endif
+
+  glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, size, 0, GL_STREAM_DRAW_ARB);
+  return glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+}
+
 void CLinuxRendererGL::BindPbo(YUVBUFFER& buff)
 {
   bool pbo = false;
@@ -2525,6 +2574,14 @@ void CLinuxRendererGL::BindPbo(YUVBUFFER& buff)
   {
     if(!buff.pbo[plane] || buff.image.plane[plane] == (BYTE*)PBO_OFFSET)
       continue;
+
+    if (buff.pboPersistent)
+    {
+      // keep it mapped, only switch the plane to the offset used for uploading
+      buff.pboMap[plane] = buff.image.plane[plane];
+      buff.image.plane[plane] = (BYTE*)PBO_OFFSET;
+      continue;
+    }
     pbo = true;
 
     glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, buff.pbo[plane]);
@@ -2537,6 +2594,25 @@ void CLinuxRendererGL::BindPbo(YUVBUFFER& buff)
 
 void CLinuxRendererGL::UnBindPbo(YUVBUFFER& buff)
 {
+  if (buff.pboPersistent)
+  {
+    // the buffer goes back to the decoder, the GPU must be done reading it
+#ifdef HAS_GL_PERSISTENT_PBO
+    if (buff.fence)
+    {
+      if (glClientWaitSync(buff.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000) == GL_TIMEOUT_EXPIRED)
+        CLog::Log(LOGWARNING, "CLinuxRendererGL::UnBindPbo - timed out waiting for upload");
+      DeletePboFence(buff);
+    }
+#endif
+    for(int plane = 0; plane < MAX_PLANES; plane++)
+    {
+      if(buff.pbo[plane] && buff.image.plane[plane] == (BYTE*)PBO_OFFSET)
+        buff.image.plane[plane] = buff.pboMap[plane];
+    }
+    return;
+  }
+
   bool pbo = false;
   for(int plane = 0; plane < MAX_PLANES; plane++)
   {
@@ -2552,6 +2628,28 @@ void CLinuxRendererGL::UnBindPbo(YUVBUFFER& buff)
     glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
 }
 
+void CLinuxRendererGL::FencePbo(YUVBUFFER& buff)
+{
+#ifdef HAS_GL_PERSISTENT_PBO
+  if (!buff.pboPersistent || !buff.pbo[0])
+    return;
+
+  DeletePboFence(buff);
+  buff.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+}
+
+void CLinuxRendererGL::DeletePboFence(YUVBUFFER& buff)
+{
+#ifdef HAS_GL_PERSISTENT_PBO
+  if (buff.fence)
+  {
+    glDeleteSync(buff.fence);
+    buff.fence = 0;
+  }
+#endif
+}
+
 CRenderInfo CLinuxRendererGL::GetRenderInfo()
 {
   CRenderInfo info;
@@ -48,6 +48,10 @@ namespace Shaders { class BaseVideoFilterShader; }
 #define ALIGN(value, alignment) (((value)+((alignment)-1))&~((alignment)-1))
 #define CLAMP(a, min, max) ((a) > (max) ? (max) : ( (a) < (min) ? (min) : a ))
 
+#if defined(GL_MAP_PERSISTENT_BIT) && defined(GL_SYNC_GPU_COMMANDS_COMPLETE)
+#define HAS_GL_PERSISTENT_PBO
+#endif
+
 #define NOSOURCE   -2
 #define AUTOSOURCE -1
 
@@ -237,6 +241,11 @@ protected:
     YV12Image image;
     unsigned  flipindex; /* used to decide if this has been uploaded */
     GLuint    pbo[MAX_PLANES];
+    bool      pboPersistent;      /* pbos stay mapped for their lifetime, see AllocatePbo */
+    BYTE*     pboMap[MAX_PLANES]; /* mapping of persistent pbos while the planes are bound for upload */
+#ifdef HAS_GL_PERSISTENT_PBO
+    GLsync    fence;              /* upload from the persistent pbos has finished */
+#endif
 
     void *hwDec;
   };
@@ -270,10 +279,14 @@ protected:
   GLuint             m_rgbPbo;
   struct SwsContext *m_context;
 
+  void* AllocatePbo(YUVBUFFER& buff, unsigned int size);
   void BindPbo(YUVBUFFER& buff);
   void UnBindPbo(YUVBUFFER& buff);
+  void FencePbo(YUVBUFFER& buff);
+  void DeletePboFence(YUVBUFFER& buff);
   bool m_pboSupported;
   bool m_pboUsed;
+  bool m_pboPersistentSupported; // new pbos are created persistently mapped
 
   bool  m_nonLinStretch;
   bool  m_nonLinStretchGui;
@@ -26,6 +26,7 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 #include "windowing/WindowingFactory.h"
 
 #include "Application.h"
@@ -845,6 +846,7 @@ void CRenderManager::FlipPage(volatile std::atomic_bool& bStop, double pts,
   m.presentfield = sync;
   m.presentmethod = presentmethod;
   m.pts = pts;
+  m.queuetime = CurrentHostCounter();
   requeue(m_queued, m_free);
   m_playerPort->UpdateRenderBuffers(m_queued.size(), m_discard.size(), m_free.size());
 
@@ -1343,6 +1345,8 @@ void CRenderManager::PrepareNextRender()
     m_presentevent.notifyAll();
 
     m_playerPort->UpdateRenderBuffers(m_queued.size(), m_discard.size(), m_free.size());
+    m_playerPort->UpdateRenderStats(m_QueueSkip, m_lateframes,
+                                    (CurrentHostCounter() - m_Queue[idx].queuetime) * 1000000 / CurrentHostFrequency());
   }
 }
 
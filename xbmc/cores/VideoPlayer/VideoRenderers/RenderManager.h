@@ -60,6 +60,7 @@ protected:
   virtual void UpdateClockSync(bool enabled) = 0;
   virtual void UpdateRenderInfo(CRenderInfo &info) = 0;
   virtual void UpdateRenderBuffers(int queued, int discard, int free) = 0;
+  virtual void UpdateRenderStats(int queueSkipped, int lateFrames, int64_t presentDelay) = 0;
 };
 
 class CRenderManager
@@ -225,6 +226,7 @@ protected:
     double         pts;
     EFIELDSYNC     presentfield;
     EPRESENTMETHOD presentmethod;
+    int64_t        queuetime;
   } m_Queue[NUM_BUFFERS];
 
   std::deque<int> m_free;
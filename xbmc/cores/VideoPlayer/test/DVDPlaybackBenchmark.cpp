@@ -0,0 +1,360 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDPlaybackBenchmark.h"
+#include "cores/VideoPlayer/DVDClock.h"
+#include "cores/VideoPlayer/DVDStreamInfo.h"
+#include "cores/VideoPlayer/DVDCodecs/DVDCodecUtils.h"
+#include "cores/VideoPlayer/DVDCodecs/DVDFactoryCodec.h"
+#include "cores/VideoPlayer/DVDCodecs/Audio/DVDAudioCodec.h"
+#include "cores/VideoPlayer/DVDCodecs/Video/DVDVideoCodec.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemux.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxFFmpeg.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDFactoryDemuxer.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDFactoryInputStream.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDInputStream.h"
+#include "FileItem.h"
+#include "cores/VideoPlayer/Process/ProcessInfo.h"
+#include "threads/SystemClock.h"
+#include "URL.h"
+#include "utils/log.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+
+#include <cstring>
+#include <inttypes.h>
+
+#if defined(TARGET_POSIX)
+#include "linux/XTimeUtils.h"
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+#if defined(TARGET_LINUX) && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace
+{
+int64_t GetCpuTime(bool thread)
+{
+#if defined(TARGET_POSIX)
+  struct rusage usage;
+#if defined(TARGET_LINUX)
+  int who = thread ? RUSAGE_THREAD : RUSAGE_SELF;
+#else
+  if (thread)
+    return -1;
+  int who = RUSAGE_SELF;
+#endif
+  if (getrusage(who, &usage) != 0)
+    return -1;
+  return ((int64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#else
+  return -1;
+#endif
+}
+
+int64_t GetHeapInUse()
+{
+#if defined(TARGET_LINUX) && defined(__GLIBC__)
+  struct mallinfo info = mallinfo();
+  return (int64_t)(unsigned int)info.uordblks + (int64_t)(unsigned int)info.hblkhd;
+#else
+  return -1;
+#endif
+}
+
+int64_t ElapsedUsec(int64_t start)
+{
+  return (CurrentHostCounter() - start) * 1000000 / CurrentHostFrequency();
+}
+}
+
+CDVDPlaybackBenchmark::CDVDPlaybackBenchmark()
+  : m_realtime(false)
+  , m_maxDuration(0)
+  , m_softwareCopy(true)
+  , m_copy(NULL)
+  , m_start(0)
+  , m_startPts(DVD_NOPTS_VALUE)
+  , m_lastPts(DVD_NOPTS_VALUE)
+{
+  memset(&m_result, 0, sizeof(m_result));
+}
+
+CDVDPlaybackBenchmark::~CDVDPlaybackBenchmark()
+{
+  if (m_copy)
+    CDVDCodecUtils::FreePicture(m_copy);
+}
+
+bool CDVDPlaybackBenchmark::Run(const std::string &path)
+{
+  std::string redactPath = CURL::GetRedacted(path);
+
+  memset(&m_result, 0, sizeof(m_result));
+  m_startPts = DVD_NOPTS_VALUE;
+  m_lastPts = DVD_NOPTS_VALUE;
+  m_processInfo.reset(CProcessInfo::CreateInstance());
+
+  CFileItem item(path, false);
+  item.SetMimeTypeForInternetFile();
+  std::unique_ptr<CDVDInputStream> inputStream(CDVDFactoryInputStream::CreateInputStream(NULL, item));
+  if (!inputStream || !inputStream->Open())
+  {
+    CLog::Log(LOGERROR, "%s - Error opening %s", __FUNCTION__, redactPath.c_str());
+    return false;
+  }
+
+  std::unique_ptr<CDVDDemux> demuxer;
+  try
+  {
+    demuxer.reset(CDVDFactoryDemuxer::CreateDemuxer(inputStream.get()));
+  }
+  catch(...)
+  {
+    CLog::Log(LOGERROR, "%s - Exception thrown when opening demuxer", __FUNCTION__);
+  }
+  if (!demuxer)
+  {
+    CLog::Log(LOGERROR, "%s - Error creating demuxer for %s", __FUNCTION__, redactPath.c_str());
+    return false;
+  }
+
+  // play the first video and the first audio stream, like VideoPlayer does by default
+  CDemuxStream *videoStream = NULL;
+  CDemuxStream *audioStream = NULL;
+  for (CDemuxStream* stream : demuxer->GetStreams())
+  {
+    if (!stream)
+      continue;
+    if (!videoStream && stream->type == STREAM_VIDEO && !(stream->flags & AV_DISPOSITION_ATTACHED_PIC))
+      videoStream = stream;
+    else if (!audioStream && stream->type == STREAM_AUDIO)
+      audioStream = stream;
+    else
+      demuxer->EnableStream(stream->demuxerId, stream->uniqueId, false);
+  }
+
+  std::unique_ptr<CDVDVideoCodec> videoCodec;
+  if (videoStream)
+  {
+    CDVDStreamInfo hint(*videoStream, true);
+    hint.software = true;
+    videoCodec.reset(CDVDFactoryCodec::CreateVideoCodec(hint, *m_processInfo));
+  }
+
+  std::unique_ptr<CDVDAudioCodec> audioCodec;
+  if (audioStream)
+  {
+    CDVDStreamInfo hint(*audioStream, true);
+    audioCodec.reset(CDVDFactoryCodec::CreateAudioCodec(hint, *m_processInfo, false, false));
+  }
+
+  if (!videoCodec && !audioCodec)
+  {
+    CLog::Log(LOGERROR, "%s - No decodable stream in %s", __FUNCTION__, redactPath.c_str());
+    return false;
+  }
+
+  int64_t cpuProcess = GetCpuTime(false);
+  int64_t cpuThread = GetCpuTime(true);
+  int64_t heap = GetHeapInUse();
+  m_start = XbmcThreads::SystemClockMillis();
+
+  while (true)
+  {
+    int64_t demuxStart = CurrentHostCounter();
+    DemuxPacket* packet = demuxer->Read();
+    if (!packet)
+      break;
+    m_processInfo->AddStageTime(CProcessInfo::STAGE_DEMUX, ElapsedUsec(demuxStart));
+
+    m_result.packets++;
+    m_result.bytes += packet->iSize;
+
+    if (videoCodec && packet->iStreamId == videoStream->uniqueId && packet->demuxerId == videoStream->demuxerId)
+      DecodeVideo(videoCodec.get(), packet->pData, packet->iSize, packet->dts, packet->pts);
+    else if (audioCodec && packet->iStreamId == audioStream->uniqueId && packet->demuxerId == audioStream->demuxerId)
+      DecodeAudio(audioCodec.get(), packet->pData, packet->iSize, packet->dts, packet->pts);
+
+    CDVDDemuxUtils::FreeDemuxPacket(packet);
+
+    if (m_maxDuration && m_startPts != DVD_NOPTS_VALUE && m_lastPts != DVD_NOPTS_VALUE &&
+        m_lastPts - m_startPts >= DVD_MSEC_TO_TIME(m_maxDuration))
+      break;
+  }
+
+  // squeeze out the pictures still held by the decoder
+  if (videoCodec)
+  {
+    videoCodec->SetCodecControl(DVD_CODEC_CTRL_DRAIN);
+    DecodeVideo(videoCodec.get(), NULL, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+  }
+
+  m_result.elapsed = XbmcThreads::SystemClockMillis() - m_start;
+  m_result.fps = m_result.elapsed ? m_result.videoFrames * 1000.0 / m_result.elapsed : 0.0;
+  m_result.cpuProcess = cpuProcess < 0 ? -1 : GetCpuTime(false) - cpuProcess;
+  m_result.cpuThread = cpuThread < 0 ? -1 : GetCpuTime(true) - cpuThread;
+
+  videoCodec.reset();
+  audioCodec.reset();
+  demuxer.reset();
+  inputStream.reset();
+  if (m_copy)
+  {
+    CDVDCodecUtils::FreePicture(m_copy);
+    m_copy = NULL;
+  }
+  m_result.heapGrowth = heap < 0 ? -1 : GetHeapInUse() - heap;
+
+  m_processInfo->UpdateDecoderDrops(m_result.droppedFrames);
+
+  CLog::Log(LOGNOTICE, "%s - %s: %d pictures (%d dropped) in %u ms, %.2f fps, cpu %" PRId64 " ms (benchmark thread %" PRId64 " ms)",
+            __FUNCTION__, redactPath.c_str(), m_result.videoFrames, m_result.droppedFrames, m_result.elapsed,
+            m_result.fps, m_result.cpuProcess, m_result.cpuThread);
+  return true;
+}
+
+void CDVDPlaybackBenchmark::DecodeVideo(CDVDVideoCodec *codec, uint8_t *data, int size, double dts, double pts)
+{
+  int64_t decodeStart = CurrentHostCounter();
+  int state = codec->Decode(data, size, dts, pts);
+  m_processInfo->AddStageTime(CProcessInfo::STAGE_DECODE, ElapsedUsec(decodeStart));
+
+  while (!(state & VC_ERROR))
+  {
+    if (state & VC_PICTURE)
+    {
+      DVDVideoPicture picture;
+      memset(&picture, 0, sizeof(picture));
+      if (codec->GetPicture(&picture))
+      {
+        if (picture.iFlags & DVP_FLAG_DROPPED)
+          m_result.droppedFrames++;
+        else
+          OutputPicture(picture);
+      }
+      codec->ClearPicture(&picture);
+    }
+
+    if ((state & VC_BUFFER) || !(state & VC_PICTURE))
+      break;
+
+    decodeStart = CurrentHostCounter();
+    state = codec->Decode(NULL, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+    m_processInfo->AddStageTime(CProcessInfo::STAGE_DECODE, ElapsedUsec(decodeStart));
+  }
+}
+
+void CDVDPlaybackBenchmark::DecodeAudio(CDVDAudioCodec *codec, uint8_t *data, int size, double dts, double pts)
+{
+  int consumed = codec->Decode(data, size, dts, pts);
+  if (consumed < 0)
+  {
+    codec->Reset();
+    return;
+  }
+
+  // null sink, just count what was decoded
+  while (true)
+  {
+    DVDAudioFrame frame;
+    codec->GetData(frame);
+    if (frame.nb_frames == 0)
+    {
+      if (consumed >= size)
+        break;
+      int ret = codec->Decode(data + consumed, size - consumed, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+      if (ret < 0)
+      {
+        codec->Reset();
+        break;
+      }
+      consumed += ret;
+      continue;
+    }
+    m_result.audioFrames += frame.nb_frames;
+  }
+}
+
+void CDVDPlaybackBenchmark::OutputPicture(DVDVideoPicture &picture)
+{
+  m_result.videoFrames++;
+
+  if (picture.pts != DVD_NOPTS_VALUE)
+  {
+    if (m_startPts == DVD_NOPTS_VALUE)
+      m_startPts = picture.pts;
+    m_lastPts = picture.pts;
+
+    if (m_realtime)
+    {
+      // display time of the picture relative to the start of playback
+      int64_t due = (int64_t)m_start + DVD_TIME_TO_MSEC(picture.pts - m_startPts);
+      int64_t now = XbmcThreads::SystemClockMillis();
+      if (now < due)
+        Sleep((unsigned int)(due - now));
+      else if (now > due + DVD_TIME_TO_MSEC(picture.iDuration))
+      {
+        m_result.droppedFrames++;
+        return;
+      }
+    }
+  }
+
+  if (!m_softwareCopy || picture.format != RENDER_FMT_YUV420P)
+    return;
+
+  int64_t copyStart = CurrentHostCounter();
+  if (m_copy && (m_copy->iWidth < picture.iWidth || m_copy->iHeight < picture.iHeight))
+  {
+    CDVDCodecUtils::FreePicture(m_copy);
+    m_copy = NULL;
+  }
+  if (!m_copy)
+    m_copy = CDVDCodecUtils::AllocatePicture((picture.iWidth + 1) & ~1, (picture.iHeight + 1) & ~1);
+  if (m_copy)
+    CDVDCodecUtils::CopyPicture(m_copy, &picture);
+  m_processInfo->AddStageTime(CProcessInfo::STAGE_UPLOAD, ElapsedUsec(copyStart));
+}
+
+void CDVDPlaybackBenchmark::GetStats(CVariant &stats) const
+{
+  if (m_processInfo)
+    m_processInfo->GetPlaybackStats(stats);
+  else
+    stats = CVariant(CVariant::VariantTypeObject);
+
+  CVariant &result = stats["benchmark"];
+  result["realtime"] = m_realtime;
+  result["packets"] = m_result.packets;
+  result["bytes"] = m_result.bytes;
+  result["videoframes"] = m_result.videoFrames;
+  result["droppedframes"] = m_result.droppedFrames;
+  result["audioframes"] = m_result.audioFrames;
+  result["elapsed"] = m_result.elapsed;
+  result["fps"] = m_result.fps;
+  result["cpuprocess"] = m_result.cpuProcess;
+  result["cputhread"] = m_result.cpuThread;
+  result["heapgrowth"] = m_result.heapGrowth;
+}
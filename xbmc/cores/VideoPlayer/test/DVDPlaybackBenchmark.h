@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+
+class CDVDAudioCodec;
+class CDVDVideoCodec;
+class CProcessInfo;
+class CVariant;
+struct DVDVideoPicture;
+
+/*!
+ \brief Runs the demux and decode pipeline of VideoPlayer on a file without a display.
+
+ Packets are read with the demuxer VideoPlayer would use and fed to software
+ video and audio decoders. Decoded pictures are copied the way the software
+ renderer uploads them and then discarded, decoded audio is discarded as well,
+ so the figures cover demux, decode and the software YUV path only.
+
+ Playback either runs as fast as possible or paced in real time, in which case
+ pictures that are ready later than their display time count as dropped.
+ */
+class CDVDPlaybackBenchmark
+{
+public:
+  struct SResult
+  {
+    int packets;
+    int64_t bytes;
+    int videoFrames;          ///< pictures returned by the video decoder
+    int droppedFrames;        ///< pictures dropped by the decoder or, in real time mode, too late
+    int64_t audioFrames;      ///< decoded audio frames (samples per channel)
+    unsigned int elapsed;     ///< wall clock time in ms
+    double fps;               ///< decoded pictures per second of wall clock time
+    int64_t cpuProcess;       ///< CPU time of the process in ms, including decoder threads, -1 if unknown
+    int64_t cpuThread;        ///< CPU time of the benchmark thread in ms, -1 if unknown
+    int64_t heapGrowth;       ///< heap in use after the run minus heap in use before, -1 if unknown
+  };
+
+  CDVDPlaybackBenchmark();
+  ~CDVDPlaybackBenchmark();
+
+  /*! \brief Pace playback by the timestamps of the video stream instead of running as fast as possible */
+  void SetRealtime(bool realtime) { m_realtime = realtime; }
+
+  /*! \brief Stop after the given amount of media time (ms), 0 plays the whole file */
+  void SetMaxDuration(unsigned int duration) { m_maxDuration = duration; }
+
+  /*! \brief Copy decoded YUV420 pictures the way the software renderer does (default on) */
+  void SetSoftwareCopy(bool copy) { m_softwareCopy = copy; }
+
+  /*!
+   \brief Play the file at path.
+   \return false if the file couldn't be opened or has neither a video nor an audio stream
+   */
+  bool Run(const std::string &path);
+
+  const SResult& GetResult() const { return m_result; }
+
+  /*! \brief The result together with the stage timings collected during the run */
+  void GetStats(CVariant &stats) const;
+
+private:
+  CDVDPlaybackBenchmark(const CDVDPlaybackBenchmark&) = delete;
+  CDVDPlaybackBenchmark& operator=(const CDVDPlaybackBenchmark&) = delete;
+
+  void DecodeVideo(CDVDVideoCodec *codec, uint8_t *data, int size, double dts, double pts);
+  void DecodeAudio(CDVDAudioCodec *codec, uint8_t *data, int size, double dts, double pts);
+  void OutputPicture(DVDVideoPicture &picture);
+
+  bool m_realtime;
+  unsigned int m_maxDuration;
+  bool m_softwareCopy;
+
+  std::unique_ptr<CProcessInfo> m_processInfo;
+  DVDVideoPicture *m_copy;
+  SResult m_result;
+
+  unsigned int m_start;
+  double m_startPts;
+  double m_lastPts;
+};
@@ -0,0 +1,63 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDPlaybackBenchmark.h"
+#include "test/TestUtils.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <iostream>
+
+TEST(TestPlaybackBenchmark, MissingFile)
+{
+  CDVDPlaybackBenchmark benchmark;
+  EXPECT_FALSE(benchmark.Run("special://temp/nonexistent-benchmark-file.mkv"));
+  EXPECT_EQ(0, benchmark.GetResult().videoFrames);
+}
+
+/*
+ * Plays the file given in KODI_BENCHMARK_FILE and prints the collected figures as JSON.
+ * Set KODI_BENCHMARK_REALTIME=1 to pace playback at the stream rate and
+ * KODI_BENCHMARK_DURATION to the number of ms to play.
+ */
+TEST(TestPlaybackBenchmark, DISABLED_Benchmark)
+{
+  std::string file = XBMC_BENCHMARK_OPTION("KODI_BENCHMARK_FILE", "");
+  ASSERT_FALSE(file.empty()) << "KODI_BENCHMARK_FILE not set";
+
+  CDVDPlaybackBenchmark benchmark;
+  benchmark.SetRealtime(atoi(XBMC_BENCHMARK_OPTION("KODI_BENCHMARK_REALTIME", "0").c_str()) != 0);
+  std::string duration = XBMC_BENCHMARK_OPTION("KODI_BENCHMARK_DURATION", "");
+  if (!duration.empty())
+    benchmark.SetMaxDuration(atoi(duration.c_str()));
+
+  ASSERT_TRUE(benchmark.Run(file));
+
+  CVariant stats;
+  benchmark.GetStats(stats);
+  std::cout << CJSONVariantWriter::Write(stats, false) << std::endl;
+
+  const CDVDPlaybackBenchmark::SResult &result = benchmark.GetResult();
+  EXPECT_GT(result.packets, 0);
+  EXPECT_GT(result.videoFrames + result.audioFrames, 0);
+}
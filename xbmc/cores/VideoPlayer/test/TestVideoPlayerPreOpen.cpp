@@ -0,0 +1,132 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/VideoPlayer/VideoPlayerPreOpen.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemux.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDInputStream.h"
+#include "FileItem.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+#include <vector>
+
+namespace
+{
+void Append(std::vector<unsigned char> &data, unsigned int value, int bytes)
+{
+  for (int i = 0; i < bytes; i++)
+    data.push_back((value >> (8 * i)) & 0xFF);
+}
+
+// one second of 8kHz mono 16 bit silence
+std::vector<unsigned char> MakeWav()
+{
+  const unsigned int samples = 8000;
+  std::vector<unsigned char> wav = { 'R', 'I', 'F', 'F' };
+  Append(wav, 36 + samples * 2, 4);
+  wav.insert(wav.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+  Append(wav, 16, 4);
+  Append(wav, 1, 2);           // PCM
+  Append(wav, 1, 2);           // channels
+  Append(wav, 8000, 4);        // sample rate
+  Append(wav, 8000 * 2, 4);    // byte rate
+  Append(wav, 2, 2);           // block align
+  Append(wav, 16, 2);          // bits per sample
+  wav.insert(wav.end(), { 'd', 'a', 't', 'a' });
+  Append(wav, samples * 2, 4);
+  wav.resize(wav.size() + samples * 2, 0);
+  return wav;
+}
+}
+
+class TestVideoPlayerPreOpen : public testing::Test
+{
+protected:
+  TestVideoPlayerPreOpen()
+  {
+    av_register_all();
+
+    std::vector<unsigned char> wav = MakeWav();
+    m_file = XBMC_CREATETEMPFILE(".wav");
+    m_file->Write(wav.data(), wav.size());
+    m_file->Close();
+    m_item = CFileItem(XBMC_TEMPFILEPATH(m_file), false);
+  }
+
+  ~TestVideoPlayerPreOpen()
+  {
+    XBMC_DELETETEMPFILE(m_file);
+  }
+
+  XFILE::CFile *m_file;
+  CFileItem m_item;
+};
+
+TEST_F(TestVideoPlayerPreOpen, TakeOver)
+{
+  // what the player does at the end of an item: open the next one ahead, then
+  // close the current one for it, which must leave the pre-open alone
+  CVideoPlayerPreOpen preOpen(NULL);
+  preOpen.Open(m_item);
+
+  bool abort = false;
+  CDVDInputStream *input = preOpen.TakeInputStream(m_item.GetPath(), abort);
+  ASSERT_NE(nullptr, input);
+  CDVDDemux *demuxer = preOpen.TakeDemuxer(input);
+  ASSERT_NE(nullptr, demuxer);
+  // the streams were probed ahead, the player can start reading right away
+  EXPECT_EQ(1, demuxer->GetNrOfStreams());
+
+  // both are the player's now, a second take gets nothing
+  EXPECT_EQ(nullptr, preOpen.TakeDemuxer(input));
+  EXPECT_EQ(nullptr, preOpen.TakeInputStream(m_item.GetPath(), abort));
+
+  delete demuxer;
+  delete input;
+}
+
+TEST_F(TestVideoPlayerPreOpen, OtherItem)
+{
+  // the user skipped to another item, it gets opened from scratch
+  CVideoPlayerPreOpen preOpen(NULL);
+  preOpen.Open(m_item);
+
+  bool abort = false;
+  EXPECT_EQ(nullptr, preOpen.TakeInputStream(m_item.GetPath() + ".other", abort));
+  EXPECT_EQ(nullptr, preOpen.TakeInputStream(m_item.GetPath(), abort));
+}
+
+TEST_F(TestVideoPlayerPreOpen, Closed)
+{
+  // a stop drops what was opened ahead
+  CVideoPlayerPreOpen preOpen(NULL);
+  preOpen.Open(m_item);
+  preOpen.Close();
+
+  bool abort = false;
+  EXPECT_EQ(nullptr, preOpen.TakeInputStream(m_item.GetPath(), abort));
+  EXPECT_EQ(nullptr, preOpen.TakeDemuxer(NULL));
+}
@@ -36,6 +36,7 @@ CAudioDecoder::CAudioDecoder()
 
   m_status = STATUS_NO_FILE;
   m_canPlay = false;
+  m_queueSize = 0;
 
   // output buffer (for transferring data from the Pcm Buffer to the rest of the audio chain)
   memset(&m_outputBuffer, 0, OUTPUT_SAMPLES * sizeof(float));
@@ -64,7 +65,7 @@ void CAudioDecoder::Destroy()
   m_canPlay = false;
 }
 
-bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
+bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferTime)
 {
   Destroy();
 
@@ -100,8 +101,14 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
     return false;
   }
 
-  /* allocate the pcmBuffer for 2 seconds of audio */
-  m_pcmBuffer.Create(2 * blockSize * m_codec->m_format.m_sampleRate);
+  /* allocate the pcmBuffer for 2 seconds of audio plus what we may decode ahead,
+   * the latter is limited to MAX_BUFFER_SIZE for high sample rates and channel counts */
+  unsigned int queueSize = QUEUE_TIME / 1000 * blockSize * m_codec->m_format.m_sampleRate;
+  uint64_t aheadSize = (uint64_t)bufferTime * blockSize * m_codec->m_format.m_sampleRate / 1000;
+  aheadSize = std::min<uint64_t>(aheadSize, MAX_BUFFER_SIZE);
+  aheadSize -= aheadSize % blockSize;
+  m_pcmBuffer.Create(queueSize + (unsigned int)aheadSize);
+  m_queueSize = queueSize * 0.9;
 
   if (file.HasMusicInfoTag())
   {
@@ -195,6 +202,23 @@ unsigned int CAudioDecoder::GetDataSize(bool checkPktSize)
   }
 }
 
+unsigned int CAudioDecoder::GetBufferedTime()
+{
+  if (!m_codec || m_codec->m_format.m_dataFormat == AE_FMT_RAW)
+    return 0;
+
+  unsigned int blockSize = (m_codec->m_bitsPerSample >> 3) * m_codec->m_format.m_channelLayout.Count();
+  return (uint64_t)m_pcmBuffer.getMaxReadSize() * 1000 / (blockSize * m_codec->m_format.m_sampleRate);
+}
+
+bool CAudioDecoder::IsBufferFull()
+{
+  if (!m_codec || m_codec->m_format.m_dataFormat == AE_FMT_RAW)
+    return m_rawBufferSize > 0;
+
+  return m_pcmBuffer.getMaxWriteSize() < PACKET_SIZE * (m_codec->m_bitsPerSample >> 3);
+}
+
 void *CAudioDecoder::GetData(unsigned int samples)
 {
   unsigned int size  = samples * (m_codec->m_bitsPerSample >> 3);
@@ -265,7 +289,7 @@ int CAudioDecoder::ReadSamples(int numsamples)
         m_pcmBuffer.WriteData((char *)m_pcmInputBuffer, readSize);
 
         // update status
-        if (m_status == STATUS_QUEUING && m_pcmBuffer.getMaxReadSize() > m_pcmBuffer.getSize() * 0.9)
+        if (m_status == STATUS_QUEUING && m_pcmBuffer.getMaxReadSize() > m_queueSize)
         {
           CLog::Log(LOGINFO, "AudioDecoder: File is queued");
           m_status = STATUS_QUEUED;
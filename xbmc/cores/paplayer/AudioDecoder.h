@@ -37,6 +37,9 @@ class CFileItem;
 #define OUTPUT_SAMPLES PACKET_SIZE      // max number of output samples
 #define INPUT_SAMPLES  PACKET_SIZE      // number of input samples (distributed over channels)
 
+#define QUEUE_TIME 2000                 // ms of audio decoded before the file is queued
+#define MAX_BUFFER_SIZE (32 * 1024 * 1024) // max bytes of decoded audio kept ahead
+
 #define STATUS_NO_FILE  0
 #define STATUS_QUEUING  1
 #define STATUS_QUEUED   2
@@ -55,7 +58,11 @@ public:
   CAudioDecoder();
   ~CAudioDecoder();
 
-  bool Create(const CFileItem &file, int64_t seekOffset);
+  /*!
+   \brief Open the codec of a file
+   \param bufferTime ms the decoder can decode ahead on top of what is needed to queue the file
+   */
+  bool Create(const CFileItem &file, int64_t seekOffset, unsigned int bufferTime = 0);
   void Destroy();
 
   int ReadSamples(int numsamples);
@@ -72,6 +79,8 @@ public:
   unsigned int GetChannels() { return GetFormat().m_channelLayout.Count(); }
   // Data management
   unsigned int GetDataSize(bool checkPktSize);
+  unsigned int GetBufferedTime();       // ms of decoded audio waiting in the pcm buffer
+  bool IsBufferFull();
   void *GetData(unsigned int samples);
   uint8_t* GetRawData(int &size);
   ICodec *GetCodec() const { return m_codec; }
@@ -80,6 +89,7 @@ public:
 private:
   // pcm buffer
   CRingBuffer m_pcmBuffer;
+  unsigned int m_queueSize;
 
   // output buffer (for transferring data from the Pcm Buffer to the rest of the audio chain)
   float m_outputBuffer[OUTPUT_SAMPLES];
@@ -25,6 +25,7 @@
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "music/tags/MusicInfoTag.h"
+#include "threads/SystemClock.h"
 #include "utils/log.h"
 #include "utils/JobManager.h"
 
@@ -67,6 +68,7 @@ PAPlayer::PAPlayer(IPlayerCallback& callback) :
   m_isFinished         (false),
   m_defaultCrossfadeMS (0),
   m_upcomingCrossfadeMS(0),
+  m_preDecodeMS        (0),
   m_currentStream      (NULL ),
   m_audioCallback      (NULL ),
   m_FileItem           (new CFileItem()),
@@ -243,6 +245,7 @@ void PAPlayer::CloseAllStreams(bool fade/* = true */)
 bool PAPlayer::OpenFile(const CFileItem& file, const CPlayerOptions &options)
 {
   m_defaultCrossfadeMS = CSettings::GetInstance().GetInt(CSettings::SETTING_MUSICPLAYER_CROSSFADE) * 1000;
+  m_preDecodeMS = CSettings::GetInstance().GetInt(CSettings::SETTING_MUSICPLAYER_PREDECODE) * 1000;
 
   if (m_streams.size() > 1 || !m_defaultCrossfadeMS || m_isPaused)
   {
@@ -344,8 +347,13 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
     m_continueStream = false;
   }
 
+  /* a stream queued in the background can be decoded ahead, a stream played
+   * right away needs to start as quickly as possible. cd drives don't really
+   * like it to be read ahead */
+  unsigned int preDecodeMS = (job && !file.IsCDDA()) ? m_preDecodeMS.load() : 0;
+
   StreamInfo *si = new StreamInfo();
-  if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75))
+  if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75, preDecodeMS))
   {
     CLog::Log(LOGWARNING, "PAPlayer::QueueNextFileEx - Failed to create the decoder");
 
@@ -407,10 +415,7 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
   si->m_prepareNextAtFrame = 0;
   // cd drives don't really like it to be crossfaded or prepared
   if(!file.IsCDDA())
-  {
-    if (streamTotalTime >= TIME_TO_CACHE_NEXT_FILE + m_defaultCrossfadeMS)
-      si->m_prepareNextAtFrame = (int)((streamTotalTime - TIME_TO_CACHE_NEXT_FILE - m_defaultCrossfadeMS) * si->m_audioFormat.m_sampleRate / 1000.0f);
-  }
+    si->m_prepareNextAtFrame = GetPrepareNextAtFrame(si, streamTotalTime);
 
   if (m_currentStream && ((m_currentStream->m_audioFormat.m_dataFormat == AE_FMT_RAW) || (si->m_audioFormat.m_dataFormat == AE_FMT_RAW)))
   {
@@ -427,6 +432,8 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
   si->m_playNextTriggered = false;
   si->m_waitOnDrain = false;
 
+  PreDecode(si, preDecodeMS);
+
   if (!PrepareStream(si))
   {
     CLog::Log(LOGINFO, "PAPlayer::QueueNextFileEx - Error preparing stream");
@@ -466,6 +473,48 @@ void PAPlayer::UpdateStreamInfoPlayNextAtFrame(StreamInfo *si, unsigned int cros
   }
 }
 
+int PAPlayer::GetPrepareNextAtFrame(StreamInfo *si, int64_t streamTotalTime)
+{
+  if (streamTotalTime < TIME_TO_CACHE_NEXT_FILE + m_defaultCrossfadeMS)
+    return 0;
+
+  // start caching earlier by the time we decode ahead, as far as the length of the stream allows
+  int64_t time = streamTotalTime - TIME_TO_CACHE_NEXT_FILE - m_defaultCrossfadeMS - m_preDecodeMS;
+  if (time < 0)
+    time = 0;
+  return std::max(1, (int)(time * si->m_audioFormat.m_sampleRate / 1000.0f));
+}
+
+void PAPlayer::PreDecode(StreamInfo *si, unsigned int preDecodeMS)
+{
+  if (!preDecodeMS || si->m_audioFormat.m_dataFormat == AE_FMT_RAW)
+    return;
+
+  /* decode ahead while the current stream is still playing, so that a slow
+   * source or codec can't make the transition to this stream stutter */
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  while (!m_bStop &&
+         si->m_decoder.GetBufferedTime() < preDecodeMS &&
+         !si->m_decoder.IsBufferFull())
+  {
+    int status = si->m_decoder.GetStatus();
+    if (status == STATUS_ENDING ||
+        status == STATUS_ENDED  ||
+        status == STATUS_NO_FILE)
+      break;
+
+    /* errors are handled once the stream is processed */
+    int ret = si->m_decoder.ReadSamples(PACKET_SIZE);
+    if (ret == RET_ERROR)
+      break;
+    else if (ret == RET_SLEEP)
+      CThread::Sleep(1);
+  }
+
+  CLog::Log(LOGDEBUG, "PAPlayer::PreDecode - decoded %u ms ahead in %u ms",
+            si->m_decoder.GetBufferedTime(), XbmcThreads::SystemClockMillis() - start);
+}
+
 inline bool PAPlayer::PrepareStream(StreamInfo *si)
 {
   /* if we have a stream we are already prepared */
@@ -796,9 +845,7 @@ inline bool PAPlayer::ProcessStream(StreamInfo *si, double &freeBufferTime)
         streamTotalTime = si->m_endOffset - si->m_startOffset;
 
       // calculate time when to prepare next stream
-      si->m_prepareNextAtFrame = 0;
-      if (streamTotalTime >= TIME_TO_CACHE_NEXT_FILE + m_defaultCrossfadeMS)
-        si->m_prepareNextAtFrame = (int)((streamTotalTime - TIME_TO_CACHE_NEXT_FILE - m_defaultCrossfadeMS) * si->m_audioFormat.m_sampleRate / 1000.0f);
+      si->m_prepareNextAtFrame = GetPrepareNextAtFrame(si, streamTotalTime);
 
       si->m_prepareTriggered = false;
       si->m_playNextAtFrame = 0;
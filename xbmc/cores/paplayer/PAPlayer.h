@@ -133,6 +133,7 @@ private:
   bool                m_isFinished;          /* if there are no more songs in the queue */
   unsigned int        m_defaultCrossfadeMS;  /* how long the default crossfade is in ms */
   unsigned int        m_upcomingCrossfadeMS; /* how long the upcoming crossfade is in ms */
+  std::atomic_uint    m_preDecodeMS;         /* how much of the next stream to decode ahead in ms */
   CEvent              m_startEvent;          /* event for playback start */
   StreamInfo*         m_currentStream;       /* the current playing stream */
   IAudioCallback*     m_audioCallback;       /* the viz audio callback */
@@ -155,11 +156,13 @@ private:
   void CloseAllStreams(bool fade = true);
   void ProcessStreams(double &freeBufferTime);
   bool PrepareStream(StreamInfo *si);
+  void PreDecode(StreamInfo *si, unsigned int preDecodeMS);
   bool ProcessStream(StreamInfo *si, double &freeBufferTime);
   bool QueueData(StreamInfo *si);
   int64_t GetTotalTime64();
   void UpdateCrossfadeTime(const CFileItem& file);
   void UpdateStreamInfoPlayNextAtFrame(StreamInfo *si, unsigned int crossFadingTime);
+  int GetPrepareNextAtFrame(StreamInfo *si, int64_t streamTotalTime);
   void UpdateGUIData(StreamInfo *si);
   int64_t GetTimeInternal();
   void SetTimeInternal(int64_t time);
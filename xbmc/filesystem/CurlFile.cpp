@@ -194,6 +194,11 @@ size_t CCurlFile::CReadState::ReadCallback(char *buffer, size_t size, size_t nit
 size_t CCurlFile::CReadState::WriteCallback(char *buffer, size_t size, size_t nitems)
 {
   unsigned int amount = size * nitems;
+  if (m_transferData)
+  {
+    m_transferData->append(buffer, amount);
+    return amount;
+  }
 //  CLog::Log(LOGDEBUG, "CCurlFile::WriteCallback (%p) with %i bytes, readsize = %i, writesize = %i", this, amount, m_buffer.getMaxReadSize(), m_buffer.getMaxWriteSize() - m_overflowSize);
   if (m_overflowSize)
   {
@@ -265,6 +270,7 @@ CCurlFile::CReadState::CReadState()
   m_sendRange = true;
   m_bLastError = false;
   m_readBuffer = 0;
+  m_transferData = NULL;
   m_isPaused = false;
   m_bRetry = true;
   m_curlHeaderList = NULL;
@@ -1091,6 +1097,41 @@ bool CCurlFile::Open(const CURL& url)
   return true;
 }
 
+XCURL::CURL_HANDLE* CCurlFile::PrepareTransfer(const CURL& url, std::string *data)
+{
+  if (!g_curlInterface.IsLoaded())
+  {
+    CLog::Log(LOGERROR, "CCurlFile::PrepareTransfer - curl interface not loaded");
+    return NULL;
+  }
+
+  CURL url2(url);
+  ParseAndCorrectUrl(url2);
+
+  if (m_state->m_easyHandle == NULL)
+    g_curlInterface.easy_aquire(url2.GetProtocol().c_str(),
+                                url2.GetHostName().c_str(),
+                                &m_state->m_easyHandle, NULL);
+
+  SetCommonOptions(m_state);
+  SetRequestHeaders(m_state);
+  m_state->m_httpheader.Clear();
+  m_state->m_transferData = data;
+  m_httpresponse = -1;
+  return m_state->m_easyHandle;
+}
+
+long CCurlFile::FinishTransfer()
+{
+  m_state->m_transferData = NULL;
+  if (!m_state->m_easyHandle ||
+      g_curlInterface.easy_getinfo(m_state->m_easyHandle, CURLINFO_RESPONSE_CODE, &m_httpresponse) != CURLE_OK)
+    m_httpresponse = -1;
+
+  SetCorrectHeaders(m_state);
+  return m_httpresponse;
+}
+
 bool CCurlFile::OpenForWrite(const CURL& url, bool bOverWrite)
 {
   if(m_opened)
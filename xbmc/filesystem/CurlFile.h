@@ -105,6 +105,19 @@ namespace XFILE
       /* static function that will get cookies stored by CURL in RFC 2109 format */
       static bool GetCookies(const CURL &url, std::string &cookies);
 
+      /*!
+       \brief Set up a download of url into data with the options of this file, to be run on a multi handle of the caller
+       \return the easy handle, owned by this file, NULL on failure
+       \sa FinishTransfer(), CCurlTransfer
+       */
+      XCURL::CURL_HANDLE* PrepareTransfer(const CURL& url, std::string *data);
+
+      /*!
+       \brief Pick up the response of a transfer set up by PrepareTransfer(), once it was removed from the multi handle
+       \return the response code
+       */
+      long FinishTransfer();
+
       class CReadState
       {
       public:
@@ -129,6 +142,7 @@ namespace XFILE
           bool            m_bRetry;
 
           char*           m_readBuffer;
+          std::string*    m_transferData;     // downloads set up by PrepareTransfer() go here instead of the buffer
 
           /* returned http header */
           CHttpHeader m_httpheader;
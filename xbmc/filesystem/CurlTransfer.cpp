@@ -0,0 +1,406 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CurlTransfer.h"
+#include "DllLibCurl.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#include <algorithm>
+
+#ifdef TARGET_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include "linux/XTimeUtils.h"
+#endif
+
+using namespace XFILE;
+using namespace XCURL;
+
+#define MAX_WAIT 200 // ms to wait for the sockets before curl's timeouts are looked at again
+
+CCurlTransfer::CCurlTransfer()
+  : m_handle(NULL),
+    m_result(CURLE_OK),
+    m_response(-1),
+    m_running(false)
+{
+}
+
+CCurlTransfer::~CCurlTransfer()
+{
+  if (m_handle)
+    CCurlEventLoop::GetInstance().Remove(this);
+}
+
+bool CCurlTransfer::Start(const std::string &url, const std::function<void()> &done)
+{
+  m_url = url;
+  m_data.clear();
+  m_result = CURLE_FAILED_INIT;
+  m_response = -1;
+  m_handle = m_file.PrepareTransfer(CURL(url), &m_data);
+  if (!m_handle)
+    return false;
+
+  m_done = done;
+  return CCurlEventLoop::GetInstance().Add(this);
+}
+
+void CCurlTransfer::Abort()
+{
+  if (m_handle)
+    CCurlEventLoop::GetInstance().Abort(this);
+}
+
+bool CCurlTransfer::Succeeded() const
+{
+  return m_result == CURLE_OK && m_response < 400;
+}
+
+CCurlEventLoop::CCurlEventLoop()
+  : CThread("CurlEventLoop"),
+    m_multi(NULL),
+    m_calling(NULL),
+    m_started(false),
+    m_stopped(false)
+{
+#ifdef TARGET_POSIX
+  if (pipe(m_wakePipe) == 0)
+  {
+    fcntl(m_wakePipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(m_wakePipe[1], F_SETFL, O_NONBLOCK);
+  }
+  else
+    m_wakePipe[0] = m_wakePipe[1] = -1;
+#endif
+}
+
+CCurlEventLoop::~CCurlEventLoop()
+{
+  Stop();
+#ifdef TARGET_POSIX
+  if (m_wakePipe[0] >= 0)
+  {
+    close(m_wakePipe[0]);
+    close(m_wakePipe[1]);
+  }
+#endif
+}
+
+CCurlEventLoop& CCurlEventLoop::GetInstance()
+{
+  static CCurlEventLoop sLoop;
+  return sLoop;
+}
+
+bool CCurlEventLoop::Add(CCurlTransfer *transfer)
+{
+  CSingleLock lock(m_section);
+  if (transfer->m_running || m_stopped)
+    return false;
+
+  if (!m_started)
+  {
+    m_started = true;
+    Create();
+  }
+  transfer->m_running = true;
+  m_adding.push_back(transfer);
+  lock.Leave();
+
+  Wake();
+  return true;
+}
+
+void CCurlEventLoop::Abort(CCurlTransfer *transfer)
+{
+  CSingleLock lock(m_section);
+  if (!transfer->m_running)
+    return;
+
+  m_aborting.push_back(transfer);
+  lock.Leave();
+
+  Wake();
+}
+
+void CCurlEventLoop::Remove(CCurlTransfer *transfer)
+{
+  CSingleLock lock(m_section);
+  m_aborting.erase(std::remove(m_aborting.begin(), m_aborting.end(), transfer), m_aborting.end());
+
+  std::vector<CCurlTransfer*>::iterator i = std::find(m_adding.begin(), m_adding.end(), transfer);
+  if (i != m_adding.end())
+  {
+    m_adding.erase(i);
+    transfer->m_running = false;
+  }
+
+  if (IsCurrentThread())
+  {
+    // from the done function of a transfer, the loop doesn't touch this one afterwards
+    i = std::find(m_active.begin(), m_active.end(), transfer);
+    if (i != m_active.end())
+    {
+      g_curlInterface.multi_remove_handle(m_multi, transfer->m_handle);
+      m_active.erase(i);
+    }
+    for (Completed::iterator j = m_completed.begin(); j != m_completed.end(); ++j)
+    {
+      if (j->first == transfer)
+      {
+        m_completed.erase(j);
+        break;
+      }
+    }
+    transfer->m_running = false;
+    return;
+  }
+
+  if (transfer->m_running)
+  {
+    // nobody is waiting for a transfer that goes away
+    transfer->m_done = nullptr;
+    m_aborting.push_back(transfer);
+    Wake();
+  }
+
+  while (transfer->m_running || m_calling == transfer)
+    m_finished.wait(m_section);
+
+  // it may have finished before the loop got to aborting it
+  m_aborting.erase(std::remove(m_aborting.begin(), m_aborting.end(), transfer), m_aborting.end());
+}
+
+void CCurlEventLoop::Stop()
+{
+  {
+    CSingleLock lock(m_section);
+    m_stopped = true;
+  }
+  m_bStop = true;
+  Wake();
+  StopThread();
+}
+
+unsigned int CCurlEventLoop::GetTransferCount() const
+{
+  CSingleLock lock(m_section);
+  return m_adding.size() + m_active.size();
+}
+
+void CCurlEventLoop::Wake()
+{
+  m_wake.Set();
+#ifdef TARGET_POSIX
+  if (m_wakePipe[1] >= 0)
+  {
+    char c = 0;
+    if (write(m_wakePipe[1], &c, 1) < 0)
+    {
+      // full, the loop wakes up anyway
+    }
+  }
+#endif
+}
+
+void CCurlEventLoop::Finish(CCurlTransfer *transfer, int result)
+{
+  // nobody else touches a running transfer
+  transfer->m_result = result;
+  transfer->m_response = transfer->m_file.FinishTransfer();
+  if (result != CURLE_OK && result != CURLE_ABORTED_BY_CALLBACK)
+    CLog::Log(LOGDEBUG, "CCurlEventLoop::%s - %s failed: %s(%d)", __FUNCTION__,
+              CURL::GetRedacted(transfer->m_url).c_str(), g_curlInterface.easy_strerror((CURLcode)result), result);
+
+  CSingleLock lock(m_section);
+  std::function<void()> done(transfer->m_done);
+  transfer->m_running = false;
+  m_calling = done ? transfer : NULL;
+  lock.Leave();
+
+  if (done)
+    done();
+
+  lock.Enter();
+  m_calling = NULL;
+  m_finished.notifyAll();
+}
+
+void CCurlEventLoop::FinishCompleted()
+{
+  while (true)
+  {
+    // a done function may remove the others
+    CSingleLock lock(m_section);
+    if (m_completed.empty())
+      return;
+    std::pair<CCurlTransfer*, int> completed = m_completed.front();
+    m_completed.erase(m_completed.begin());
+    lock.Leave();
+
+    Finish(completed.first, completed.second);
+  }
+}
+
+void CCurlEventLoop::WaitForSockets()
+{
+  fd_set fdread;
+  fd_set fdwrite;
+  fd_set fdexcep;
+  FD_ZERO(&fdread);
+  FD_ZERO(&fdwrite);
+  FD_ZERO(&fdexcep);
+
+  int maxfd = -1;
+  g_curlInterface.multi_fdset(m_multi, &fdread, &fdwrite, &fdexcep, &maxfd);
+
+  long timeout = -1;
+  if (g_curlInterface.multi_timeout(m_multi, &timeout) != CURLM_OK || timeout < 0 || timeout > MAX_WAIT)
+    timeout = MAX_WAIT;
+  if (timeout == 0)
+    return;
+
+#ifdef TARGET_POSIX
+  if (m_wakePipe[0] >= 0)
+  {
+    FD_SET(m_wakePipe[0], &fdread);
+    maxfd = std::max(maxfd, m_wakePipe[0]);
+  }
+#else
+  // nothing interrupts select() for new transfers, don't let them wait long
+  timeout = std::min(timeout, 20L);
+  if (maxfd == -1)
+  {
+    Sleep(timeout);
+    return;
+  }
+#endif
+
+  struct timeval wait = { (int)timeout / 1000, ((int)timeout % 1000) * 1000 };
+  int rc = select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &wait);
+
+#ifdef TARGET_POSIX
+  if (rc > 0 && m_wakePipe[0] >= 0 && FD_ISSET(m_wakePipe[0], &fdread))
+  {
+    char buffer[64];
+    while (read(m_wakePipe[0], buffer, sizeof(buffer)) > 0)
+      ;
+  }
+#endif
+}
+
+void CCurlEventLoop::Process()
+{
+  g_curlInterface.Load();
+  m_multi = g_curlInterface.multi_init();
+  CLog::Log(LOGDEBUG, "CCurlEventLoop::%s - started", __FUNCTION__);
+
+  while (!m_bStop)
+  {
+    {
+      CSingleLock lock(m_section);
+      for (auto transfer : m_adding)
+      {
+        if (g_curlInterface.multi_add_handle(m_multi, transfer->m_handle) == CURLM_OK)
+          m_active.push_back(transfer);
+        else
+          m_completed.push_back(std::make_pair(transfer, (int)CURLE_FAILED_INIT));
+      }
+      m_adding.clear();
+
+      for (auto transfer : m_aborting)
+      {
+        std::vector<CCurlTransfer*>::iterator i = std::find(m_active.begin(), m_active.end(), transfer);
+        if (i != m_active.end())
+        {
+          g_curlInterface.multi_remove_handle(m_multi, transfer->m_handle);
+          m_active.erase(i);
+          m_completed.push_back(std::make_pair(transfer, (int)CURLE_ABORTED_BY_CALLBACK));
+        }
+      }
+      m_aborting.clear();
+
+      if (m_active.empty() && m_completed.empty())
+      {
+        lock.Leave();
+        m_wake.Wait();
+        continue;
+      }
+    }
+
+    FinishCompleted();
+
+    int running = 0;
+    while (g_curlInterface.multi_perform(m_multi, &running) == CURLM_CALL_MULTI_PERFORM)
+      ;
+
+    int msgs;
+    CURLMsg *msg;
+    while ((msg = g_curlInterface.multi_info_read(m_multi, &msgs)))
+    {
+      if (msg->msg != CURLMSG_DONE)
+        continue;
+
+      // the message is gone once the handle is removed
+      CURL_HANDLE *handle = msg->easy_handle;
+      int result = msg->data.result;
+      g_curlInterface.multi_remove_handle(m_multi, handle);
+
+      CSingleLock lock(m_section);
+      for (std::vector<CCurlTransfer*>::iterator i = m_active.begin(); i != m_active.end(); ++i)
+      {
+        if ((*i)->m_handle == handle)
+        {
+          m_completed.push_back(std::make_pair(*i, result));
+          m_active.erase(i);
+          break;
+        }
+      }
+    }
+
+    FinishCompleted();
+
+    if (!m_active.empty())
+      WaitForSockets();
+  }
+
+  // abort what is left, the jobs waiting for these are woken to finish or to be freed if cancelled
+  {
+    CSingleLock lock(m_section);
+    for (auto transfer : m_active)
+    {
+      g_curlInterface.multi_remove_handle(m_multi, transfer->m_handle);
+      m_completed.push_back(std::make_pair(transfer, (int)CURLE_ABORTED_BY_CALLBACK));
+    }
+    for (auto transfer : m_adding)
+      m_completed.push_back(std::make_pair(transfer, (int)CURLE_ABORTED_BY_CALLBACK));
+    m_active.clear();
+    m_adding.clear();
+    m_aborting.clear();
+  }
+  FinishCompleted();
+
+  g_curlInterface.multi_cleanup(m_multi);
+  m_multi = NULL;
+  g_curlInterface.Unload();
+}
@@ -0,0 +1,151 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CurlFile.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace XFILE
+{
+  class CCurlEventLoop;
+
+  /*!
+   \brief A download into memory that doesn't need a thread of its own.
+
+   The transfer is run by the CCurlEventLoop together with all others, the
+   done function is called on the loop's thread once it's finished. Async
+   jobs use it to wait for a download without blocking a worker:
+
+   \code
+   m_transfer.Start(url, [this]{ Wake(); });
+   return SUSPENDED;
+   \endcode
+
+   \sa CAsyncJob
+   */
+  class CCurlTransfer
+  {
+  public:
+    CCurlTransfer();
+    ~CCurlTransfer();
+
+    /*!
+     \brief The file the options of the transfer are taken from, e.g. the user agent or request headers
+     */
+    CCurlFile& GetFile() { return m_file; }
+
+    /*!
+     \brief Start downloading.
+     \param url what to download
+     \param done called on the loop's thread once the transfer succeeded, failed or was aborted
+     \return false if the transfer couldn't be started, done isn't called then
+     */
+    bool Start(const std::string &url, const std::function<void()> &done);
+
+    /*!
+     \brief Stop the transfer early, done is still called. Doesn't wait.
+     */
+    void Abort();
+
+    bool Succeeded() const;
+    long GetResponseCode() const { return m_response; }
+    const std::string& GetData() const { return m_data; }
+    const CHttpHeader& GetHttpHeader() const { return m_file.GetHttpHeader(); }
+
+  private:
+    friend class CCurlEventLoop;
+
+    CCurlFile             m_file;
+    std::string           m_url;
+    std::string           m_data;
+    std::function<void()> m_done;
+    XCURL::CURL_HANDLE*   m_handle;
+    int                   m_result;   // CURLcode
+    long                  m_response;
+    bool                  m_running;  // guarded by the loop's section
+  };
+
+  /*!
+   \brief Thread running all CCurlTransfer on a single curl multi handle.
+
+   Started with the first transfer, it waits for the sockets of all transfers at
+   once and finishes them as they complete.
+   */
+  class CCurlEventLoop : protected CThread
+  {
+  public:
+    static CCurlEventLoop& GetInstance();
+
+    bool Add(CCurlTransfer *transfer);
+    void Abort(CCurlTransfer *transfer);
+
+    /*!
+     \brief Stop the transfer, once this returns the loop doesn't use it anymore.
+     */
+    void Remove(CCurlTransfer *transfer);
+
+    unsigned int GetTransferCount() const;
+
+    /*!
+     \brief Abort all transfers and stop the thread, no transfers can be started afterwards.
+     The done functions of the transfers still running are called before this returns.
+     */
+    void Stop();
+
+  protected:
+    void Process() override;
+
+  private:
+    CCurlEventLoop();
+    ~CCurlEventLoop() override;
+    CCurlEventLoop(const CCurlEventLoop&) = delete;
+    CCurlEventLoop& operator=(const CCurlEventLoop&) = delete;
+
+    void Wake();
+    void WaitForSockets();
+    void FinishCompleted();
+    void Finish(CCurlTransfer *transfer, int result);
+
+    typedef std::vector<std::pair<CCurlTransfer*, int>> Completed;
+
+    XCURL::CURLM*               m_multi;
+    std::vector<CCurlTransfer*> m_adding;
+    std::vector<CCurlTransfer*> m_aborting;
+    std::vector<CCurlTransfer*> m_active;    // on the multi handle, only changed by the loop's thread
+    Completed                   m_completed; // off the multi handle with their result, to be finished
+    CCurlTransfer*              m_calling;   // the transfer whose done function is running
+    bool                        m_started;   // the thread keeps running once it was started
+    bool                        m_stopped;   // no more transfers are taken
+    CEvent                      m_wake;
+#ifdef TARGET_POSIX
+    int                         m_wakePipe[2]; // interrupts waiting for the sockets
+#endif
+    mutable CCriticalSection    m_section;
+    XbmcThreads::ConditionVariable m_finished;
+  };
+}
@@ -0,0 +1,262 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/CurlTransfer.h"
+#include "utils/AsyncJob.h"
+#include "utils/JobManager.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifdef TARGET_POSIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+// answers every request on the loopback with the same body, once it is allowed to
+class CTestHttpServer
+{
+public:
+  explicit CTestHttpServer(const std::string &body) :
+    m_body(body),
+    m_port(0),
+    m_respond(true),
+    m_stop(false)
+  {
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(m_socket, (sockaddr*)&addr, sizeof(addr)) == 0 &&
+        listen(m_socket, 8) == 0 &&
+        getsockname(m_socket, (sockaddr*)&addr, &len) == 0)
+      m_port = ntohs(addr.sin_port);
+    m_thread = std::thread(&CTestHttpServer::Run, this);
+  }
+
+  ~CTestHttpServer()
+  {
+    m_stop = true;
+    shutdown(m_socket, SHUT_RDWR);
+    m_thread.join();
+    close(m_socket);
+  }
+
+  std::string GetURL(const std::string &file) const
+  {
+    return StringUtils::Format("http://127.0.0.1:%d/%s", m_port, file.c_str());
+  }
+
+  void SetRespond(bool respond) { m_respond = respond; }
+
+private:
+  void Run()
+  {
+    while (!m_stop)
+    {
+      int client = accept(m_socket, NULL, NULL);
+      if (client < 0)
+        break;
+
+      std::string request;
+      char buffer[1024];
+      while (request.find("\r\n\r\n") == std::string::npos)
+      {
+        ssize_t bytes = recv(client, buffer, sizeof(buffer), 0);
+        if (bytes <= 0)
+          break;
+        request.append(buffer, bytes);
+      }
+
+      while (!m_respond && !m_stop)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+      std::string response = StringUtils::Format("HTTP/1.1 200 OK\r\n"
+                                                 "Content-Type: text/plain\r\n"
+                                                 "Content-Length: %u\r\n"
+                                                 "Connection: close\r\n\r\n", (unsigned int)m_body.size());
+      response += m_body;
+      send(client, response.c_str(), response.size(), MSG_NOSIGNAL);
+      close(client);
+    }
+  }
+
+  std::string m_body;
+  int m_socket;
+  int m_port;
+  std::atomic<bool> m_respond;
+  std::atomic<bool> m_stop;
+  std::thread m_thread;
+};
+
+class CDownloadJob : public CAsyncJob
+{
+public:
+  CDownloadJob(const std::string &url, std::atomic<int> &freed) :
+    m_url(url),
+    m_started(false),
+    m_freed(freed)
+  {
+  }
+
+  ~CDownloadJob() override
+  {
+    m_freed++;
+  }
+
+  const char *GetType() const override
+  {
+    return "DownloadJob";
+  }
+
+  STATUS Resume() override
+  {
+    if (!m_started)
+    {
+      m_started = true;
+      if (!m_transfer.Start(m_url, [this]{ Wake(); }))
+        return FAILED;
+      return SUSPENDED;
+    }
+    return m_transfer.Succeeded() ? SUCCEEDED : FAILED;
+  }
+
+  void Abort() override
+  {
+    m_transfer.Abort();
+  }
+
+  XFILE::CCurlTransfer m_transfer;
+
+private:
+  std::string m_url;
+  bool m_started;
+  std::atomic<int> &m_freed;
+};
+
+class CDownloadCallback : public IJobCallback
+{
+public:
+  CDownloadCallback() :
+    m_done(false),
+    m_success(false),
+    m_response(-1)
+  {
+  }
+
+  void OnJobComplete(unsigned int jobID, bool success, CJob *job) override
+  {
+    CDownloadJob *download = static_cast<CDownloadJob*>(job);
+    m_data = download->m_transfer.GetData();
+    m_response = download->m_transfer.GetResponseCode();
+    m_success = success;
+    m_done = true;
+  }
+
+  std::atomic<bool> m_done;
+  bool m_success;
+  long m_response;
+  std::string m_data;
+};
+
+bool WaitFor(const std::function<bool()> &condition)
+{
+  for (int i = 0; i < 1000 && !condition(); i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return condition();
+}
+
+unsigned int GetSuspendedJobs()
+{
+  CVariant stats;
+  CJobManager::GetInstance().GetStats(stats);
+  return (unsigned int)stats["suspended"].asUnsignedInteger();
+}
+}
+
+class TestCurlTransfer : public testing::Test
+{
+protected:
+  ~TestCurlTransfer()
+  {
+    /* Always cancel jobs test completion */
+    CJobManager::GetInstance().CancelJobs();
+    CJobManager::GetInstance().Restart();
+  }
+};
+
+TEST_F(TestCurlTransfer, DownloadInJob)
+{
+  CTestHttpServer server("hello world");
+  CDownloadCallback callback;
+  std::atomic<int> freed(0);
+  CJobManager::GetInstance().AddJob(new CDownloadJob(server.GetURL("file.txt"), freed), &callback);
+
+  ASSERT_TRUE(WaitFor([&]{ return callback.m_done.load(); }));
+  EXPECT_TRUE(callback.m_success);
+  EXPECT_EQ(200, callback.m_response);
+  EXPECT_EQ("hello world", callback.m_data);
+  EXPECT_TRUE(WaitFor([&]{ return freed == 1; }));
+}
+
+TEST_F(TestCurlTransfer, JobSuspendedWhileWaiting)
+{
+  CTestHttpServer server("slow");
+  server.SetRespond(false);
+  CDownloadCallback callback;
+  std::atomic<int> freed(0);
+  CJobManager::GetInstance().AddJob(new CDownloadJob(server.GetURL("file.txt"), freed), &callback);
+
+  // the job gives its worker back while the server takes its time
+  EXPECT_TRUE(WaitFor([]{ return GetSuspendedJobs() == 1; }));
+  EXPECT_FALSE(callback.m_done);
+
+  server.SetRespond(true);
+  ASSERT_TRUE(WaitFor([&]{ return callback.m_done.load(); }));
+  EXPECT_TRUE(callback.m_success);
+  EXPECT_EQ("slow", callback.m_data);
+  EXPECT_TRUE(WaitFor([]{ return GetSuspendedJobs() == 0; }));
+}
+
+TEST_F(TestCurlTransfer, CancelWhileWaiting)
+{
+  CTestHttpServer server("never");
+  server.SetRespond(false);
+  CDownloadCallback callback;
+  std::atomic<int> freed(0);
+  unsigned int id = CJobManager::GetInstance().AddJob(new CDownloadJob(server.GetURL("file.txt"), freed), &callback);
+  ASSERT_TRUE(WaitFor([]{ return GetSuspendedJobs() == 1; }));
+
+  // the transfer is aborted and the job freed without its callback
+  CJobManager::GetInstance().CancelJob(id);
+  EXPECT_TRUE(WaitFor([&]{ return freed == 1; }));
+  EXPECT_EQ(0U, GetSuspendedJobs());
+  EXPECT_FALSE(callback.m_done);
+}
+#endif
@@ -23,6 +23,9 @@
 #include "XBTF.h"
 #include "utils/log.h"
 #include <string.h>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 
 #ifndef NO_XBMC_FILESYSTEM
 #include "filesystem/File.h"
@@ -31,6 +34,164 @@ using namespace XFILE;
 #include "SimpleFS.h"
 #endif
 
+namespace
+{
+// DXT blocks are 4x4 pixels, in the XB_FMT_A8R8G8B8 byte order
+uint16_t To565(int r, int g, int b)
+{
+  return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+}
+
+void From565(uint16_t color, int *rgb)
+{
+  rgb[0] = ((color >> 11) & 31) * 255 / 31;
+  rgb[1] = ((color >> 5) & 63) * 255 / 63;
+  rgb[2] = (color & 31) * 255 / 31;
+}
+
+void CompressColorBlock(const unsigned char *block, unsigned char *dest)
+{
+  // the end points are the extremes along the principal axis of the colors
+  float mean[3] = { 0, 0, 0 };
+  for (int i = 0; i < 16; i++)
+  {
+    mean[0] += block[i * 4 + 2];
+    mean[1] += block[i * 4 + 1];
+    mean[2] += block[i * 4];
+  }
+  for (int c = 0; c < 3; c++)
+    mean[c] /= 16;
+
+  float cov[6] = { 0, 0, 0, 0, 0, 0 };
+  for (int i = 0; i < 16; i++)
+  {
+    float r = block[i * 4 + 2] - mean[0];
+    float g = block[i * 4 + 1] - mean[1];
+    float b = block[i * 4] - mean[2];
+    cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+    cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+  }
+
+  float axis[3] = { 1, 1, 1 };
+  for (int iter = 0; iter < 4; iter++)
+  {
+    float r = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+    float g = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+    float b = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+    float length = std::max(std::max(fabsf(r), fabsf(g)), fabsf(b));
+    if (length < 1e-6f)
+      break;
+    axis[0] = r / length; axis[1] = g / length; axis[2] = b / length;
+  }
+
+  int minIndex = 0, maxIndex = 0;
+  float minDot = 1e30f, maxDot = -1e30f;
+  for (int i = 0; i < 16; i++)
+  {
+    float dot = block[i * 4 + 2] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4] * axis[2];
+    if (dot < minDot)
+    {
+      minDot = dot;
+      minIndex = i;
+    }
+    if (dot > maxDot)
+    {
+      maxDot = dot;
+      maxIndex = i;
+    }
+  }
+
+  const unsigned char *maxColor = block + maxIndex * 4;
+  const unsigned char *minColor = block + minIndex * 4;
+  uint16_t color0 = To565(maxColor[2], maxColor[1], maxColor[0]);
+  uint16_t color1 = To565(minColor[2], minColor[1], minColor[0]);
+  // color0 > color1 selects the four color mode, which DXT1 needs to be opaque
+  if (color0 < color1)
+    std::swap(color0, color1);
+
+  uint32_t indices = 0;
+  if (color0 != color1)
+  {
+    int palette[4][3];
+    From565(color0, palette[0]);
+    From565(color1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+      int best = 0;
+      int bestError = INT_MAX;
+      for (int j = 0; j < 4; j++)
+      {
+        int r = block[i * 4 + 2] - palette[j][0];
+        int g = block[i * 4 + 1] - palette[j][1];
+        int b = block[i * 4] - palette[j][2];
+        int error = r * r + g * g + b * b;
+        if (error < bestError)
+        {
+          bestError = error;
+          best = j;
+        }
+      }
+      indices |= best << (i * 2);
+    }
+  }
+
+  dest[0] = color0 & 0xff;
+  dest[1] = color0 >> 8;
+  dest[2] = color1 & 0xff;
+  dest[3] = color1 >> 8;
+  for (int i = 0; i < 4; i++)
+    dest[4 + i] = (indices >> (i * 8)) & 0xff;
+}
+
+void CompressAlphaBlock(const unsigned char *block, unsigned char *dest)
+{
+  int alpha0 = 0, alpha1 = 255;
+  for (int i = 0; i < 16; i++)
+  {
+    alpha0 = std::max(alpha0, (int)block[i * 4 + 3]);
+    alpha1 = std::min(alpha1, (int)block[i * 4 + 3]);
+  }
+
+  // alpha0 > alpha1 selects eight interpolated values
+  uint64_t indices = 0;
+  if (alpha0 != alpha1)
+  {
+    int palette[8];
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    for (int j = 1; j < 7; j++)
+      palette[j + 1] = ((7 - j) * alpha0 + j * alpha1) / 7;
+
+    for (int i = 0; i < 16; i++)
+    {
+      int best = 0;
+      int bestError = INT_MAX;
+      for (int j = 0; j < 8; j++)
+      {
+        int error = abs(block[i * 4 + 3] - palette[j]);
+        if (error < bestError)
+        {
+          bestError = error;
+          best = j;
+        }
+      }
+      indices |= (uint64_t)best << (i * 3);
+    }
+  }
+
+  dest[0] = alpha0;
+  dest[1] = alpha1;
+  for (int i = 0; i < 6; i++)
+    dest[2 + i] = (indices >> (i * 8)) & 0xff;
+}
+}
+
 CDDSImage::CDDSImage()
 {
   m_data = NULL;
@@ -115,6 +276,61 @@ bool CDDSImage::ReadFile(const std::string &inputFile)
   return true;
 }
 
+bool CDDSImage::Create(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *bgra, bool alpha)
+{
+  if (!width || !height || !bgra)
+    return false;
+
+  Allocate(width, height, alpha ? XB_FMT_DXT5 : XB_FMT_DXT1);
+
+  unsigned char *dest = m_data;
+  unsigned char block[16 * 4];
+  for (unsigned int y = 0; y < height; y += 4)
+  {
+    for (unsigned int x = 0; x < width; x += 4)
+    {
+      // the edge pixels are repeated into blocks that stick out of the image
+      for (unsigned int by = 0; by < 4; by++)
+      {
+        const unsigned char *src = bgra + std::min(y + by, height - 1) * pitch;
+        for (unsigned int bx = 0; bx < 4; bx++)
+          memcpy(block + (by * 4 + bx) * 4, src + std::min(x + bx, width - 1) * 4, 4);
+      }
+      if (alpha)
+      {
+        CompressAlphaBlock(block, dest);
+        dest += 8;
+      }
+      CompressColorBlock(block, dest);
+      dest += 8;
+    }
+  }
+  return true;
+}
+
+bool CDDSImage::WriteFile(const std::string &outputFile) const
+{
+  if (!m_data)
+    return false;
+
+  // open the file
+  CFile file;
+  if (!file.OpenForWrite(outputFile, true))
+    return false;
+
+  // write the header
+  if (file.Write("DDS ", 4) != 4 ||
+      file.Write(&m_desc, sizeof(m_desc)) != sizeof(m_desc))
+    return false;
+
+  // and the data
+  if (file.Write(m_data, m_desc.linearSize) != m_desc.linearSize)
+    return false;
+
+  file.Close();
+  return true;
+}
+
 unsigned int CDDSImage::GetStorageRequirements(unsigned int width, unsigned int height, unsigned int format)
 {
   switch (format)
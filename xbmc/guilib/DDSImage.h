@@ -38,6 +38,13 @@ public:
 
   bool ReadFile(const std::string &file);
 
+  /*! \brief Compress an image to DXT1, or to DXT5 if it has an alpha channel
+   \param pitch bytes per row of pixels
+   \param bgra pixels in the XB_FMT_A8R8G8B8 byte order
+   */
+  bool Create(unsigned int width, unsigned int height, unsigned int pitch, unsigned char const *bgra, bool alpha);
+  bool WriteFile(const std::string &file) const;
+
 private:
   void Allocate(unsigned int width, unsigned int height, unsigned int format);
   static const char *GetFourCC(unsigned int format);
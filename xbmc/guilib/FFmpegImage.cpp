@@ -24,6 +24,7 @@
 #include "guilib/Texture.h"
 
 #include <algorithm>
+#include <cstring>
 
 extern "C"
 {
@@ -165,7 +166,15 @@ CFFmpegImage::~CFFmpegImage()
 bool CFFmpegImage::LoadImageFromMemory(unsigned char* buffer, unsigned int bufSize,
                                       unsigned int width, unsigned int height)
 {
-    
+  // the jpeg decoder can skip most of the work for images far larger than needed
+  unsigned int jpegWidth, jpegHeight, orientation;
+  if (ReadJpegHeader(buffer, bufSize, jpegWidth, jpegHeight, orientation))
+  {
+    m_lowres = GetLowres(jpegWidth, jpegHeight, orientation, width, height);
+    m_originalWidth = jpegWidth;
+    m_originalHeight = jpegHeight;
+  }
+
   if (!Initialize(buffer, bufSize))
   {
     //log
@@ -257,12 +266,15 @@ bool CFFmpegImage::Initialize(unsigned char* buffer, unsigned int bufSize)
   }
   AVCodecContext* codec_ctx = m_fctx->streams[0]->codec;
   AVCodec* codec = avcodec_find_decoder(codec_ctx->codec_id);
+  if (codec && codec_ctx->codec_id == AV_CODEC_ID_MJPEG)
+    codec_ctx->lowres = std::min(m_lowres, av_codec_get_max_lowres(codec));
   if (avcodec_open2(codec_ctx, codec, NULL) < 0)
   {
     avformat_close_input(&m_fctx);
     FreeIOCtx(&m_ioctx);
     return false;
   }
+  m_lowres = codec_ctx->lowres;
 
   return true;
 }
@@ -293,8 +305,12 @@ AVFrame* CFFmpegImage::ExtractFrame()
       av_frame_set_pkt_duration(frame, av_rescale_q(frame->pkt_duration, m_fctx->streams[0]->time_base, AVRational{ 1, 1000 }));
       m_height = frame->height;
       m_width = frame->width;
-      m_originalWidth = m_width;
-      m_originalHeight = m_height;
+      // a downscaled jpeg keeps the size from its header
+      if (!m_lowres)
+      {
+        m_originalWidth = m_width;
+        m_originalHeight = m_height;
+      }
 
       const AVPixFmtDescriptor* pixDescriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
       if (pixDescriptor && ((pixDescriptor->flags & (AV_PIX_FMT_FLAG_ALPHA | AV_PIX_FMT_FLAG_PAL)) != 0))
@@ -358,6 +374,94 @@ AVPixelFormat CFFmpegImage::ConvertFormats(AVFrame* frame)
   }
 }
 
+bool CFFmpegImage::ReadJpegHeader(const unsigned char* buffer, unsigned int bufSize,
+                                  unsigned int &width, unsigned int &height, unsigned int &orientation)
+{
+  orientation = 0;
+  if (bufSize < 4 || buffer[0] != 0xFF || buffer[1] != 0xD8)
+    return false;
+
+  unsigned int pos = 2;
+  while (pos + 4 <= bufSize)
+  {
+    if (buffer[pos] != 0xFF)
+      return false;
+    unsigned char marker = buffer[pos + 1];
+    if (marker == 0xFF)
+    { // fill byte
+      pos++;
+      continue;
+    }
+    if (marker == 0xD9 || marker == 0xDA) // end of image or start of scan before the frame header
+      return false;
+
+    unsigned int length = (buffer[pos + 2] << 8) | buffer[pos + 3];
+    if (length < 2)
+      return false;
+
+    // SOF0 - SOF15, except DHT, JPG and DAC which share the range
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+    {
+      if (pos + 9 > bufSize)
+        return false;
+      height = (buffer[pos + 5] << 8) | buffer[pos + 6];
+      width = (buffer[pos + 7] << 8) | buffer[pos + 8];
+      return width > 0 && height > 0;
+    }
+
+    // APP1 with the EXIF orientation, TIFF layout in either byte order
+    const unsigned char *tiff = buffer + pos + 10;
+    unsigned int tiffSize = length - 8;
+    if (marker == 0xE1 && length >= 16 && pos + 2 + length <= bufSize && memcmp(buffer + pos + 4, "Exif\0\0", 6) == 0 &&
+        (tiff[0] == 'I' || tiff[0] == 'M') && tiff[0] == tiff[1])
+    {
+      bool intel = tiff[0] == 'I';
+      auto read16 = [&](unsigned int offset) -> unsigned int
+      {
+        return intel ? tiff[offset] | (tiff[offset + 1] << 8) : (tiff[offset] << 8) | tiff[offset + 1];
+      };
+      unsigned int ifd = intel ? read16(4) | (read16(6) << 16) : (read16(4) << 16) | read16(6);
+      if (ifd < tiffSize && tiffSize - ifd >= 2)
+      {
+        unsigned int entries = read16(ifd);
+        for (unsigned int i = 0; i < entries && ifd + 2 + (i + 1) * 12 <= tiffSize; i++)
+        {
+          unsigned int entry = ifd + 2 + i * 12;
+          if (read16(entry) == 0x0112)
+          {
+            orientation = read16(entry + 8);
+            break;
+          }
+        }
+      }
+    }
+    pos += 2 + length;
+  }
+  return false;
+}
+
+int CFFmpegImage::GetLowres(unsigned int width, unsigned int height, unsigned int orientation,
+                            unsigned int maxWidth, unsigned int maxHeight)
+{
+  if (!maxWidth || !maxHeight)
+    return 0;
+
+  // the maximum is of the image as shown, the decoder works on it as stored
+  if (orientation >= 5)
+    std::swap(maxWidth, maxHeight);
+
+  // the size Decode() scales it to
+  float scale = std::min(std::min(maxWidth / (float)width, maxHeight / (float)height), 1.0f);
+  unsigned int scaledWidth = (unsigned int)(width * scale + 0.5f);
+  unsigned int scaledHeight = (unsigned int)(height * scale + 0.5f);
+
+  // 1/2, 1/4 or 1/8 as long as it is at least as large
+  int lowres = 0;
+  while (lowres < 3 && (width >> (lowres + 1)) >= scaledWidth && (height >> (lowres + 1)) >= scaledHeight)
+    lowres++;
+  return lowres;
+}
+
 void CFFmpegImage::FreeIOCtx(AVIOContext** ioctx)
 {
   av_freep(&((*ioctx)->buffer));
@@ -440,9 +544,9 @@ bool CFFmpegImage::DecodeFrame(AVFrame* frame, unsigned int width, unsigned int
   AVPixelFormat pixFormat = ConvertFormats(frame);
 
   // assumption quadratic maximums e.g. 2048x2048
-  float ratio = m_width / (float)m_height;
-  unsigned int nHeight = m_originalHeight;
-  unsigned int nWidth = m_originalWidth;
+  float ratio = frame->width / (float)frame->height;
+  unsigned int nHeight = frame->height;
+  unsigned int nWidth = frame->width;
   if (nHeight > height)
   {
     nHeight = height;
@@ -454,7 +558,7 @@ bool CFFmpegImage::DecodeFrame(AVFrame* frame, unsigned int width, unsigned int
     nHeight = (unsigned int)(nWidth / ratio + 0.5f);
   }
 
-  struct SwsContext* context = sws_getContext(m_originalWidth, m_originalHeight, pixFormat,
+  struct SwsContext* context = sws_getContext(frame->width, frame->height, pixFormat,
     nWidth, nHeight, AV_PIX_FMT_RGB32, SWS_BICUBIC, NULL, NULL, NULL);
 
   if (range == AVCOL_RANGE_JPEG)
@@ -467,7 +571,7 @@ bool CFFmpegImage::DecodeFrame(AVFrame* frame, unsigned int width, unsigned int
     sws_setColorspaceDetails(context, inv_table, srcRange, table, dstRange, brightness, contrast, saturation);
   }
 
-  sws_scale(context, frame->data, frame->linesize, 0, m_originalHeight,
+  sws_scale(context, frame->data, frame->linesize, 0, frame->height,
     pictureRGB->data, pictureRGB->linesize);
   sws_freeContext(context);
 
@@ -64,6 +64,8 @@ struct AVFormatContext;
 
 class CFFmpegImage : public IImage
 {
+  friend class TestFFmpegImageHelper;
+
 public:
   explicit CFFmpegImage(const std::string& strMimeType);
   virtual ~CFFmpegImage();
@@ -88,6 +90,10 @@ private:
   AVFrame* ExtractFrame();
   bool DecodeFrame(AVFrame* m_pFrame, unsigned int width, unsigned int height, unsigned int pitch, unsigned char * const pixels);
   static AVPixelFormat ConvertFormats(AVFrame* frame);
+  static bool ReadJpegHeader(const unsigned char* buffer, unsigned int bufSize,
+                             unsigned int &width, unsigned int &height, unsigned int &orientation);
+  static int GetLowres(unsigned int width, unsigned int height, unsigned int orientation,
+                       unsigned int maxWidth, unsigned int maxHeight);
   std::string m_strMimeType;
   void CleanupLocalOutputBuffer();
 
@@ -100,4 +106,5 @@ private:
 
   AVFrame* m_pFrame;
   uint8_t* m_outputBuffer;
+  int m_lowres = 0; ///< jpegs are decoded at 1/2^m_lowres of their size
 };
@@ -33,6 +33,8 @@
 #include "settings/Settings.h"
 #include "guiinfo/GUIInfoLabels.h"
 
+#include <algorithm>
+
 #define HOLD_TIME_START 100
 #define HOLD_TIME_END   3000
 #define SCROLLING_GAP   200U
@@ -156,13 +158,12 @@ void CGUIBaseContainer::ProcessItem(float posX, float posY, CGUIListItemPtr& ite
 
   if (m_bInvalidated)
     item->SetInvalid();
+  // track every item we process, so its layouts can be given back once it leaves the view
+  m_layoutItems.insert(item);
   if (focused)
   {
     if (!item->GetFocusedLayout())
-    {
-      CGUIListItemLayout *layout = new CGUIListItemLayout(*m_focusedLayout);
-      item->SetFocusedLayout(layout);
-    }
+      item->SetFocusedLayout(m_focusedLayoutPool.Get(*m_focusedLayout));
     if (item->GetFocusedLayout())
     {
       if (item != m_lastItem || !HasFocus())
@@ -186,10 +187,7 @@ void CGUIBaseContainer::ProcessItem(float posX, float posY, CGUIListItemPtr& ite
     if (item->GetFocusedLayout())
       item->GetFocusedLayout()->SetFocusedItem(0);  // focus is not set
     if (!item->GetLayout())
-    {
-      CGUIListItemLayout *layout = new CGUIListItemLayout(*m_layout);
-      item->SetLayout(layout);
-    }
+      item->SetLayout(m_layoutPool.Get(*m_layout));
     if (item->GetFocusedLayout())
       item->GetFocusedLayout()->Process(item.get(), m_parentID, currentTime, dirtyregions);
     if (item->GetLayout())
@@ -859,6 +857,9 @@ void CGUIBaseContainer::AllocResources()
 void CGUIBaseContainer::FreeResources(bool immediately)
 {
   CGUIControl::FreeResources(immediately);
+  ReleaseLayouts();
+  m_layoutPool.Clear();
+  m_focusedLayoutPool.Clear();
   if (m_listProvider)
   {
     if (immediately)
@@ -876,6 +877,11 @@ void CGUIBaseContainer::UpdateLayout(bool updateAllItems)
   { // free memory of items
     for (iItems it = m_items.begin(); it != m_items.end(); ++it)
       (*it)->FreeMemory();
+    for (std::set<CGUIListItemPtr>::iterator it = m_layoutItems.begin(); it != m_layoutItems.end(); ++it)
+      (*it)->FreeMemory();
+    m_layoutItems.clear();
+    m_layoutPool.Clear();
+    m_focusedLayoutPool.Clear();
   }
   // and recalculate the layout
   CalculateLayout();
@@ -1132,9 +1138,21 @@ void CGUIBaseContainer::Reset()
   m_wasReset = true;
   m_items.clear();
   m_lastItem.reset();
+  ReleaseLayouts();
   ResetAutoScrolling();
 }
 
+void CGUIBaseContainer::ReleaseLayouts()
+{
+  // the items may live on elsewhere, they shouldn't keep our layouts (nor we them)
+  for (std::set<CGUIListItemPtr>::iterator it = m_layoutItems.begin(); it != m_layoutItems.end(); ++it)
+  {
+    m_layoutPool.Put((*it)->DetachLayout());
+    m_focusedLayoutPool.Put((*it)->DetachFocusedLayout());
+  }
+  m_layoutItems.clear();
+}
+
 void CGUIBaseContainer::LoadLayout(TiXmlElement *layout)
 {
   TiXmlElement *itemElement = layout->FirstChildElement("itemlayout");
@@ -1175,17 +1193,44 @@ void CGUIBaseContainer::SetRenderOffset(const CPoint &offset)
 
 void CGUIBaseContainer::FreeMemory(int keepStart, int keepEnd)
 {
+  if (keepStart == keepEnd)
+    return;
+
+  // gather the items in view (plus cache), which is all we keep layouts for
+  std::vector<const CGUIListItem*> keep;
+  int numItems = m_items.size();
   if (keepStart < keepEnd)
-  { // remove before keepStart and after keepEnd
-    for (int i = 0; i < keepStart && i < (int)m_items.size(); ++i)
-      m_items[i]->FreeMemory();
-    for (int i = std::max(keepEnd + 1, 0); i < (int)m_items.size(); ++i)
-      m_items[i]->FreeMemory();
+  {
+    for (int i = std::max(keepStart, 0); i <= keepEnd && i < numItems; ++i)
+      keep.push_back(m_items[i].get());
   }
   else
   { // wrapping
-    for (int i = std::max(keepEnd + 1, 0); i < keepStart && i < (int)m_items.size(); ++i)
-      m_items[i]->FreeMemory();
+    for (int i = 0; i <= keepEnd && i < numItems; ++i)
+      keep.push_back(m_items[i].get());
+    for (int i = std::max(keepStart, 0); i < numItems; ++i)
+      keep.push_back(m_items[i].get());
+  }
+  std::sort(keep.begin(), keep.end());
+
+  m_layoutPool.SetCapacity(keep.size());
+  m_focusedLayoutPool.SetCapacity(1);
+
+  // only tracked items can hold layouts, so only they need visiting - recycle the layouts of those that left the view
+  for (std::set<CGUIListItemPtr>::iterator it = m_layoutItems.begin(); it != m_layoutItems.end(); )
+  {
+    CGUIListItem *item = it->get();
+    if (item->GetLayout() || item->GetFocusedLayout())
+    {
+      if (std::binary_search(keep.begin(), keep.end(), item))
+      {
+        ++it;
+        continue;
+      }
+      m_layoutPool.Put(item->DetachLayout());
+      m_focusedLayoutPool.Put(item->DetachFocusedLayout());
+    }
+    it = m_layoutItems.erase(it);
   }
 }
 
@@ -25,6 +25,7 @@
  *
  */
 
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -136,6 +137,7 @@ protected:
   inline float Size() const;
   void MoveToRow(int row);
   void FreeMemory(int keepStart, int keepEnd);
+  void ReleaseLayouts();
   void GetCurrentLayouts();
   CGUIListItemLayout *GetFocusedLayout() const;
 
@@ -159,6 +161,10 @@ protected:
   CGUIListItemLayout *m_layout;
   CGUIListItemLayout *m_focusedLayout;
 
+  CGUIListItemLayoutPool m_layoutPool;        ///< spare layouts of items that left the view
+  CGUIListItemLayoutPool m_focusedLayoutPool;
+  std::set<CGUIListItemPtr> m_layoutItems; ///< items that may hold our layouts, so FreeMemory() needn't visit all items
+
   void ScrollToOffset(int offset);
   void SetContainerMoving(int direction);
   void UpdateScrollOffset(unsigned int currentTime);
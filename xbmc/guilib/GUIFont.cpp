@@ -266,6 +266,25 @@ float CGUIFont::GetLineHeight() const
   return m_font->GetLineHeight(m_lineSpacing) * g_graphicsContext.GetGUIScaleY();
 }
 
+void CGUIFont::GetCharMetrics(character_t ch, float &advance, float &width)
+{
+  advance = width = 0;
+  if (m_font)
+    m_font->GetCharMetricsInternal(ch, advance, width);
+}
+
+float CGUIFont::GetUnscaledTextHeight(int numLines) const
+{
+  if (!m_font) return 0;
+  return m_font->GetTextHeight(m_lineSpacing, numLines);
+}
+
+float CGUIFont::GetUnscaledLineHeight() const
+{
+  if (!m_font) return 0;
+  return m_font->GetLineHeight(m_lineSpacing);
+}
+
 float CGUIFont::GetScaleFactor() const
 {
   if (!m_font) return 1.0f;
@@ -143,6 +143,13 @@ public:
   float GetTextBaseLine() const;
   float GetLineHeight() const;
 
+  /*! \brief Metrics in unscaled font units, for measuring text away from the render thread.
+   GetCharMetrics() may need to render the glyph, so must be called with the graphics context held.
+   */
+  void GetCharMetrics(character_t ch, float &advance, float &width);
+  float GetUnscaledTextHeight(int numLines) const;
+  float GetUnscaledLineHeight() const;
+
   //! get font scale factor (rendered height / original height)
   float GetScaleFactor() const;
 
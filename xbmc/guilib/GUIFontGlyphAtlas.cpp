@@ -0,0 +1,216 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "GUIFontGlyphAtlas.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#define NO_PAGE std::numeric_limits<unsigned int>::max()
+#define SHELF_ROUNDING 4 // shelf heights are rounded up to a multiple of this
+
+CGUIFontGlyphAtlas::CGUIFontGlyphAtlas()
+  : m_clock(0)
+{
+}
+
+bool CGUIFontGlyphAtlas::Lookup(const std::string& face, uint32_t letterAndStyle, Glyph& glyph, std::vector<unsigned char>& pixels)
+{
+  CSingleLock lock(m_critSection);
+
+  auto it = m_glyphs.find(GlyphKey(face, letterAndStyle));
+  if (it == m_glyphs.end())
+    return false;
+
+  const Entry& entry = it->second;
+  glyph.width = entry.width;
+  glyph.rows = entry.rows;
+  glyph.left = entry.left;
+  glyph.top = entry.top;
+  glyph.advance = entry.advance;
+
+  pixels.resize(entry.width * entry.rows);
+  if (entry.page != NO_PAGE)
+  {
+    Page& page = m_pages[entry.page];
+    page.lastUsed = ++m_clock;
+
+    const unsigned char* src = &page.pixels[entry.y * PAGE_SIZE + entry.x];
+    unsigned char* dst = pixels.data();
+    for (unsigned int y = 0; y < entry.rows; y++)
+    {
+      memcpy(dst, src, entry.width);
+      src += PAGE_SIZE;
+      dst += entry.width;
+    }
+  }
+  return true;
+}
+
+bool CGUIFontGlyphAtlas::Store(const std::string& face, uint32_t letterAndStyle,
+                               const unsigned char* pixels, unsigned int width, unsigned int rows, int pitch,
+                               int left, int top, long advance)
+{
+  CSingleLock lock(m_critSection);
+
+  GlyphKey key(face, letterAndStyle);
+  if (m_glyphs.find(key) != m_glyphs.end())
+    return true;
+
+  Entry entry;
+  entry.page = NO_PAGE;
+  entry.x = entry.y = 0;
+  entry.width = width;
+  entry.rows = rows;
+  entry.left = left;
+  entry.top = top;
+  entry.advance = advance;
+
+  if (width > 0 && rows > 0)
+  {
+    if (!pixels || width > PAGE_SIZE || rows > PAGE_SIZE)
+      return false;
+
+    if (!Allocate(width, rows, entry.page, entry.x, entry.y))
+      return false;
+
+    Page& page = m_pages[entry.page];
+    page.lastUsed = ++m_clock;
+    page.glyphs.push_back(key);
+
+    unsigned char* dst = &page.pixels[entry.y * PAGE_SIZE + entry.x];
+    for (unsigned int y = 0; y < rows; y++)
+    {
+      memcpy(dst, pixels, width);
+      pixels += pitch;
+      dst += PAGE_SIZE;
+    }
+  }
+
+  m_glyphs.insert(std::make_pair(key, entry));
+  return true;
+}
+
+void CGUIFontGlyphAtlas::Clear()
+{
+  CSingleLock lock(m_critSection);
+
+  m_glyphs.clear();
+  m_pages.clear();
+  m_clock = 0;
+}
+
+unsigned int CGUIFontGlyphAtlas::GetPageCount() const
+{
+  CSingleLock lock(m_critSection);
+  return m_pages.size();
+}
+
+bool CGUIFontGlyphAtlas::Allocate(unsigned int width, unsigned int rows, unsigned int& page, unsigned int& x, unsigned int& y)
+{
+  // try the most recently used pages first, they are most likely to have room on a matching shelf
+  std::vector<unsigned int> order(m_pages.size());
+  for (unsigned int i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+  {
+    return m_pages[a].lastUsed > m_pages[b].lastUsed;
+  });
+  for (unsigned int i : order)
+  {
+    if (AllocateInPage(m_pages[i], width, rows, x, y))
+    {
+      page = i;
+      return true;
+    }
+  }
+
+  // grow by adding a page rather than rebuilding the existing ones
+  if (m_pages.size() < MAX_PAGES)
+  {
+    Page newPage;
+    newPage.pixels.resize(PAGE_SIZE * PAGE_SIZE, 0);
+    newPage.nextY = 0;
+    newPage.lastUsed = 0;
+    m_pages.push_back(std::move(newPage));
+    page = m_pages.size() - 1;
+    return AllocateInPage(m_pages.back(), width, rows, x, y);
+  }
+
+  page = RecyclePage();
+  return AllocateInPage(m_pages[page], width, rows, x, y);
+}
+
+bool CGUIFontGlyphAtlas::AllocateInPage(Page& page, unsigned int width, unsigned int rows, unsigned int& x, unsigned int& y)
+{
+  unsigned int height = (rows + SHELF_ROUNDING - 1) / SHELF_ROUNDING * SHELF_ROUNDING;
+
+  for (auto& shelf : page.shelves)
+  {
+    if (shelf.height == height && shelf.posX + width <= PAGE_SIZE)
+    {
+      x = shelf.posX;
+      y = shelf.y;
+      shelf.posX += width;
+      return true;
+    }
+  }
+
+  if (page.nextY + height > PAGE_SIZE)
+    return false;
+
+  Shelf shelf;
+  shelf.y = page.nextY;
+  shelf.height = height;
+  shelf.posX = width;
+  page.shelves.push_back(shelf);
+  page.nextY += height;
+
+  x = 0;
+  y = shelf.y;
+  return true;
+}
+
+unsigned int CGUIFontGlyphAtlas::RecyclePage()
+{
+  unsigned int oldest = 0;
+  for (unsigned int i = 1; i < m_pages.size(); i++)
+  {
+    if (m_pages[i].lastUsed < m_pages[oldest].lastUsed)
+      oldest = i;
+  }
+
+  Page& page = m_pages[oldest];
+  for (const auto& key : page.glyphs)
+  {
+    auto it = m_glyphs.find(key);
+    if (it != m_glyphs.end() && it->second.page == oldest)
+      m_glyphs.erase(it);
+  }
+  CLog::Log(LOGDEBUG, "%s: recycling glyph page %u (%u glyphs)", __FUNCTION__, oldest, (unsigned int)page.glyphs.size());
+
+  page.glyphs.clear();
+  page.shelves.clear();
+  page.nextY = 0;
+  return oldest;
+}
@@ -0,0 +1,134 @@
+/*!
+\file GUIFontGlyphAtlas.h
+\brief
+*/
+
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+#include "utils/GlobalsHandling.h"
+
+/*!
+ \ingroup textures
+ \brief Shared store of rasterised glyph bitmaps.
+
+ Every CGUIFontTTFBase rasterises its glyphs with FreeType before copying them
+ into its own hardware texture. When that texture fills up, or a font object is
+ recreated for the same face and size, all glyphs used to be rasterised again.
+ The atlas keeps the 8 bit alpha bitmaps of recently used glyphs in a set of
+ fixed size pages shared by all font objects, keyed by face (file, size, aspect
+ and border), style and letter, so re-caching a glyph is a plain copy.
+
+ The atlas grows by adding pages up to a fixed limit. Once the limit is reached
+ the least recently used page is recycled, dropping the glyphs on it.
+ */
+class CGUIFontGlyphAtlas
+{
+public:
+  /*! \brief Placement and metrics of a glyph stored in the atlas */
+  struct Glyph
+  {
+    unsigned int width;
+    unsigned int rows;
+    int left;                    ///< FreeType bitmap left bearing
+    int top;                     ///< FreeType bitmap top bearing
+    long advance;                ///< horizontal advance in 26.6 units
+  };
+
+  CGUIFontGlyphAtlas();
+  ~CGUIFontGlyphAtlas() = default;
+
+  /*! \brief Look up a glyph previously stored for this face.
+   \param face identifier of the face, size, aspect and border (CGUIFontTTFBase::GetFileName())
+   \param letterAndStyle letter in the low 16 bits and style in the high 16 bits
+   \param glyph [out] glyph metrics
+   \param pixels [out] bitmap of the glyph, tightly packed (pitch == width)
+   \return true if the glyph is cached
+   */
+  bool Lookup(const std::string& face, uint32_t letterAndStyle, Glyph& glyph, std::vector<unsigned char>& pixels);
+
+  /*! \brief Store a rasterised glyph.
+   Empty glyphs are stored as metrics only and don't take any page space.
+   \return true if the glyph could be placed
+   */
+  bool Store(const std::string& face, uint32_t letterAndStyle,
+             const unsigned char* pixels, unsigned int width, unsigned int rows, int pitch,
+             int left, int top, long advance);
+
+  /*! \brief Drop everything and release all pages */
+  void Clear();
+
+  unsigned int GetPageCount() const;
+
+  static const unsigned int PAGE_SIZE = 512;
+  static const unsigned int MAX_PAGES = 8;
+
+private:
+  CGUIFontGlyphAtlas(const CGUIFontGlyphAtlas&) = delete;
+  CGUIFontGlyphAtlas& operator=(const CGUIFontGlyphAtlas&) = delete;
+
+  typedef std::pair<std::string, uint32_t> GlyphKey;
+
+  struct Entry
+  {
+    unsigned int page;
+    unsigned int x, y;
+    unsigned int width, rows;
+    int left, top;
+    long advance;
+  };
+
+  struct Shelf
+  {
+    unsigned int y;
+    unsigned int height;
+    unsigned int posX;
+  };
+
+  struct Page
+  {
+    std::vector<unsigned char> pixels;
+    std::vector<Shelf> shelves;
+    unsigned int nextY;
+    uint64_t lastUsed;
+    std::vector<GlyphKey> glyphs;
+  };
+
+  bool Allocate(unsigned int width, unsigned int rows, unsigned int& page, unsigned int& x, unsigned int& y);
+  bool AllocateInPage(Page& page, unsigned int width, unsigned int rows, unsigned int& x, unsigned int& y);
+  unsigned int RecyclePage();
+
+  std::map<GlyphKey, Entry> m_glyphs;
+  std::vector<Page> m_pages;
+  uint64_t m_clock;
+  mutable CCriticalSection m_critSection;
+};
+
+XBMC_GLOBAL_REF(CGUIFontGlyphAtlas, g_fontGlyphAtlas);
+#define g_fontGlyphAtlas XBMC_GLOBAL_USE(CGUIFontGlyphAtlas)
@@ -23,7 +23,10 @@
 #include "GUIWindowManager.h"
 #include "addons/Skin.h"
 #include "GUIFontTTF.h"
+#include "GUIFontGlyphAtlas.h"
 #include "GUIFont.h"
+#include "GUITextLayout.h"
+#include "threads/SingleLock.h"
 #include "utils/XMLUtils.h"
 #include "GUIControlFactory.h"
 #include "filesystem/Directory.h"
@@ -205,6 +208,9 @@ void GUIFontManager::ReloadTTFFonts(void)
   if (!m_vecFonts.size())
     return;   // we haven't even loaded fonts in yet
 
+  // cached layouts were measured with the old font sizes
+  CGUITextLayout::FlushLayoutCache();
+
   for (unsigned int i = 0; i < m_vecFonts.size(); i++)
   {
     CGUIFont* font = m_vecFonts[i];
@@ -239,6 +245,9 @@ void GUIFontManager::ReloadTTFFonts(void)
 
 void GUIFontManager::Unload(const std::string& strFontName)
 {
+  CSingleLock lock(g_graphicsContext);
+  CGUITextLayout::FlushLayoutCache();
+
   for (std::vector<CGUIFont*>::iterator iFont = m_vecFonts.begin(); iFont != m_vecFonts.end(); ++iFont)
   {
     if (StringUtils::EqualsNoCase((*iFont)->GetFontName(), strFontName))
@@ -324,6 +333,10 @@ CGUIFont* GUIFontManager::GetDefaultFont(bool border)
 
 void GUIFontManager::Clear()
 {
+  // background text layouts measure with the graphics context held
+  CSingleLock lock(g_graphicsContext);
+  CGUITextLayout::FlushLayoutCache();
+
   for (int i = 0; i < (int)m_vecFonts.size(); ++i)
   {
     CGUIFont* pFont = m_vecFonts[i];
@@ -333,6 +346,9 @@ void GUIFontManager::Clear()
   m_vecFonts.clear();
   m_vecFontFiles.clear();
   m_vecFontInfo.clear();
+
+  // glyphs of the old font set are of no use anymore
+  g_fontGlyphAtlas.Clear();
 }
 
 void GUIFontManager::LoadFonts(const std::string& fontSet)
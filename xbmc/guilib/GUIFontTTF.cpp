@@ -21,6 +21,7 @@
 #include "GUIFont.h"
 #include "GUIFontTTF.h"
 #include "GUIFontManager.h"
+#include "GUIFontGlyphAtlas.h"
 #include "Texture.h"
 #include "GraphicContext.h"
 #include "filesystem/SpecialProtocol.h"
@@ -583,6 +584,17 @@ float CGUIFontTTFBase::GetCharWidthInternal(character_t ch)
   return 0;
 }
 
+void CGUIFontTTFBase::GetCharMetricsInternal(character_t ch, float &advance, float &width)
+{
+  advance = width = 0;
+  Character *c = GetCharacter(ch);
+  if (c)
+  {
+    advance = c->advance;
+    width = std::max(c->right - c->left + c->offsetX, c->advance);
+  }
+}
+
 float CGUIFontTTFBase::GetTextHeight(float lineSpacing, int numLines) const
 {
   return (float)(numLines - 1) * GetLineHeight(lineSpacing) + m_cellHeight;
@@ -691,38 +703,70 @@ CGUIFontTTFBase::Character* CGUIFontTTFBase::GetCharacter(character_t chr)
 
 bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *ch)
 {
-  int glyph_index = FT_Get_Char_Index( m_face, letter );
+  character_t letterAndStyle = (style << 16) | letter;
 
   FT_Glyph glyph = NULL;
-  if (FT_Load_Glyph( m_face, glyph_index, FT_LOAD_TARGET_LIGHT ))
-  {
-    CLog::Log(LOGDEBUG, "%s Failed to load glyph %x", __FUNCTION__, letter);
-    return false;
-  }
-  // make bold if applicable
-  if (style & FONT_STYLE_BOLD)
-    SetGlyphStrength(m_face->glyph, GLYPH_STRENGTH_BOLD);
-  // and italics if applicable
-  if (style & FONT_STYLE_ITALICS)
-    ObliqueGlyph(m_face->glyph);
-  // and light if applicable
-  if (style & FONT_STYLE_LIGHT)
-    SetGlyphStrength(m_face->glyph, GLYPH_STRENGTH_LIGHT);
-  // grab the glyph
-  if (FT_Get_Glyph(m_face->glyph, &glyph))
+  FT_BitmapGlyph bitGlyph;
+  FT_BitmapGlyphRec atlasGlyph;
+  long advance;
+
+  // glyphs rasterised before (by us or another font object of the same face) are in the shared atlas
+  CGUIFontGlyphAtlas::Glyph cached;
+  if (g_fontGlyphAtlas.Lookup(m_strFileName, letterAndStyle, cached, m_glyphPixels))
   {
-    CLog::Log(LOGDEBUG, "%s Failed to get glyph %x", __FUNCTION__, letter);
-    return false;
+    memset(&atlasGlyph, 0, sizeof(atlasGlyph));
+    atlasGlyph.left = cached.left;
+    atlasGlyph.top = cached.top;
+    atlasGlyph.bitmap.width = cached.width;
+    atlasGlyph.bitmap.rows = cached.rows;
+    atlasGlyph.bitmap.pitch = cached.width;
+    atlasGlyph.bitmap.buffer = m_glyphPixels.data();
+    atlasGlyph.bitmap.num_grays = 256;
+    atlasGlyph.bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
+    bitGlyph = &atlasGlyph;
+    advance = cached.advance;
   }
-  if (m_stroker)
-    FT_Glyph_StrokeBorder(&glyph, m_stroker, 0, 1);
-  // render the glyph
-  if (FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, NULL, 1))
+  else
   {
-    CLog::Log(LOGDEBUG, "%s Failed to render glyph %x to a bitmap", __FUNCTION__, letter);
-    return false;
+    int glyph_index = FT_Get_Char_Index( m_face, letter );
+
+    if (FT_Load_Glyph( m_face, glyph_index, FT_LOAD_TARGET_LIGHT ))
+    {
+      CLog::Log(LOGDEBUG, "%s Failed to load glyph %x", __FUNCTION__, letter);
+      return false;
+    }
+    // make bold if applicable
+    if (style & FONT_STYLE_BOLD)
+      SetGlyphStrength(m_face->glyph, GLYPH_STRENGTH_BOLD);
+    // and italics if applicable
+    if (style & FONT_STYLE_ITALICS)
+      ObliqueGlyph(m_face->glyph);
+    // and light if applicable
+    if (style & FONT_STYLE_LIGHT)
+      SetGlyphStrength(m_face->glyph, GLYPH_STRENGTH_LIGHT);
+    // grab the glyph
+    if (FT_Get_Glyph(m_face->glyph, &glyph))
+    {
+      CLog::Log(LOGDEBUG, "%s Failed to get glyph %x", __FUNCTION__, letter);
+      return false;
+    }
+    if (m_stroker)
+      FT_Glyph_StrokeBorder(&glyph, m_stroker, 0, 1);
+    // render the glyph
+    if (FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, NULL, 1))
+    {
+      CLog::Log(LOGDEBUG, "%s Failed to render glyph %x to a bitmap", __FUNCTION__, letter);
+      FT_Done_Glyph(glyph);
+      return false;
+    }
+    bitGlyph = (FT_BitmapGlyph)glyph;
+    advance = m_face->glyph->advance.x;
+
+    g_fontGlyphAtlas.Store(m_strFileName, letterAndStyle,
+                           bitGlyph->bitmap.buffer, bitGlyph->bitmap.width, bitGlyph->bitmap.rows, bitGlyph->bitmap.pitch,
+                           bitGlyph->left, bitGlyph->top, advance);
   }
-  FT_BitmapGlyph bitGlyph = (FT_BitmapGlyph)glyph;
+
   FT_Bitmap bitmap = bitGlyph->bitmap;
   bool isEmptyGlyph = (bitmap.width == 0 || bitmap.rows == 0);
 
@@ -747,7 +791,8 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
         if (newHeight > g_Windowing.GetMaxTextureSize())
         {
           CLog::Log(LOGDEBUG, "%s: New cache texture is too large (%u > %u pixels long)", __FUNCTION__, newHeight, g_Windowing.GetMaxTextureSize());
-          FT_Done_Glyph(glyph);
+          if (glyph)
+            FT_Done_Glyph(glyph);
           return false;
         }
 
@@ -755,7 +800,8 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
         newTexture = ReallocTexture(newHeight);
         if(newTexture == NULL)
         {
-          FT_Done_Glyph(glyph);
+          if (glyph)
+            FT_Done_Glyph(glyph);
           CLog::Log(LOGDEBUG, "%s: Failed to allocate new texture of height %u", __FUNCTION__, newHeight);
           return false;
         }
@@ -765,20 +811,21 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
 
     if(m_texture == NULL)
     {
-      FT_Done_Glyph(glyph);
+      if (glyph)
+        FT_Done_Glyph(glyph);
       CLog::Log(LOGDEBUG, "%s: no texture to cache character to", __FUNCTION__);
       return false;
     }
   }
   // set the character in our table
-  ch->letterAndStyle = (style << 16) | letter;
+  ch->letterAndStyle = letterAndStyle;
   ch->offsetX = (short)bitGlyph->left;
   ch->offsetY = (short)m_cellBaseLine - bitGlyph->top;
   ch->left = isEmptyGlyph ? 0 : ((float)m_posX + ch->offsetX);
   ch->top = isEmptyGlyph ? 0 : ((float)m_posY + ch->offsetY);
   ch->right = ch->left + bitmap.width;
   ch->bottom = ch->top + bitmap.rows;
-  ch->advance = (float)MathUtils::round_int( (float)m_face->glyph->advance.x / 64 );
+  ch->advance = (float)MathUtils::round_int( (float)advance / 64 );
 
   // we need only render if we actually have some pixels
   if (!isEmptyGlyph)
@@ -795,7 +842,8 @@ bool CGUIFontTTFBase::CacheCharacter(wchar_t letter, uint32_t style, Character *
   m_numChars++;
 
   // free the glyph
-  FT_Done_Glyph(glyph);
+  if (glyph)
+    FT_Done_Glyph(glyph);
 
   return true;
 }
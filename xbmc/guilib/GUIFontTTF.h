@@ -117,6 +117,7 @@ protected:
 
   float GetTextWidthInternal(vecText::const_iterator start, vecText::const_iterator end);
   float GetCharWidthInternal(character_t ch);
+  void GetCharMetricsInternal(character_t ch, float &advance, float &width);
   float GetTextHeight(float lineSpacing, int numLines) const;
   float GetTextBaseLine() const { return (float)m_cellBaseLine; }
   float GetLineHeight(float lineSpacing) const;
@@ -195,6 +196,7 @@ protected:
 
   std::string m_strFileName;
   XUTILS::auto_buffer m_fontFileInMemory; // used only in some cases, see CFreeTypeLibrary::GetFont()
+  std::vector<unsigned char> m_glyphPixels; // scratch buffer for glyphs taken from the shared atlas
 
   CGUIFontCache<CGUIFontCacheStaticPosition, CGUIFontCacheStaticValue> m_staticCache;
   CGUIFontCache<CGUIFontCacheDynamicPosition, CGUIFontCacheDynamicValue> m_dynamicCache;
@@ -148,6 +148,12 @@ public:
   void SetFocusedLayout(CGUIListItemLayout *layout);
   CGUIListItemLayout *GetFocusedLayout();
 
+  /*! \brief Take the layouts away from this item without freeing them
+   \return the layout, owned by the caller from now on
+   */
+  CGUIListItemLayout *DetachLayout();
+  CGUIListItemLayout *DetachFocusedLayout();
+
   void FreeIcons();
   void FreeMemory(bool immediately = false);
   void SetInvalid();
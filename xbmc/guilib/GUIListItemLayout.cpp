@@ -27,6 +27,14 @@
 #include "GUIImage.h"
 #include "utils/XBMCTinyXML.h"
 
+#include <atomic>
+
+static unsigned int NextLayoutID()
+{
+  static std::atomic<unsigned int> nextID(1);
+  return nextID++;
+}
+
 CGUIListItemLayout::CGUIListItemLayout()
 : m_group(0, 0, 0, 0, 0, 0)
 {
@@ -34,6 +42,8 @@ CGUIListItemLayout::CGUIListItemLayout()
   m_height = 0;
   m_focused = false;
   m_invalidated = true;
+  m_id = NextLayoutID();
+  m_sourceID = 0;
   m_group.SetPushUpdates(true);
 }
 
@@ -45,6 +55,8 @@ CGUIListItemLayout::CGUIListItemLayout(const CGUIListItemLayout &from)
   m_focused = from.m_focused;
   m_condition = from.m_condition;
   m_invalidated = true;
+  m_id = NextLayoutID();
+  m_sourceID = from.m_id;
 }
 
 CGUIListItemLayout::~CGUIListItemLayout()
@@ -93,6 +105,14 @@ void CGUIListItemLayout::Render(CGUIListItem *item, int parentID)
   m_group.DoRender();
 }
 
+void CGUIListItemLayout::Recycle()
+{
+  m_group.ResetAnimations();
+  m_group.SetFocusedItem(0);
+  m_group.SetInvalid();
+  m_invalidated = true;
+}
+
 void CGUIListItemLayout::SetFocusedItem(unsigned int focus)
 {
   m_group.SetFocusedItem(focus);
@@ -229,3 +249,61 @@ void CGUIListItemLayout::DumpTextureUse()
   m_group.DumpTextureUse();
 }
 #endif
+
+CGUIListItemLayoutPool& CGUIListItemLayoutPool::operator=(const CGUIListItemLayoutPool &from)
+{
+  Clear();
+  m_capacity = from.m_capacity;
+  return *this;
+}
+
+CGUIListItemLayoutPool::~CGUIListItemLayoutPool()
+{
+  Clear();
+}
+
+CGUIListItemLayout *CGUIListItemLayoutPool::Get(const CGUIListItemLayout &source)
+{
+  while (!m_layouts.empty())
+  {
+    CGUIListItemLayout *layout = m_layouts.back();
+    m_layouts.pop_back();
+    if (layout->IsCopyOf(source))
+    {
+      layout->Recycle();
+      return layout;
+    }
+    // copied from a template no longer in use
+    delete layout;
+  }
+  return new CGUIListItemLayout(source);
+}
+
+void CGUIListItemLayoutPool::Put(CGUIListItemLayout *layout)
+{
+  if (!layout)
+    return;
+
+  layout->FreeResources();
+  if (m_layouts.size() < m_capacity)
+    m_layouts.push_back(layout);
+  else
+    delete layout;
+}
+
+void CGUIListItemLayoutPool::SetCapacity(size_t capacity)
+{
+  m_capacity = capacity;
+  while (m_layouts.size() > m_capacity)
+  {
+    delete m_layouts.back();
+    m_layouts.pop_back();
+  }
+}
+
+void CGUIListItemLayoutPool::Clear()
+{
+  for (std::vector<CGUIListItemLayout*>::iterator it = m_layouts.begin(); it != m_layouts.end(); ++it)
+    delete *it;
+  m_layouts.clear();
+}
@@ -20,6 +20,8 @@
  *
  */
 
+#include <vector>
+
 #include "GUIListGroup.h"
 #include "GUITexture.h"
 #include "GUIInfoTypes.h"
@@ -45,6 +47,14 @@ public:
   void SetInvalid() { m_invalidated = true; };
   void FreeResources(bool immediately = false);
 
+  /*! \brief Prepare a layout previously used for another item to display a new one */
+  void Recycle();
+
+  /*! \brief Whether this layout was copied from the given template, used to check whether a pooled layout still matches.
+   Layouts are compared by id rather than address, as templates are destroyed and reallocated when the skin reloads.
+   */
+  bool IsCopyOf(const CGUIListItemLayout &source) const { return m_sourceID == source.m_id; };
+
 //#ifdef GUILIB_PYTHON_COMPATIBILITY
   void CreateListControlLayouts(float width, float height, bool focused, const CLabelInfo &labelInfo, const CLabelInfo &labelInfo2, const CTextureInfo &texture, const CTextureInfo &textureFocus, float texHeight, float iconWidth, float iconHeight, const std::string &nofocusCondition, const std::string &focusCondition);
 //#endif
@@ -69,8 +79,44 @@ protected:
   float m_height;
   bool m_focused;
   bool m_invalidated;
+  unsigned int m_id;       ///< unique to this layout object
+  unsigned int m_sourceID; ///< id of the layout this one was copied from
 
   INFO::InfoPtr m_condition;
   CGUIInfoBool m_isPlaying;
 };
 
+/*!
+ \brief Spare item layouts kept by a container for reuse.
+
+ Copying the template layout for every item that scrolls into view, and deleting it again once
+ it scrolls out, allocates and frees a full control tree per item. Containers instead return the
+ layouts of items leaving the view to a pool, and take them back for items coming into view.
+ Copies of a pool start out empty.
+ */
+class CGUIListItemLayoutPool
+{
+public:
+  CGUIListItemLayoutPool() : m_capacity(0) {};
+  CGUIListItemLayoutPool(const CGUIListItemLayoutPool &from) : m_capacity(from.m_capacity) {};
+  CGUIListItemLayoutPool& operator=(const CGUIListItemLayoutPool &from);
+  ~CGUIListItemLayoutPool();
+
+  /*! \brief Get a layout for a new item, either recycled or copied from the template
+   \param source the template layout
+   \return a layout owned by the caller
+   */
+  CGUIListItemLayout *Get(const CGUIListItemLayout &source);
+
+  /*! \brief Return a layout that is no longer needed.
+   The pool takes ownership, deleting the layout if it is full.
+   */
+  void Put(CGUIListItemLayout *layout);
+
+  void SetCapacity(size_t capacity);
+  void Clear();
+
+private:
+  std::vector<CGUIListItemLayout*> m_layouts;
+  size_t m_capacity;
+};
@@ -95,6 +95,9 @@ bool CGUITextBox::UpdateColors()
 void CGUITextBox::UpdateInfo(const CGUIListItem *item)
 {
   m_textColor = m_label.textColor;
+  // long texts (plots, lyrics) are laid out in the background, except inside list items where
+  // showing the previous item's text while laying out would be misleading
+  SetAsyncLayout(item == NULL);
   if (!CGUITextLayout::Update(item ? m_info.GetItemLabel(item) : m_info.GetLabel(m_parentID), m_width))
     return; // nothing changed
 
@@ -22,9 +22,267 @@
 #include "GUIFont.h"
 #include "GUIControl.h"
 #include "GUIColorManager.h"
+#include "GraphicContext.h"
+#include "threads/SingleLock.h"
 #include "utils/CharsetConverter.h"
+#include "utils/JobManager.h"
 #include "utils/StringUtils.h"
 
+#include <list>
+#include <map>
+#include <set>
+#include <tuple>
+
+#define LAYOUT_CACHE_MAX_CHARS (256 * 1024) // total number of characters kept in cached layouts
+
+struct CGUITextLayout::CLayoutKey
+{
+  std::string utf8;
+  std::wstring utf16;
+  bool isUtf16;
+  CGUIFont *font;
+  uint32_t style;
+  color_t textColor;
+  float maxWidth;
+  float maxHeight;
+  float scaleX; ///< GUI scale the text is measured at, as the same font measures differently per window resolution
+  float scaleY;
+  bool wrap;
+  bool forceLTRReadingOrder;
+
+  bool operator<(const CLayoutKey &rhs) const
+  {
+    return std::tie(font, style, textColor, maxWidth, maxHeight, scaleX, scaleY, wrap, forceLTRReadingOrder, isUtf16, utf8, utf16) <
+           std::tie(rhs.font, rhs.style, rhs.textColor, rhs.maxWidth, rhs.maxHeight, rhs.scaleX, rhs.scaleY, rhs.wrap, rhs.forceLTRReadingOrder, rhs.isUtf16, rhs.utf8, rhs.utf16);
+  }
+  size_t Size() const { return utf8.size() + utf16.size(); }
+};
+
+struct CGUITextLayout::CLayoutResult
+{
+  std::vector<CGUIString> lines;
+  vecColors colors;
+  float textWidth;
+  float textHeight;
+  unsigned int cacheGeneration; ///< generation of the layout cache the result was computed in
+};
+
+/*! \brief State shared between a layout and the background jobs laying out its text.
+ abandoned is only accessed with the graphics context held, as that is what fonts are destroyed under.
+ */
+struct CGUITextLayout::CAsyncState
+{
+  CCriticalSection lock;
+  unsigned int generation = 0;
+  std::shared_ptr<const CLayoutResult> result; ///< finished layout of the current generation
+  bool abandoned = false;
+};
+
+/*! \brief Unscaled font metrics a background job lays out with.
+ Every character of the text is measured up front so the graphics context is only taken once,
+ and widths are scaled by the GUI scale held in the layout key rather than that of the active window.
+ */
+struct CGUITextLayout::CJobMetrics
+{
+  CJobMetrics(CGUIFont *font, const CAsyncState *state, float scaleX, float scaleY)
+    : font(font), state(state), scaleX(scaleX), scaleY(scaleY)
+  {
+  }
+
+  bool Load(const vecText &text)
+  {
+    std::set<character_t> letters(text.begin(), text.end());
+
+    CSingleLock lock(g_graphicsContext);
+    if (state->abandoned)
+      return false;
+    lineHeight = font->GetUnscaledLineHeight();
+    cellHeight = font->GetUnscaledTextHeight(1);
+    for (std::set<character_t>::const_iterator i = letters.begin(); i != letters.end(); ++i)
+      font->GetCharMetrics(*i, widths[*i].first, widths[*i].second);
+    return true;
+  }
+
+  float TextWidth(const vecText &text)
+  {
+    float width = 0;
+    for (vecText::const_iterator i = text.begin(); i != text.end(); ++i)
+    {
+      Widths::const_iterator letter = widths.find(*i);
+      if (letter == widths.end())
+        letter = Measure(*i); // not in the original text, e.g. mirrored by the bidi transform
+      // the last letter takes its render width so italics aren't chopped, as CGUIFontTTFBase does
+      width += (i + 1 == text.end()) ? letter->second.second : letter->second.first;
+    }
+    return width * scaleX;
+  }
+
+  float LineHeight() const { return lineHeight * scaleY; }
+  float TextHeight(int numLines) const { return ((numLines - 1) * lineHeight + cellHeight) * scaleY; }
+
+private:
+  typedef std::map<character_t, std::pair<float, float> > Widths; ///< advance and render width
+
+  Widths::const_iterator Measure(character_t letter)
+  {
+    std::pair<float, float> &metrics = widths[letter];
+    CSingleLock lock(g_graphicsContext);
+    if (!state->abandoned)
+      font->GetCharMetrics(letter, metrics.first, metrics.second);
+    return widths.find(letter);
+  }
+
+  CGUIFont *font;
+  const CAsyncState *state;
+  float scaleX;
+  float scaleY;
+  float lineHeight = 0;
+  float cellHeight = 0;
+  Widths widths;
+};
+
+/*! \brief LRU cache of finished layouts, shared by all text layouts */
+class CGUITextLayoutCache
+{
+public:
+  typedef CGUITextLayout::CLayoutKey Key;
+  typedef std::shared_ptr<const CGUITextLayout::CLayoutResult> Result;
+
+  Result Lookup(const Key &key)
+  {
+    CSingleLock lock(m_section);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+      return Result();
+    m_age.splice(m_age.begin(), m_age, it->second.age);
+    return it->second.result;
+  }
+
+  void Insert(const Key &key, const Result &result)
+  {
+    if (key.Size() > LAYOUT_CACHE_MAX_CHARS / 4)
+      return;
+
+    CSingleLock lock(m_section);
+    if (result->cacheGeneration != m_generation)
+      return; // laid out with fonts that have been flushed since
+    auto inserted = m_entries.insert(std::make_pair(key, Entry()));
+    if (!inserted.second)
+      return;
+    m_age.push_front(&inserted.first->first);
+    inserted.first->second.result = result;
+    inserted.first->second.age = m_age.begin();
+    m_size += key.Size();
+
+    while (m_size > LAYOUT_CACHE_MAX_CHARS && !m_age.empty())
+    {
+      const Key *oldest = m_age.back();
+      m_age.pop_back();
+      m_size -= oldest->Size();
+      m_entries.erase(*oldest);
+    }
+  }
+
+  void Flush()
+  {
+    CSingleLock lock(m_section);
+    m_generation++;
+    m_age.clear();
+    m_entries.clear();
+    m_size = 0;
+  }
+
+  unsigned int Generation()
+  {
+    CSingleLock lock(m_section);
+    return m_generation;
+  }
+
+  static CGUITextLayoutCache &Get()
+  {
+    static CGUITextLayoutCache cache;
+    return cache;
+  }
+
+private:
+  typedef std::list<const Key*> Age; // most recently used first
+  struct Entry
+  {
+    Result result;
+    Age::iterator age;
+  };
+
+  std::map<Key, Entry> m_entries;
+  Age m_age;
+  size_t m_size = 0;
+  unsigned int m_generation = 0;
+  CCriticalSection m_section;
+};
+
+/*! \brief Lays out text on a private CGUITextLayout and hands the result back to the owner */
+class CGUITextLayoutJob : public CJob
+{
+public:
+  CGUITextLayoutJob(const CGUITextLayout::CLayoutKey &key, const std::shared_ptr<CGUITextLayout::CAsyncState> &state, unsigned int generation, unsigned int cacheGeneration)
+    : m_key(key), m_state(state), m_generation(generation), m_cacheGeneration(cacheGeneration)
+  {
+  }
+
+  const char *GetType() const override { return "textlayout"; }
+
+  bool DoWork() override
+  {
+    {
+      CSingleLock lock(m_state->lock);
+      if (m_state->generation != m_generation)
+        return false; // superseded before we got to run
+    }
+    if (CGUITextLayoutCache::Get().Generation() != m_cacheGeneration)
+      return false; // fonts were flushed, the owner will be laid out again
+
+    std::wstring utf16(m_key.utf16);
+    if (!m_key.isUtf16)
+      g_charsetConverter.utf8ToW(m_key.utf8, utf16, false);
+
+    vecText parsedText;
+    vecColors colors;
+    CGUITextLayout::ParseText(utf16, m_key.style, m_key.textColor, colors, parsedText);
+
+    CGUITextLayout::CJobMetrics metrics(m_key.font, m_state.get(), m_key.scaleX, m_key.scaleY);
+    if (!metrics.Load(parsedText))
+      return false;
+
+    CGUITextLayout layout(m_key.font, m_key.wrap, m_key.maxHeight);
+    layout.m_jobMetrics = &metrics;
+    layout.UpdateStyled(parsedText, colors, m_key.maxWidth, m_key.forceLTRReadingOrder);
+
+    {
+      CSingleLock lock(g_graphicsContext);
+      if (m_state->abandoned)
+        return false;
+    }
+
+    std::shared_ptr<CGUITextLayout::CLayoutResult> result(new CGUITextLayout::CLayoutResult);
+    result->lines.swap(layout.m_lines);
+    result->colors.swap(layout.m_colors);
+    result->textWidth = layout.m_textWidth;
+    result->textHeight = layout.m_textHeight;
+    result->cacheGeneration = m_cacheGeneration;
+    CGUITextLayoutCache::Get().Insert(m_key, result);
+
+    CSingleLock lock(m_state->lock);
+    if (m_state->generation == m_generation)
+      m_state->result = result;
+    return true;
+  }
+
+private:
+  CGUITextLayout::CLayoutKey m_key;
+  std::shared_ptr<CGUITextLayout::CAsyncState> m_state;
+  unsigned int m_generation;
+  unsigned int m_cacheGeneration;
+};
+
 CGUIString::CGUIString(iString start, iString end, bool carriageReturn)
 {
   m_text.assign(start, end);
@@ -49,6 +307,8 @@ CGUITextLayout::CGUITextLayout(CGUIFont *font, bool wrap, float fHeight, CGUIFon
   m_textWidth = 0;
   m_textHeight = 0;
   m_lastUpdateW = false;
+  m_asyncLayout = false;
+  m_jobMetrics = NULL;
 }
 
 void CGUITextLayout::SetWrap(bool bWrap)
@@ -56,6 +316,32 @@ void CGUITextLayout::SetWrap(bool bWrap)
   m_wrap = bWrap;
 }
 
+void CGUITextLayout::SetAsyncLayout(bool async)
+{
+#ifdef HAS_DX
+  // measuring caches glyphs, which reallocates the glyph texture on the D3D device context,
+  // and that may only be used from the render thread
+  m_asyncLayout = false;
+#else
+  m_asyncLayout = async;
+#endif
+}
+
+void CGUITextLayout::FlushLayoutCache()
+{
+  CGUITextLayoutCache::Get().Flush();
+}
+
+void CGUITextLayout::CAsyncHolder::Abandon()
+{
+  if (!m_state)
+    return;
+
+  CSingleLock lock(g_graphicsContext);
+  m_state->abandoned = true;
+  m_state.reset();
+}
+
 void CGUITextLayout::Render(float x, float y, float angle, color_t color, color_t shadowColor, uint32_t alignment, float maxWidth, bool solid)
 {
   if (!m_font)
@@ -214,25 +500,135 @@ void CGUITextLayout::RenderOutline(float x, float y, color_t color, color_t outl
 
 bool CGUITextLayout::Update(const std::string &text, float maxWidth, bool forceUpdate /*= false*/, bool forceLTRReadingOrder /*= false*/)
 {
+  bool adopted = AdoptAsyncLayout();
   if (text == m_lastUtf8Text && !forceUpdate && !m_lastUpdateW)
-    return false;
+    return adopted;
 
   m_lastUtf8Text = text;
   m_lastUpdateW = false;
+
+  CLayoutKey key(MakeKey(text, std::wstring(), false, maxWidth, forceLTRReadingOrder));
+  if (UpdateCached(key))
+    return true;
+
+  if (m_asyncLayout)
+  {
+    QueueAsyncLayout(key);
+    return adopted;
+  }
+
   std::wstring utf16;
   g_charsetConverter.utf8ToW(text, utf16, false);
   UpdateCommon(utf16, maxWidth, forceLTRReadingOrder);
+  StoreCached(key);
   return true;
 }
 
 bool CGUITextLayout::UpdateW(const std::wstring &text, float maxWidth /*= 0*/, bool forceUpdate /*= false*/, bool forceLTRReadingOrder /*= false*/)
 {
+  bool adopted = AdoptAsyncLayout();
   if (text == m_lastText && !forceUpdate && m_lastUpdateW)
-    return false;
+    return adopted;
 
   m_lastText = text;
   m_lastUpdateW = true;
+
+  CLayoutKey key(MakeKey(std::string(), text, true, maxWidth, forceLTRReadingOrder));
+  if (UpdateCached(key))
+    return true;
+
+  if (m_asyncLayout)
+  {
+    QueueAsyncLayout(key);
+    return adopted;
+  }
+
   UpdateCommon(text, maxWidth, forceLTRReadingOrder);
+  StoreCached(key);
+  return true;
+}
+
+CGUITextLayout::CLayoutKey CGUITextLayout::MakeKey(const std::string &utf8, const std::wstring &utf16, bool isUtf16, float maxWidth, bool forceLTRReadingOrder) const
+{
+  CLayoutKey key;
+  key.utf8 = utf8;
+  key.utf16 = utf16;
+  key.isUtf16 = isUtf16;
+  key.font = m_font;
+  key.style = m_font ? m_font->GetStyle() : 0;
+  key.textColor = m_textColor;
+  key.maxWidth = maxWidth;
+  key.maxHeight = m_maxHeight;
+  key.scaleX = g_graphicsContext.GetGUIScaleX();
+  key.scaleY = g_graphicsContext.GetGUIScaleY();
+  key.wrap = m_wrap;
+  key.forceLTRReadingOrder = forceLTRReadingOrder;
+  return key;
+}
+
+bool CGUITextLayout::UpdateCached(const CLayoutKey &key)
+{
+  std::shared_ptr<const CLayoutResult> result = CGUITextLayoutCache::Get().Lookup(key);
+  if (!result)
+    return false;
+
+  // anything still being laid out in the background is out of date now
+  if (m_async.m_state)
+  {
+    CSingleLock lock(m_async.m_state->lock);
+    m_async.m_state->generation++;
+    m_async.m_state->result.reset();
+  }
+
+  m_lines = result->lines;
+  m_colors = result->colors;
+  m_textWidth = result->textWidth;
+  m_textHeight = result->textHeight;
+  return true;
+}
+
+void CGUITextLayout::StoreCached(const CLayoutKey &key)
+{
+  std::shared_ptr<CLayoutResult> result(new CLayoutResult);
+  result->lines = m_lines;
+  result->colors = m_colors;
+  result->textWidth = m_textWidth;
+  result->textHeight = m_textHeight;
+  result->cacheGeneration = CGUITextLayoutCache::Get().Generation();
+  CGUITextLayoutCache::Get().Insert(key, result);
+}
+
+void CGUITextLayout::QueueAsyncLayout(const CLayoutKey &key)
+{
+  if (!m_async.m_state)
+    m_async.m_state = std::make_shared<CAsyncState>();
+
+  unsigned int generation;
+  {
+    CSingleLock lock(m_async.m_state->lock);
+    generation = ++m_async.m_state->generation;
+    m_async.m_state->result.reset();
+  }
+  CJobManager::GetInstance().AddJob(new CGUITextLayoutJob(key, m_async.m_state, generation, CGUITextLayoutCache::Get().Generation()), NULL, CJob::PRIORITY_HIGH);
+}
+
+bool CGUITextLayout::AdoptAsyncLayout()
+{
+  if (!m_async.m_state)
+    return false;
+
+  std::shared_ptr<const CLayoutResult> result;
+  {
+    CSingleLock lock(m_async.m_state->lock);
+    result.swap(m_async.m_state->result);
+  }
+  if (!result || result->cacheGeneration != CGUITextLayoutCache::Get().Generation())
+    return false;
+
+  m_lines = result->lines;
+  m_colors = result->colors;
+  m_textWidth = result->textWidth;
+  m_textHeight = result->textHeight;
   return true;
 }
 
@@ -499,7 +895,7 @@ void CGUITextLayout::WrapText(const vecText &text, float maxWidth)
   if (!m_font)
     return;
 
-  int nMaxLines = (m_maxHeight > 0 && m_font->GetLineHeight() > 0)?(int)ceilf(m_maxHeight / m_font->GetLineHeight()):-1;
+  int nMaxLines = GetMaxLines();
 
   m_lines.clear();
 
@@ -520,7 +916,7 @@ void CGUITextLayout::WrapText(const vecText &text, float maxWidth)
       // check for a space
       if (CanWrapAtLetter(letter))
       {
-        float width = m_font->GetTextWidth(curLine);
+        float width = MeasureText(curLine);
         if (width > maxWidth)
         {
           if (lastSpace != line.m_text.begin() && lastSpaceInLine > 0)
@@ -547,7 +943,7 @@ void CGUITextLayout::WrapText(const vecText &text, float maxWidth)
       ++pos;
     }
     // now add whatever we have left to the string
-    float width = m_font->GetTextWidth(curLine);
+    float width = MeasureText(curLine);
     if (width > maxWidth)
     {
       // too long - put up to the last space on if we can + remove it from what's left.
@@ -573,7 +969,7 @@ void CGUITextLayout::WrapText(const vecText &text, float maxWidth)
 
 void CGUITextLayout::LineBreakText(const vecText &text, std::vector<CGUIString> &lines)
 {
-  int nMaxLines = (m_maxHeight > 0 && m_font && m_font->GetLineHeight() > 0)?(int)ceilf(m_maxHeight / m_font->GetLineHeight()):-1;
+  int nMaxLines = GetMaxLines();
   vecText::const_iterator lineStart = text.begin();
   vecText::const_iterator pos = text.begin();
   while (pos != text.end() && (nMaxLines <= 0 || lines.size() < (size_t)nMaxLines))
@@ -613,11 +1009,32 @@ void CGUITextLayout::CalcTextExtent()
   for (std::vector<CGUIString>::iterator i = m_lines.begin(); i != m_lines.end(); ++i)
   {
     const CGUIString &string = *i;
-    float w = m_font->GetTextWidth(string.m_text);
+    float w = MeasureText(string.m_text);
     if (w > m_textWidth)
       m_textWidth = w;
   }
-  m_textHeight = m_font->GetTextHeight(m_lines.size());
+
+  if (m_jobMetrics)
+    m_textHeight = m_jobMetrics->TextHeight(m_lines.size());
+  else
+    m_textHeight = m_font->GetTextHeight(m_lines.size());
+}
+
+float CGUITextLayout::MeasureText(const vecText &text) const
+{
+  if (m_jobMetrics)
+    return m_jobMetrics->TextWidth(text);
+  return m_font->GetTextWidth(text);
+}
+
+int CGUITextLayout::GetMaxLines() const
+{
+  if (m_maxHeight <= 0 || !m_font)
+    return -1;
+
+  float lineHeight = m_jobMetrics ? m_jobMetrics->LineHeight() : m_font->GetLineHeight();
+
+  return lineHeight > 0 ? (int)ceilf(m_maxHeight / lineHeight) : -1;
 }
 
 unsigned int CGUITextLayout::GetTextLength() const
@@ -681,6 +1098,7 @@ void CGUITextLayout::AppendToUTF32(const std::string &utf8, character_t colStyle
 
 void CGUITextLayout::Reset()
 {
+  m_async.Abandon();
   m_lines.clear();
   m_lastText.clear();
   m_lastUtf8Text.clear();
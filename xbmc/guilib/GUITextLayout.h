@@ -21,6 +21,7 @@
  */
 
 
+#include <memory>
 #include <string>
 #include <stdint.h>
 #include <vector>
@@ -34,6 +35,7 @@
 
 class CGUIFont;
 class CScrollInfo;
+class CGUITextLayoutJob;
 
 // Process will be:
 
@@ -64,6 +66,8 @@ public:
 
 class CGUITextLayout
 {
+  friend class CGUITextLayoutJob;
+  friend class CGUITextLayoutCache;
 public:
   CGUITextLayout(CGUIFont *font, bool wrap, float fHeight=0.0f, CGUIFont *borderFont = NULL);  // this may need changing - we may just use this class to replace CLabelInfo completely
 
@@ -107,6 +111,19 @@ public:
   void SetWrap(bool bWrap=true);
   void SetMaxHeight(float fHeight);
 
+  /*! \brief Lay out changed text on a background job rather than in Update()
+   While the new layout is computed the previous one keeps being rendered. Update() and UpdateW()
+   return true once the new layout has been picked up, so they should keep being called every frame.
+   With DirectX, glyphs can't be cached off the render thread, so text is always laid out synchronously.
+   \param async true to lay out in the background, false (the default) to lay out synchronously.
+   */
+  void SetAsyncLayout(bool async);
+
+  /*! \brief Drop all cached layouts.
+   Must be called whenever font metrics change or fonts are destroyed.
+   */
+  static void FlushLayoutCache();
+
 
   static void DrawText(CGUIFont *font, float x, float y, color_t color, color_t shadowColor, const std::string &text, uint32_t align);
   static void Filter(std::string &text);
@@ -118,6 +135,8 @@ protected:
   static std::wstring BidiFlip(const std::wstring &text, bool forceLTRReadingOrder);
   void CalcTextExtent();
   void UpdateCommon(const std::wstring &text, float maxWidth, bool forceLTRReadingOrder);
+  float MeasureText(const vecText &text) const;
+  int GetMaxLines() const;
   
   /*! \brief Returns the text, utf8 encoded
    \return utf8 text
@@ -144,6 +163,35 @@ protected:
   float m_textWidth;
   float m_textHeight;
 private:
+  struct CLayoutKey;
+  struct CLayoutResult;
+  struct CAsyncState;
+  struct CJobMetrics;
+
+  /*! \brief Holder for the state shared with background layout jobs.
+   Copies of a layout don't share pending jobs, and destroying the holder abandons them.
+   */
+  class CAsyncHolder
+  {
+  public:
+    CAsyncHolder() = default;
+    CAsyncHolder(const CAsyncHolder &) {}
+    CAsyncHolder& operator=(const CAsyncHolder &) { Abandon(); return *this; }
+    ~CAsyncHolder() { Abandon(); }
+    void Abandon();
+    std::shared_ptr<CAsyncState> m_state;
+  };
+
+  bool UpdateCached(const CLayoutKey &key);
+  void StoreCached(const CLayoutKey &key);
+  bool AdoptAsyncLayout();
+  void QueueAsyncLayout(const CLayoutKey &key);
+  CLayoutKey MakeKey(const std::string &utf8, const std::wstring &utf16, bool isUtf16, float maxWidth, bool forceLTRReadingOrder) const;
+
+  bool m_asyncLayout;
+  CAsyncHolder m_async;
+  CJobMetrics *m_jobMetrics; ///< set on the private layout a background job computes with
+
   inline bool IsSpace(character_t letter) const XBMC_FORCE_INLINE
   {
     return (letter & 0xffff) == L' ';
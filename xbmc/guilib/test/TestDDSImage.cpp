@@ -0,0 +1,248 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "guilib/DDSImage.h"
+#include "guilib/XBTF.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+// smooth gradients with a few hard edges, in the XB_FMT_A8R8G8B8 byte order
+std::vector<unsigned char> MakeImage(unsigned int width, unsigned int height)
+{
+  std::vector<unsigned char> image(width * height * 4);
+  for (unsigned int y = 0; y < height; y++)
+  {
+    for (unsigned int x = 0; x < width; x++)
+    {
+      unsigned char *pixel = &image[(y * width + x) * 4];
+      pixel[0] = (unsigned char)((x + y) * 255 / (width + height));
+      pixel[1] = (unsigned char)(y * 255 / height);
+      pixel[2] = (unsigned char)(x * 255 / width);
+      pixel[3] = (unsigned char)(255 - x * 255 / width);
+      if ((x / 16 + y / 16) % 2)
+        pixel[2] = 255 - pixel[2];
+    }
+  }
+  return image;
+}
+
+void Expand565(uint16_t color, int *bgr)
+{
+  bgr[2] = ((color >> 11) & 31) * 255 / 31;
+  bgr[1] = ((color >> 5) & 63) * 255 / 63;
+  bgr[0] = (color & 31) * 255 / 31;
+}
+
+// reference decoder following the S3TC specification
+std::vector<unsigned char> Decompress(const CDDSImage &dds)
+{
+  const unsigned int width = dds.GetWidth();
+  const unsigned int height = dds.GetHeight();
+  const bool alpha = dds.GetFormat() == XB_FMT_DXT5;
+  const unsigned char *block = dds.GetData();
+
+  std::vector<unsigned char> image(width * height * 4);
+  for (unsigned int y = 0; y < height; y += 4)
+  {
+    for (unsigned int x = 0; x < width; x += 4)
+    {
+      int alphas[8] = { 255, 255, 255, 255, 255, 255, 255, 255 };
+      uint64_t alphaIndices = 0;
+      if (alpha)
+      {
+        alphas[0] = block[0];
+        alphas[1] = block[1];
+        if (alphas[0] > alphas[1])
+        {
+          for (int i = 1; i < 7; i++)
+            alphas[i + 1] = ((7 - i) * alphas[0] + i * alphas[1]) / 7;
+        }
+        else
+        {
+          for (int i = 1; i < 5; i++)
+            alphas[i + 1] = ((5 - i) * alphas[0] + i * alphas[1]) / 5;
+          alphas[6] = 0;
+          alphas[7] = 255;
+        }
+        for (int i = 0; i < 6; i++)
+          alphaIndices |= (uint64_t)block[2 + i] << (8 * i);
+        block += 8;
+      }
+
+      uint16_t color0 = block[0] | (block[1] << 8);
+      uint16_t color1 = block[2] | (block[3] << 8);
+      uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+      block += 8;
+
+      int palette[4][3];
+      Expand565(color0, palette[0]);
+      Expand565(color1, palette[1]);
+      for (int c = 0; c < 3; c++)
+      {
+        if (color0 > color1 || alpha)
+        {
+          palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+          palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        { // three colors and transparent black, an opaque image must never use it
+          palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+          palette[3][c] = 0;
+        }
+      }
+
+      for (unsigned int i = 0; i < 16; i++)
+      {
+        unsigned int px = x + i % 4, py = y + i / 4;
+        if (px >= width || py >= height)
+          continue;
+        unsigned char *pixel = &image[(py * width + px) * 4];
+        const int *color = palette[(indices >> (2 * i)) & 3];
+        pixel[0] = color[0];
+        pixel[1] = color[1];
+        pixel[2] = color[2];
+        pixel[3] = alphas[(alphaIndices >> (3 * i)) & 7];
+        if (!alpha && color0 <= color1 && ((indices >> (2 * i)) & 3) == 3)
+          pixel[3] = 0;
+      }
+    }
+  }
+  return image;
+}
+
+// largest and mean absolute difference of one channel
+void Compare(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, int channel, int &maxError, double &meanError)
+{
+  maxError = 0;
+  meanError = 0;
+  for (size_t i = channel; i < a.size(); i += 4)
+  {
+    int error = std::abs(a[i] - b[i]);
+    maxError = std::max(maxError, error);
+    meanError += error;
+  }
+  meanError /= a.size() / 4;
+}
+}
+
+TEST(TestDDSImage, DXT1RoundTrip)
+{
+  // not a multiple of the 4x4 block size
+  const unsigned int width = 67, height = 45;
+  std::vector<unsigned char> image = MakeImage(width, height);
+
+  CDDSImage dds;
+  ASSERT_TRUE(dds.Create(width, height, width * 4, image.data(), false));
+  EXPECT_EQ((unsigned int)XB_FMT_DXT1, dds.GetFormat());
+  EXPECT_EQ(width, dds.GetWidth());
+  EXPECT_EQ(height, dds.GetHeight());
+  EXPECT_EQ(17U * 12U * 8U, dds.GetSize());
+
+  std::vector<unsigned char> decoded = Decompress(dds);
+  for (int channel = 0; channel < 3; channel++)
+  {
+    int maxError;
+    double meanError;
+    Compare(image, decoded, channel, maxError, meanError);
+    EXPECT_LT(meanError, 4.0) << "channel " << channel;
+    EXPECT_LT(maxError, 64) << "channel " << channel;
+  }
+
+  // the alpha channel is dropped, and no pixel may come out transparent
+  for (size_t i = 3; i < decoded.size(); i += 4)
+    ASSERT_EQ(255, decoded[i]) << "pixel " << i / 4;
+}
+
+TEST(TestDDSImage, DXT5RoundTrip)
+{
+  const unsigned int width = 67, height = 45;
+  std::vector<unsigned char> image = MakeImage(width, height);
+
+  CDDSImage dds;
+  ASSERT_TRUE(dds.Create(width, height, width * 4, image.data(), true));
+  EXPECT_EQ((unsigned int)XB_FMT_DXT5, dds.GetFormat());
+  EXPECT_EQ(17U * 12U * 16U, dds.GetSize());
+
+  std::vector<unsigned char> decoded = Decompress(dds);
+  for (int channel = 0; channel < 4; channel++)
+  {
+    int maxError;
+    double meanError;
+    Compare(image, decoded, channel, maxError, meanError);
+    EXPECT_LT(meanError, 4.0) << "channel " << channel;
+    EXPECT_LT(maxError, 64) << "channel " << channel;
+  }
+}
+
+TEST(TestDDSImage, SolidColorIsExact)
+{
+  // both colors are exact in 565, with alpha at the ends of the range
+  const unsigned int width = 8, height = 8;
+  std::vector<unsigned char> image(width * height * 4);
+  for (unsigned int i = 0; i < width * height; i++)
+  {
+    image[i * 4 + 0] = i < 32 ? 255 : 0;
+    image[i * 4 + 1] = i < 32 ? 0 : 255;
+    image[i * 4 + 2] = 255;
+    image[i * 4 + 3] = i % 2 ? 255 : 0;
+  }
+
+  CDDSImage dxt1;
+  ASSERT_TRUE(dxt1.Create(width, height, width * 4, image.data(), false));
+  std::vector<unsigned char> decoded = Decompress(dxt1);
+  for (unsigned int i = 0; i < width * height * 4; i++)
+    EXPECT_EQ(i % 4 == 3 ? 255 : image[i], decoded[i]) << "byte " << i;
+
+  CDDSImage dxt5;
+  ASSERT_TRUE(dxt5.Create(width, height, width * 4, image.data(), true));
+  EXPECT_EQ(image, Decompress(dxt5));
+}
+
+TEST(TestDDSImage, WriteAndRead)
+{
+  const unsigned int width = 20, height = 12;
+  std::vector<unsigned char> image = MakeImage(width, height);
+  CDDSImage dds;
+  ASSERT_TRUE(dds.Create(width, height, width * 4, image.data(), true));
+
+  XFILE::CFile *file = XBMC_CREATETEMPFILE(".dds");
+  ASSERT_NE(nullptr, file);
+  std::string path = XBMC_TEMPFILEPATH(file);
+  file->Close();
+  EXPECT_TRUE(dds.WriteFile(path));
+
+  CDDSImage read;
+  EXPECT_TRUE(read.ReadFile(path));
+  EXPECT_EQ((unsigned int)XB_FMT_DXT5, read.GetFormat());
+  EXPECT_EQ(width, read.GetWidth());
+  EXPECT_EQ(height, read.GetHeight());
+  ASSERT_EQ(dds.GetSize(), read.GetSize());
+  EXPECT_EQ(0, memcmp(dds.GetData(), read.GetData(), dds.GetSize()));
+  EXPECT_TRUE(XBMC_DELETETEMPFILE(file));
+}
@@ -0,0 +1,205 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "guilib/FFmpegImage.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+class TestFFmpegImageHelper
+{
+public:
+  static bool ReadJpegHeader(const std::vector<unsigned char> &jpeg,
+                             unsigned int &width, unsigned int &height, unsigned int &orientation)
+  {
+    return CFFmpegImage::ReadJpegHeader(jpeg.data(), jpeg.size(), width, height, orientation);
+  }
+
+  static int GetLowres(unsigned int width, unsigned int height, unsigned int orientation,
+                       unsigned int maxWidth, unsigned int maxHeight)
+  {
+    return CFFmpegImage::GetLowres(width, height, orientation, maxWidth, maxHeight);
+  }
+};
+
+namespace
+{
+void Append16(std::vector<unsigned char> &data, unsigned int value, bool intel = false)
+{
+  if (intel)
+  {
+    data.push_back(value & 0xFF);
+    data.push_back(value >> 8);
+  }
+  else
+  {
+    data.push_back(value >> 8);
+    data.push_back(value & 0xFF);
+  }
+}
+
+void Append32(std::vector<unsigned char> &data, unsigned int value, bool intel)
+{
+  Append16(data, intel ? value & 0xFFFF : value >> 16, intel);
+  Append16(data, intel ? value >> 16 : value & 0xFFFF, intel);
+}
+
+// APP1 segment with an EXIF IFD holding a software tag followed by the orientation
+std::vector<unsigned char> MakeExif(unsigned int orientation, bool intel)
+{
+  std::vector<unsigned char> tiff;
+  tiff.push_back(intel ? 'I' : 'M');
+  tiff.push_back(intel ? 'I' : 'M');
+  Append16(tiff, 42, intel);
+  Append32(tiff, 8, intel);           // offset of the first IFD
+  Append16(tiff, 2, intel);           // entries
+  Append16(tiff, 0x0131, intel);      // software, ASCII, stored elsewhere
+  Append16(tiff, 2, intel);
+  Append32(tiff, 8, intel);
+  Append32(tiff, 0, intel);
+  Append16(tiff, 0x0112, intel);      // orientation, SHORT
+  Append16(tiff, 3, intel);
+  Append32(tiff, 1, intel);
+  Append16(tiff, orientation, intel);
+  Append16(tiff, 0, intel);
+  Append32(tiff, 0, intel);           // no next IFD
+
+  std::vector<unsigned char> segment = { 0xFF, 0xE1 };
+  Append16(segment, 2 + 6 + tiff.size());
+  const char exif[] = { 'E', 'x', 'i', 'f', 0, 0 };
+  segment.insert(segment.end(), exif, exif + sizeof(exif));
+  segment.insert(segment.end(), tiff.begin(), tiff.end());
+  return segment;
+}
+
+// baseline frame header of a three component image
+std::vector<unsigned char> MakeFrame(unsigned int width, unsigned int height)
+{
+  std::vector<unsigned char> segment = { 0xFF, 0xC0 };
+  Append16(segment, 17);
+  segment.push_back(8);
+  Append16(segment, height);
+  Append16(segment, width);
+  segment.push_back(3);
+  for (unsigned char component = 1; component <= 3; component++)
+  {
+    segment.push_back(component);
+    segment.push_back(component == 1 ? 0x22 : 0x11);
+    segment.push_back(component == 1 ? 0 : 1);
+  }
+  return segment;
+}
+
+std::vector<unsigned char> MakeJpeg(const std::vector<std::vector<unsigned char>> &segments)
+{
+  std::vector<unsigned char> jpeg = { 0xFF, 0xD8 };
+  for (const auto &segment : segments)
+    jpeg.insert(jpeg.end(), segment.begin(), segment.end());
+  // the start of scan, the decoder would take it from here
+  jpeg.insert(jpeg.end(), { 0xFF, 0xDA, 0x00, 0x02 });
+  return jpeg;
+}
+}
+
+TEST(TestFFmpegImage, ReadJpegHeader)
+{
+  unsigned int width, height, orientation;
+  EXPECT_TRUE(TestFFmpegImageHelper::ReadJpegHeader(MakeJpeg({ MakeFrame(4000, 2250) }), width, height, orientation));
+  EXPECT_EQ(4000U, width);
+  EXPECT_EQ(2250U, height);
+  EXPECT_EQ(0U, orientation);
+}
+
+TEST(TestFFmpegImage, ReadJpegHeaderExifByteOrder)
+{
+  for (bool intel : { true, false })
+  {
+    for (unsigned int rotated = 1; rotated <= 8; rotated++)
+    {
+      unsigned int width, height, orientation;
+      std::vector<unsigned char> jpeg = MakeJpeg({ MakeExif(rotated, intel), MakeFrame(640, 480) });
+      EXPECT_TRUE(TestFFmpegImageHelper::ReadJpegHeader(jpeg, width, height, orientation));
+      EXPECT_EQ(rotated, orientation) << (intel ? "II" : "MM");
+      // the frame size is as stored, whatever the orientation
+      EXPECT_EQ(640U, width);
+      EXPECT_EQ(480U, height);
+    }
+  }
+}
+
+TEST(TestFFmpegImage, ReadJpegHeaderTruncated)
+{
+  unsigned int width, height, orientation;
+  std::vector<unsigned char> jpeg = MakeJpeg({ MakeExif(6, true), MakeFrame(640, 480) });
+
+  // the file ends inside the APP1 segment, before the frame header
+  std::vector<unsigned char> truncated(jpeg.begin(), jpeg.begin() + 20);
+  EXPECT_FALSE(TestFFmpegImageHelper::ReadJpegHeader(truncated, width, height, orientation));
+  EXPECT_EQ(0U, orientation);
+
+  // the segment is complete but its IFD offset points past its end
+  std::vector<unsigned char> exif = MakeExif(6, false);
+  exif[2 + 2 + 6 + 6] = 0x04;
+  EXPECT_TRUE(TestFFmpegImageHelper::ReadJpegHeader(MakeJpeg({ exif, MakeFrame(640, 480) }), width, height, orientation));
+  EXPECT_EQ(0U, orientation);
+  EXPECT_EQ(640U, width);
+
+  // the frame header itself is cut short
+  std::vector<unsigned char> frame = MakeJpeg({ MakeFrame(640, 480) });
+  frame.resize(8);
+  EXPECT_FALSE(TestFFmpegImageHelper::ReadJpegHeader(frame, width, height, orientation));
+}
+
+TEST(TestFFmpegImage, ReadJpegHeaderNotJpeg)
+{
+  unsigned int width, height, orientation;
+  std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+  EXPECT_FALSE(TestFFmpegImageHelper::ReadJpegHeader(png, width, height, orientation));
+
+  // a scan before any frame header
+  EXPECT_FALSE(TestFFmpegImageHelper::ReadJpegHeader(MakeJpeg({}), width, height, orientation));
+}
+
+TEST(TestFFmpegImage, GetLowres)
+{
+  // 4000px fanart for a 1920px slot: 1/2 still covers it, 1/4 does not
+  EXPECT_EQ(1, TestFFmpegImageHelper::GetLowres(4000, 2250, 0, 1920, 1080));
+  // 1000px poster for a 300px thumb, scaled to 200x300: 1/4 is 250x375
+  EXPECT_EQ(2, TestFFmpegImageHelper::GetLowres(1000, 1500, 0, 300, 300));
+  // a square one is scaled to 300x300, 1/4 would be too small
+  EXPECT_EQ(1, TestFFmpegImageHelper::GetLowres(1000, 1000, 0, 300, 300));
+  // never more than 1/8
+  EXPECT_EQ(3, TestFFmpegImageHelper::GetLowres(8000, 8000, 0, 256, 256));
+  // no reduction when the image is no larger, or no size was asked for
+  EXPECT_EQ(0, TestFFmpegImageHelper::GetLowres(1920, 1080, 0, 1920, 1080));
+  EXPECT_EQ(0, TestFFmpegImageHelper::GetLowres(640, 480, 0, 1920, 1080));
+  EXPECT_EQ(0, TestFFmpegImageHelper::GetLowres(4000, 2250, 0, 0, 0));
+}
+
+TEST(TestFFmpegImage, GetLowresRotated)
+{
+  // stored as 4000x2000, shown as 2000x4000 in a 500x1000 slot
+  for (unsigned int orientation = 5; orientation <= 8; orientation++)
+    EXPECT_EQ(2, TestFFmpegImageHelper::GetLowres(4000, 2000, orientation, 500, 1000)) << orientation;
+  // not rotated, the same file would fill only 500x250 of it
+  for (unsigned int orientation = 0; orientation <= 4; orientation++)
+    EXPECT_EQ(3, TestFFmpegImageHelper::GetLowres(4000, 2000, orientation, 500, 1000)) << orientation;
+}
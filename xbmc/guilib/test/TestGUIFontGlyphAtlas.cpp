@@ -0,0 +1,154 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "guilib/GUIFontGlyphAtlas.h"
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+namespace
+{
+std::vector<unsigned char> MakeBitmap(unsigned int width, unsigned int rows, unsigned int pitch, unsigned char seed)
+{
+  std::vector<unsigned char> bitmap(pitch * rows, 0xff);
+  for (unsigned int y = 0; y < rows; y++)
+    for (unsigned int x = 0; x < width; x++)
+      bitmap[y * pitch + x] = (unsigned char)(seed + y * width + x);
+  return bitmap;
+}
+
+bool StoreBitmap(CGUIFontGlyphAtlas &atlas, const std::string &face, uint32_t letter, unsigned int size)
+{
+  std::vector<unsigned char> bitmap = MakeBitmap(size, size, size, (unsigned char)letter);
+  return atlas.Store(face, letter, bitmap.data(), size, size, size, 0, 0, 0);
+}
+}
+
+TEST(TestGUIFontGlyphAtlas, StoreAndLookup)
+{
+  CGUIFontGlyphAtlas atlas;
+  // pitch wider than the glyph, the padding must not end up in the atlas
+  std::vector<unsigned char> bitmap = MakeBitmap(5, 7, 8, 10);
+  EXPECT_TRUE(atlas.Store("face", 'A', bitmap.data(), 5, 7, 8, 1, 6, 320));
+
+  CGUIFontGlyphAtlas::Glyph glyph;
+  std::vector<unsigned char> pixels;
+  ASSERT_TRUE(atlas.Lookup("face", 'A', glyph, pixels));
+  EXPECT_EQ(5U, glyph.width);
+  EXPECT_EQ(7U, glyph.rows);
+  EXPECT_EQ(1, glyph.left);
+  EXPECT_EQ(6, glyph.top);
+  EXPECT_EQ(320, glyph.advance);
+  EXPECT_EQ(MakeBitmap(5, 7, 5, 10), pixels);
+  EXPECT_EQ(1U, atlas.GetPageCount());
+}
+
+TEST(TestGUIFontGlyphAtlas, KeyedByFaceAndStyle)
+{
+  CGUIFontGlyphAtlas atlas;
+  EXPECT_TRUE(StoreBitmap(atlas, "face", 'A', 4));
+
+  CGUIFontGlyphAtlas::Glyph glyph;
+  std::vector<unsigned char> pixels;
+  EXPECT_FALSE(atlas.Lookup("other", 'A', glyph, pixels));
+  EXPECT_FALSE(atlas.Lookup("face", 'A' | (1 << 16), glyph, pixels));
+  EXPECT_FALSE(atlas.Lookup("face", 'B', glyph, pixels));
+  EXPECT_TRUE(atlas.Lookup("face", 'A', glyph, pixels));
+}
+
+TEST(TestGUIFontGlyphAtlas, FirstStoreWins)
+{
+  CGUIFontGlyphAtlas atlas;
+  std::vector<unsigned char> first = MakeBitmap(3, 3, 3, 1);
+  std::vector<unsigned char> second = MakeBitmap(3, 3, 3, 100);
+  EXPECT_TRUE(atlas.Store("face", 'A', first.data(), 3, 3, 3, 0, 0, 64));
+  EXPECT_TRUE(atlas.Store("face", 'A', second.data(), 3, 3, 3, 0, 0, 128));
+
+  CGUIFontGlyphAtlas::Glyph glyph;
+  std::vector<unsigned char> pixels;
+  ASSERT_TRUE(atlas.Lookup("face", 'A', glyph, pixels));
+  EXPECT_EQ(64, glyph.advance);
+  EXPECT_EQ(first, pixels);
+}
+
+TEST(TestGUIFontGlyphAtlas, EmptyGlyphTakesNoPage)
+{
+  CGUIFontGlyphAtlas atlas;
+  EXPECT_TRUE(atlas.Store("face", ' ', NULL, 0, 0, 0, 0, 0, 256));
+  EXPECT_EQ(0U, atlas.GetPageCount());
+
+  CGUIFontGlyphAtlas::Glyph glyph;
+  std::vector<unsigned char> pixels;
+  ASSERT_TRUE(atlas.Lookup("face", ' ', glyph, pixels));
+  EXPECT_EQ(0U, glyph.width);
+  EXPECT_EQ(256, glyph.advance);
+  EXPECT_TRUE(pixels.empty());
+}
+
+TEST(TestGUIFontGlyphAtlas, RejectsOversizedGlyph)
+{
+  CGUIFontGlyphAtlas atlas;
+  EXPECT_FALSE(StoreBitmap(atlas, "face", 'A', CGUIFontGlyphAtlas::PAGE_SIZE + 1));
+
+  CGUIFontGlyphAtlas::Glyph glyph;
+  std::vector<unsigned char> pixels;
+  EXPECT_FALSE(atlas.Lookup("face", 'A', glyph, pixels));
+  EXPECT_EQ(0U, atlas.GetPageCount());
+}
+
+TEST(TestGUIFontGlyphAtlas, RecyclesLeastRecentlyUsedPage)
+{
+  CGUIFontGlyphAtlas atlas;
+  // four glyphs of half the page size fill a page
+  const unsigned int size = CGUIFontGlyphAtlas::PAGE_SIZE / 2;
+  const unsigned int maxPages = CGUIFontGlyphAtlas::MAX_PAGES;
+  const uint32_t glyphs = maxPages * 4;
+  for (uint32_t letter = 0; letter < glyphs; letter++)
+    ASSERT_TRUE(StoreBitmap(atlas, "face", letter, size));
+  EXPECT_EQ(maxPages, atlas.GetPageCount());
+
+  // using a glyph of the first page makes the second page the oldest
+  CGUIFontGlyphAtlas::Glyph glyph;
+  std::vector<unsigned char> pixels;
+  EXPECT_TRUE(atlas.Lookup("face", 0, glyph, pixels));
+
+  EXPECT_TRUE(StoreBitmap(atlas, "face", glyphs, size));
+  EXPECT_EQ(maxPages, atlas.GetPageCount());
+
+  for (uint32_t letter = 4; letter < 8; letter++)
+    EXPECT_FALSE(atlas.Lookup("face", letter, glyph, pixels));
+  for (uint32_t letter = 0; letter < 4; letter++)
+    EXPECT_TRUE(atlas.Lookup("face", letter, glyph, pixels));
+  ASSERT_TRUE(atlas.Lookup("face", glyphs, glyph, pixels));
+  EXPECT_EQ(MakeBitmap(size, size, size, (unsigned char)glyphs), pixels);
+}
+
+TEST(TestGUIFontGlyphAtlas, Clear)
+{
+  CGUIFontGlyphAtlas atlas;
+  EXPECT_TRUE(StoreBitmap(atlas, "face", 'A', 8));
+  atlas.Clear();
+
+  CGUIFontGlyphAtlas::Glyph glyph;
+  std::vector<unsigned char> pixels;
+  EXPECT_FALSE(atlas.Lookup("face", 'A', glyph, pixels));
+  EXPECT_EQ(0U, atlas.GetPageCount());
+}
@@ -1737,6 +1737,11 @@ JSONRPC_STATUS CPlayerOperations::GetPropertyValue(PlayerType player, const std:
   }
   else if (property == "live")
     result = IsPVRChannel();
+  else if (property == "playbackstats")
+  {
+    if (player != Video || !g_application.m_pPlayer->GetPlaybackStats(result))
+      result = CVariant(CVariant::VariantTypeNull);
+  }
   else
     return InvalidParams;
 
@@ -20,6 +20,7 @@
 
 #include "XBMCOperations.h"
 #include "messaging/ApplicationMessenger.h"
+#include "utils/JobManager.h"
 #include "utils/Variant.h"
 #include "powermanagement/PowerManager.h"
 
@@ -95,3 +96,9 @@ JSONRPC_STATUS CXBMCOperations::GetInfoBooleans(const std::string &method, ITran
 
   return OK;
 }
+
+JSONRPC_STATUS CXBMCOperations::GetJobStatistics(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CJobManager::GetInstance().GetStats(result);
+  return OK;
+}
@@ -25,10 +25,11 @@
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 
+#include <cstdlib>
+
 #ifdef TARGET_WINDOWS
 #include <windows.h>
 #else
-#include <cstdlib>
 #include <climits>
 #include <ctime>
 #endif
@@ -357,3 +358,11 @@ std::string CXBMCTestUtils::getNewLineCharacters() const
   return "\n";
 #endif
 }
+
+std::string CXBMCTestUtils::getBenchmarkOption(const char *name, std::string const& defaultValue) const
+{
+  const char *value = getenv(name);
+  if (!value || !*value)
+    return defaultValue;
+  return value;
+}
@@ -90,6 +90,13 @@ public:
 
   /* Function to return the newline characters for this platform */
   std::string getNewLineCharacters() const;
+
+  /* Function to get the option of a benchmark, the value of the environment
+   * variable 'name' or 'defaultValue' if it is not set. Benchmarks are named
+   * DISABLED_Benchmark so they are left out of the default run, run them with
+   * --gtest_also_run_disabled_tests.
+   */
+  std::string getBenchmarkOption(const char *name, std::string const& defaultValue) const;
 private:
   CXBMCTestUtils();
   CXBMCTestUtils(CXBMCTestUtils const&);
@@ -111,3 +118,5 @@ private:
 #define XBMC_TEMPFILEPATH(a) CXBMCTestUtils::Instance().TempFilePath(a)
 #define XBMC_CREATECORRUPTEDFILE(a, b) \
   CXBMCTestUtils::Instance().CreateCorruptedFile(a, b)
+#define XBMC_BENCHMARK_OPTION(a, b) \
+  CXBMCTestUtils::Instance().getBenchmarkOption(a, b)
@@ -19,6 +19,11 @@
  */
 
 #include "ActorProtocol.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/TimeUtils.h"
+
+#include <inttypes.h>
 
 using namespace Actor;
 
@@ -37,9 +42,8 @@ void Message::Release()
   if (data != buffer)
     delete [] data;
 
-  // delete event in case of sync message
-  if (event)
-    delete event;
+  // the event of a sync message stays with the message for the next one
+  event = NULL;
 
   origin->ReturnMessage(this);
 }
@@ -69,6 +73,7 @@ bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
       else
         msg->data = msg->buffer;
       memcpy(msg->data, data, size);
+      msg->payloadSize = size;
     }
   }
 
@@ -80,31 +85,108 @@ bool Message::Reply(int sig, void *data /* = NULL*/, int size /* = 0 */)
   return true;
 }
 
+MessageRing::MessageRing(unsigned int size)
+{
+  size_t capacity = 2;
+  while (capacity < size)
+    capacity <<= 1;
+
+  m_cells.reset(new Cell[capacity]);
+  for (size_t i = 0; i < capacity; i++)
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  m_mask = capacity - 1;
+  m_enqueue.store(0, std::memory_order_relaxed);
+  m_dequeue.store(0, std::memory_order_relaxed);
+}
+
+bool MessageRing::Push(Message *msg)
+{
+  Cell *cell;
+  size_t pos = m_enqueue.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    cell = &m_cells[pos & m_mask];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+    if (dif == 0)
+    {
+      if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (dif < 0)
+      return false; // full
+    else
+      pos = m_enqueue.load(std::memory_order_relaxed);
+  }
+
+  cell->msg = msg;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool MessageRing::Pop(Message **msg)
+{
+  Cell *cell;
+  size_t pos = m_dequeue.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    cell = &m_cells[pos & m_mask];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (dif == 0)
+    {
+      if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (dif < 0)
+      return false; // empty
+    else
+      pos = m_dequeue.load(std::memory_order_relaxed);
+  }
+
+  *msg = cell->msg;
+  cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+  return true;
+}
+
+Protocol::Protocol(std::string name, CEvent* inEvent, CEvent *outEvent)
+  : portName(name)
+  , containerInEvent(inEvent)
+  , containerOutEvent(outEvent)
+  , freeMessages(MSG_POOL_MAX)
+  , allocatedMessages(MSG_POOL_SIZE)
+  , inDefered(false)
+  , outDefered(false)
+{
+  for (int i = 0; i < MSG_POOL_SIZE; i++)
+    freeMessages.Push(new Message());
+}
+
 Protocol::~Protocol()
 {
   Message *msg;
   Purge();
-  while (!freeMessageQueue.empty())
-  {
-    msg = freeMessageQueue.front();
-    freeMessageQueue.pop();
+  while (freeMessages.Pop(&msg))
     delete msg;
-  }
+
+  ProtocolStats in = GetInStats();
+  ProtocolStats out = GetOutStats();
+  CLog::Log(LOGDEBUG, "Protocol::%s - %s: %d messages allocated, in: %" PRIu64 " messages avg %" PRId64 " us max %" PRId64 " us %" PRIu64 " overflows"
+            ", out: %" PRIu64 " messages avg %" PRId64 " us max %" PRId64 " us %" PRIu64 " overflows", __FUNCTION__,
+            portName.c_str(), allocatedMessages.load(),
+            in.messages, in.avgLatency, in.maxLatency, in.overflows,
+            out.messages, out.avgLatency, out.maxLatency, out.overflows);
 }
 
 Message *Protocol::GetMessage()
 {
   Message *msg;
 
-  CSingleLock lock(criticalSection);
-
-  if (!freeMessageQueue.empty())
+  if (!freeMessages.Pop(&msg))
   {
-    msg = freeMessageQueue.front();
-    freeMessageQueue.pop();
-  }
-  else
     msg = new Message();
+    allocatedMessages++;
+  }
 
   msg->isSync = false;
   msg->isSyncFini = false;
@@ -120,9 +202,70 @@ Message *Protocol::GetMessage()
 
 void Protocol::ReturnMessage(Message *msg)
 {
+  if (!freeMessages.Push(msg))
+  {
+    delete msg;
+    allocatedMessages--;
+  }
+}
+
+void Protocol::Send(Port &port, Message *msg)
+{
+  msg->sendTime = CurrentHostCounter();
+
+  // once a message went to the overflow queue the following ones have to queue up behind it
+  if (port.overflowCount.load() == 0 && port.ring.Push(msg))
+    return;
+
   CSingleLock lock(criticalSection);
+  port.overflow.push(msg);
+  port.overflowCount++;
+  port.overflows.fetch_add(1, std::memory_order_relaxed);
+}
 
-  freeMessageQueue.push(msg);
+bool Protocol::Receive(Port &port, Message **msg)
+{
+  if (!port.pending.empty())
+  {
+    *msg = port.pending.front();
+    port.pending.pop_front();
+  }
+  else if (!port.ring.Pop(msg))
+  {
+    if (port.overflowCount.load() == 0)
+      return false;
+
+    // a sender may have filled the ring right before switching to the overflow queue
+    CSingleLock lock(criticalSection);
+    if (!port.ring.Pop(msg))
+    {
+      if (port.overflow.empty())
+        return false;
+      *msg = port.overflow.front();
+      port.overflow.pop();
+      port.overflowCount--;
+    }
+  }
+
+  // only the receiving thread updates the counters
+  int64_t latency = CurrentHostCounter() - (*msg)->sendTime;
+  port.messages.store(port.messages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  port.totalLatency.store(port.totalLatency.load(std::memory_order_relaxed) + latency, std::memory_order_relaxed);
+  if (latency > port.maxLatency.load(std::memory_order_relaxed))
+    port.maxLatency.store(latency, std::memory_order_relaxed);
+
+  return true;
+}
+
+ProtocolStats Protocol::GetStats(const Port &port) const
+{
+  ProtocolStats stats;
+  int64_t freq = CurrentHostFrequency();
+  stats.messages = port.messages.load(std::memory_order_relaxed);
+  stats.overflows = port.overflows.load(std::memory_order_relaxed);
+  stats.avgLatency = stats.messages ? port.totalLatency.load(std::memory_order_relaxed) / (int64_t)stats.messages * 1000000 / freq : 0;
+  stats.maxLatency = port.maxLatency.load(std::memory_order_relaxed) * 1000000 / freq;
+  return stats;
 }
 
 bool Protocol::SendOutMessage(int signal, void *data /* = NULL */, int size /* = 0 */, Message *outMsg /* = NULL */)
@@ -143,11 +286,10 @@ bool Protocol::SendOutMessage(int signal, void *data /* = NULL */, int size /* =
     else
       msg->data = msg->buffer;
     memcpy(msg->data, data, size);
+    msg->payloadSize = size;
   }
 
-  { CSingleLock lock(criticalSection);
-    outMessages.push(msg);
-  }
+  Send(outMessages, msg);
   containerOutEvent->Set();
 
   return true;
@@ -171,11 +313,10 @@ bool Protocol::SendInMessage(int signal, void *data /* = NULL */, int size /* =
     else
       msg->data = msg->buffer;
     memcpy(msg->data, data, size);
+    msg->payloadSize = size;
   }
 
-  { CSingleLock lock(criticalSection);
-    inMessages.push(msg);
-  }
+  Send(inMessages, msg);
   containerInEvent->Set();
 
   return true;
@@ -187,7 +328,9 @@ bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, voi
   Message *msg = GetMessage();
   msg->isOut = true;
   msg->isSync = true;
-  msg->event = new CEvent;
+  if (!msg->syncEvent)
+    msg->syncEvent = new CEvent;
+  msg->event = msg->syncEvent;
   msg->event->Reset();
   SendOutMessage(signal, data, size, msg);
 
@@ -216,28 +359,18 @@ bool Protocol::SendOutMessageSync(int signal, Message **retMsg, int timeout, voi
 
 bool Protocol::ReceiveOutMessage(Message **msg)
 {
-  CSingleLock lock(criticalSection);
-
-  if (outMessages.empty() || outDefered)
+  if (outDefered)
     return false;
 
-  *msg = outMessages.front();
-  outMessages.pop();
-
-  return true;
+  return Receive(outMessages, msg);
 }
 
 bool Protocol::ReceiveInMessage(Message **msg)
 {
-  CSingleLock lock(criticalSection);
-
-  if (inMessages.empty() || inDefered)
+  if (inDefered)
     return false;
 
-  *msg = inMessages.front();
-  inMessages.pop();
-
-  return true;
+  return Receive(inMessages, msg);
 }
 
 
@@ -252,46 +385,42 @@ void Protocol::Purge()
     msg->Release();
 }
 
-void Protocol::PurgeIn(int signal)
+void Protocol::PurgePort(Port &port, int signal)
 {
   Message *msg;
-  std::queue<Message*> msgs;
-
-  CSingleLock lock(criticalSection);
 
-  while (!inMessages.empty())
+  // everything sent so far moves to pending, later messages queue up behind it
   {
-    msg = inMessages.front();
-    inMessages.pop();
-    if (msg->signal != signal)
-      msgs.push(msg);
+    CSingleLock lock(criticalSection);
+    while (port.ring.Pop(&msg))
+      port.pending.push_back(msg);
+    while (!port.overflow.empty())
+    {
+      port.pending.push_back(port.overflow.front());
+      port.overflow.pop();
+    }
+    port.overflowCount = 0;
   }
-  while (!msgs.empty())
+
+  for (std::deque<Message*>::iterator it = port.pending.begin(); it != port.pending.end();)
   {
-    msg = msgs.front();
-    msgs.pop();
-    inMessages.push(msg);
+    msg = *it;
+    if (msg->signal == signal)
+    {
+      it = port.pending.erase(it);
+      msg->Release();
+    }
+    else
+      ++it;
   }
 }
 
-void Protocol::PurgeOut(int signal)
+void Protocol::PurgeIn(int signal)
 {
-  Message *msg;
-  std::queue<Message*> msgs;
-
-  CSingleLock lock(criticalSection);
+  PurgePort(inMessages, signal);
+}
 
-  while (!outMessages.empty())
-  {
-    msg = outMessages.front();
-    outMessages.pop();
-    if (msg->signal != signal)
-      msgs.push(msg);
-  }
-  while (!msgs.empty())
-  {
-    msg = msgs.front();
-    msgs.pop();
-    outMessages.push(msg);
-  }
+void Protocol::PurgeOut(int signal)
+{
+  PurgePort(outMessages, signal);
 }
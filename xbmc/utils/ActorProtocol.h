@@ -21,10 +21,19 @@
 #pragma once
 
 #include "threads/Thread.h"
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <queue>
 #include "memory.h"
 
-#define MSG_INTERNAL_BUFFER_SIZE 32
+// payloads up to this size are copied into the message itself
+#define MSG_INTERNAL_BUFFER_SIZE 512
+// messages allocated with every port and the most a port keeps for reuse
+#define MSG_POOL_SIZE 32
+#define MSG_POOL_MAX 256
+// messages one direction of a port can hold before senders fall back to a locked queue
+#define MSG_PORT_SIZE 256
 
 namespace Actor
 {
@@ -51,14 +60,57 @@ public:
   bool Reply(int sig, void *data = NULL, int size = 0);
 
 private:
-  Message() {isSync = false; data = NULL; event = NULL; replyMessage = NULL;};
+  Message() {isSync = false; data = NULL; event = NULL; replyMessage = NULL; syncEvent = NULL; sendTime = 0;};
+  ~Message() {delete syncEvent;};
+  CEvent *syncEvent;
+  int64_t sendTime;
+};
+
+/*!
+ \brief Bounded lock-free queue of messages
+
+ Any number of threads may push and pop concurrently (D. Vyukov's bounded
+ queue), every slot carries a sequence number telling whether it is ready to
+ be written or read, so neither side ever takes a lock or allocates.
+ */
+class MessageRing
+{
+public:
+  /*!
+   \param size capacity, rounded up to a power of two
+   */
+  explicit MessageRing(unsigned int size);
+  bool Push(Message *msg);
+  bool Pop(Message **msg);
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    Message *msg;
+  };
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask;
+  // producers and consumer work on different cache lines
+  alignas(64) std::atomic<size_t> m_enqueue;
+  alignas(64) std::atomic<size_t> m_dequeue;
+};
+
+/*!
+ \brief Time messages of one direction of a port spent queued
+ */
+struct ProtocolStats
+{
+  uint64_t messages;
+  uint64_t overflows;
+  int64_t avgLatency; // us
+  int64_t maxLatency; // us
 };
 
 class Protocol
 {
 public:
-  Protocol(std::string name, CEvent* inEvent, CEvent *outEvent)
-    : portName(name), inDefered(false), outDefered(false) {containerInEvent = inEvent; containerOutEvent = outEvent;};
+  Protocol(std::string name, CEvent* inEvent, CEvent *outEvent);
   virtual ~Protocol();
   Message *GetMessage();
   void ReturnMessage(Message *msg);
@@ -74,14 +126,43 @@ public:
   void DeferOut(bool value) {outDefered = value;};
   void Lock() {criticalSection.lock();};
   void Unlock() {criticalSection.unlock();};
+  ProtocolStats GetInStats() const {return GetStats(inMessages);};
+  ProtocolStats GetOutStats() const {return GetStats(outMessages);};
   std::string portName;
 
 protected:
+  /*!
+   \brief One direction of the port, any thread sends, only the owning actor receives
+
+   Messages go through the lock-free ring. When a burst fills it senders
+   don't block, they append to the overflow queue under the lock, and keep
+   doing so until the receiver has drained it, which keeps every sender's
+   messages in order. Messages the receiver took out of the ring but didn't
+   hand out yet (purging) wait in pending.
+   */
+  struct Port
+  {
+    Port() : ring(MSG_PORT_SIZE), overflowCount(0), messages(0), overflows(0), totalLatency(0), maxLatency(0) {};
+    MessageRing ring;
+    std::queue<Message*> overflow;
+    std::atomic<int> overflowCount;
+    std::deque<Message*> pending;
+    std::atomic<uint64_t> messages;
+    std::atomic<uint64_t> overflows;
+    std::atomic<int64_t> totalLatency;
+    std::atomic<int64_t> maxLatency;
+  };
+  void Send(Port &port, Message *msg);
+  bool Receive(Port &port, Message **msg);
+  void PurgePort(Port &port, int signal);
+  ProtocolStats GetStats(const Port &port) const;
+
   CEvent *containerInEvent, *containerOutEvent;
   CCriticalSection criticalSection;
-  std::queue<Message*> outMessages;
-  std::queue<Message*> inMessages;
-  std::queue<Message*> freeMessageQueue;
+  Port outMessages;
+  Port inMessages;
+  MessageRing freeMessages;
+  std::atomic<int> allocatedMessages;
   bool inDefered, outDefered;
 };
 
@@ -0,0 +1,61 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AsyncJob.h"
+#include "JobManager.h"
+#include "threads/SingleLock.h"
+
+CAsyncJob::CAsyncJob()
+  : m_state(STATE_RUNNING),
+    m_blocking(false)
+{
+}
+
+bool CAsyncJob::DoWork()
+{
+  m_blocking = true;
+  while (true)
+  {
+    STATUS status = Resume();
+    if (status != SUSPENDED)
+      return status == SUCCEEDED;
+    m_woken.Wait();
+    // the job may be gone once we return, wait until Wake() is done with it
+    CSingleLock lock(m_wakeSection);
+  }
+}
+
+void CAsyncJob::Wake()
+{
+  if (m_blocking)
+  {
+    CSingleLock lock(m_wakeSection);
+    m_woken.Set();
+    return;
+  }
+
+  // the worker still busy with the job resumes it right away
+  int state = STATE_RUNNING;
+  if (m_state.compare_exchange_strong(state, STATE_WOKEN))
+    return;
+
+  m_state = STATE_RUNNING;
+  CJobManager::GetInstance().ResumeJob(this);
+}
@@ -0,0 +1,92 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Job.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+
+#include <atomic>
+
+/*!
+ \ingroup jobs
+ \brief Base class for jobs that wait for I/O without blocking a worker.
+
+ Subclasses implement Resume() instead of DoWork(). When the job has to wait, it starts the I/O,
+ e.g. a XFILE::CCurlTransfer, and returns SUSPENDED. Whatever does the I/O calls Wake() once it
+ is done, and the CJobManager calls Resume() again, possibly on another worker, to go on from
+ where the job left off. The worker is free for other jobs in the meantime. A job waits for one
+ thing at a time, and Wake() is called once for every time the job was suspended.
+
+ Jobs that are run directly through DoWork() block while they wait, so an async job works
+ wherever a CJob does.
+
+ \sa CJobManager, XFILE::CCurlTransfer
+ */
+class CAsyncJob : public CJob
+{
+public:
+  enum STATUS
+  {
+    FAILED = 0,
+    SUCCEEDED,
+    SUSPENDED  // waiting for Wake()
+  };
+
+  CAsyncJob();
+  ~CAsyncJob() override {}
+
+  /*!
+   \brief Run the job in the calling thread, blocking while it waits.
+   */
+  bool DoWork() override;
+
+  /*!
+   \brief Do the work until the job is done or has to wait.
+   \return SUSPENDED if the job waits for Wake() to be resumed, else whether the job succeeded
+   */
+  virtual STATUS Resume() = 0;
+
+  /*!
+   \brief Called when the job is cancelled while it waits. The job should stop its I/O early,
+   Wake() still has to be called. Must not block.
+   */
+  virtual void Abort() {}
+
+  /*!
+   \brief Resume the job once what it waits for is done. May be called from any thread.
+   */
+  void Wake();
+
+private:
+  friend class CJobManager;
+
+  enum STATE
+  {
+    STATE_RUNNING = 0,
+    STATE_WOKEN,     // woken before the worker was done suspending it
+    STATE_SUSPENDED
+  };
+
+  std::atomic<int> m_state;
+  bool   m_blocking;  // run through DoWork()
+  CEvent m_woken;
+  CCriticalSection m_wakeSection; // held by Wake() while it sets m_woken
+};
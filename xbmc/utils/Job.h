@@ -22,6 +22,7 @@
 class CJob;
 
 #include <stddef.h>
+#include <string>
 
 #define kJobTypeMediaFlags  "mediaflags"
 #define kJobTypeCacheImage  "cacheimage"
@@ -112,7 +113,7 @@ public:
     PRIORITY_HIGH,
     PRIORITY_DEDICATED, // will create a new worker if no worker is available at queue time
   };
-  CJob() { m_callback = NULL; };
+  CJob() { m_callback = NULL; m_affinity = 0; };
 
   /*!
    \brief Destructor for job objects.
@@ -165,7 +166,34 @@ public:
    \sa IJobCallback::OnJobProgress()
    */
   virtual bool ShouldCancel(unsigned int progress, unsigned int total) const;
+
+  /*!
+   \brief Hint that this job works on the same data as other jobs with the same affinity.
+
+   Jobs with the same non-zero affinity are queued for the same worker thread, which keeps
+   their data in the cache of the core it runs on. Idle workers may still take them over.
+   Must be set before the job is added to the CJobManager.
+
+   \param affinity any value identifying the data, 0 for none
+   */
+  void SetAffinity(unsigned int affinity) { m_affinity = affinity; }
+  unsigned int GetAffinity() const { return m_affinity; }
+
+  /*!
+   \brief The resource this job does its I/O on, e.g. the server the files it reads are on.
+
+   Only a limited number of jobs of the same resource are processed at once, jobs of other
+   resources are processed while the rest wait for their turn. Must be set before the job is
+   added to the CJobManager.
+
+   \param resource any string identifying the resource, empty for none
+   \sa CJobManager::GetResource(), CJobManager::SetResourceLimit()
+   */
+  void SetResource(const std::string &resource) { m_resource = resource; }
+  const std::string& GetResource() const { return m_resource; }
 private:
   friend class CJobManager;
   CJobManager *m_callback;
+  unsigned int m_affinity;
+  std::string  m_resource;
 };
@@ -19,10 +19,23 @@
  */
 
 #include "JobManager.h"
+#include "AsyncJob.h"
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <inttypes.h>
 #include <stdexcept>
+#include "URL.h"
+#include "filesystem/SpecialProtocol.h"
+#include "filesystem/StackDirectory.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "threads/ThreadLocal.h"
+#include "utils/CPUInfo.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/Variant.h"
 #include "utils/log.h"
 #ifdef TARGET_POSIX
 #include "linux/XTimeUtils.h"
@@ -30,6 +43,10 @@
 
 #include "system.h"
 
+#define MIN_WORKERS 5
+#define STATS_LOG_INTERVAL 60000 // ms between the summaries in the log
+#define DEFAULT_RESOURCE_LIMIT 2  // jobs of a resource processed at once
+
 bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
 {
   if (m_callback)
@@ -37,9 +54,45 @@ bool CJob::ShouldCancel(unsigned int progress, unsigned int total) const
   return false;
 }
 
-CJobWorker::CJobWorker(CJobManager *manager) : CThread("JobWorker")
+namespace
+{
+// the worker running on this thread, if any
+XbmcThreads::ThreadLocal<CJobWorker> currentWorker;
+
+// upper bounds of the histogram buckets, the last bucket takes everything above
+const int64_t statsBounds[] = { 1000, 5000, 20000, 100000, 500000, 2000000, 10000000, 60000000 }; // usec
+
+const char* priorityNames[] = { "lowpausable", "low", "normal", "high", "dedicated" };
+
+int64_t ElapsedUsec(int64_t start, int64_t end)
+{
+  if (!start || end < start)
+    return 0;
+  return (end - start) * 1000000 / CurrentHostFrequency();
+}
+
+std::string TypeName(const CJob *job)
+{
+  std::string type = job->GetType();
+  return type.empty() ? "unknown" : type;
+}
+
+CVariant TimeStatsToVariant(uint64_t count, int64_t total, int64_t max, const unsigned int *buckets, int size)
+{
+  CVariant value(CVariant::VariantTypeObject);
+  value["average"] = count ? total / (int64_t)count : 0;
+  value["max"] = max;
+  value["histogram"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = 0; i < size; i++)
+    value["histogram"].push_back(buckets[i]);
+  return value;
+}
+}
+
+CJobWorker::CJobWorker(CJobManager *manager, int index) : CThread("JobWorker")
 {
   m_jobManager = manager;
+  m_index = index;
   Create(true); // start work immediately, and kill ourselves when we're done
 }
 
@@ -56,6 +109,7 @@ CJobWorker::~CJobWorker()
 void CJobWorker::Process()
 {
   SetPriority( GetMinPriority() );
+  currentWorker.set(this);
   while (true)
   {
     // request an item from our manager (this call is blocking)
@@ -66,14 +120,27 @@ void CJobWorker::Process()
     bool success = false;
     try
     {
-      success = job->DoWork();
+      CAsyncJob *async = dynamic_cast<CAsyncJob*>(job);
+      if (async)
+      {
+        CAsyncJob::STATUS status = async->Resume();
+        if (status == CAsyncJob::SUSPENDED)
+        {
+          m_jobManager->OnJobSuspended(this, async);
+          continue;
+        }
+        success = status == CAsyncJob::SUCCEEDED;
+      }
+      else
+        success = job->DoWork();
     }
     catch (...)
     {
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, job->GetType());
     }
-    m_jobManager->OnJobComplete(success, job);
+    m_jobManager->OnJobComplete(this, success, job);
   }
+  currentWorker.set(NULL);
 }
 
 void CJobQueue::CJobPointer::CancelJob()
@@ -147,6 +214,9 @@ void CJobQueue::QueueNextJob()
   if (m_jobQueue.size() && m_processing.size() < m_jobsAtOnce)
   {
     CJobPointer &job = m_jobQueue.back();
+    // jobs of a queue usually work on related data, keep them on one worker
+    if (!job.m_job->GetAffinity())
+      job.m_job->SetAffinity(std::hash<const CJobQueue*>()(this));
     job.m_id = CJobManager::GetInstance().AddJob(job.m_job, this, m_priority);
     m_processing.push_back(job);
     m_jobQueue.pop_back();
@@ -184,6 +254,18 @@ CJobManager::CJobManager()
   m_jobCounter = 0;
   m_running = true;
   m_pauseJobs = false;
+  m_nextQueue = 0;
+  m_processingCount = 0;
+  m_workersStarted = false;
+  m_idle = 0;
+  m_lastStatsLog = XbmcThreads::SystemClockMillis();
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    m_queued[priority] = 0;
+
+  // one worker per core, but jobs often wait for I/O, so never less than we used to allow
+  int workers = std::max(g_cpuInfo.getCPUCount(), MIN_WORKERS);
+  for (int i = 0; i < workers; ++i)
+    m_queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue));
 }
 
 void CJobManager::Restart()
@@ -200,24 +282,75 @@ void CJobManager::CancelJobs()
   CSingleLock lock(m_section);
   m_running = false;
 
+  // clear the jobs set aside for their resource
+  JobQueue waiting;
+  {
+    CSingleLock resourceLock(m_resourceSection);
+    for (auto &resource : m_resources)
+    {
+      waiting.insert(waiting.end(), resource.second.m_waiting.begin(), resource.second.m_waiting.end());
+      resource.second.m_waiting.clear();
+    }
+  }
+  for (auto &item : waiting)
+    AddCancelled(item);
+  for_each(waiting.begin(), waiting.end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+
   // clear any pending jobs
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  std::vector<std::string> held;
+  for (auto &queue : m_queues)
   {
-    for_each(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
-    m_jobQueue[priority].clear();
+    CSingleLock queueLock(queue->m_section);
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority < CJob::PRIORITY_DEDICATED; ++priority)
+    {
+      for (auto &item : queue->m_jobs[priority])
+      {
+        AddCancelled(item);
+        if (item.m_resourceHeld)
+          held.push_back(item.m_job->GetResource());
+      }
+      for_each(queue->m_jobs[priority].begin(), queue->m_jobs[priority].end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+      m_queued[priority] -= (int)queue->m_jobs[priority].size();
+      queue->m_jobs[priority].clear();
+    }
+  }
+  for (auto &item : m_dedicated)
+  {
+    AddCancelled(item);
+    if (item.m_resourceHeld)
+      held.push_back(item.m_job->GetResource());
+  }
+  for_each(m_dedicated.begin(), m_dedicated.end(), std::mem_fun_ref(&CWorkItem::FreeJob));
+  m_queued[CJob::PRIORITY_DEDICATED] -= (int)m_dedicated.size();
+  m_dedicated.clear();
+  for (auto &resource : held)
+    ReleaseResource(resource, 1, NULL);
+
+  // abort the I/O of jobs waiting for it, they are deleted once they are woken
+  for (auto &item : m_suspended)
+  {
+    if (item.m_callback)
+      AddCancelled(item);
+    item.Cancel();
+    static_cast<CAsyncJob*>(item.m_job)->Abort();
   }
 
   // cancel any callbacks on jobs still processing
-  for_each(m_processing.begin(), m_processing.end(), std::mem_fun_ref(&CWorkItem::Cancel));
+  for (auto worker : m_workers)
+  {
+    CSingleLock workerLock(worker->m_section);
+    for_each(worker->m_processing.begin(), worker->m_processing.end(), std::mem_fun_ref(&CWorkItem::Cancel));
+  }
 
   // tell our workers to finish
   while (m_workers.size())
   {
+    m_jobCondition.notifyAll();
     lock.Leave();
-    m_jobEvent.Set();
-    Sleep(0); // yield after setting the event to give the workers some time to die
+    Sleep(0); // yield after waking the workers to give them some time to die
     lock.Enter();
   }
+  m_workersStarted = false;
 }
 
 CJobManager::~CJobManager()
@@ -226,22 +359,58 @@ CJobManager::~CJobManager()
 
 unsigned int CJobManager::AddJob(CJob *job, IJobCallback *callback, CJob::PRIORITY priority)
 {
-  CSingleLock lock(m_section);
-
   if (!m_running)
     return 0;
 
   // increment the job counter, ensuring 0 (invalid job) is never hit
-  m_jobCounter++;
-  if (m_jobCounter == 0)
-    m_jobCounter++;
+  unsigned int id = ++m_jobCounter;
+  if (id == 0)
+    id = ++m_jobCounter;
 
   // create a work item for this job
-  CWorkItem work(job, m_jobCounter, priority, callback);
-  m_jobQueue[priority].push_back(work);
+  CWorkItem work(job, id, priority, callback);
+  work.m_queueTime = CurrentHostCounter();
+
+  if (priority == CJob::PRIORITY_DEDICATED)
+  {
+    CSingleLock lock(m_section);
+    if (!m_running)
+      return 0;
+
+    m_dedicated.push_back(work);
+    m_queued[priority]++;
+
+    // dedicated jobs don't wait for a worker to become free
+    if (m_idle)
+      m_jobCondition.notify();
+    else
+      m_workers.push_back(new CJobWorker(this));
+    return id;
+  }
+
+  StartWorkers();
 
-  StartWorkers(priority);
-  return work.m_id;
+  // keep jobs added by a job on its worker, the data they work on is likely still in its cache
+  CJobWorker *worker = currentWorker.get();
+  unsigned int index;
+  if (job->GetAffinity())
+    index = job->GetAffinity() % m_queues.size();
+  else if (worker && worker->m_jobManager == this && worker->GetIndex() >= 0)
+    index = worker->GetIndex();
+  else
+    index = m_nextQueue++ % m_queues.size();
+
+  {
+    CSingleLock lock(m_queues[index]->m_section);
+    if (!m_running)
+      return 0;
+
+    m_queues[index]->m_jobs[priority].push_back(work);
+    m_queued[priority]++;
+  }
+
+  WakeWorkers(false);
+  return id;
 }
 
 void CJobManager::CancelJob(unsigned int jobID)
@@ -249,87 +418,259 @@ void CJobManager::CancelJob(unsigned int jobID)
   CSingleLock lock(m_section);
 
   // check whether we have this job in the queue
-  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  for (auto &queue : m_queues)
   {
-    JobQueue::iterator i = find(m_jobQueue[priority].begin(), m_jobQueue[priority].end(), jobID);
-    if (i != m_jobQueue[priority].end())
+    CSingleLock queueLock(queue->m_section);
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority < CJob::PRIORITY_DEDICATED; ++priority)
     {
-      delete i->m_job;
-      m_jobQueue[priority].erase(i);
-      return;
+      JobQueue::iterator i = find(queue->m_jobs[priority].begin(), queue->m_jobs[priority].end(), jobID);
+      if (i != queue->m_jobs[priority].end())
+      {
+        std::string resource = i->m_resourceHeld ? i->m_job->GetResource() : "";
+        AddCancelled(*i);
+        delete i->m_job;
+        queue->m_jobs[priority].erase(i);
+        m_queued[priority]--;
+        queueLock.Leave();
+        if (!resource.empty())
+          ReleaseResource(resource, 1, NULL);
+        return;
+      }
+    }
+  }
+  JobQueue::iterator i = find(m_dedicated.begin(), m_dedicated.end(), jobID);
+  if (i != m_dedicated.end())
+  {
+    std::string resource = i->m_resourceHeld ? i->m_job->GetResource() : "";
+    AddCancelled(*i);
+    delete i->m_job;
+    m_dedicated.erase(i);
+    m_queued[CJob::PRIORITY_DEDICATED]--;
+    if (!resource.empty())
+      ReleaseResource(resource, 1, NULL);
+    return;
+  }
+
+  // or if it was set aside for its resource
+  {
+    CSingleLock resourceLock(m_resourceSection);
+    for (auto &resource : m_resources)
+    {
+      JobQueue &waiting = resource.second.m_waiting;
+      JobQueue::iterator j = find(waiting.begin(), waiting.end(), jobID);
+      if (j != waiting.end())
+      {
+        CWorkItem item(*j);
+        waiting.erase(j);
+        resourceLock.Leave();
+        AddCancelled(item);
+        item.FreeJob();
+        return;
+      }
     }
   }
+
+  // or if it waits for I/O, it finds out once it's resumed
+  Processing::iterator k = find(m_suspended.begin(), m_suspended.end(), jobID);
+  if (k != m_suspended.end())
+  {
+    if (k->m_callback)
+      AddCancelled(*k);
+    k->Cancel();
+    static_cast<CAsyncJob*>(k->m_job)->Abort();
+    return;
+  }
+
   // or if we're processing it
-  Processing::iterator it = find(m_processing.begin(), m_processing.end(), jobID);
-  if (it != m_processing.end())
-    it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+  for (auto worker : m_workers)
+  {
+    CSingleLock workerLock(worker->m_section);
+    Processing::iterator it = find(worker->m_processing.begin(), worker->m_processing.end(), jobID);
+    if (it != worker->m_processing.end())
+    {
+      if (it->m_callback)
+        AddCancelled(*it);
+      it->m_callback = NULL; // job is in progress, so only thing to do is to remove callback
+      return;
+    }
+  }
 }
 
-void CJobManager::StartWorkers(CJob::PRIORITY priority)
+void CJobManager::StartWorkers()
 {
+  if (m_workersStarted)
+    return;
+
   CSingleLock lock(m_section);
+  if (m_workersStarted || !m_running)
+    return;
 
-  // check how many free threads we have
-  if (m_processing.size() >= GetMaxWorkers(priority))
+  for (unsigned int i = 0; i < m_queues.size(); ++i)
+    m_workers.push_back(new CJobWorker(this, i));
+  m_workersStarted = true;
+}
+
+void CJobManager::WakeWorkers(bool all)
+{
+  // callers change m_queued or m_processingCount first, GetNextJob() counts a worker as idle
+  // before it checks them, so one of the two sees the other
+  if (!m_idle)
     return;
 
-  // do we have any sleeping threads?
-  if (m_processing.size() < m_workers.size())
+  CSingleLock lock(m_section);
+  if (all)
+    m_jobCondition.notifyAll();
+  else
+    m_jobCondition.notify();
+}
+
+bool CJobManager::ReserveWorker(CJob::PRIORITY priority)
+{
+  unsigned int count = m_processingCount;
+  unsigned int max = GetMaxWorkers(priority);
+  while (count < max)
   {
-    m_jobEvent.Set();
-    return;
+    if (m_processingCount.compare_exchange_weak(count, count + 1))
+      return true;
   }
+  return false;
+}
 
-  // everyone is busy - we need more workers
-  m_workers.push_back(new CJobWorker(this));
+bool CJobManager::HasJobs() const
+{
+  for (int priority = CJob::PRIORITY_DEDICATED; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
+  {
+    if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
+      continue;
+
+    if (m_queued[priority] > 0 && m_processingCount < GetMaxWorkers(CJob::PRIORITY(priority)))
+      return true;
+  }
+  return false;
 }
 
-CJob *CJobManager::PopJob()
+bool CJobManager::TakeJob(const CJobWorker *worker, CJob::PRIORITY priority, CWorkItem &item)
+{
+  if (priority == CJob::PRIORITY_DEDICATED)
+  {
+    CSingleLock lock(m_section);
+    if (m_dedicated.empty())
+      return false;
+    item = m_dedicated.front();
+    m_dedicated.pop_front();
+    m_queued[priority]--;
+    return true;
+  }
+
+  // start with our own queue, workers for dedicated jobs have none and just steal
+  bool own = worker->GetIndex() >= 0;
+  unsigned int start = own ? worker->GetIndex() : m_nextQueue.load();
+  for (unsigned int i = 0; i < m_queues.size(); ++i)
+  {
+    WorkerQueue &queue = *m_queues[(start + i) % m_queues.size()];
+    CSingleLock lock(queue.m_section);
+    JobQueue &jobs = queue.m_jobs[priority];
+    if (jobs.empty())
+      continue;
+
+    // our own jobs are done in the order they came in, the newest ones are stolen
+    if (own && i == 0)
+    {
+      item = jobs.front();
+      jobs.pop_front();
+    }
+    else
+    {
+      item = jobs.back();
+      jobs.pop_back();
+    }
+    m_queued[priority]--;
+    return true;
+  }
+  return false;
+}
+
+CJob *CJobManager::PopJob(CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
   for (int priority = CJob::PRIORITY_DEDICATED; priority >= CJob::PRIORITY_LOW_PAUSABLE; --priority)
   {
+    if (!m_running)
+      return NULL;
+
     // Check whether we're pausing pausable jobs
     if (priority == CJob::PRIORITY_LOW_PAUSABLE && m_pauseJobs)
       continue;
 
-    if (m_jobQueue[priority].size() && m_processing.size() < GetMaxWorkers(CJob::PRIORITY(priority)))
+    if (m_queued[priority] <= 0 || !ReserveWorker(CJob::PRIORITY(priority)))
+      continue;
+
+    CWorkItem job;
+    if (!TakeJob(worker, CJob::PRIORITY(priority), job))
     {
-      // pop the job off the queue
-      CWorkItem job = m_jobQueue[priority].front();
-      m_jobQueue[priority].pop_front();
-
-      // add to the processing vector
-      m_processing.push_back(job);
-      job.m_job->m_callback = this;
-      return job.m_job;
+      // someone else was quicker
+      m_processingCount--;
+      continue;
+    }
+
+    if (!AcquireResource(job))
+    {
+      // the job was set aside until its resource is free, look for another one of this priority
+      m_processingCount--;
+      ++priority;
+      continue;
     }
+
+    // add to the processing vector, resumed jobs keep the time they first started
+    if (!job.m_startTime)
+      job.m_startTime = CurrentHostCounter();
+    CSingleLock lock(worker->m_section);
+    worker->m_processing.push_back(job);
+    job.m_job->m_callback = this;
+    return job.m_job;
   }
   return NULL;
 }
 
 void CJobManager::PauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = true;
 }
 
 void CJobManager::UnPauseJobs()
 {
-  CSingleLock lock(m_section);
   m_pauseJobs = false;
+
+  // hand the slots left free while paused to the jobs waiting for them
+  std::vector<std::string> resources;
+  {
+    CSingleLock lock(m_resourceSection);
+    for (auto &resource : m_resources)
+      resources.push_back(resource.first);
+  }
+  for (auto &resource : resources)
+    ReleaseResource(resource, 0, NULL);
+
+  WakeWorkers(true);
 }
 
 bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 {
-  CSingleLock lock(m_section);
-
   if (m_pauseJobs)
     return false;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
+  CSingleLock lock(m_section);
+  for (auto worker : m_workers)
+  {
+    CSingleLock workerLock(worker->m_section);
+    for(Processing::const_iterator it = worker->m_processing.begin(); it < worker->m_processing.end(); ++it)
+    {
+      if (priority == it->m_priority)
+        return true;
+    }
+  }
+  for (auto &item : m_suspended)
   {
-    if (priority == it->m_priority)
+    if (priority == item.m_priority)
       return true;
   }
   return false;
@@ -338,69 +679,112 @@ bool CJobManager::IsProcessing(const CJob::PRIORITY &priority) const
 int CJobManager::IsProcessing(const std::string &type) const
 {
   int jobsMatched = 0;
-  CSingleLock lock(m_section);
 
   if (m_pauseJobs)
     return 0;
 
-  for(Processing::const_iterator it = m_processing.begin(); it < m_processing.end(); ++it)
+  CSingleLock lock(m_section);
+  for (auto worker : m_workers)
+  {
+    CSingleLock workerLock(worker->m_section);
+    for(Processing::const_iterator it = worker->m_processing.begin(); it < worker->m_processing.end(); ++it)
+    {
+      if (type == std::string(it->m_job->GetType()))
+        jobsMatched++;
+    }
+  }
+  for (auto &item : m_suspended)
   {
-    if (type == std::string(it->m_job->GetType()))
+    if (type == std::string(item.m_job->GetType()))
       jobsMatched++;
   }
   return jobsMatched;
 }
 
-CJob *CJobManager::GetNextJob(const CJobWorker *worker)
+CJob *CJobManager::GetNextJob(CJobWorker *worker)
 {
-  CSingleLock lock(m_section);
   while (m_running)
   {
-    // grab a job off the queue if we have one
-    CJob *job = PopJob();
+    // grab a job off the queues if we have one
+    CJob *job = PopJob(worker);
     if (job)
       return job;
-    // no jobs are left - sleep for 30 seconds to allow new jobs to come in
-    lock.Leave();
-    bool newJob = m_jobEvent.WaitMSec(30000);
-    lock.Enter();
-    if (!newJob)
+
+    CSingleLock lock(m_section);
+    // count as idle before checking for jobs: a job added after the check sees us
+    // and notifies, which can't happen before we wait as that takes m_section
+    m_idle++;
+    if (!m_running || HasJobs())
+    {
+      m_idle--;
+      continue;
+    }
+
+    bool newJob = true;
+    if (worker->GetIndex() >= 0)
+      m_jobCondition.wait(m_section);
+    else
+    {
+      // no jobs are left - sleep for 30 seconds to allow new jobs to come in
+      newJob = m_jobCondition.wait(m_section, 30000);
+    }
+    m_idle--;
+    if (!newJob && !HasJobs())
       break;
   }
-  // ensure no jobs have come in during the period after
-  // timeout and before we held the lock
-  CJob *job = PopJob();
-  if (job)
-    return job;
   // have no jobs
   RemoveWorker(worker);
   return NULL;
 }
 
-bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
+bool CJobManager::FindProcessing(const CJob *job, CWorkItem &item) const
 {
+  // jobs usually ask from the worker processing them
+  CJobWorker *worker = currentWorker.get();
+  if (worker && worker->m_jobManager == this)
+  {
+    CSingleLock workerLock(worker->m_section);
+    Processing::const_iterator i = find(worker->m_processing.begin(), worker->m_processing.end(), job);
+    if (i != worker->m_processing.end())
+    {
+      item = *i;
+      return true;
+    }
+  }
+
   CSingleLock lock(m_section);
-  // find the job in the processing queue, and check whether it's cancelled (no callback)
-  Processing::const_iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  for (auto other : m_workers)
   {
-    CWorkItem item(*i);
-    lock.Leave(); // leave section prior to call
-    if (item.m_callback)
+    CSingleLock workerLock(other->m_section);
+    Processing::const_iterator i = find(other->m_processing.begin(), other->m_processing.end(), job);
+    if (i != other->m_processing.end())
     {
-      item.m_callback->OnJobProgress(item.m_id, progress, total, job);
-      return false;
+      item = *i;
+      return true;
     }
   }
+  return false;
+}
+
+bool CJobManager::OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const
+{
+  // find the job in the processing queues, and check whether it's cancelled (no callback)
+  CWorkItem item;
+  if (FindProcessing(job, item) && item.m_callback)
+  {
+    item.m_callback->OnJobProgress(item.m_id, progress, total, job);
+    return false;
+  }
   return true; // couldn't find the job, or it's been cancelled
 }
 
-void CJobManager::OnJobComplete(bool success, CJob *job)
+void CJobManager::OnJobComplete(CJobWorker *worker, bool success, CJob *job)
 {
-  CSingleLock lock(m_section);
+  int64_t end = CurrentHostCounter();
+  CSingleLock lock(worker->m_section);
   // remove the job from the processing queue
-  Processing::iterator i = find(m_processing.begin(), m_processing.end(), job);
-  if (i != m_processing.end())
+  Processing::iterator i = find(worker->m_processing.begin(), worker->m_processing.end(), job);
+  if (i != worker->m_processing.end())
   {
     // tell any listeners we're done with the job, then delete it
     CWorkItem item(*i);
@@ -415,27 +799,423 @@ void CJobManager::OnJobComplete(bool success, CJob *job)
       CLog::Log(LOGERROR, "%s error processing job %s", __FUNCTION__, item.m_job->GetType());
     }
     lock.Enter();
-    Processing::iterator j = find(m_processing.begin(), m_processing.end(), job);
-    if (j != m_processing.end())
-      m_processing.erase(j);
+    Processing::iterator j = find(worker->m_processing.begin(), worker->m_processing.end(), job);
+    if (j != worker->m_processing.end())
+      worker->m_processing.erase(j);
+
+    int64_t wait = ElapsedUsec(item.m_queueTime, item.m_startTime);
+    JobTypeStats &stats = worker->m_stats.types[TypeName(item.m_job)];
+    if (success)
+      stats.completed++;
+    else
+      stats.failed++;
+    stats.wait.Add(wait);
+    stats.run.Add(ElapsedUsec(item.m_startTime, end));
+    worker->m_stats.wait[item.m_priority].Add(wait);
     lock.Leave();
+    std::string resource = item.m_job->GetResource();
+    item.FreeJob();
+
+    // a job held back by the limit of its priority or its resource may go now
+    m_processingCount--;
+    if (!resource.empty())
+      ReleaseResource(resource, 1, worker);
+    if (HasJobs())
+      WakeWorkers(false);
+  }
+
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  unsigned int last = m_lastStatsLog;
+  if (now - last >= STATS_LOG_INTERVAL && m_lastStatsLog.compare_exchange_strong(last, now))
+    LogStats();
+}
+
+void CJobManager::OnJobSuspended(CJobWorker *worker, CAsyncJob *job)
+{
+  {
+    CSingleLock lock(m_section);
+    CSingleLock workerLock(worker->m_section);
+    Processing::iterator i = find(worker->m_processing.begin(), worker->m_processing.end(), job);
+    if (i != worker->m_processing.end())
+    {
+      m_suspended.push_back(*i);
+      worker->m_processing.erase(i);
+    }
+  }
+
+  // the worker goes on with other jobs while this one waits, and so does the slot of its resource
+  m_processingCount--;
+  const std::string resource = job->GetResource();
+  if (!resource.empty())
+    ReleaseResource(resource, 1, worker);
+  if (HasJobs())
+    WakeWorkers(false);
+
+  int state = CAsyncJob::STATE_RUNNING;
+  if (!job->m_state.compare_exchange_strong(state, CAsyncJob::STATE_SUSPENDED))
+  {
+    // it was woken while the worker was still busy with it
+    job->m_state = CAsyncJob::STATE_RUNNING;
+    ResumeJob(job);
+  }
+}
+
+void CJobManager::ResumeJob(CAsyncJob *job)
+{
+  CWorkItem item;
+  {
+    CSingleLock lock(m_section);
+    Processing::iterator i = find(m_suspended.begin(), m_suspended.end(), job);
+    if (i == m_suspended.end())
+      return;
+    item = *i;
+    m_suspended.erase(i);
+  }
+
+  // it gave the slot of its resource back while it waited, it takes one again once it runs
+  item.m_resourceHeld = false;
+  if (!Requeue(item, currentWorker.get()))
+  {
+    // cancelled while it waited
     item.FreeJob();
   }
 }
 
+void CJobManager::AddCancelled(const CWorkItem &item)
+{
+  CSingleLock lock(m_section);
+  m_stats.types[TypeName(item.m_job)].cancelled++;
+}
+
+void CJobManager::GetStats(CVariant &stats) const
+{
+  int64_t now = CurrentHostCounter();
+  JobStats total;
+  std::map<std::string, unsigned int> queued;
+  std::map<std::string, unsigned int> running;
+  unsigned int priorityQueued[CJob::PRIORITY_DEDICATED + 1] = {};
+  int64_t priorityOldest[CJob::PRIORITY_DEDICATED + 1] = {};
+
+  auto countQueued = [&](const CWorkItem &item)
+  {
+    queued[TypeName(item.m_job)]++;
+    priorityQueued[item.m_priority]++;
+    priorityOldest[item.m_priority] = std::max(priorityOldest[item.m_priority], ElapsedUsec(item.m_queueTime, now));
+  };
+
+  CSingleLock lock(m_section);
+  total.Merge(m_stats);
+  for (auto &item : m_dedicated)
+    countQueued(item);
+  for (auto &queue : m_queues)
+  {
+    CSingleLock queueLock(queue->m_section);
+    for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority < CJob::PRIORITY_DEDICATED; ++priority)
+    {
+      for (auto &item : queue->m_jobs[priority])
+        countQueued(item);
+    }
+  }
+  for (auto worker : m_workers)
+  {
+    CSingleLock workerLock(worker->m_section);
+    total.Merge(worker->m_stats);
+    for (auto &item : worker->m_processing)
+      running[TypeName(item.m_job)]++;
+  }
+  for (auto &item : m_suspended)
+    running[TypeName(item.m_job)]++;
+
+  CVariant resources(CVariant::VariantTypeObject);
+  {
+    CSingleLock resourceLock(m_resourceSection);
+    for (auto &resource : m_resources)
+    {
+      for (auto &item : resource.second.m_waiting)
+        countQueued(item);
+      CVariant &value = resources[resource.first];
+      value["running"] = resource.second.m_running;
+      value["waiting"] = (unsigned int)resource.second.m_waiting.size();
+      value["limit"] = GetResourceLimit(resource.first);
+    }
+  }
+
+  stats = CVariant(CVariant::VariantTypeObject);
+  stats["workers"] = (unsigned int)m_workers.size();
+  stats["idle"] = m_idle.load();
+  stats["processing"] = m_processingCount.load();
+  stats["suspended"] = (unsigned int)m_suspended.size();
+  stats["paused"] = m_pauseJobs.load();
+  stats["resources"] = resources;
+  lock.Leave();
+
+  stats["histogrambounds"] = CVariant(CVariant::VariantTypeArray);
+  for (int i = 0; i < STATS_BUCKETS - 1; i++)
+    stats["histogrambounds"].push_back((int)statsBounds[i]);
+
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+  {
+    const TimeStats &wait = total.wait[priority];
+    CVariant &value = stats["priorities"][priorityNames[priority]];
+    value["queued"] = priorityQueued[priority];
+    value["oldest"] = priorityOldest[priority];
+    value["wait"] = TimeStatsToVariant(wait.count, wait.total, wait.max, wait.buckets, STATS_BUCKETS);
+  }
+
+  // types that only have jobs waiting or running show up as well
+  for (auto &type : queued)
+    total.types[type.first];
+  for (auto &type : running)
+    total.types[type.first];
+
+  stats["types"] = CVariant(CVariant::VariantTypeObject);
+  for (auto &type : total.types)
+  {
+    const JobTypeStats &typeStats = type.second;
+    CVariant &value = stats["types"][type.first];
+    value["queued"] = queued[type.first];
+    value["running"] = running[type.first];
+    value["completed"] = typeStats.completed;
+    value["failed"] = typeStats.failed;
+    value["cancelled"] = typeStats.cancelled;
+    value["wait"] = TimeStatsToVariant(typeStats.wait.count, typeStats.wait.total, typeStats.wait.max, typeStats.wait.buckets, STATS_BUCKETS);
+    value["run"] = TimeStatsToVariant(typeStats.run.count, typeStats.run.total, typeStats.run.max, typeStats.run.buckets, STATS_BUCKETS);
+  }
+}
+
+void CJobManager::LogStats() const
+{
+  CVariant stats;
+  GetStats(stats);
+
+  // the types that kept the workers busy the longest
+  std::vector<std::pair<int64_t, std::string>> types;
+  for (CVariant::const_iterator_map it = stats["types"].begin_map(); it != stats["types"].end_map(); ++it)
+  {
+    const CVariant &type = it->second;
+    int64_t run = type["run"]["average"].asInteger() * (type["completed"].asInteger() + type["failed"].asInteger());
+    types.push_back(std::make_pair(run, it->first));
+  }
+  std::sort(types.rbegin(), types.rend());
+
+  std::string summary;
+  for (unsigned int i = 0; i < types.size() && i < 5; i++)
+  {
+    const CVariant &type = stats["types"][types[i].second];
+    summary += StringUtils::Format(", %s: %" PRIu64 " done, %" PRIu64 " queued, %" PRIu64 " cancelled, wait %" PRId64 "/%" PRId64 " ms, run %" PRId64 "/%" PRId64 " ms",
+                                   types[i].second.c_str(),
+                                   type["completed"].asUnsignedInteger() + type["failed"].asUnsignedInteger(),
+                                   type["queued"].asUnsignedInteger(),
+                                   type["cancelled"].asUnsignedInteger(),
+                                   type["wait"]["average"].asInteger() / 1000, type["wait"]["max"].asInteger() / 1000,
+                                   type["run"]["average"].asInteger() / 1000, type["run"]["max"].asInteger() / 1000);
+  }
+
+  CLog::Log(LOGDEBUG, "CJobManager::%s - %" PRIu64 " workers, %" PRIu64 " idle, %" PRIu64 " processing%s", __FUNCTION__,
+            stats["workers"].asUnsignedInteger(), stats["idle"].asUnsignedInteger(), stats["processing"].asUnsignedInteger(),
+            summary.c_str());
+}
+
+CJobManager::TimeStats::TimeStats()
+  : count(0),
+    total(0),
+    max(0)
+{
+  memset(buckets, 0, sizeof(buckets));
+}
+
+void CJobManager::TimeStats::Add(int64_t usec)
+{
+  int bucket = std::upper_bound(statsBounds, statsBounds + STATS_BUCKETS - 1, usec) - statsBounds;
+  count++;
+  total += usec;
+  max = std::max(max, usec);
+  buckets[bucket]++;
+}
+
+void CJobManager::TimeStats::Merge(const TimeStats &other)
+{
+  count += other.count;
+  total += other.total;
+  max = std::max(max, other.max);
+  for (int i = 0; i < STATS_BUCKETS; i++)
+    buckets[i] += other.buckets[i];
+}
+
+void CJobManager::JobTypeStats::Merge(const JobTypeStats &other)
+{
+  completed += other.completed;
+  failed += other.failed;
+  cancelled += other.cancelled;
+  wait.Merge(other.wait);
+  run.Merge(other.run);
+}
+
+void CJobManager::JobStats::Merge(const JobStats &other)
+{
+  for (auto &type : other.types)
+    types[type.first].Merge(type.second);
+  for (unsigned int priority = CJob::PRIORITY_LOW_PAUSABLE; priority <= CJob::PRIORITY_DEDICATED; ++priority)
+    wait[priority].Merge(other.wait[priority]);
+}
+
 void CJobManager::RemoveWorker(const CJobWorker *worker)
 {
   CSingleLock lock(m_section);
   // remove our worker
   Workers::iterator i = find(m_workers.begin(), m_workers.end(), worker);
   if (i != m_workers.end())
+  {
+    // keep what the worker did
+    CSingleLock workerLock((*i)->m_section);
+    m_stats.Merge((*i)->m_stats);
+    workerLock.Leave();
     m_workers.erase(i); // workers auto-delete
+  }
 }
 
-unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority)
+unsigned int CJobManager::GetMaxWorkers(CJob::PRIORITY priority) const
 {
-  static const unsigned int max_workers = 5;
   if (priority == CJob::PRIORITY_DEDICATED)
     return 10000; // A large number..
-  return max_workers - (CJob::PRIORITY_HIGH - priority);
+  return m_queues.size() - (CJob::PRIORITY_HIGH - priority);
+}
+
+unsigned int CJobManager::GetResourceLimit(const std::string &resource) const
+{
+  CSingleLock lock(m_resourceSection);
+  std::map<std::string, unsigned int>::const_iterator i = m_resourceLimits.find(resource);
+  return i != m_resourceLimits.end() ? i->second : DEFAULT_RESOURCE_LIMIT;
+}
+
+void CJobManager::SetResourceLimit(const std::string &resource, unsigned int limit)
+{
+  {
+    CSingleLock lock(m_resourceSection);
+    if (limit)
+      m_resourceLimits[resource] = limit;
+    else
+      m_resourceLimits.erase(resource);
+  }
+  // a higher limit lets jobs set aside go right away
+  ReleaseResource(resource, 0, NULL);
+}
+
+std::string CJobManager::GetResource(const std::string &path)
+{
+  if (URIUtils::IsStack(path))
+    return GetResource(XFILE::CStackDirectory::GetFirstStackedFile(path));
+  if (URIUtils::IsSpecial(path))
+    return GetResource(CSpecialProtocol::TranslatePath(path));
+
+  CURL url(path);
+  if (URIUtils::HasParentInHostname(url) || url.IsProtocol("image"))
+    return GetResource(url.GetHostName());
+  if (url.IsLocal() || url.GetHostName().empty())
+    return "";
+
+  std::string resource = url.GetProtocol() + "://" + url.GetHostName();
+  if (url.HasPort())
+    resource += StringUtils::Format(":%i", url.GetPort());
+  // the shares of a server are often on disks of their own
+  if (url.IsProtocol("smb") && !url.GetShareName().empty())
+    resource += "/" + url.GetShareName();
+  StringUtils::ToLower(resource);
+  return resource;
+}
+
+bool CJobManager::AcquireResource(const CWorkItem &item)
+{
+  const std::string &resource = item.m_job->GetResource();
+  if (resource.empty() || item.m_resourceHeld)
+    return true;
+
+  CSingleLock lock(m_resourceSection);
+  ResourceState &state = m_resources[resource];
+  if (state.m_running < GetResourceLimit(resource))
+  {
+    state.m_running++;
+    return true;
+  }
+  // a job that was woken goes ahead of the ones that haven't started yet
+  if (item.m_startTime)
+    state.m_waiting.push_front(item);
+  else
+    state.m_waiting.push_back(item);
+  return false;
+}
+
+void CJobManager::ReleaseResource(const std::string &resource, unsigned int slots, const CJobWorker *worker)
+{
+  JobQueue ready;
+  {
+    CSingleLock lock(m_resourceSection);
+    std::map<std::string, ResourceState>::iterator i = m_resources.find(resource);
+    if (i == m_resources.end())
+      return;
+
+    // the oldest jobs set aside get the free slots before any newer job can take them
+    ResourceState &state = i->second;
+    state.m_running -= std::min(slots, state.m_running);
+    unsigned int limit = GetResourceLimit(resource);
+    JobQueue::iterator j = state.m_waiting.begin();
+    while (j != state.m_waiting.end() && state.m_running < limit)
+    {
+      // a paused job would hold on to the slot without running
+      if (m_pauseJobs && j->m_priority == CJob::PRIORITY_LOW_PAUSABLE)
+      {
+        ++j;
+        continue;
+      }
+      ready.push_back(*j);
+      ready.back().m_resourceHeld = true;
+      j = state.m_waiting.erase(j);
+      state.m_running++;
+    }
+    if (!state.m_running && state.m_waiting.empty())
+      m_resources.erase(i);
+  }
+
+  for (auto &item : ready)
+  {
+    if (!Requeue(item, worker))
+    {
+      // cancelled in the meantime
+      AddCancelled(item);
+      item.FreeJob();
+      ReleaseResource(resource, 1, NULL);
+    }
+  }
+}
+
+bool CJobManager::Requeue(const CWorkItem &item, const CJobWorker *worker)
+{
+  if (item.m_priority == CJob::PRIORITY_DEDICATED)
+  {
+    CSingleLock lock(m_section);
+    if (!m_running)
+      return false;
+
+    m_dedicated.push_front(item);
+    m_queued[item.m_priority]++;
+    // a worker that is done with a job of the resource takes it itself
+    if (m_idle)
+      m_jobCondition.notify();
+    else if (!worker)
+      m_workers.push_back(new CJobWorker(this));
+    return true;
+  }
+
+  // ahead of the others on the queue of the worker that is done, which likely takes it next
+  unsigned int index = worker && worker->GetIndex() >= 0 ? worker->GetIndex() : m_nextQueue++ % m_queues.size();
+  {
+    CSingleLock lock(m_queues[index]->m_section);
+    if (!m_running)
+      return false;
+
+    m_queues[index]->m_jobs[item.m_priority].push_front(item);
+    m_queued[item.m_priority]++;
+  }
+  WakeWorkers(false);
+  return true;
 }
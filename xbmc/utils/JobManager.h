@@ -19,25 +19,21 @@
  *
  */
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <queue>
 #include <vector>
 #include <string>
+#include "threads/Condition.h"
 #include "threads/CriticalSection.h"
 #include "threads/Thread.h"
 #include "Job.h"
 
+class CAsyncJob;
 class CJobManager;
-
-class CJobWorker : public CThread
-{
-public:
-  CJobWorker(CJobManager *manager);
-  virtual ~CJobWorker();
-
-  void Process();
-private:
-  CJobManager  *m_jobManager;
-};
+class CJobWorker;
+class CVariant;
 
 /*!
  \ingroup jobs
@@ -170,6 +166,25 @@ private:
  priority levels.  Lower priority jobs are executed only if there are sufficient
  spare worker threads free to allow for higher priority jobs that may arise.
 
+ Jobs are run by a fixed set of workers, one per core but at least five as many
+ jobs block on I/O. Every worker owns a queue per priority, jobs added by a
+ worker go to its own queue and other jobs are spread over all of them, unless
+ the job has an affinity. A worker takes the jobs of its own queue in order and
+ steals from the back of the others' when its own is empty, so adding and taking
+ jobs doesn't contend for one lock. Dedicated jobs get a worker of their own if
+ all are busy, which goes away again once idle.
+
+ Jobs that have a resource set only run up to the limit of that resource at
+ once. A job taken while its resource is busy is set aside and the worker goes
+ on with the next job, so a slow server doesn't hold up the jobs of the others.
+ Once a job of the resource is done, the oldest job set aside takes its place.
+
+ A CAsyncJob that waits for I/O is suspended and gives its worker back, it is
+ queued again once it is woken, so a few workers keep many transfers going.
+ While it waits it gives the slot of its resource back, so the limit is on the
+ jobs of a resource that run rather than on the transfers they have going. A
+ woken job takes a slot again ahead of the jobs set aside that haven't started.
+
  \sa CJob and IJobCallback
  */
 class CJobManager
@@ -177,12 +192,15 @@ class CJobManager
   class CWorkItem
   {
   public:
-    CWorkItem(CJob *job, unsigned int id, CJob::PRIORITY priority, IJobCallback *callback)
+    CWorkItem(CJob *job = NULL, unsigned int id = 0, CJob::PRIORITY priority = CJob::PRIORITY_LOW, IJobCallback *callback = NULL)
     {
       m_job = job;
       m_id = id;
       m_callback = callback;
       m_priority = priority;
+      m_queueTime = 0;
+      m_startTime = 0;
+      m_resourceHeld = false;
     }
     bool operator==(unsigned int jobID) const
     {
@@ -205,6 +223,45 @@ class CJobManager
     unsigned int  m_id;
     IJobCallback *m_callback;
     CJob::PRIORITY m_priority;
+    int64_t       m_queueTime;   // host counter when the job was added
+    int64_t       m_startTime;   // host counter when a worker took the job
+    bool          m_resourceHeld; // the job was set aside and got the slot of a job of its resource
+  };
+
+  static const int STATS_BUCKETS = 9;
+
+  struct TimeStats
+  {
+    TimeStats();
+    void Add(int64_t usec);
+    void Merge(const TimeStats &other);
+
+    uint64_t     count;
+    int64_t      total;          // usec
+    int64_t      max;            // usec
+    unsigned int buckets[STATS_BUCKETS];
+  };
+
+  struct JobTypeStats
+  {
+    JobTypeStats() : completed(0), failed(0), cancelled(0) {}
+    void Merge(const JobTypeStats &other);
+
+    uint64_t  completed;
+    uint64_t  failed;
+    uint64_t  cancelled;
+    TimeStats wait;              // from being added until a worker took the job
+    TimeStats run;
+  };
+
+  /*! \brief Statistics of the jobs completed by a worker, or by the workers that are gone
+   */
+  struct JobStats
+  {
+    void Merge(const JobStats &other);
+
+    std::map<std::string, JobTypeStats> types;
+    TimeStats wait[CJob::PRIORITY_DEDICATED + 1];
   };
 
   template<typename F>
@@ -297,25 +354,56 @@ public:
    */
   bool IsProcessing(const CJob::PRIORITY &priority) const;
 
+  /*!
+   \brief Get the number of workers that jobs of all but dedicated priority are queued to.
+   \return the number of worker queues, fixed for the lifetime of the job manager
+   */
+  unsigned int GetQueueCount() const { return m_queues.size(); }
+
+  /*!
+   \brief Get statistics of the jobs queued, processing and done so far.
+   \param stats object with the jobs queued per priority and counters and histograms of
+   the wait and run times per priority and job type
+   */
+  void GetStats(CVariant &stats) const;
+
+  /*!
+   \brief Limit the number of jobs of a resource processed at once.
+   \param resource the resource, as given to CJob::SetResource()
+   \param limit the number of jobs, 0 for the default
+   \sa CJob::SetResource()
+   */
+  void SetResourceLimit(const std::string &resource, unsigned int limit);
+
+  /*!
+   \brief The resource a job reading the given path does its I/O on.
+   \param path file or directory the job reads
+   \return the protocol and host of remote paths, plus the share for SMB, empty for local ones
+   \sa CJob::SetResource()
+   */
+  static std::string GetResource(const std::string &path);
+
 protected:
   friend class CJobWorker;
   friend class CJob;
+  friend class CAsyncJob;
 
   /*!
    \brief Get a new job to process. Blocks until a new job is available, or a timeout has occurred.
    \param worker a pointer to the current CJobWorker instance requesting a job.
    \sa CJob
    */
-  CJob *GetNextJob(const CJobWorker *worker);
+  CJob *GetNextJob(CJobWorker *worker);
 
   /*!
    \brief Callback from CJobWorker after a job has completed.
    Calls IJobCallback::OnJobComplete(), and then destroys job.
+   \param worker the worker that processed the job.
    \param job a pointer to the calling subclassed CJob instance.
    \param success the result from the DoWork call
    \sa IJobCallback, CJob
    */
-  void  OnJobComplete(bool success, CJob *job);
+  void  OnJobComplete(CJobWorker *worker, bool success, CJob *job);
 
   /*!
    \brief Callback from CJob to report progress and check for cancellation.
@@ -328,6 +416,19 @@ protected:
    */
   bool  OnJobProgress(unsigned int progress, unsigned int total, const CJob *job) const;
 
+  /*!
+   \brief Callback from CJobWorker after an async job returned CAsyncJob::SUSPENDED.
+   The worker is free for other jobs until the job is woken.
+   \sa ResumeJob(), CAsyncJob
+   */
+  void  OnJobSuspended(CJobWorker *worker, CAsyncJob *job);
+
+  /*!
+   \brief Queue a suspended job again, called by CAsyncJob::Wake().
+   \sa OnJobSuspended(), CAsyncJob
+   */
+  void  ResumeJob(CAsyncJob *job);
+
 private:
   // private construction, and no assignements; use the provided singleton methods
   CJobManager();
@@ -335,27 +436,118 @@ private:
   CJobManager const& operator=(CJobManager const&);
   virtual ~CJobManager();
 
-  /*! \brief Pop a job off the job queue and add to the processing queue ready to process
+  typedef std::deque<CWorkItem>    JobQueue;
+  typedef std::vector<CWorkItem>   Processing;
+  typedef std::vector<CJobWorker*> Workers;
+
+  /*! \brief The queues owned by a worker, one per priority
+   */
+  struct WorkerQueue
+  {
+    JobQueue         m_jobs[CJob::PRIORITY_DEDICATED];
+    CCriticalSection m_section;
+  };
+
+  /*! \brief Pop a job off the job queues and add to the worker's processing queue ready to process
    \return the job to process, NULL if no jobs are available
    */
-  CJob *PopJob();
+  CJob *PopJob(CJobWorker *worker);
 
-  void StartWorkers(CJob::PRIORITY priority);
-  void RemoveWorker(const CJobWorker *worker);
-  static unsigned int GetMaxWorkers(CJob::PRIORITY priority);
+  /*! \brief Take a job of the given priority from the worker's own queue, or steal one from another queue
+   */
+  bool TakeJob(const CJobWorker *worker, CJob::PRIORITY priority, CWorkItem &item);
 
-  unsigned int m_jobCounter;
+  /*! \brief Whether a job could be popped, ignoring the queue it is in
+   */
+  bool HasJobs() const;
 
-  typedef std::deque<CWorkItem>    JobQueue;
-  typedef std::vector<CWorkItem>   Processing;
-  typedef std::vector<CJobWorker*> Workers;
+  /*! \brief Count a job of the given priority as processing, if the priority is below its limit
+   */
+  bool ReserveWorker(CJob::PRIORITY priority);
 
-  JobQueue   m_jobQueue[CJob::PRIORITY_DEDICATED + 1];
-  bool       m_pauseJobs;
-  Processing m_processing;
+  /*! \brief Wake up idle workers to look for jobs
+   */
+  void WakeWorkers(bool all);
+
+  /*! \brief Take a slot of the job's resource, or set the job aside until one is free
+   \return true if the job can be processed now
+   */
+  bool AcquireResource(const CWorkItem &item);
+
+  /*! \brief Give back the slots of jobs that are done, the oldest jobs set aside get them
+   \param worker the worker that was processing the job, NULL if none
+   */
+  void ReleaseResource(const std::string &resource, unsigned int slots, const CJobWorker *worker);
+
+  /*! \brief Queue a job that was set aside again, it keeps the slot of its resource
+   \return false if the manager was cancelled in the meantime
+   */
+  bool Requeue(const CWorkItem &item, const CJobWorker *worker);
+
+  /*! \brief Find the job in the processing queue of any worker
+   */
+  bool FindProcessing(const CJob *job, CWorkItem &item) const;
+
+  void StartWorkers();
+  void RemoveWorker(const CJobWorker *worker);
+  void LogStats() const;
+  void AddCancelled(const CWorkItem &item);
+  unsigned int GetMaxWorkers(CJob::PRIORITY priority) const;
+  unsigned int GetResourceLimit(const std::string &resource) const;
+
+  std::atomic<unsigned int> m_jobCounter;
+
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+  std::atomic<unsigned int> m_nextQueue;
+  std::atomic<int> m_queued[CJob::PRIORITY_DEDICATED + 1];  // jobs waiting per priority
+  std::atomic<unsigned int> m_processingCount;
+  std::atomic<bool> m_pauseJobs;
+
+  JobQueue   m_dedicated;         // guarded by m_section, any idle worker may take them
+  JobStats   m_stats;             // guarded by m_section, of workers that are gone and cancelled jobs
+  std::atomic<unsigned int> m_lastStatsLog;
+  Processing m_suspended;         // guarded by m_section, async jobs waiting for I/O
   Workers    m_workers;
+  std::atomic<bool> m_workersStarted; // if the workers owning the queues are running
+  std::atomic<unsigned int> m_idle; // workers waiting for m_jobCondition
+
+  struct ResourceState
+  {
+    ResourceState() : m_running(0) {}
+    unsigned int m_running;       // jobs processing, or handed the slot of one
+    JobQueue     m_waiting;       // jobs set aside, oldest first
+  };
+  std::map<std::string, ResourceState> m_resources;   // only of resources with jobs
+  std::map<std::string, unsigned int> m_resourceLimits;
+  CCriticalSection m_resourceSection; // guards the above, no other lock is taken while holding it
 
   CCriticalSection m_section;
-  CEvent           m_jobEvent;
-  bool             m_running;
+  XbmcThreads::ConditionVariable m_jobCondition;
+  std::atomic<bool> m_running;
+};
+
+class CJobWorker : public CThread
+{
+public:
+  /*!
+   \brief Start a worker
+   \param index the queue owned by this worker, -1 for a worker that was started for a dedicated job
+   and goes away once it has been idle for a while
+   */
+  CJobWorker(CJobManager *manager, int index = -1);
+  virtual ~CJobWorker();
+
+  void Process();
+
+  int GetIndex() const { return m_index; }
+
+private:
+  friend class CJobManager;
+
+  CJobManager  *m_jobManager;
+  int           m_index;
+
+  CJobManager::Processing m_processing;  // the job being processed
+  CJobManager::JobStats   m_stats;       // of the jobs this worker completed
+  CCriticalSection        m_section;     // guards m_processing and m_stats
 };
@@ -0,0 +1,197 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "utils/ActorProtocol.h"
+#include "threads/Event.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+using namespace Actor;
+
+namespace
+{
+struct Payload
+{
+  int sender;
+  int sequence;
+};
+}
+
+class TestActorProtocol : public testing::Test
+{
+protected:
+  TestActorProtocol() : protocol("test", &inEvent, &outEvent) {}
+
+  CEvent inEvent, outEvent;
+  Protocol protocol;
+};
+
+TEST_F(TestActorProtocol, Order)
+{
+  int i;
+  // more than the ring holds, the rest has to come through the overflow queue in order
+  for (i = 0; i < MSG_PORT_SIZE * 2; i++)
+    protocol.SendOutMessage(i);
+
+  Message *msg;
+  for (i = 0; protocol.ReceiveOutMessage(&msg); i++)
+  {
+    EXPECT_EQ(i, msg->signal);
+    msg->Release();
+  }
+  EXPECT_EQ(MSG_PORT_SIZE * 2, i);
+
+  ProtocolStats stats = protocol.GetOutStats();
+  EXPECT_EQ((uint64_t)MSG_PORT_SIZE * 2, stats.messages);
+  EXPECT_EQ((uint64_t)MSG_PORT_SIZE, stats.overflows);
+  EXPECT_EQ(0u, protocol.GetInStats().messages);
+}
+
+TEST_F(TestActorProtocol, Payload)
+{
+  Payload small = { 1, 2 };
+  protocol.SendInMessage(7, &small, sizeof(small));
+
+  uint8_t large[MSG_INTERNAL_BUFFER_SIZE + 1];
+  for (unsigned int i = 0; i < sizeof(large); i++)
+    large[i] = i;
+  protocol.SendInMessage(8, large, sizeof(large));
+
+  Message *msg;
+  ASSERT_TRUE(protocol.ReceiveInMessage(&msg));
+  EXPECT_EQ(msg->buffer, msg->data);
+  EXPECT_EQ((int)sizeof(small), msg->payloadSize);
+  EXPECT_EQ(2, reinterpret_cast<Payload*>(msg->data)->sequence);
+  msg->Release();
+
+  ASSERT_TRUE(protocol.ReceiveInMessage(&msg));
+  EXPECT_NE(msg->buffer, msg->data);
+  EXPECT_EQ(0, memcmp(large, msg->data, sizeof(large)));
+  msg->Release();
+}
+
+TEST_F(TestActorProtocol, Defer)
+{
+  protocol.SendOutMessage(1);
+  protocol.DeferOut(true);
+
+  Message *msg;
+  EXPECT_FALSE(protocol.ReceiveOutMessage(&msg));
+  protocol.DeferOut(false);
+  ASSERT_TRUE(protocol.ReceiveOutMessage(&msg));
+  EXPECT_EQ(1, msg->signal);
+  msg->Release();
+}
+
+TEST_F(TestActorProtocol, PurgeOut)
+{
+  for (int i = 0; i < 266; i++)
+    protocol.SendOutMessage(i % 3);
+  protocol.PurgeOut(1);
+  protocol.SendOutMessage(1);
+
+  Message *msg;
+  int count = 0;
+  int last = -1;
+  while (protocol.ReceiveOutMessage(&msg))
+  {
+    count++;
+    last = msg->signal;
+    if (count <= 177)
+      EXPECT_NE(1, msg->signal);
+    msg->Release();
+  }
+  // 89 of the 266 purged, one more sent after the purge
+  EXPECT_EQ(178, count);
+  EXPECT_EQ(1, last);
+}
+
+TEST_F(TestActorProtocol, Sync)
+{
+  std::thread actor([this]()
+  {
+    Message *msg;
+    while (!protocol.ReceiveOutMessage(&msg))
+      outEvent.WaitMSec(100);
+    int reply = msg->signal + 1;
+    msg->Reply(reply, &reply, sizeof(reply));
+    msg->Release();
+  });
+
+  Message *reply;
+  ASSERT_TRUE(protocol.SendOutMessageSync(41, &reply, 5000));
+  EXPECT_EQ(42, reply->signal);
+  EXPECT_EQ(42, *reinterpret_cast<int*>(reply->data));
+  reply->Release();
+  actor.join();
+
+  // the receiver never answers
+  EXPECT_FALSE(protocol.SendOutMessageSync(1, &reply, 10));
+  Message *msg;
+  ASSERT_TRUE(protocol.ReceiveOutMessage(&msg));
+  EXPECT_TRUE(msg->Reply(2));
+  msg->Release();
+}
+
+TEST_F(TestActorProtocol, Senders)
+{
+  const int senders = 4;
+  const int messages = 20000;
+
+  std::vector<std::thread> threads;
+  for (int s = 0; s < senders; s++)
+  {
+    threads.push_back(std::thread([this, s]()
+    {
+      for (int i = 0; i < messages; i++)
+      {
+        Payload payload = { s, i };
+        protocol.SendInMessage(0, &payload, sizeof(payload));
+      }
+    }));
+  }
+
+  // every sender's messages arrive in order
+  std::vector<int> next(senders, 0);
+  int received = 0;
+  Message *msg;
+  while (received < senders * messages)
+  {
+    if (!protocol.ReceiveInMessage(&msg))
+    {
+      inEvent.WaitMSec(10);
+      continue;
+    }
+    Payload *payload = reinterpret_cast<Payload*>(msg->data);
+    EXPECT_EQ(next[payload->sender], payload->sequence);
+    next[payload->sender] = payload->sequence + 1;
+    msg->Release();
+    received++;
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_FALSE(protocol.ReceiveInMessage(&msg));
+  EXPECT_EQ((uint64_t)senders * messages, protocol.GetInStats().messages);
+}
@@ -0,0 +1,231 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VideoProbeQueue.h"
+#include "Application.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/CPUInfo.h"
+#include "utils/Job.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+#include "video/VideoThumbLoader.h"
+
+#include <algorithm>
+#include <iterator>
+
+CVideoProbeQueue& CVideoProbeQueue::GetInstance()
+{
+  static CVideoProbeQueue queue;
+  return queue;
+}
+
+CVideoProbeQueue::CVideoProbeQueue()
+  : m_jobCounter(0)
+  , m_stopped(false)
+{
+}
+
+CVideoProbeQueue::~CVideoProbeQueue()
+{
+  for (auto& worker : m_workers)
+    worker->StopThread();
+
+  for (auto& item : m_queue)
+    delete item.job;
+}
+
+std::string CVideoProbeQueue::GetSource(const std::string &path)
+{
+  CURL url(path);
+  if (URIUtils::IsInArchive(path))
+    return GetSource(url.GetHostName());
+
+  // local files all count as one source
+  if (url.GetHostName().empty())
+    return "";
+  return url.GetProtocol() + "://" + url.GetHostName();
+}
+
+void CVideoProbeQueue::AddJob(CThumbExtractor *job, IJobCallback *callback)
+{
+  CSingleLock lock(m_section);
+
+  if (m_stopped)
+  {
+    delete job;
+    return;
+  }
+
+  auto same = [&](const CItem &item) { return item.callback == callback && *item.job == job; };
+  if (std::find_if(m_queue.begin(), m_queue.end(), same) != m_queue.end() ||
+      std::find_if(m_running.begin(), m_running.end(), same) != m_running.end())
+  {
+    delete job;
+    return;
+  }
+
+  CItem item;
+  item.job = job;
+  item.callback = callback;
+  item.source = GetSource(job->m_item.GetPath());
+  item.id = ++m_jobCounter;
+  m_queue.push_back(item);
+
+  unsigned int maxWorkers = std::min<unsigned int>(std::max(g_cpuInfo.getCPUCount(), 1), MAX_WORKERS);
+  if (m_workers.size() < maxWorkers && m_workers.size() < m_queue.size() + m_running.size())
+  {
+    m_workers.push_back(std::unique_ptr<CWorker>(new CWorker(*this)));
+    m_workers.back()->Create();
+    CLog::Log(LOGDEBUG, "CVideoProbeQueue::%s - started probe worker %d", __FUNCTION__, (int)m_workers.size());
+  }
+  m_jobEvent.Set();
+}
+
+void CVideoProbeQueue::CancelJobs(IJobCallback *callback)
+{
+  {
+    CSingleLock lock(m_section);
+
+    for (auto it = m_queue.begin(); it != m_queue.end(); )
+    {
+      if (it->callback == callback)
+      {
+        delete it->job;
+        it = m_queue.erase(it);
+      }
+      else
+        ++it;
+    }
+
+    for (auto& item : m_running)
+    {
+      if (item.callback == callback)
+        item.callback = NULL;
+    }
+  }
+
+  // wait for a completion that is already being reported
+  CSingleLock lock(m_callbackSection);
+}
+
+void CVideoProbeQueue::Stop()
+{
+  std::vector<std::unique_ptr<CWorker> > workers;
+  {
+    CSingleLock lock(m_section);
+    m_stopped = true;
+
+    for (auto& item : m_queue)
+      delete item.job;
+    m_queue.clear();
+
+    // the loaders waiting for these are being torn down
+    for (auto& item : m_running)
+      item.callback = NULL;
+
+    workers.swap(m_workers);
+  }
+
+  for (auto& worker : workers)
+    worker->StopThread();
+}
+
+bool CVideoProbeQueue::Next(CItem &item)
+{
+  CSingleLock lock(m_section);
+
+  // leave the disk and the network to playback
+  if (g_application.m_pPlayer->IsPlayingVideo())
+    return false;
+
+  for (auto it = m_queue.rbegin(); it != m_queue.rend(); ++it)
+  {
+    auto source = m_sources.find(it->source);
+    if (source == m_sources.end() || source->second < MAX_PER_SOURCE)
+    {
+      m_sources[it->source]++;
+      item = *it;
+      m_running.push_back(item);
+      m_queue.erase(std::next(it).base());
+      return true;
+    }
+  }
+  return false;
+}
+
+void CVideoProbeQueue::Complete(CItem &item, bool success)
+{
+  CSingleLock callbackLock(m_callbackSection);
+
+  IJobCallback *callback = NULL;
+  {
+    CSingleLock lock(m_section);
+
+    auto it = std::find_if(m_running.begin(), m_running.end(), [&](const CItem &running) { return running.id == item.id; });
+    if (it != m_running.end())
+    {
+      callback = it->callback;
+      m_running.erase(it);
+    }
+
+    if (--m_sources[item.source] == 0)
+      m_sources.erase(item.source);
+  }
+  // a source became free
+  m_jobEvent.Set();
+
+  if (callback)
+    callback->OnJobComplete(item.id, success, item.job);
+  delete item.job;
+}
+
+CVideoProbeQueue::CWorker::CWorker(CVideoProbeQueue &queue)
+  : CThread("VideoProbe")
+  , m_queue(queue)
+{
+}
+
+void CVideoProbeQueue::CWorker::StopThread(bool bWait /*= true*/)
+{
+  m_bStop = true;
+  m_queue.m_jobEvent.Set();
+  CThread::StopThread(bWait);
+}
+
+void CVideoProbeQueue::CWorker::Process()
+{
+  CItem item;
+  while (!m_bStop)
+  {
+    if (!m_queue.Next(item))
+    {
+      m_queue.m_jobEvent.WaitMSec(1000);
+      continue;
+    }
+
+    item.job->m_codecCache = &m_codecCache;
+    bool success = item.job->DoWork();
+    item.job->m_codecCache = NULL;
+
+    m_queue.Complete(item, success);
+  }
+  m_codecCache.Clear();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cores/VideoPlayer/DVDFileInfo.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/Thread.h"
+
+class CThumbExtractor;
+class IJobCallback;
+
+/*!
+ \ingroup thumbs,jobs
+ \brief Runs thumb and stream details extraction of many files in parallel
+
+ Files are probed by a small pool of workers, at most MAX_PER_SOURCE of them
+ on the same server or local disk so a single NAS isn't overwhelmed, while
+ files of different sources are probed side by side. Every worker keeps its
+ video decoder open for the next file with the same stream parameters.
+ Nothing is probed while a video is playing.
+
+ Shared by all video thumb loaders, jobs are completed through the callback
+ given with them, like jobs of the CJobManager.
+ */
+class CVideoProbeQueue
+{
+public:
+  static CVideoProbeQueue& GetInstance();
+
+  /*!
+   \brief Queue a job, the most recently queued job of a free source runs first.
+   The queue takes ownership of the job.
+   */
+  void AddJob(CThumbExtractor *job, IJobCallback *callback);
+
+  /*!
+   \brief Drop the queued jobs of callback. Returns once no job of callback is
+   completing anymore, running jobs finish without being reported.
+   */
+  void CancelJobs(IJobCallback *callback);
+
+  /*!
+   \brief Drop all queued jobs and wait for the workers to exit.
+   Called on shutdown, before the player and settings the workers depend on go away.
+   Jobs added afterwards are dropped.
+   */
+  void Stop();
+
+  static const unsigned int MAX_WORKERS = 4;
+  static const unsigned int MAX_PER_SOURCE = 2;
+
+private:
+  CVideoProbeQueue();
+  ~CVideoProbeQueue();
+  CVideoProbeQueue(const CVideoProbeQueue&) = delete;
+  CVideoProbeQueue& operator=(const CVideoProbeQueue&) = delete;
+
+  struct CItem
+  {
+    CThumbExtractor *job;
+    IJobCallback *callback;
+    std::string source;
+    unsigned int id;
+  };
+
+  class CWorker : public CThread
+  {
+  public:
+    explicit CWorker(CVideoProbeQueue &queue);
+    void StopThread(bool bWait = true) override;
+
+  protected:
+    void Process() override;
+
+  private:
+    CVideoProbeQueue &m_queue;
+    CDVDThumbCodecCache m_codecCache;
+  };
+
+  static std::string GetSource(const std::string &path);
+  bool Next(CItem &item);
+  void Complete(CItem &item, bool success);
+
+  CCriticalSection m_section;
+  CCriticalSection m_callbackSection;
+  CEvent m_jobEvent;
+  std::deque<CItem> m_queue;
+  std::vector<CItem> m_running;
+  std::map<std::string, unsigned int> m_sources;
+  std::vector<std::unique_ptr<CWorker> > m_workers;
+  unsigned int m_jobCounter;
+  bool m_stopped;
+};
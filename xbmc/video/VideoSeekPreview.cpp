@@ -0,0 +1,236 @@
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "VideoSeekPreview.h"
+#include "TextureCache.h"
+#include "URL.h"
+#include "cores/VideoPlayer/DVDFileInfo.h"
+#include "filesystem/File.h"
+#include "settings/Settings.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/JobManager.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(TARGET_POSIX)
+#include "linux/XTimeUtils.h"
+#endif
+
+CSeekPreviewExtractor::CSeekPreviewExtractor(const CFileItem &item)
+  : m_item(item)
+{
+}
+
+bool CSeekPreviewExtractor::operator==(const CJob* job) const
+{
+  if (strcmp(job->GetType(), GetType()) == 0)
+  {
+    const CSeekPreviewExtractor* jobExtract = dynamic_cast<const CSeekPreviewExtractor*>(job);
+    if (jobExtract && jobExtract->m_item.GetPath() == m_item.GetPath())
+      return true;
+  }
+  return false;
+}
+
+std::string CSeekPreviewExtractor::GetThumbURL(const std::string &path, int time)
+{
+  return StringUtils::Format("seekpreview://%s/%i", path.c_str(), time);
+}
+
+bool CSeekPreviewExtractor::GetThumb(size_t index, int &time, std::string &image) const
+{
+  if (index >= m_thumbs.size() || !m_thumbs[index].done)
+    return false;
+
+  time = m_thumbs[index].time;
+  image = CTextureCache::GetCachedPath(m_thumbs[index].details.file);
+  return true;
+}
+
+bool CSeekPreviewExtractor::Pause(unsigned int busy, size_t progress)
+{
+  // idle long enough for the time spent working to stay within our share
+  unsigned int idle = busy * (100 - CPU_SHARE) / CPU_SHARE;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  while (XbmcThreads::SystemClockMillis() - start < idle)
+  {
+    if (ShouldCancel(progress, m_thumbs.size()))
+      return false;
+    Sleep(std::min(idle - (XbmcThreads::SystemClockMillis() - start), 100u));
+  }
+  return !ShouldCancel(progress, m_thumbs.size());
+}
+
+bool CSeekPreviewExtractor::DoWork()
+{
+  const std::string &path = m_item.GetPath();
+
+  // same restrictions as the thumb extractor
+  if (m_item.IsLiveTV()
+  ||  m_item.IsPVRRecording()
+  ||  URIUtils::IsUPnP(path)
+  ||  URIUtils::IsBluray(path)
+  ||  m_item.IsBDFile()
+  ||  m_item.IsDVD()
+  ||  m_item.IsDiscImage()
+  ||  m_item.IsDVDFile(false, true)
+  ||  m_item.IsInternetStream()
+  ||  m_item.IsDiscStub()
+  ||  m_item.IsPlayList()
+  ||  m_item.IsStack())
+    return false;
+
+  if (URIUtils::IsRemote(path) &&
+     !URIUtils::IsOnLAN(path)  &&
+     (URIUtils::IsFTP(path)    ||
+      URIUtils::IsHTTP(path)))
+    return false;
+
+  int duration = 0;
+  if (!CDVDFileInfo::GetFileDuration(path, duration) || duration <= 0)
+    return false;
+
+  int interval = std::max(INTERVAL, duration / MAX_THUMBS);
+
+  // thumbnails cached during an earlier playback are reused
+  std::vector<int> times;
+  std::vector<CTextureDetails> details;
+  std::vector<size_t> pending;
+  for (int time = 0; time < duration; time += interval)
+  {
+    Thumb thumb;
+    thumb.time = time;
+    thumb.url = GetThumbURL(path, time);
+    thumb.details.file = CTextureCache::GetCacheFile(thumb.url) + ".jpg";
+    thumb.done = XFILE::CFile::Exists(CTextureCache::GetCachedPath(thumb.details.file));
+    if (!thumb.done)
+    {
+      pending.push_back(m_thumbs.size());
+      times.push_back(time);
+      details.push_back(thumb.details);
+    }
+    m_thumbs.push_back(thumb);
+  }
+
+  for (size_t i = 0; i < m_thumbs.size(); i++)
+  {
+    if (m_thumbs[i].done && ShouldCancel(i + 1, m_thumbs.size()))
+      return false;
+  }
+
+  if (pending.empty())
+    return true;
+
+  CLog::Log(LOGDEBUG, "%s - extracting %d seek preview thumbs every %d ms from %s", __FUNCTION__,
+            (int)pending.size(), interval, CURL::GetRedacted(path).c_str());
+
+  bool cancelled = false;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CDVDFileInfo::ExtractThumbs(path, times, WIDTH, details, [&](size_t index, bool ok)
+  {
+    Thumb &thumb = m_thumbs[pending[index]];
+    if (ok)
+    {
+      thumb.details = details[index];
+      thumb.done = CTextureCache::GetInstance().AddCachedTexture(thumb.url, thumb.details);
+    }
+
+    if (!Pause(XbmcThreads::SystemClockMillis() - start, pending[index] + 1))
+    {
+      cancelled = true;
+      return false;
+    }
+    start = XbmcThreads::SystemClockMillis();
+    return true;
+  });
+
+  return !cancelled;
+}
+
+CVideoSeekPreview::CVideoSeekPreview()
+  : m_jobID(0)
+{
+}
+
+CVideoSeekPreview::~CVideoSeekPreview()
+{
+  Stop();
+}
+
+void CVideoSeekPreview::Start(const CFileItem &item)
+{
+  Stop();
+
+  if (!CSettings::GetInstance().GetBool(CSettings::SETTING_MYVIDEOS_EXTRACTTHUMB))
+    return;
+
+  CSingleLock lock(m_section);
+  m_jobID = CJobManager::GetInstance().AddJob(new CSeekPreviewExtractor(item), this, CJob::PRIORITY_LOW);
+}
+
+void CVideoSeekPreview::Stop()
+{
+  unsigned int jobID;
+  {
+    CSingleLock lock(m_section);
+    jobID = m_jobID;
+    m_jobID = 0;
+    m_thumbs.clear();
+  }
+
+  if (jobID)
+    CJobManager::GetInstance().CancelJob(jobID);
+}
+
+std::string CVideoSeekPreview::GetThumb(int time) const
+{
+  CSingleLock lock(m_section);
+
+  auto it = m_thumbs.upper_bound(time);
+  if (it == m_thumbs.begin())
+    return "";
+  return (--it)->second;
+}
+
+void CVideoSeekPreview::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CSingleLock lock(m_section);
+  if (jobID == m_jobID)
+    m_jobID = 0;
+}
+
+void CVideoSeekPreview::OnJobProgress(unsigned int jobID, unsigned int progress, unsigned int total, const CJob *job)
+{
+  const CSeekPreviewExtractor *extractor = static_cast<const CSeekPreviewExtractor*>(job);
+
+  int time;
+  std::string image;
+  if (progress == 0 || !extractor->GetThumb(progress - 1, time, image))
+    return;
+
+  CSingleLock lock(m_section);
+  if (jobID == m_jobID)
+    m_thumbs[time] = image;
+}
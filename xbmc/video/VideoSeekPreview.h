@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2017 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "FileItem.h"
+#include "TextureCacheJob.h"
+#include "threads/CriticalSection.h"
+#include "utils/Job.h"
+
+/*!
+ \ingroup thumbs,jobs
+ \brief Extracts the seek preview thumbnails of a video file
+
+ Decodes one keyframe every few seconds into a small thumbnail and stores it
+ in the texture cache under seekpreview://<path>/<ms>, so a file is only
+ worked on once. The job runs at low priority and sleeps between thumbnails
+ to stay within a fixed share of one cpu while the file is playing.
+
+ \sa CVideoSeekPreview
+ */
+class CSeekPreviewExtractor : public CJob
+{
+public:
+  explicit CSeekPreviewExtractor(const CFileItem &item);
+
+  bool DoWork() override;
+  const char* GetType() const override { return "seekpreview"; }
+  bool operator==(const CJob* job) const override;
+
+  /*!
+   \brief Get a thumbnail, valid once progress was reported beyond index
+   \return false if the thumbnail could not be extracted
+   */
+  bool GetThumb(size_t index, int &time, std::string &image) const;
+
+  static std::string GetThumbURL(const std::string &path, int time);
+
+  static const int INTERVAL = 10000;   ///< ms between thumbnails
+  static const int MAX_THUMBS = 360;   ///< longer files get a wider interval
+  static const int WIDTH = 320;        ///< width of the thumbnails
+  static const int CPU_SHARE = 10;     ///< percent of one cpu the job may use
+
+private:
+  struct Thumb
+  {
+    int time;
+    std::string url;
+    CTextureDetails details;
+    bool done;
+  };
+
+  bool Pause(unsigned int busy, size_t progress);
+
+  CFileItem m_item;
+  std::vector<Thumb> m_thumbs;
+};
+
+/*!
+ \brief Seek preview thumbnails of the playing file
+
+ Owned by the info manager, which starts it for every video that starts
+ playing and hands the thumbnail closest to the seek bar position to skins
+ as Player.SeekPreview.
+ */
+class CVideoSeekPreview : public IJobCallback
+{
+public:
+  CVideoSeekPreview();
+  ~CVideoSeekPreview() override;
+
+  void Start(const CFileItem &item);
+  void Stop();
+
+  /*!
+   \brief Cached image of the closest thumbnail at or before time (ms), empty if there is none yet
+   */
+  std::string GetThumb(int time) const;
+
+  void OnJobComplete(unsigned int jobID, bool success, CJob *job) override;
+  void OnJobProgress(unsigned int jobID, unsigned int progress, unsigned int total, const CJob *job) override;
+
+private:
+  mutable CCriticalSection m_section;
+  unsigned int m_jobID;
+  std::map<int, std::string> m_thumbs;
+};
@@ -42,6 +42,7 @@
 #include "utils/URIUtils.h"
 #include "video/VideoDatabase.h"
 #include "video/VideoInfoTag.h"
+#include "video/VideoProbeQueue.h"
 
 using namespace XFILE;
 using namespace VIDEO;
@@ -59,6 +60,7 @@ CThumbExtractor::CThumbExtractor(const CFileItem& item,
   m_item = item;
   m_pos = pos;
   m_fillStreamDetails = fillStreamDetails;
+  m_codecCache = NULL;
 
   if (item.IsVideoDb() && item.HasVideoInfoTag())
     m_item.SetPath(item.GetVideoInfoTag()->m_strFileNameAndPath);
@@ -114,7 +116,7 @@ bool CThumbExtractor::DoWork()
     // construct the thumb cache file
     CTextureDetails details;
     details.file = CTextureCache::GetCacheFile(m_target) + ".jpg";
-    result = CDVDFileInfo::ExtractThumb(m_item.GetPath(), details, m_fillStreamDetails ? &m_item.GetVideoInfoTag()->m_streamDetails : NULL, (int) m_pos);
+    result = CDVDFileInfo::ExtractThumb(m_item.GetPath(), details, m_fillStreamDetails ? &m_item.GetVideoInfoTag()->m_streamDetails : NULL, (int) m_pos, m_codecCache);
     if(result)
     {
       CTextureCache::GetInstance().AddCachedTexture(m_target, details);
@@ -191,6 +193,7 @@ CVideoThumbLoader::CVideoThumbLoader() :
 CVideoThumbLoader::~CVideoThumbLoader()
 {
   StopThread();
+  CVideoProbeQueue::GetInstance().CancelJobs(this);
   delete m_videoDatabase;
 }
 
@@ -400,7 +403,7 @@ bool CVideoThumbLoader::LoadItemLookup(CFileItem* pItem)
           SetupRarOptions(item,path);
 
         CThumbExtractor* extract = new CThumbExtractor(item, path, true, thumbURL);
-        AddJob(extract);
+        CVideoProbeQueue::GetInstance().AddJob(extract, this);
 
         m_videoDatabase->Close();
         return true;
@@ -417,7 +420,7 @@ bool CVideoThumbLoader::LoadItemLookup(CFileItem* pItem)
       if (URIUtils::IsInRAR(item.GetPath()))
         SetupRarOptions(item,path);
       CThumbExtractor* extract = new CThumbExtractor(item,path,false);
-      AddJob(extract);
+      CVideoProbeQueue::GetInstance().AddJob(extract, this);
     }
   }
 
@@ -25,6 +25,7 @@
 #include "utils/JobManager.h"
 #include "FileItem.h"
 
+class CDVDThumbCodecCache;
 class CStreamDetails;
 class CVideoDatabase;
 
@@ -60,6 +61,7 @@ public:
   bool       m_thumb; ///< extract thumb?
   int64_t    m_pos; ///< position to extract thumb from
   bool m_fillStreamDetails; ///< fill in stream details? 
+  CDVDThumbCodecCache *m_codecCache; ///< decoder to reuse, set by the CVideoProbeQueue worker running the job
 };
 
 class CVideoThumbLoader : public CThumbLoader, public CJobQueue